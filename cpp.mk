@@ -25,12 +25,17 @@ FLAGS_16=$(CPP_FLAGS_LOW) -mregparm=3 -mpreferred-stack-boundary=2
 FLAGS_32=$(CPP_FLAGS_LOW) -mpreferred-stack-boundary=4
 FLAGS_64=-mpreferred-stack-boundary=4 $(ENABLE_SSE_FLAGS) $(DISABLE_AVX_FLAGS)
 
+# The kernel must not touch the FPU/SSE/AVX registers, they are lazily
+# switched between the processes
+KERNEL_FLAGS_64=-mpreferred-stack-boundary=4 $(DISABLE_SSE_FLAGS) $(DISABLE_AVX_FLAGS) -mno-80387
+
 # Activate Stack Smashing Protection
 FLAGS_64 += -fstack-protector
+KERNEL_FLAGS_64 += -fstack-protector
 
-KERNEL_CPP_FLAGS_64=$(COMMON_CPP_FLAGS) $(FLAGS_64)
+KERNEL_CPP_FLAGS_64=$(COMMON_CPP_FLAGS) $(KERNEL_FLAGS_64)
 
-ACPICA_C_FLAGS= $(COMMON_C_FLAGS) $(FLAGS_64) -include include/thor_acenv.hpp -include include/thor_acenvex.hpp
+ACPICA_C_FLAGS= $(COMMON_C_FLAGS) $(KERNEL_FLAGS_64) -include include/thor_acenv.hpp -include include/thor_acenvex.hpp
 
 COMMON_LINK_FLAGS=-lgcc
 
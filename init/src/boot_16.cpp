@@ -416,8 +416,8 @@ void setup_gdt(){
     gdt[1] = code_32_descriptor();
     gdt[2] = data_descriptor();
     gdt[3] = code_64_descriptor();
-    gdt[4] = user_code_64_descriptor();
-    gdt[5] = user_data_descriptor();
+    gdt[4] = user_data_descriptor();
+    gdt[5] = user_code_64_descriptor();
 
     //2. Init TSS Descriptor
 
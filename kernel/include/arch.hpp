@@ -33,6 +33,47 @@ inline bool interrupts_enabled(){
     return flags & 0x200;
 }
 
+/*!
+ * \brief Returns the current value of the Time Stamp Counter
+ */
+inline uint64_t rdtsc(){
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a" (low), "=d" (high));
+    return (uint64_t(high) << 32) | low;
+}
+
+/*!
+ * \brief Hint the processor that the code is in a spin-wait loop
+ */
+inline void pause(){
+    asm volatile("pause" : : : "memory");
+}
+
+/*!
+ * \brief Execute the CPUID instruction for the given leaf and subleaf
+ */
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d){
+    asm volatile("cpuid"
+        : "=a" (a), "=b" (b), "=c" (c), "=d" (d)
+        : "a" (leaf), "c" (subleaf));
+}
+
+/*!
+ * \brief Read the given Model Specific Register
+ */
+inline uint64_t read_msr(uint32_t msr){
+    uint32_t low, high;
+    asm volatile("rdmsr" : "=a" (low), "=d" (high) : "c" (msr));
+    return (uint64_t(high) << 32) | low;
+}
+
+/*!
+ * \brief Write the given Model Specific Register
+ */
+inline void write_msr(uint32_t msr, uint64_t value){
+    asm volatile("wrmsr" : : "c" (msr), "a" (uint32_t(value)), "d" (uint32_t(value >> 32)));
+}
+
 } //enf of arch namespace
 
 #endif
@@ -8,7 +8,7 @@
 #ifndef CONDITION_VARIABLE_H
 #define CONDITION_VARIABLE_H
 
-#include "conc/wait_list.hpp"
+#include "conc/wait_queue.hpp"
 #include "conc/spinlock.hpp"
 
 #include "process.hpp"
@@ -54,7 +54,7 @@ struct condition_variable {
 
 private:
     mutable spinlock lock; ///< The spin lock used for protecting the queue
-    wait_list queue;       ///< The queue of waiting threads
+    wait_queue queue;      ///< The queue of waiting threads
 };
 
 #endif
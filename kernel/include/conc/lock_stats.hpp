@@ -0,0 +1,31 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+#include <types.hpp>
+#include <string.hpp>
+
+/*!
+ * \brief Contention statistics of a lock
+ */
+struct lock_stats {
+    volatile uint64_t acquisitions = 0; ///< The number of acquisitions
+    volatile uint64_t contentions  = 0; ///< The number of acquisitions that had to wait
+    volatile uint64_t spins        = 0; ///< The number of spin iterations
+    volatile uint64_t sleeps       = 0; ///< The number of times a process had to sleep
+    volatile uint64_t max_hold     = 0; ///< The maximum hold time, in TSC cycles
+
+    /*!
+     * \brief Export the statistics in sysfs, under /sys/locks/<name>/
+     * \param name The name of the lock
+     */
+    void publish(const std::string& name);
+};
+
+#endif
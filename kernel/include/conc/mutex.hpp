@@ -12,16 +12,22 @@
 #include <lock_guard.hpp>
 
 #include "conc/spinlock.hpp"
-#include "conc/wait_list.hpp"
+#include "conc/wait_queue.hpp"
+#include "conc/lock_stats.hpp"
 
 #include "scheduler.hpp"
 #include "logging.hpp"
+#include "arch.hpp"
 
 /*!
- * \brief A mutex implementation.
+ * \brief An adaptive mutex implementation.
  *
  * Once the lock is acquired, the critical section is only accessible by the
  * thread who acquired the mutex.
+ *
+ * On contention, the mutex spins for a short time as long as the owner is
+ * running, since it is likely to release the lock soon. Otherwise, the
+ * process is put to sleep until the lock is handed to it.
  */
 struct mutex {
     /*!
@@ -40,18 +46,11 @@ struct mutex {
      * \brief Acquire the lock
      */
     void lock() {
-        value_lock.lock();
-
-        if (value > 0) {
-            value = 0;
-
-            value_lock.unlock();
-        } else {
-            queue.enqueue();
-
-            value_lock.unlock();
-            scheduler::reschedule();
+        if (!try_acquire()) {
+            lock_contended();
         }
+
+        acquired();
     }
 
     /*!
@@ -62,10 +61,8 @@ struct mutex {
      * \return true if the lock was acquired, false otherwise.
      */
     bool try_lock() {
-        std::lock_guard<spinlock> l(value_lock);
-
-        if (value > 0) {
-            value = 0;
+        if (try_acquire()) {
+            acquired();
 
             return true;
         } else {
@@ -77,22 +74,88 @@ struct mutex {
      * \brief Release the lock
      */
     void unlock() {
+        auto hold = arch::rdtsc() - acquire_time;
+
+        if (hold > stats.max_hold) {
+            stats.max_hold = hold;
+        }
+
+        owner = scheduler::INVALID_PID;
+
         std::lock_guard<spinlock> l(value_lock);
 
         if (queue.empty()) {
             value = 1;
         } else {
-            queue.dequeue();
+            queue.wake_one();
 
             //No need to increment value, the process won't
             //decrement it
         }
     }
 
+    /*!
+     * \brief Export the contention statistics of the mutex in sysfs
+     * \param name The name of the mutex
+     */
+    void publish(const std::string& name) {
+        stats.publish(name);
+    }
+
 private:
-    mutable spinlock value_lock; ///< The spin protecting the value
-    volatile size_t value = 1;   ///< The value of the mutex
-    wait_list queue;             ///< The sleep queue
+    static constexpr const size_t MAX_SPINS = 1000; ///< The maximum number of spin iterations
+
+    bool try_acquire() {
+        return value && __sync_bool_compare_and_swap(&value, 1, 0);
+    }
+
+    void acquired() {
+        owner        = scheduler::get_pid();
+        acquire_time = arch::rdtsc();
+
+        ++stats.acquisitions;
+    }
+
+    void lock_contended() {
+        __sync_fetch_and_add(&stats.contentions, 1);
+
+        // Spin while the owner is running on another processor
+        for (size_t i = 0; i < MAX_SPINS; ++i) {
+            auto o = owner;
+
+            if (o == scheduler::INVALID_PID || o == scheduler::get_pid() || scheduler::get_process_state(o) != scheduler::process_state::RUNNING) {
+                break;
+            }
+
+            arch::pause();
+
+            __sync_fetch_and_add(&stats.spins, 1);
+
+            if (try_acquire()) {
+                return;
+            }
+        }
+
+        value_lock.lock();
+
+        if (__sync_bool_compare_and_swap(&value, 1, 0)) {
+            value_lock.unlock();
+        } else {
+            __sync_fetch_and_add(&stats.sleeps, 1);
+
+            queue.enqueue();
+
+            value_lock.unlock();
+            scheduler::reschedule();
+        }
+    }
+
+    mutable spinlock value_lock;                              ///< The spin protecting the value
+    volatile size_t value = 1;                                ///< The value of the mutex
+    wait_queue queue;                                         ///< The sleep queue
+    volatile scheduler::pid_t owner = scheduler::INVALID_PID; ///< The owner of the mutex
+    uint64_t acquire_time = 0;                                ///< The TSC at acquisition
+    lock_stats stats;                                         ///< The contention statistics
 };
 
 #endif
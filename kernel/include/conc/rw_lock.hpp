@@ -8,8 +8,12 @@
 #ifndef RW_LOCK_H
 #define RW_LOCK_H
 
-#include "conc/mutex.hpp"
-#include "conc/condition_variable.hpp"
+#include <lock_guard.hpp>
+
+#include "conc/spinlock.hpp"
+#include "conc/wait_queue.hpp"
+
+#include "scheduler.hpp"
 
 struct rw_lock;
 
@@ -78,64 +82,64 @@ struct rw_lock final {
      * \brief Acquire the lock for reading
      */
     void read_lock(){
-        m.lock();
+        lock.lock();
 
         while(writer){
-            m.unlock();
-            write.wait();
-            m.lock();
+            // The process is enqueued before the lock is released, a wake
+            // up cannot be missed
+            queue.enqueue();
+            lock.unlock();
+            scheduler::reschedule();
+            lock.lock();
         }
 
         ++readers;
 
-        m.unlock();
+        lock.unlock();
     }
 
     /*!
      * \brief Release the lock for reading
      */
     void read_unlock(){
-        m.lock();
+        std::lock_guard<spinlock> l(lock);
 
         --readers;
 
-        // If there are no more readers, notify one writer
+        // If there are no more readers, wake up one writer
         if(!readers){
-            write.notify_one();
+            queue.wake_one();
         }
-
-        m.unlock();
     }
 
     /*!
      * \brief Acquire the lock for writing.
      */
     void write_lock(){
-        m.lock();
+        lock.lock();
 
         while(writer || readers){
-            m.unlock();
-            write.wait();
-            m.lock();
+            queue.enqueue();
+            lock.unlock();
+            scheduler::reschedule();
+            lock.lock();
         }
 
         writer = true;
 
-        m.unlock();
+        lock.unlock();
     }
 
     /*!
      * \brief Release the lock for writing.
      */
     void write_unlock(){
-        m.lock();
+        std::lock_guard<spinlock> l(lock);
 
         writer = false;
 
-        // Notify all writers and readers
-        write.notify_all();
-
-        m.unlock();
+        // Wake up all writers and readers
+        queue.wake_all();
     }
 
     /*!
@@ -153,26 +157,26 @@ struct rw_lock final {
     }
 
 private:
-    condition_variable write; ///< The write condition variable
-    mutex m;                  ///< Mutex protecting the counter
-    size_t readers = 0;       ///< Number of readers
-    bool writer    = false;   ///< Boolean flag indicating if there is a writer
+    spinlock lock;          ///< Spin lock protecting the state
+    wait_queue queue;       ///< The waiting readers and writers
+    size_t readers = 0;     ///< Number of readers
+    bool writer    = false; ///< Boolean flag indicating if there is a writer
 };
 
 inline void writer_rw_lock::lock(){
-    l.read_lock();
+    l.write_lock();
 }
 
 inline void writer_rw_lock::unlock(){
-    l.read_unlock();
+    l.write_unlock();
 }
 
 inline void reader_rw_lock::lock(){
-    l.write_lock();
+    l.read_lock();
 }
 
 inline void reader_rw_lock::unlock(){
-    l.write_unlock();
+    l.read_unlock();
 }
 
 #endif
@@ -12,7 +12,7 @@
 #include <lock_guard.hpp>
 
 #include "conc/spinlock.hpp"
-#include "conc/wait_list.hpp"
+#include "conc/wait_queue.hpp"
 
 #include "scheduler.hpp"
 
@@ -82,7 +82,7 @@ struct semaphore {
             ++value;
         } else {
             // Wake up the process
-            queue.dequeue();
+            queue.wake_one();
 
             //No need to increment value, the process won't
             //decrement it
@@ -98,24 +98,14 @@ struct semaphore {
     void release(size_t n) {
         std::lock_guard<spinlock> l(value_lock);
 
-        if (queue.empty()) {
-            value += n;
-        } else {
-            while (n && !queue.empty()) {
-                queue.dequeue();
-                --n;
-            }
-
-            if (n) {
-                value += n;
-            }
-        }
+        // The woken processes won't decrement the value
+        value += n - queue.wake_n(n);
     }
 
 private:
     spinlock value_lock;    ///< The spin lock protecting the counter
     volatile size_t value;  ///< The value of the counter
-    wait_list queue;        ///< The sleep queue
+    wait_queue queue;       ///< The sleep queue
 };
 
 #endif
@@ -10,10 +10,15 @@
 
 #include <types.hpp>
 
+#include "arch.hpp"
+
 /*!
- * \brief Implementation of a spinlock
+ * \brief Implementation of a ticket spinlock
  *
- * A spinlock simply waits in a loop until the lock is available.
+ * Each process takes a ticket and waits in a loop until its ticket is
+ * served. This guarantees FIFO ordering between the waiting processes. The
+ * waiting loop only reads the lock and backs off proportionally to the number
+ * of processes before it in the queue.
  */
 struct spinlock {
     /*!
@@ -22,36 +27,49 @@ struct spinlock {
      * This will wait indefinitely.
      */
     void lock() {
-        while (!__sync_bool_compare_and_swap(&value, 0, 1))
-            ;
-        __sync_synchronize();
-        //TODO The last synchronize is probably not necessary
+        auto ticket = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+
+        while (true) {
+            auto current = __atomic_load_n(&serving, __ATOMIC_ACQUIRE);
+
+            if (current == ticket) {
+                return;
+            }
+
+            // Back off proportionally to our position in the queue
+            for (size_t i = 0; i < (ticket - current) * BACKOFF; ++i) {
+                arch::pause();
+            }
+        }
     }
 
     /*!
-     * \brief Acquire the lock.
+     * \brief Try to acquire the lock.
      *
-     * This will wait indefinitely.
+     * This function returns immediately.
+     *
+     * \return true if the lock was acquired, false otherwise.
      */
     bool try_lock() {
-        if(__sync_bool_compare_and_swap(&value, 0, 1)){
-            __sync_synchronize();
-            return true;
-        }
+        // The lock is free only if the next ticket is the one being served
+        auto current = __atomic_load_n(&serving, __ATOMIC_RELAXED);
 
-        return false;
+        return __atomic_compare_exchange_n(&next, &current, current + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
     }
 
     /*!
      * \brief Release the lock
      */
     void unlock() {
-        __sync_synchronize();
-        value = 0;
+        // Only the owner of the lock modifies serving
+        __atomic_store_n(&serving, serving + 1, __ATOMIC_RELEASE);
     }
 
 private:
-    volatile size_t value = 0; ///< The value of the lock
+    static constexpr const size_t BACKOFF = 16; ///< The number of pauses per waiting process
+
+    volatile uint32_t next    = 0; ///< The next ticket to give
+    volatile uint32_t serving = 0; ///< The ticket currently being served
 };
 
 #endif
@@ -0,0 +1,110 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <types.hpp>
+#include <utility.hpp>
+
+/*!
+ * \brief A bounded lock-free ring with a single producer and a single
+ * consumer.
+ *
+ * The producer and the consumer can run concurrently, for instance an IRQ
+ * handler and a kernel thread. Several producers (or consumers) must be
+ * serialized by the caller.
+ *
+ * \tparam T The type of the elements
+ * \tparam S The capacity of the ring (must be a power of two)
+ */
+template<typename T, size_t S>
+struct spsc_ring {
+    static_assert(S && (S & (S - 1)) == 0, "The capacity of the ring must be a power of two");
+
+    /*!
+     * \brief Push a value to the ring (producer side)
+     *
+     * The depth is computed from a single read of the consumer position,
+     * made once the value is visible to the consumer. It is 0 if the
+     * consumer already popped the value, and 1 if the consumer may have seen
+     * the ring empty and needs to be woken up.
+     *
+     * \param value The value to push
+     * \param depth Set to the number of elements in the ring after the push
+     * \return true if the value was pushed, false if the ring was full
+     */
+    bool push(const T& value, size_t& depth){
+        auto tail = __atomic_load_n(&this->tail, __ATOMIC_RELAXED);
+        auto head = __atomic_load_n(&this->head, __ATOMIC_ACQUIRE);
+
+        if(tail - head == S){
+            return false;
+        }
+
+        buffer[tail & (S - 1)] = value;
+
+        __atomic_store_n(&this->tail, tail + 1, __ATOMIC_RELEASE);
+
+        // Pairs with the fence in pop(), so that either the producer sees
+        // the ring emptied, or the consumer sees the new element
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        depth = tail + 1 - __atomic_load_n(&this->head, __ATOMIC_ACQUIRE);
+
+        return true;
+    }
+
+    /*!
+     * \brief Pop a value from the ring (consumer side)
+     * \param value The popped value
+     * \return true if a value was popped, false if the ring was empty
+     */
+    bool pop(T& value){
+        auto head = __atomic_load_n(&this->head, __ATOMIC_RELAXED);
+        auto tail = __atomic_load_n(&this->tail, __ATOMIC_ACQUIRE);
+
+        if(head == tail){
+            return false;
+        }
+
+        value = std::move(buffer[head & (S - 1)]);
+
+        __atomic_store_n(&this->head, head + 1, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        return true;
+    }
+
+    /*!
+     * \brief Returns the number of elements in the ring
+     */
+    size_t size() const {
+        return __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    }
+
+    /*!
+     * \brief Indicates if the ring is empty
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /*!
+     * \brief Returns the capacity of the ring
+     */
+    static constexpr size_t capacity(){
+        return S;
+    }
+
+private:
+    T buffer[S];      ///< The elements
+    size_t head = 0;  ///< The number of popped elements (written by the consumer)
+    size_t tail = 0;  ///< The number of pushed elements (written by the producer)
+};
+
+#endif
@@ -0,0 +1,115 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef WAIT_QUEUE_H
+#define WAIT_QUEUE_H
+
+#include <types.hpp>
+
+struct wait_queue;
+
+/*!
+ * \brief The node of a process in a wait queue.
+ *
+ * Each process has a single node, it can only wait in one queue at a time.
+ */
+struct wait_node {
+    size_t pid;        ///< The pid of the process
+    wait_node* next;   ///< The next node in the queue
+    wait_node* prev;   ///< The previous node in the queue
+    wait_queue* queue; ///< The queue the process is waiting in (nullptr if none)
+    bool timed_out;    ///< Indicates if the last wait ended with a timeout
+};
+
+/*!
+ * \brief A queue of waiting processes.
+ *
+ * It is implemented as an intrusive doubly linked list, all the operations
+ * are O(1), except the wake up of several processes. The queue is protected
+ * against interrupts, the scheduler removes the processes whose timeout is
+ * passed directly from their queue.
+ */
+struct wait_queue {
+    /*!
+     * \brief Test if the queue is empty.
+     */
+    bool empty() const;
+
+    /*!
+     * \brief Returns the number of waiting processes
+     */
+    size_t size() const;
+
+    /*!
+     * \brief Returns the first process of the queue
+     * \return The pid of the first process
+     */
+    size_t top() const;
+
+    /*!
+     * \brief Enqueue the current process in the queue and block it. The
+     * process will only stop running on the next reschedule.
+     */
+    void enqueue();
+
+    /*!
+     * \brief Enqueue the current process in the queue and block it, with a
+     * timeout. The process will only stop running on the next reschedule.
+     * \param ms The timeout, in milliseconds
+     */
+    void enqueue_timeout(size_t ms);
+
+    /*!
+     * \brief Indicates if the last wait of the current process ended with
+     * its timeout
+     */
+    bool timed_out() const;
+
+    /*!
+     * \brief Wake up the first process of the queue
+     * \return The pid of the woken process, INVALID_PID if the queue is empty
+     */
+    size_t wake_one();
+
+    /*!
+     * \brief Wake up at most n processes from the queue
+     * \return The number of woken processes
+     */
+    size_t wake_n(size_t n);
+
+    /*!
+     * \brief Wake up all the processes from the queue
+     * \return The number of woken processes
+     */
+    size_t wake_all();
+
+    /*!
+     * \brief Remove the given node from the queue, without waking up the
+     * process.
+     *
+     * The node must be in this queue.
+     */
+    void remove(wait_node& node);
+
+    /*!
+     * \brief Remove the given node from the queue because its timeout is
+     * passed.
+     *
+     * This is called by the scheduler, with interrupts disabled.
+     */
+    void expire(wait_node& node);
+
+private:
+    void push(wait_node& node);
+    void unlink(wait_node& node);
+
+    wait_node* head = nullptr; ///< The head of the queue
+    wait_node* tail = nullptr; ///< The tail of the queue
+    size_t count    = 0;       ///< The number of waiting processes
+};
+
+#endif
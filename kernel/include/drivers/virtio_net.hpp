@@ -0,0 +1,29 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef VIRTIO_NET_H
+#define VIRTIO_NET_H
+
+#include <types.hpp>
+
+#include "net/network.hpp"
+
+#include "drivers/pci.hpp"
+
+namespace virtio_net {
+
+/*!
+ * \brief Indicates if the given PCI device is a supported virtio-net device
+ */
+bool is_supported(pci::device_descriptor& pci_device);
+
+void init_driver(network::interface_descriptor& interface, pci::device_descriptor& pci_device);
+void finalize_driver(network::interface_descriptor& interface);
+
+} //end of namespace virtio_net
+
+#endif
@@ -0,0 +1,54 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef FPU_H
+#define FPU_H
+
+#include <types.hpp>
+
+/*
+ * The extended processor state (x87, SSE and AVX registers) is switched
+ * lazily. The kernel itself never touches these registers. On each context
+ * switch, CR0.TS is set unless the next process already owns the FPU. The
+ * first FPU/SSE/AVX instruction of the process then raises #NM, where the
+ * state of the previous owner is saved and the state of the process is
+ * restored.
+ */
+
+namespace fpu {
+
+/*!
+ * \brief Detect the save mechanism (XSAVEOPT, XSAVE or FXSAVE) and enable
+ * the supported state components.
+ */
+void init();
+
+/*!
+ * \brief Finalize the FPU support (register sysfs values)
+ */
+void finalize();
+
+/*!
+ * \brief Let the FPU know that the given process is about to run.
+ *
+ * This must be called with interrupts disabled.
+ */
+void switched(size_t pid);
+
+/*!
+ * \brief Release the extended state of the given process
+ */
+void release(size_t pid);
+
+/*!
+ * \brief Returns the size, in bytes, of the extended state area
+ */
+size_t area_size();
+
+} //end of namespace fpu
+
+#endif
@@ -81,11 +81,20 @@ private:
 
 using dynamic_fun_t = std::string (*)();
 using dynamic_fun_data_t = std::string (*)(void*);
+using store_fun_data_t = size_t (*)(void*, const std::string&); ///< Returns 0 on success, an error code otherwise
 
 void set_constant_value(const path& mount_point, const path& file_path, const std::string& value);
 void set_dynamic_value(const path& mount_point, const path& file_path, dynamic_fun_t fun);
 void set_dynamic_value_data(const path& mount_point, const path& file_path, dynamic_fun_data_t fun, void* data);
 
+/*!
+ * \brief Set a dynamic value that can also be written by the user
+ * \param fun The function returning the value
+ * \param store The function storing a written value
+ * \param data The data given to both functions
+ */
+void set_writable_value_data(const path& mount_point, const path& file_path, dynamic_fun_data_t fun, store_fun_data_t store, void* data);
+
 void delete_value(const path& mount_point, const path& file_path);
 void delete_folder(const path& mount_point, const path& file_path);
 
@@ -0,0 +1,60 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <types.hpp>
+#include <expected.hpp>
+
+#include "process.hpp"
+
+/*
+ * Futexes let user programs sleep on a 32-bit word of their address space.
+ * The user space only enters the kernel when there is contention. The wait
+ * queues are keyed by the thread group and the address of the word, so they
+ * are private to a process and shared between its threads.
+ */
+
+namespace futex {
+
+/*!
+ * \brief Finalize the futex support (register sysfs values)
+ */
+void finalize();
+
+/*!
+ * \brief Release the wait queues of the given thread group, once its threads are killed
+ * \param tgid The thread group
+ */
+void release_group(scheduler::pid_t tgid);
+
+/*!
+ * \brief Block the current process until woken up on the given address
+ *
+ * The process is only blocked if the word at the given address still
+ * contains the expected value.
+ *
+ * \param address The user address of the word
+ * \param value The expected value of the word
+ * \param ms The timeout in milliseconds (0 means no timeout)
+ * \return nothing or an error (ERROR_WOULD_BLOCK if the value changed, ERROR_TIMEOUT if the timeout passed,
+ * ERROR_BUSY if there is no free wait queue)
+ */
+std::expected<void> wait(size_t address, uint32_t value, size_t ms);
+
+/*!
+ * \brief Wake up processes waiting on the given address
+ * \param address The user address of the word
+ * \param n The maximum number of processes to wake up
+ * \return The number of processes woken up or an error
+ */
+std::expected<size_t> wake(size_t address, size_t n);
+
+} //end of namespace futex
+
+#endif
@@ -18,4 +18,14 @@ task_state_segment_t& tss();
 
 } //end of namespace gdt
 
+extern "C" {
+
+/*!
+ * \brief The address of the kernel stack pointer (rsp0) of the TSS, used by
+ * the SYSCALL entry point
+ */
+extern const uint64_t tss_rsp0_address;
+
+} //end of extern "C"
+
 #endif
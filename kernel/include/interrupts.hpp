@@ -27,7 +27,6 @@ struct fault_regs {
 } __attribute__((packed));
 
 struct syscall_regs {
-    sse_128 xmm_registers[16];
     uint64_t rax;
     uint64_t rbx;
     uint64_t rcx;
@@ -51,8 +50,17 @@ struct syscall_regs {
     uint64_t ds;
 } __attribute__((packed));
 
+// The IRQ and system call stubs and task_switch build exactly this frame:
+// save_context (15 registers), the gate number and the interrupt frame
+static_assert(sizeof(syscall_regs) == 21 * 8, "The syscall_regs must match the frame of the entry stubs");
+
 void setup_interrupts();
 
+/*!
+ * \brief Register the sysfs values of the interrupts (latency of the IRQ handlers)
+ */
+void finalize();
+
 bool register_irq_handler(size_t irq, void (*handler)(syscall_regs*, void*), void* data);
 bool register_syscall_handler(size_t irq, void (*handler)(syscall_regs*));
 
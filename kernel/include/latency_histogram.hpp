@@ -0,0 +1,85 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <types.hpp>
+#include <string.hpp>
+
+/*
+ * Fixed-size histograms of latencies, in TSC cycles, with log2 buckets:
+ * the bucket i counts the latencies in [2^i, 2^(i+1)), the last bucket
+ * also counts all the longer latencies.
+ *
+ * Recording does not allocate and does not lock, the caller must make sure
+ * that it is not interrupted by another recording on the same histogram.
+ */
+
+namespace latency {
+
+constexpr const size_t buckets = 40; ///< The number of buckets (the last starts at 2^39 cycles)
+
+/*!
+ * \brief A histogram of latencies
+ */
+struct histogram {
+    uint64_t count;            ///< The number of recorded latencies
+    uint64_t total;            ///< The sum of the recorded latencies
+    uint64_t max;              ///< The maximum recorded latency
+    uint64_t counts[buckets];  ///< The number of latencies in each bucket
+};
+
+/*!
+ * \brief Returns the bucket of the given latency
+ */
+inline size_t bucket(uint64_t cycles){
+    if(!cycles){
+        return 0;
+    }
+
+    size_t log2 = 63 - __builtin_clzll(cycles);
+
+    return log2 < buckets ? log2 : buckets - 1;
+}
+
+/*!
+ * \brief Record a latency in the given histogram
+ */
+inline void record(histogram& h, uint64_t cycles){
+    ++h.count;
+    h.total += cycles;
+
+    if(cycles > h.max){
+        h.max = cycles;
+    }
+
+    ++h.counts[bucket(cycles)];
+}
+
+/*!
+ * \brief Clear the given histogram
+ */
+inline void clear(histogram& h){
+    h.count = 0;
+    h.total = 0;
+    h.max   = 0;
+
+    for(size_t i = 0; i < buckets; ++i){
+        h.counts[i] = 0;
+    }
+}
+
+/*!
+ * \brief Format the given histogram as "count mean max" followed by a
+ * "log2:count" pair for each non-empty bucket
+ */
+std::string to_string(const histogram& h);
+
+} //end of namespace latency
+
+#endif
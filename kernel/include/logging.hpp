@@ -12,6 +12,11 @@
 #ifndef LOGGING_HPP
 #define LOGGING_HPP
 
+// The minimum level of the messages compiled in the kernel (0 is TRACE)
+#ifndef THOR_LOG_LEVEL
+#define THOR_LOG_LEVEL 0
+#endif
+
 namespace logging {
 
 enum class log_level : char {
@@ -22,20 +27,93 @@ enum class log_level : char {
     USER
 };
 
+constexpr const log_level min_level = static_cast<log_level>(THOR_LOG_LEVEL); ///< The minimum level compiled in
+constexpr const size_t max_args     = 8;                                      ///< The maximum number of arguments of a message
+
+/*!
+ * \brief Indicates if the messages of the given level are compiled in.
+ *
+ * Since the level is always a constant at the call site, the calls for the
+ * disabled levels are removed by the compiler.
+ */
+constexpr bool enabled(log_level level){
+    return level >= min_level;
+}
+
 bool is_early();
 bool is_file();
 void finalize();
 void to_file();
 
-void log(log_level level, const char* s);
-void log(log_level level, const std::string& s);
+/*!
+ * \brief Start the task writing the messages of the log ring.
+ *
+ * Until then, the messages are formatted and written directly.
+ */
+void start_drainer();
+
+/*!
+ * \brief Write the pending messages of the log ring to the debug output
+ */
+void flush();
+
+/*!
+ * \brief Record a message with its arguments, the formatting is deferred.
+ */
+void log_args(log_level level, const char* format, const uint64_t* args, size_t n);
+
+/*!
+ * \brief Record a message without level with its arguments, the formatting is deferred.
+ */
+void log_args(const char* format, const uint64_t* args, size_t n);
+
+template<typename T>
+inline uint64_t log_arg(T value){
+    return uint64_t(value);
+}
+
+template<typename T>
+inline uint64_t log_arg(T* value){
+    return reinterpret_cast<uint64_t>(value);
+}
+
+void log_message(log_level level, const char* s);
+
+inline void log(log_level level, const char* s){
+    if(enabled(level)){
+        log_message(level, s);
+    }
+}
+
+inline void log(log_level level, const std::string& s){
+    if(enabled(level)){
+        log_message(level, s.c_str());
+    }
+}
+
 void logf(log_level level, const char* s, va_list va);
-void logf(log_level level, const char* s, ...);
+
+template<typename... Args>
+inline void logf(log_level level, const char* s, Args... args){
+    static_assert(sizeof...(Args) <= max_args, "Too many arguments for logging::logf");
+
+    if(enabled(level)){
+        uint64_t values[sizeof...(Args) + 1] = {log_arg(args)...};
+        log_args(level, s, values, sizeof...(Args));
+    }
+}
 
 void log(const char* s);
 void log(const std::string& s);
 void logf(const char* s, va_list va);
-void logf(const char* s, ...);
+
+template<typename... Args>
+inline void logf(const char* s, Args... args){
+    static_assert(sizeof...(Args) <= max_args, "Too many arguments for logging::logf");
+
+    uint64_t values[sizeof...(Args) + 1] = {log_arg(args)...};
+    log_args(s, values, sizeof...(Args));
+}
 
 } //end of namespace logging
 
@@ -9,13 +9,14 @@
 #define NET_ARP_CACHE_H
 
 #include <types.hpp>
-#include <vector.hpp>
+#include <array.hpp>
 #include <expected.hpp>
 
 #include "tlib/net_constants.hpp"
 
 #include "net/ip_layer.hpp"
 #include "net/interface.hpp"
+#include "net/packet.hpp"
 
 namespace network {
 
@@ -27,28 +28,51 @@ namespace arp {
 
 struct layer;
 
+constexpr const uint64_t unresolved_mac = 0x0; ///< The destination of the frames prepared before the resolution of their target
+
+constexpr const size_t cache_entries   = 128;   ///< The number of neighbours in the cache
+constexpr const size_t cache_buckets   = 64;    ///< The number of hash buckets
+constexpr const size_t max_parked      = 8;     ///< The maximum number of packets waiting for a resolution
+constexpr const size_t request_timeout = 1000;  ///< The time to wait for a reply before sending the request again, in ms
+constexpr const size_t max_requests    = 3;     ///< The number of requests sent before giving up
+constexpr const size_t reachable_time  = 60000; ///< The time a resolved address is used before being resolved again, in ms
+constexpr const size_t failed_time     = 3000;  ///< The time a failed resolution is remembered, in ms
+
 /*!
- * \brief An entry in the ARP cache
+ * \brief The state of a neighbour
  */
-struct cache_entry {
-    uint64_t mac;            ///< The MAC address
-    network::ip::address ip; ///< The IP address
-
-    /*!
-     * \brief Construct a new empty cache entry
-     */
-    cache_entry(){}
+enum class entry_state {
+    EMPTY,      ///< The entry is not used
+    INCOMPLETE, ///< A request is in flight, the packets are parked
+    REACHABLE,  ///< The MAC address is known
+    FAILED      ///< The neighbour did not answer
+};
 
-    /*!
-     * \brief Construct a new cache entry
-     * \param mac The MAC address
-     * \param ip The IP address
-     */
-    cache_entry(uint64_t mac, network::ip::address ip) : mac(mac), ip(ip) {}
+/*!
+ * \brief A neighbour in the ARP cache
+ */
+struct cache_entry {
+    network::ip::address ip;   ///< The IP address
+    uint64_t mac;              ///< The MAC address (REACHABLE)
+    entry_state state;         ///< The state of the entry
+    uint64_t expires;          ///< The time at which the state expires, in ms
+    uint64_t last_used;        ///< The last time the entry was used, in ms
+    size_t interface;          ///< The interface of the requests
+    size_t requests;           ///< The number of requests sent for the resolution
+    uint64_t deadline;         ///< The time at which the request is sent again (INCOMPLETE)
+
+    std::array<network::packet_p, max_parked> parked; ///< The packets waiting for the resolution
+    size_t parked_count;                              ///< The number of parked packets
+
+    cache_entry* next; ///< The next entry in the bucket (or in the free list)
 };
 
 /*!
- * \brief An ARP cache
+ * \brief An ARP cache.
+ *
+ * The neighbours are hashed by IP address. The packets sent to a neighbour
+ * being resolved are parked in its entry and sent when the reply arrives,
+ * only one request is in flight for each neighbour.
  */
 struct cache {
     /*!
@@ -59,66 +83,73 @@ struct cache {
     cache(network::arp::layer* layer, network::ethernet::layer* parent);
 
     /*!
-     * \brief Update the cache entry for the given MAC address
+     * \brief Update the cache entry for the given IP address and send
+     * the packets parked for it.
      * \param mac The MAC address
      * \param ip The IP address
+     * \param create Indicates if the entry must be created if it does not exist
      */
-    void update_cache(uint64_t mac, network::ip::address ip);
+    void update_cache(uint64_t mac, network::ip::address ip, bool create);
 
     /*!
-     * \brief Indicates if the given MAC address is cached or not
+     * \brief Indicates if the given IP address is resolved or not
      */
-    bool is_mac_cached(uint64_t mac) const ;
-
-    /*!
-     * \brief Indicates if the given IP address is cached or not
-     */
-    bool is_ip_cached(network::ip::address ip) const ;
-
-    /*!
-     * \brief Returns the IP address of the given MAC address.
-     * The address must be in cache.
-     * \param ip The MAC address to look for in the cache
-     * \return The IP address of the MAC address
-     */
-    network::ip::address get_ip(uint64_t mac) const ;
+    bool is_ip_cached(network::ip::address ip);
 
     /*!
      * \brief Returns the MAC address of the given IP address.
-     * The address must be in cache.
+     * The address must be resolved.
      * \param ip The IP address to look for in the cache
      * \return The MAC address of the IP address
      */
-    uint64_t get_mac(network::ip::address ip) const ;
+    uint64_t get_mac(network::ip::address ip);
 
     /*!
-     * \brief Returns the MAC address of the given IP address. If the
-     * address is not cached a request will be generated and it will
-     * wait for the answer (may stall indefinitely).
+     * \brief Returns the MAC address of the given IP address, without waiting.
+     *
+     * If the address is not resolved, a request is sent (unless one is
+     * already in flight) and unresolved_mac is returned. The packet must
+     * then be given to park() instead of being sent.
+     *
      * \param interface The network interface to use
      * \param ip The IP address to look for in the cache
-     * \return The MAC address of the IP address
+     * \return The MAC address of the IP address, unresolved_mac or an error if the neighbour did not answer
      */
-    std::expected<uint64_t> get_mac_force(network::interface_descriptor& interface, network::ip::address ip);
+    std::expected<uint64_t> resolve(network::interface_descriptor& interface, network::ip::address ip);
 
     /*!
-     * \brief Returns the MAC address of the given IP address. If the
-     * address is not cached a request will be generated and it will
-     * wait for the answer or until the timeout (in ms) is reached.
+     * \brief Send a packet prepared for an unresolved address once the
+     * address is resolved. When too many packets are parked, the oldest
+     * one is dropped.
      * \param interface The network interface to use
-     * \param ip The IP address to look for in the cache
-     * \param ms The maximum time, in milliseconds, to wait
-     * \return The MAC address of the IP address
+     * \param ip The IP address of the neighbour
+     * \param packet The packet to send (finalized by the upper layers)
+     * \return nothing or an error if the neighbour cannot be resolved
+     */
+    std::expected<void> park(network::interface_descriptor& interface, network::ip::address ip, network::packet_p& packet);
+
+    /*!
+     * \brief Send the requests again and give up on the neighbours that
+     * did not answer. Must be called periodically.
      */
-    std::expected<uint64_t> get_mac_force(network::interface_descriptor& interface, network::ip::address ip, size_t ms);
+    void timer();
 
 private:
     std::expected<void> arp_request(network::interface_descriptor& interface, network::ip::address ip);
 
+    cache_entry* find_entry(network::ip::address ip);
+    cache_entry* new_entry(network::ip::address ip, uint64_t now);
+    void unlink_entry(cache_entry* entry);
+    void enqueue_packet(cache_entry& entry, network::packet_p& packet);
+    void send_resolved(network::packet_p& packet, uint64_t mac);
+
     network::arp::layer* arp_layer; ///< The ARP layer
     network::ethernet::layer* ethernet_layer; ///< The ethernet layer
 
-    std::vector<cache_entry> mac_cache; ///< The cache of MAC addresses
+    std::array<cache_entry, cache_entries> entries;  ///< The neighbours
+    std::array<cache_entry*, cache_buckets> buckets; ///< The hash buckets
+    cache_entry* free_entries = nullptr;             ///< The unused entries
+    size_t incomplete = 0;                           ///< The number of entries being resolved
 };
 
 } // end of arp namespace
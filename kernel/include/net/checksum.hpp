@@ -12,21 +12,147 @@
 
 namespace network {
 
+/*!
+ * \brief Fold a 64-bit ones-complement sum into 16 bits
+ */
+inline uint16_t checksum_fold(uint64_t sum){
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return sum;
+}
+
+/*!
+ * \brief Add a 64-bit word to a ones-complement sum, with end-around carry
+ */
+inline uint64_t checksum_add_word(uint64_t sum, uint64_t word){
+    sum += word;
+    return sum + (sum < word);
+}
+
+/*!
+ * \brief Compute the ones-complement sum of a buffer, in the byte order of
+ * the machine.
+ *
+ * The sum is computed 64 bits at a time, 32 bytes per iteration. Since
+ * the ones-complement sum does not depend on the byte order, only the
+ * folded result needs to be swapped.
+ */
+inline uint16_t checksum_native(const void* buffer, size_t length){
+    auto* bytes = static_cast<const uint8_t*>(buffer);
+
+    uint64_t sum = 0;
+
+    while(length >= 32){
+        uint64_t w[4];
+        __builtin_memcpy(w, bytes, 32);
+
+        sum = checksum_add_word(sum, w[0]);
+        sum = checksum_add_word(sum, w[1]);
+        sum = checksum_add_word(sum, w[2]);
+        sum = checksum_add_word(sum, w[3]);
+
+        bytes += 32;
+        length -= 32;
+    }
+
+    while(length >= 8){
+        uint64_t w;
+        __builtin_memcpy(&w, bytes, 8);
+
+        sum = checksum_add_word(sum, w);
+
+        bytes += 8;
+        length -= 8;
+    }
+
+    if(length >= 4){
+        uint32_t w;
+        __builtin_memcpy(&w, bytes, 4);
+
+        sum = checksum_add_word(sum, w);
+
+        bytes += 4;
+        length -= 4;
+    }
+
+    if(length >= 2){
+        uint16_t w;
+        __builtin_memcpy(&w, bytes, 2);
+
+        sum = checksum_add_word(sum, w);
+
+        bytes += 2;
+        length -= 2;
+    }
+
+    // The last odd byte is the high byte of a network-order word
+    if(length){
+        sum = checksum_add_word(sum, *bytes);
+    }
+
+    return checksum_fold(sum);
+}
+
+/*!
+ * \brief Compute the ones-complement sum of a buffer, as network-order
+ * 16-bit words. The result can be accumulated with other sums before
+ * checksum_finalize.
+ */
 template<typename T>
 uint32_t checksum_add_bytes(T* values, size_t length){
-    auto raw_values = reinterpret_cast<uint8_t*>(values);
+    return __builtin_bswap16(checksum_native(values, length));
+}
+
+/*!
+ * \brief Copy a buffer and compute its ones-complement sum in the same pass
+ * \return The sum, as network-order 16-bit words (see checksum_add_bytes)
+ */
+inline uint32_t checksum_copy(char* destination, const char* source, size_t length){
+    uint64_t sum = 0;
+
+    while(length >= 32){
+        uint64_t w[4];
+        __builtin_memcpy(w, source, 32);
+        __builtin_memcpy(destination, w, 32);
+
+        sum = checksum_add_word(sum, w[0]);
+        sum = checksum_add_word(sum, w[1]);
+        sum = checksum_add_word(sum, w[2]);
+        sum = checksum_add_word(sum, w[3]);
+
+        source += 32;
+        destination += 32;
+        length -= 32;
+    }
+
+    while(length >= 8){
+        uint64_t w;
+        __builtin_memcpy(&w, source, 8);
+        __builtin_memcpy(destination, &w, 8);
+
+        sum = checksum_add_word(sum, w);
 
-    uint32_t sum = 0;
+        source += 8;
+        destination += 8;
+        length -= 8;
+    }
+
+    auto native = checksum_fold(sum);
+
+    // The remaining bytes start at an even offset
+    auto tail = checksum_native(source, length);
 
     for(size_t i = 0; i < length; ++i){
-        if(i & 1){
-            sum += static_cast<uint32_t>(raw_values[i]);
-        } else {
-            sum += static_cast<uint32_t>(raw_values[i]) << 8;
-        }
+        destination[i] = source[i];
     }
 
-    return sum;
+    uint32_t total = uint32_t(native) + tail;
+
+    return __builtin_bswap16(checksum_fold(total));
 }
 
 inline uint16_t checksum_finalize(uint32_t sum){
@@ -47,6 +173,30 @@ inline uint16_t checksum_finalize_nz(uint32_t sum){
     }
 }
 
+/*!
+ * \brief Update a checksum after a 16-bit field changed (RFC 1624).
+ *
+ * The checksum and the values must be in the same byte order, for instance
+ * as stored in the header.
+ */
+inline uint16_t checksum_update(uint16_t checksum, uint16_t old_value, uint16_t new_value){
+    uint32_t sum = uint16_t(~checksum) + uint32_t(uint16_t(~old_value)) + new_value;
+
+    return checksum_finalize(sum);
+}
+
+/*!
+ * \brief Update a checksum after a 32-bit field changed (RFC 1624)
+ */
+inline uint16_t checksum_update_32(uint16_t checksum, uint32_t old_value, uint32_t new_value){
+    uint32_t sum = uint16_t(~checksum);
+
+    sum += uint16_t(~old_value) + uint32_t(uint16_t(~(old_value >> 16)));
+    sum += (new_value & 0xFFFF) + (new_value >> 16);
+
+    return checksum_finalize(sum);
+}
+
 } // end of network namespace
 
 #endif
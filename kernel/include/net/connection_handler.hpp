@@ -12,55 +12,58 @@
 
 #include "conc/rw_lock.hpp"
 
+#include "tlib/net_constants.hpp"
+
 namespace network {
 
 /*!
  * \brief A thread-safe collection of network connection (UDP/TCP)
+ *
+ * The connections are demultiplexed with two hash tables: the connected
+ * connections are indexed by (local port, remote address, remote port) and
+ * the servers by their local port. A connection is only visible to the
+ * demultiplexing once it has been bound.
  */
 template <typename C>
 struct connection_handler {
     using connection_type = C; ///< The type of connnection
 
     /*!
-     * \brief Get the first connection matching the packet ports
+     * \brief Get the connection matching the packet, or the server
+     * listening on its target port.
      */
-    connection_type* get_connection_for_packet(size_t source_port, size_t target_port) {
+    connection_type* get_connection_for_packet(network::ip::address source_address, size_t source_port, size_t target_port) {
         auto lock = connections_lock.reader_lock();
         std::lock_guard<reader_rw_lock> l(lock);
 
-        for (auto& connection : connections) {
-            if(connection.server){
-                if (connection.server_port == target_port) {
-                    return &connection;
-                }
-            } else {
-                if (connection.server_port == source_port && connection.local_port == target_port) {
-                    return &connection;
-                }
-            }
-        }
+        return find_connection(source_address, source_port, target_port);
+    }
 
-        return nullptr;
+    /*!
+     * \brief Execute a functor for the connection matching the packet, or
+     * the server listening on its target port. The collection cannot be
+     * modified during the execution of the functor.
+     */
+    template<typename Functor>
+    void for_each_connection_for_packet(network::ip::address source_address, size_t source_port, size_t target_port, Functor fun){
+        auto lock = connections_lock.reader_lock();
+        std::lock_guard<reader_rw_lock> l(lock);
+
+        if (auto* connection = find_connection(source_address, source_port, target_port)) {
+            fun(*connection);
+        }
     }
 
     /*!
-     * \brief Execute a functor for each connection matcing the packet ports
+     * \brief Apply the functor to each connection
      */
     template<typename Functor>
-    void for_each_connection_for_packet(size_t source_port, size_t target_port, Functor fun){
+    void for_each_connection(Functor fun){
         auto lock = connections_lock.reader_lock();
         std::lock_guard<reader_rw_lock> l(lock);
 
-        for (auto& connection : connections) {
-            if(connection.server){
-                if (connection.server_port == target_port) {
-                    fun(connection);
-                }
-            } else {
-                if (connection.server_port == source_port && connection.local_port == target_port) {
-                    fun(connection);
-                }
-            }
+        for (auto& node : connections) {
+            fun(node.connection);
         }
     }
 
@@ -71,7 +74,28 @@ struct connection_handler {
         auto lock = connections_lock.writer_lock();
         std::lock_guard<writer_rw_lock> l(lock);
 
-        return connections.emplace_back();
+        return connections.emplace_back().connection;
+    }
+
+    /*!
+     * \brief Make the connection visible to the demultiplexing, once its
+     * ports and address are set.
+     */
+    void bind_connection(connection_type& connection) {
+        auto lock = connections_lock.writer_lock();
+        std::lock_guard<writer_rw_lock> l(lock);
+
+        auto& n = node_of(connection);
+
+        if (n.bound) {
+            return;
+        }
+
+        auto& head = bucket_of(connection);
+
+        n.next  = head;
+        n.bound = true;
+        head    = &n;
     }
 
     /*!
@@ -81,11 +105,23 @@ struct connection_handler {
         auto lock = connections_lock.writer_lock();
         std::lock_guard<writer_rw_lock> l(lock);
 
+        auto& n = node_of(connection);
+
+        if (n.bound) {
+            auto* it = &bucket_of(connection);
+
+            while (*it != &n) {
+                it = &(*it)->next;
+            }
+
+            *it = n.next;
+        }
+
         auto end = connections.end();
         auto it  = connections.begin();
 
         while (it != end) {
-            if (&(*it) == &connection) {
+            if (&(*it) == &n) {
                 connections.erase(it);
                 return;
             }
@@ -95,9 +131,62 @@ struct connection_handler {
     }
 
 private:
+    static constexpr const size_t connection_buckets = 256; ///< The number of buckets for the connected connections (8 bits of hash)
+    static constexpr const size_t server_buckets     = 64;  ///< The number of buckets for the servers
+
+    /*!
+     * \brief A connection and its link in the hash tables
+     */
+    struct node {
+        connection_type connection; ///< The connection (must be the first member)
+        node* next = nullptr;       ///< The next node in the same bucket
+        bool bound = false;         ///< Indicates if the node is in a bucket
+    };
+
+    static node& node_of(connection_type& connection){
+        // The connection is the first member of its node
+        return *reinterpret_cast<node*>(&connection);
+    }
+
+    static size_t connection_hash(size_t local_port, network::ip::address remote_address, size_t remote_port){
+        auto h = (local_port << 16 | remote_port) ^ remote_address.raw_address;
+
+        // Fibonacci hashing, the ports of a server only differ in their low bits
+        return (uint32_t(h) * 2654435761U) >> 24;
+    }
+
+    node*& bucket_of(connection_type& connection){
+        if (connection.server) {
+            return servers[connection.server_port % server_buckets];
+        } else {
+            return buckets[connection_hash(connection.local_port, connection.server_address, connection.server_port)];
+        }
+    }
+
+    connection_type* find_connection(network::ip::address source_address, size_t source_port, size_t target_port){
+        for (auto* n = buckets[connection_hash(target_port, source_address, source_port)]; n; n = n->next) {
+            auto& connection = n->connection;
+
+            if (connection.local_port == target_port && connection.server_port == source_port && connection.server_address == source_address) {
+                return &connection;
+            }
+        }
+
+        for (auto* n = servers[target_port % server_buckets]; n; n = n->next) {
+            if (n->connection.server_port == target_port) {
+                return &n->connection;
+            }
+        }
+
+        return nullptr;
+    }
+
     rw_lock connections_lock; ///< The Readers/Writer lock
 
-    std::list<connection_type> connections; ///< The list of connections
+    std::list<node> connections; ///< The list of connections
+
+    node* buckets[connection_buckets] = {}; ///< The connected connections, by local port and remote endpoint
+    node* servers[server_buckets]     = {}; ///< The servers, by local port
 };
 
 } // end of network namespace
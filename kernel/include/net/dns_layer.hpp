@@ -70,7 +70,27 @@ struct layer {
      */
     std::expected<void> finalize_packet(network::interface_descriptor& interface, network::socket& sock, network::packet_p& p);
 
+    /*!
+     * \brief Resolve the address of a domain name.
+     *
+     * The answers are cached according to their TTL, including the negative
+     * ones. Concurrent resolutions of the same name share a single query.
+     *
+     * \param name The domain name
+     * \param length The length of the domain name
+     * \param server The DNS server to query on a cache miss
+     * \param timeout_ms The time to wait for each try
+     * \param tries The number of queries to send before giving up
+     * \return the address or an error
+     */
+    std::expected<network::ip::address> resolve(const char* name, size_t length, network::ip::address server, size_t timeout_ms, size_t tries);
+
 private:
+    /*!
+     * \brief Send a query for the given name
+     */
+    std::expected<void> send_query(const char* name, size_t length, uint16_t identification, network::ip::address server);
+
     network::udp::layer* parent; ///< The parent layer
 };
 
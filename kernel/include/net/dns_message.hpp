@@ -0,0 +1,332 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef NET_DNS_MESSAGE_H
+#define NET_DNS_MESSAGE_H
+
+#include <types.hpp>
+
+/*
+ * Encoding of DNS queries and decoding of DNS responses, on raw buffers.
+ *
+ * Everything is bounds-checked against the length of the message since the
+ * responses come from the network.
+ */
+
+namespace network {
+
+namespace dns {
+
+constexpr const size_t max_name_length = 253; ///< The maximum length of a dotted domain name
+constexpr const size_t header_length   = 12;  ///< The length of the DNS header
+constexpr const size_t max_pointers    = 16;  ///< The maximum compression pointers followed in a name
+
+constexpr const uint16_t type_a     = 1;  ///< A record
+constexpr const uint16_t type_cname = 5;  ///< CNAME record
+constexpr const uint16_t type_soa   = 6;  ///< SOA record
+constexpr const uint16_t class_in   = 1;  ///< Internet class
+
+constexpr const uint8_t rcode_ok       = 0; ///< No error
+constexpr const uint8_t rcode_nxdomain = 3; ///< The name does not exist
+
+/*!
+ * \brief The information extracted from a DNS response
+ */
+struct response_info {
+    uint16_t identification = 0; ///< The identification of the response
+    uint8_t rcode           = 0; ///< The response code
+    bool address_found      = false; ///< Indicates if an A record was found
+    uint32_t address        = 0; ///< The address (a << 24 | b << 16 | c << 8 | d)
+    uint32_t ttl            = 0; ///< The TTL of the address, in seconds
+    bool soa_found          = false; ///< Indicates if a SOA record was found in the authority section
+    uint32_t negative_ttl   = 0; ///< The negative TTL given by the SOA record, in seconds
+};
+
+inline uint16_t read_16(const uint8_t* bytes){
+    return (uint16_t(bytes[0]) << 8) | bytes[1];
+}
+
+inline uint32_t read_32(const uint8_t* bytes){
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+}
+
+inline void write_16(uint8_t* bytes, uint16_t value){
+    bytes[0] = value >> 8;
+    bytes[1] = value & 0xFF;
+}
+
+inline char to_lower(char c){
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+/*!
+ * \brief Indicates if two names are equal, ignoring the case
+ */
+inline bool names_equal(const char* a, size_t a_length, const char* b, size_t b_length){
+    if(a_length != b_length){
+        return false;
+    }
+
+    for(size_t i = 0; i < a_length; ++i){
+        if(to_lower(a[i]) != to_lower(b[i])){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Indicates if the given dotted name can be sent in a query
+ */
+inline bool valid_name(const char* name, size_t length){
+    if(!length || length > max_name_length){
+        return false;
+    }
+
+    size_t label = 0;
+
+    for(size_t i = 0; i < length; ++i){
+        if(name[i] == '.'){
+            if(!label){
+                return false;
+            }
+
+            label = 0;
+        } else if(++label > 63){
+            return false;
+        }
+    }
+
+    return label > 0;
+}
+
+/*!
+ * \brief Encode a query for the A record of the given name
+ * \param buffer The buffer to write the query in
+ * \param size The size of the buffer
+ * \return The length of the query, 0 if it does not fit or if the name is invalid
+ */
+inline size_t encode_query(char* buffer, size_t size, uint16_t identification, const char* name, size_t length){
+    // Header, labels (one length byte more than the dots), root label, type and class
+    auto total = header_length + length + 2 + 4;
+
+    if(!valid_name(name, length) || total > size){
+        return 0;
+    }
+
+    auto* bytes = reinterpret_cast<uint8_t*>(buffer);
+
+    write_16(bytes, identification);
+    write_16(bytes + 2, 0x0100); // Standard query, recursion desired
+    write_16(bytes + 4, 1);      // One question
+    write_16(bytes + 6, 0);
+    write_16(bytes + 8, 0);
+    write_16(bytes + 10, 0);
+
+    auto* label_length = bytes + header_length;
+    auto* out          = label_length + 1;
+
+    *label_length = 0;
+
+    for(size_t i = 0; i < length; ++i){
+        if(name[i] == '.'){
+            label_length = out++;
+            *label_length = 0;
+        } else {
+            *out++ = name[i];
+            ++*label_length;
+        }
+    }
+
+    *out++ = 0;
+
+    write_16(out, type_a);
+    write_16(out + 2, class_in);
+
+    return total;
+}
+
+/*!
+ * \brief Read a possibly compressed name at the given offset.
+ *
+ * \param offset The offset of the name, set to the offset after the name in the record
+ * \param name The buffer for the dotted name (at least max_name_length + 1 bytes)
+ * \param name_length Set to the length of the dotted name
+ * \return true if the name is valid, false otherwise
+ */
+inline bool read_name(const uint8_t* message, size_t length, size_t& offset, char* name, size_t& name_length){
+    size_t position = offset;
+    size_t pointers = 0;
+    bool jumped     = false;
+
+    name_length = 0;
+
+    while(true){
+        if(position >= length){
+            return false;
+        }
+
+        uint8_t label = message[position];
+
+        if((label & 0xC0) == 0xC0){
+            if(position + 1 >= length || ++pointers > max_pointers){
+                return false;
+            }
+
+            if(!jumped){
+                offset = position + 2;
+                jumped = true;
+            }
+
+            position = ((label & 0x3F) << 8) | message[position + 1];
+            continue;
+        }
+
+        if(label & 0xC0){
+            return false;
+        }
+
+        ++position;
+
+        if(!label){
+            break;
+        }
+
+        if(position + label > length || name_length + (name_length ? 1 : 0) + label > max_name_length){
+            return false;
+        }
+
+        if(name_length){
+            name[name_length++] = '.';
+        }
+
+        for(size_t i = 0; i < label; ++i){
+            name[name_length++] = to_lower(message[position + i]);
+        }
+
+        position += label;
+    }
+
+    if(!jumped){
+        offset = position;
+    }
+
+    name[name_length] = '\0';
+
+    return true;
+}
+
+/*!
+ * \brief Skip a possibly compressed name
+ * \return true if the name is valid, false otherwise
+ */
+inline bool skip_name(const uint8_t* message, size_t length, size_t& offset){
+    char name[max_name_length + 1];
+    size_t name_length;
+
+    return read_name(message, length, offset, name, name_length);
+}
+
+/*!
+ * \brief Decode the response to an A query for the given name.
+ *
+ * The first A record of the answers is used, following the CNAME records,
+ * with the smallest TTL of the chain. A SOA record in the authority section
+ * gives the TTL of negative answers.
+ *
+ * \return true if the message is a valid response for the name, false otherwise
+ */
+inline bool decode_response(const char* buffer, size_t length, const char* name, size_t name_length, response_info& info){
+    auto* message = reinterpret_cast<const uint8_t*>(buffer);
+
+    if(length < header_length){
+        return false;
+    }
+
+    info.identification = read_16(message);
+
+    auto flags          = read_16(message + 2);
+    auto questions      = read_16(message + 4);
+    auto answers        = read_16(message + 6);
+    auto authority_rrs  = read_16(message + 8);
+
+    // Only responses to a single question are expected
+    if(!(flags & 0x8000) || questions != 1){
+        return false;
+    }
+
+    info.rcode = flags & 0xF;
+
+    size_t offset = header_length;
+
+    char record_name[max_name_length + 1];
+    size_t record_name_length;
+
+    // The question must be the one that was asked
+
+    if(!read_name(message, length, offset, record_name, record_name_length) || offset + 4 > length){
+        return false;
+    }
+
+    if(!names_equal(record_name, record_name_length, name, name_length) || read_16(message + offset) != type_a || read_16(message + offset + 2) != class_in){
+        return false;
+    }
+
+    offset += 4;
+
+    uint32_t ttl = 0xFFFFFFFF;
+
+    for(size_t i = 0; i < size_t(answers) + authority_rrs; ++i){
+        if(!skip_name(message, length, offset) || offset + 10 > length){
+            return false;
+        }
+
+        auto type        = read_16(message + offset);
+        auto rr_class    = read_16(message + offset + 2);
+        auto rr_ttl      = read_32(message + offset + 4);
+        auto data_length = read_16(message + offset + 8);
+
+        offset += 10;
+
+        if(offset + data_length > length){
+            return false;
+        }
+
+        if(rr_class == class_in){
+            if(i < answers){
+                if(type == type_cname){
+                    ttl = rr_ttl < ttl ? rr_ttl : ttl;
+                } else if(type == type_a && data_length == 4 && !info.address_found){
+                    info.address_found = true;
+                    info.address       = read_32(message + offset);
+                    info.ttl           = rr_ttl < ttl ? rr_ttl : ttl;
+                }
+            } else if(type == type_soa && !info.soa_found){
+                // The minimum field is the last of the SOA record
+                size_t soa = offset;
+
+                if(skip_name(message, length, soa) && skip_name(message, length, soa) && soa + 20 <= offset + data_length){
+                    auto minimum = read_32(message + soa + 16);
+
+                    info.soa_found    = true;
+                    info.negative_ttl = minimum < rr_ttl ? minimum : rr_ttl;
+                }
+            }
+        }
+
+        offset += data_length;
+    }
+
+    return true;
+}
+
+} // end of dns namespace
+
+} // end of network namespace
+
+#endif
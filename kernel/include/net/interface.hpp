@@ -11,10 +11,9 @@
 #include <types.hpp>
 #include <string.hpp>
 #include <lock_guard.hpp>
-#include <shared_ptr.hpp>
-#include <queue.hpp>
 
 #include "conc/mutex.hpp"
+#include "conc/spsc_ring.hpp"
 #include "conc/semaphore.hpp"
 #include "conc/deferred_unique_semaphore.hpp"
 
@@ -46,22 +45,101 @@ struct interface_descriptor {
     size_t tx_packets_counter = 0; ///< Counter of transmitted packets
     size_t tx_bytes_counter   = 0; ///< Counter of transmitted bytes
 
-    mutable mutex tx_lock;                    ///< Mutex protecting the queues
+    size_t rx_drops     = 0; ///< Counter of received packets dropped because the RX ring was full
+    size_t tx_drops     = 0; ///< Counter of packets dropped because the TX ring was full
+    size_t rx_queue_max = 0; ///< The maximum depth reached by the RX ring
+    size_t tx_queue_max = 0; ///< The maximum depth reached by the TX ring
+
+    size_t rx_interrupts = 0;  ///< Counter of RX interrupts that scheduled a poll
+    size_t rx_polls      = 0;  ///< Counter of poll rounds run by the RX thread
+    size_t poll_budget   = 64; ///< The maximum number of packets handled by a poll round
+
+    volatile bool poll_scheduled = false; ///< Indicates if the RX thread must poll the driver
+
+    mutable mutex tx_lock;                    ///< Mutex serializing the producers of the TX ring
     mutable semaphore tx_sem;                 ///< Semaphore for transmission
     mutable deferred_unique_semaphore rx_sem; ///< Semaphore for reception
 
-    std::queue<network::packet_p> rx_queue;
-    std::queue<network::packet_p> tx_queue;
+    spsc_ring<network::packet_p, 256> rx_ring; ///< The received packets (driver -> RX thread)
+    spsc_ring<network::packet_p, 256> tx_ring; ///< The packets to transmit (senders -> TX thread)
 
     void (*hw_send)(interface_descriptor&, packet_p& p); ///< Driver hardware send function
 
+    /*!
+     * \brief Driver poll function, nullptr if the driver pushes the packets from its IRQ handler.
+     *
+     * Called by the RX thread with the RX interrupts masked, it must give at
+     * most budget packets to the deliver function and return their number.
+     */
+    size_t (*hw_poll)(interface_descriptor&, size_t budget, void (*deliver)(interface_descriptor&, packet_p& p)) = nullptr;
+
+    void (*hw_poll_complete)(interface_descriptor&) = nullptr; ///< Driver function re-enabling the RX interrupts after a poll
+
     /*!
      * \brief Send a packet through this interface
      */
     void send(packet_p& p){
-        std::lock_guard<mutex> l(tx_lock);
-        tx_queue.push(p);
-        tx_sem.unlock();
+        size_t depth;
+        bool pushed;
+
+        {
+            std::lock_guard<mutex> l(tx_lock);
+            pushed = tx_ring.push(p, depth);
+        }
+
+        if(!pushed){
+            ++tx_drops;
+            return;
+        }
+
+        if(depth > tx_queue_max){
+            tx_queue_max = depth;
+        }
+
+        // The TX thread drains the whole ring on each wake up
+        if(depth == 1){
+            tx_sem.unlock();
+        }
+    }
+
+    /*!
+     * \brief Give a received packet to the RX thread.
+     *
+     * This must be called by the driver from its IRQ handler, or with the
+     * interrupts disabled, so that there is a single producer at a time.
+     */
+    void receive(packet_p& p){
+        size_t depth;
+
+        if(!rx_ring.push(p, depth)){
+            ++rx_drops;
+            return;
+        }
+
+        if(depth > rx_queue_max){
+            rx_queue_max = depth;
+        }
+
+        // The RX thread drains the whole ring on each wake up
+        if(depth == 1){
+            rx_sem.notify();
+        }
+    }
+
+    /*!
+     * \brief Let the RX thread poll the driver.
+     *
+     * This must be called by the driver from its IRQ handler, after masking
+     * its RX interrupts. They are re-enabled by hw_poll_complete once the
+     * driver has no more packets.
+     */
+    void schedule_poll(){
+        ++rx_interrupts;
+
+        if(!poll_scheduled){
+            poll_scheduled = true;
+            rx_sem.notify();
+        }
     }
 
     /*!
@@ -123,6 +123,49 @@ std::expected<size_t> receive_from(socket_fd_t socket_fd, char* buffer, size_t n
  */
 std::expected<size_t> receive_from(socket_fd_t socket_fd, char* buffer, size_t n, size_t ms, void* address);
 
+/*!
+ * \brief Send several datagrams at once
+ * \param socket_fd The file descriptor of the socket
+ * \param addressed Indicates if the datagrams are sent to their address or to the connected server
+ * \return the number of sent datagrams on success and a negative error code otherwise
+ */
+std::expected<size_t> send_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n, char* target_buffer, bool addressed);
+
+/*!
+ * \brief Receive several datagrams at once, waiting only for the first one
+ * \param socket_fd The file descriptor of the socket
+ * \return the number of received datagrams on success and a negative error code otherwise
+ */
+std::expected<size_t> receive_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n);
+
+/*!
+ * \brief Receive several datagrams at once, waiting at most ms milliseconds for the first one
+ * \param socket_fd The file descriptor of the socket
+ * \return the number of received datagrams on success and a negative error code otherwise
+ */
+std::expected<size_t> receive_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n, size_t ms);
+
+/*!
+ * \brief Create the packet ring of a socket and map it in the process
+ * \param socket_fd The file descriptor of the socket
+ * \return the address of the ring on success and a negative error code otherwise
+ */
+std::expected<size_t> open_ring(socket_fd_t socket_fd);
+
+/*!
+ * \brief Send the slots of the packet ring of the socket that were filled by the process
+ * \param socket_fd The file descriptor of the socket
+ * \return the number of sent slots on success and a negative error code otherwise
+ */
+std::expected<size_t> ring_send(socket_fd_t socket_fd);
+
+/*!
+ * \brief Wait for a free slot in the packet ring of the socket
+ * \param socket_fd The file descriptor of the socket
+ * \return 0 on success and a negative error code otherwise
+ */
+std::expected<void> ring_wait(socket_fd_t socket_fd);
+
 /*!
  * \brief Listen to a socket or not
  * \param socket_fd The file descriptor of the packet
@@ -221,6 +264,12 @@ std::expected<size_t> wait_for_packet(char* buffer, socket_fd_t socket_fd);
  */
 std::expected<size_t> wait_for_packet(char* buffer, socket_fd_t socket_fd, size_t ms);
 
+/*!
+ * \brief Returns the current readiness of the socket
+ * \return A combination of the poll events (POLL_IN, POLL_OUT, POLL_HUP)
+ */
+size_t poll_events(network::socket& socket);
+
 /*!
  * \brief Propagate a packet through the raw sockets.
  *
@@ -231,6 +280,17 @@ std::expected<size_t> wait_for_packet(char* buffer, socket_fd_t socket_fd, size_
  */
 void propagate_packet(const packet_p& packet, socket_protocol protocol);
 
+/*!
+ * \brief Resolve the address of a domain name, through the DNS cache
+ * \param name The domain name
+ * \param length The length of the domain name
+ * \param server The DNS server (the default one if the address is zero)
+ * \param timeout_ms The time to wait for each query
+ * \param tries The number of queries to send before giving up
+ * \return the address on success and a negative error code otherwise
+ */
+std::expected<network::ip::address> resolve(const char* name, size_t length, network::ip::address server, size_t timeout_ms, size_t tries);
+
 /*!
  * \brief Return the IP address of the DNS server
  */
@@ -9,12 +9,13 @@
 #define NET_PACKET_H
 
 #include <types.hpp>
-#include <shared_ptr.hpp>
 
 #include "assert.hpp"
 
 namespace network {
 
+constexpr const size_t packet_buffer_size = 2048; ///< The size of a pooled packet buffer
+
 /*!
  * \brief A network packet.
  */
@@ -31,8 +32,11 @@ struct packet {
     uint64_t tags;          ///< Tags of the layer indices
     uint64_t interface;     ///< Id of the interface
 
-    packet() : fd(0), user(false), tags(0) {}
-    packet(char* payload, size_t payload_size) : payload(payload), payload_size(payload_size), index(0), fd(0), user(false), tags(0) {}
+    volatile uint32_t refs; ///< The number of references to the packet
+    bool pooled;            ///< Indicates if the packet comes from the packet pool
+
+    packet() : fd(0), user(false), tags(0), refs(0), pooled(false) {}
+    packet(char* payload, size_t payload_size) : payload(payload), payload_size(payload_size), index(0), fd(0), user(false), tags(0), refs(0), pooled(false) {}
 
     packet(const packet& rhs) = delete;
     packet& operator=(const packet& rhs) = delete;
@@ -56,7 +60,108 @@ struct packet {
     }
 };
 
-using packet_p = std::shared_ptr<packet>;
+/*!
+ * \brief Give back a packet without references to the pool (or to the heap)
+ */
+void release_packet(packet* p);
+
+/*!
+ * \brief An intrusive reference-counted pointer to a packet
+ */
+struct packet_p {
+    packet_p() : ptr(nullptr) {}
+
+    explicit packet_p(packet* p) : ptr(p) {
+        acquire();
+    }
+
+    packet_p(const packet_p& rhs) : ptr(rhs.ptr) {
+        acquire();
+    }
+
+    packet_p(packet_p&& rhs) : ptr(rhs.ptr) {
+        rhs.ptr = nullptr;
+    }
+
+    packet_p& operator=(const packet_p& rhs){
+        if(this != &rhs){
+            release();
+            ptr = rhs.ptr;
+            acquire();
+        }
+
+        return *this;
+    }
+
+    packet_p& operator=(packet_p&& rhs){
+        if(this != &rhs){
+            release();
+            ptr = rhs.ptr;
+            rhs.ptr = nullptr;
+        }
+
+        return *this;
+    }
+
+    ~packet_p(){
+        release();
+    }
+
+    packet* get() const {
+        return ptr;
+    }
+
+    packet& operator*() const {
+        return *ptr;
+    }
+
+    packet* operator->() const {
+        return ptr;
+    }
+
+    explicit operator bool() const {
+        return ptr;
+    }
+
+private:
+    void acquire(){
+        if(ptr){
+            __atomic_add_fetch(&ptr->refs, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    void release(){
+        if(ptr && __atomic_sub_fetch(&ptr->refs, 1, __ATOMIC_ACQ_REL) == 0){
+            release_packet(ptr);
+        }
+
+        ptr = nullptr;
+    }
+
+    packet* ptr; ///< The packet
+};
+
+/*!
+ * \brief Initialize the packet pool
+ */
+void init_packet_pool();
+
+/*!
+ * \brief Allocate a kernel packet.
+ *
+ * The packet is taken from the pool if it fits in a pooled buffer and the
+ * pool is not exhausted, otherwise it is allocated on the heap.
+ *
+ * \param size The size of the payload
+ */
+packet_p make_packet(size_t size);
+
+/*!
+ * \brief Create a packet around a user buffer
+ * \param buffer The user buffer
+ * \param size The size of the payload
+ */
+packet_p make_user_packet(char* buffer, size_t size);
 
 } // end of network namespace
 
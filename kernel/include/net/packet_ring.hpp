@@ -0,0 +1,113 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef NET_PACKET_RING_H
+#define NET_PACKET_RING_H
+
+#include <types.hpp>
+#include <expected.hpp>
+
+#include "tlib/net_constants.hpp"
+
+#include "conc/mutex.hpp"
+#include "conc/wait_queue.hpp"
+
+
+/*
+ * A packet ring is a set of packet buffers mapped both in a process and in
+ * the kernel. The process writes its payloads directly in the slots and sends
+ * all of them with a single system call. The slots stay writable by the
+ * process, so the kernel never trusts them: the payload of a slot is copied
+ * once into a kernel packet, with the headers built by the kernel, and the
+ * slot is given back to the process right away.
+ */
+
+namespace network {
+
+struct socket;
+
+/*!
+ * \brief The kernel side of a packet ring
+ */
+struct packet_ring {
+    size_t physical        = 0; ///< The physical address of the ring
+    size_t virtual_address = 0; ///< The kernel virtual address of the ring
+    size_t user_address    = 0; ///< The virtual address of the ring in the process
+
+    uint64_t sent  = 0;     ///< The number of slots consumed (and given back to the process)
+    size_t senders = 0;     ///< The number of sends in progress on the ring
+    bool closed    = false; ///< Indicates if the socket released the ring
+
+    mutex send_lock;  ///< Serializes the sends (the slots are consumed in order)
+    wait_queue queue; ///< The processes waiting for a free slot
+
+    /*!
+     * \brief Returns the header shared with the process
+     */
+    packet_ring_header& header() const {
+        return *reinterpret_cast<packet_ring_header*>(virtual_address);
+    }
+
+    /*!
+     * \brief Returns the start of the given slot
+     */
+    char* slot(size_t index) const {
+        return reinterpret_cast<char*>(virtual_address + packet_ring_slots_offset + index * packet_ring_slot_size);
+    }
+
+    /*!
+     * \brief Returns the start of the next slot to send
+     */
+    char* next_slot() const {
+        return slot(sent % packet_ring_slots);
+    }
+};
+
+/*!
+ * \brief Create the packet ring of the socket and map it in the current process
+ * \return The address of the ring in the process
+ */
+std::expected<size_t> create_ring(socket& socket);
+
+/*!
+ * \brief Release the packet ring of the socket.
+ *
+ * The memory is only freed once no send is in progress on the ring.
+ *
+ * \param unmap Indicates if the ring must be unmapped from the current process
+ */
+void close_ring(socket& socket, bool unmap);
+
+/*!
+ * \brief Start a send on the ring, waiting for the other sends of the ring.
+ *
+ * The ring is not freed until the matching end_ring_send, even if the socket
+ * is closed in the meantime.
+ */
+void begin_ring_send(packet_ring& ring);
+
+/*!
+ * \brief End a send on the ring, freeing the ring if it was closed
+ */
+void end_ring_send(packet_ring& ring);
+
+/*!
+ * \brief Copy the payload of the next slot of the ring into a kernel packet
+ * and give the slot back to the process.
+ * \param destination The payload of the kernel packet
+ * \param n The size of the payload, validated by the kernel
+ */
+void take_ring_payload(packet_ring& ring, char* destination, size_t n);
+
+/*!
+ * \brief Wait until the ring of the socket has at least one free slot
+ */
+void wait_ring(socket& socket);
+
+} // end of network namespace
+
+#endif
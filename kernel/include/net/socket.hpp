@@ -20,10 +20,14 @@
 
 #include "net/packet.hpp"
 
+#include "poll.hpp"
+
 #include "assert.hpp"
 
 namespace network {
 
+struct packet_ring;
+
 /*!
  * \brief Represent a network socket
  */
@@ -41,6 +45,11 @@ struct socket {
     std::queue<network::packet_p> listen_packets; ///< The packets that wait to be read in listen mode
     condition_variable listen_queue;              ///< Condition variable to wait for packets
 
+    std::vector<poll::poll_set*> pollers; ///< The poll sets watching this socket
+    size_t poll_sequence = 0;             ///< The number of readiness notifications
+
+    network::packet_ring* ring = nullptr; ///< The packet ring (optional)
+
     socket() {}
     socket(size_t id, socket_domain domain, socket_type type, socket_protocol protocol, size_t next_fd, bool listen)
             : id(id), domain(domain), type(type), protocol(protocol), next_fd(next_fd), listen(listen) {}
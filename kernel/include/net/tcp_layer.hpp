@@ -11,8 +11,12 @@
 #include <types.hpp>
 #include <atomic.hpp>
 #include <queue.hpp>
+#include <vector.hpp>
+#include <circular_buffer.hpp>
 
 #include "conc/condition_variable.hpp"
+#include "conc/mutex.hpp"
+#include "conc/wait_queue.hpp"
 
 #include "net/packet.hpp"
 #include "net/connection_handler.hpp"
@@ -27,6 +31,27 @@ struct layer;
 
 namespace tcp {
 
+constexpr const size_t receive_buffer_size = 32 * 1024; ///< The size of the receive buffer of a connection
+
+/*!
+ * \brief A range of sequence numbers received out of order
+ */
+struct tcp_range {
+    uint32_t start; ///< The first sequence number
+    uint32_t end;   ///< The sequence number after the last one
+};
+
+/*!
+ * \brief A data segment waiting to be acknowledged
+ */
+struct tcp_segment {
+    network::packet_p packet; ///< A kernel copy of the segment
+    uint32_t seq;             ///< The sequence number of the first byte
+    uint32_t len;             ///< The number of data bytes
+    uint64_t sent;            ///< The time (ms) of the last transmission
+    bool retransmitted;       ///< Indicates if the segment was sent more than once
+};
+
 /*!
  * \brief A TCP connection
  */
@@ -48,9 +73,39 @@ struct tcp_connection {
 
     uint32_t fina_ack_number = 0; ///< The next ack number (from finalize)
     uint32_t fina_seq_number = 0; ///< The next sequence number (from finalize)
+    uint32_t fina_window     = 0; ///< The window advertised by the peer (from finalize)
 
     network::socket* socket = nullptr; ///< Pointer to the user socket
 
+    // Sliding window (all the fields are protected by send_lock)
+
+    bool established = false; ///< Indicates if the handshake is done and data can flow
+
+    uint32_t snd_una  = 0; ///< The oldest unacknowledged sequence number
+    uint32_t snd_wnd  = 0; ///< The window advertised by the peer
+    uint32_t cwnd     = 0; ///< The congestion window, in bytes
+    uint32_t ssthresh = 0; ///< The slow start threshold, in bytes
+    size_t dup_acks   = 0; ///< The number of consecutive duplicate ACKs
+
+    size_t srtt            = 0; ///< The smoothed round-trip time (ms, scaled by 8)
+    size_t rttvar          = 0; ///< The round-trip time variation (ms, scaled by 4)
+    size_t rto             = 0; ///< The retransmission timeout (ms)
+    uint64_t rto_deadline  = 0; ///< The time (ms) of the next retransmission (0 if not armed)
+    size_t retransmissions = 0; ///< The number of consecutive timeouts
+    size_t probes          = 0; ///< The number of unanswered zero window probes
+
+    std::queue<tcp_segment> rtx_queue; ///< The unacknowledged segments, in order
+    mutex send_lock;                   ///< The lock protecting the send state
+    wait_queue window_queue;           ///< The senders waiting for the window to open
+
+    // Receive buffer (all the fields are protected by receive_lock)
+
+    circular_buffer<char, receive_buffer_size> rcv_buffer; ///< The received data not yet read by the user
+    std::vector<tcp_range> ooo_ranges;                     ///< The data written after the end of the buffer
+    uint32_t rcv_wnd = 0;                                  ///< The last advertised window
+    mutex receive_lock;                                    ///< The lock protecting the receive buffer
+    wait_queue receive_queue;                              ///< The readers waiting for data
+
     tcp_connection() : listening(false) {
         //Nothing else to init
     }
@@ -107,19 +162,35 @@ struct layer {
     std::expected<void> send(char* target_buffer, network::socket& socket, const char* buffer, size_t n);
 
     /*!
-     * \brief Receive a message directly
-     * \þaram buffer The buffer in which to store the message
+     * \brief Send the next pending slot of the packet ring of the socket
+     * \param socket The user socket
+     * \param ring The packet ring of the socket
+     * \param n The size of the payload written in the slot
+     * \return Nothing or an error
+     */
+    std::expected<void> ring_send(network::socket& socket, network::packet_ring& ring, size_t n);
+
+    /*!
+     * \brief Read data from the stream, waiting for some to be available.
+     *
+     * Less than n bytes can be read, the rest stays in the receive buffer.
+     *
+     * \þaram buffer The buffer in which to store the data
      * \param socket The user socket
-     * \param n The maximum message size
+     * \param n The maximum number of bytes to read
      * \return The number of bytes read or an error
      */
     std::expected<size_t> receive(char* buffer, network::socket& socket, size_t n);
 
     /*!
-     * \brief Receive a message directly
-     * \þaram buffer The buffer in which to store the message
+     * \brief Read data from the stream, waiting at most ms milliseconds for
+     * some to be available.
+     *
+     * Less than n bytes can be read, the rest stays in the receive buffer.
+     *
+     * \þaram buffer The buffer in which to store the data
      * \param socket The user socket
-     * \param n The maximum message size
+     * \param n The maximum number of bytes to read
      * \param ms The maximum amout of milliseconds to wait
      * \return The number of bytes read or an error
      */
@@ -166,7 +237,28 @@ struct layer {
      */
     std::expected<size_t> accept(network::socket& socket, size_t ms);
 
+    /*!
+     * \brief Returns the current readiness of the socket
+     *
+     * A listening socket is readable when a connection can be accepted.
+     */
+    size_t poll_events(network::socket& socket);
+
+    /*!
+     * \brief Retransmit the segments whose timeout is passed.
+     *
+     * This is called periodically by the TCP timer task.
+     */
+    void timer();
+
 private:
+    std::expected<void> finalize_handshake(network::interface_descriptor& interface, network::socket& socket, network::packet_p& p);
+    std::expected<void> send_segment(network::interface_descriptor& interface, network::socket& socket, network::packet_p& p);
+    void process_ack(tcp_connection& connection, uint32_t ack, uint32_t window, bool duplicate);
+    void retransmit(tcp_connection& connection);
+    void send_ack(network::interface_descriptor& interface, tcp_connection& connection);
+    std::expected<size_t> read_data(tcp_connection& connection, char* buffer, size_t n);
+
     std::expected<network::packet_p> kernel_prepare_packet(network::interface_descriptor& interface, network::ip::address target_ip, size_t source, size_t target, size_t payload_size);
     std::expected<network::packet_p> kernel_prepare_packet(network::interface_descriptor& interface, tcp_connection& connection, size_t payload_size);
     std::expected<void> finalize_packet_direct(network::interface_descriptor& interface, network::packet_p& p);
@@ -217,6 +217,45 @@ struct layer {
      */
     std::expected<void> send_to(char* target_buffer, network::socket& socket, const char* buffer, size_t n, void* address);
 
+    /*!
+     * \brief Send several messages directly
+     * \param target_buffer The buffer in which to write the packets
+     * \param socket The user socket
+     * \param datagrams The messages
+     * \param n The number of messages
+     * \param addressed Indicates if the messages are sent to their address or to the connected server
+     * \return The number of messages sent or an error if none could be sent
+     */
+    std::expected<size_t> send_many(char* target_buffer, network::socket& socket, network::datagram* datagrams, size_t n, bool addressed);
+
+    /*!
+     * \brief Send the next pending slot of the packet ring of the socket
+     * \param socket The user socket
+     * \param ring The packet ring of the socket
+     * \param n The size of the payload written in the slot
+     * \return Nothing or an error
+     */
+    std::expected<void> ring_send(network::socket& socket, network::packet_ring& ring, size_t n);
+
+    /*!
+     * \brief Receive several messages directly, waiting only for the first
+     * \param socket The user socket
+     * \param datagrams The messages to fill
+     * \param n The maximum number of messages
+     * \return The number of messages received or an error
+     */
+    std::expected<size_t> receive_many(network::socket& socket, network::datagram* datagrams, size_t n);
+
+    /*!
+     * \brief Receive several messages directly, waiting at most ms milliseconds for the first
+     * \param socket The user socket
+     * \param datagrams The messages to fill
+     * \param n The maximum number of messages
+     * \param ms The maximum amout of milliseconds to wait
+     * \return The number of messages received or an error
+     */
+    std::expected<size_t> receive_many(network::socket& socket, network::datagram* datagrams, size_t n, size_t ms);
+
     /*!
      * \brief Register the DNS layer
      * \param layer The DNS layer
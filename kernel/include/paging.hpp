@@ -174,9 +174,10 @@ void map_kernel_inside_user(scheduler::process_t& process);
  * \brief Map the given virtual page to the given physical page for the given process
  * \param virt The virtual page
  * \param physical The physical page
+ * \param flags The paging flags of the page
  * \return true if paging is possible, false otherwise
  */
-bool user_map(scheduler::process_t& process, size_t virt, size_t physical);
+bool user_map(scheduler::process_t& process, size_t virt, size_t physical, uint8_t flags = PRESENT | WRITE | USER);
 
 /*!
  * \brief Map the given virtual pages to the given physical page for the given process
@@ -187,6 +188,24 @@ bool user_map(scheduler::process_t& process, size_t virt, size_t physical);
  */
 bool user_map_pages(scheduler::process_t& process, size_t virt, size_t physical, size_t pages);
 
+/*!
+ * \brief Unmap the given virtual pages of the given process.
+ *
+ * The physical pages are not released. The TLB is only flushed for the
+ * current address space.
+ *
+ * \param virt The first virtual page
+ * \param pages The number of pages to unmap
+ */
+void user_unmap_pages(scheduler::process_t& process, size_t virt, size_t pages);
+
+/*!
+ * \brief Indicates if the given virtual address is mapped as a user page in
+ * the given process
+ * \param virt The virtual address
+ */
+bool user_page_present(scheduler::process_t& process, size_t virt);
+
 /*!
  * \brief Returns the physical address of the PML4T table
  */
@@ -0,0 +1,132 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef POLL_H
+#define POLL_H
+
+#include <types.hpp>
+#include <vector.hpp>
+#include <deque.hpp>
+#include <expected.hpp>
+
+#include "tlib/poll_constants.hpp"
+
+#include "conc/wait_queue.hpp"
+
+namespace network {
+
+struct socket;
+
+} // end of namespace network
+
+/*
+ * Poll sets let a process wait for the readiness of several sockets and
+ * files at once. The readiness is evaluated when waiting, the network
+ * layers only have to notify the sockets when their state changes. In
+ * edge-triggered mode, a descriptor is only reported again after a new
+ * notification.
+ */
+
+namespace poll {
+
+/*!
+ * \brief A descriptor registered in a poll set
+ */
+struct poll_entry {
+    poll_target target;   ///< The kind of descriptor
+    size_t fd;            ///< The descriptor
+    size_t events;        ///< The events of interest (and POLL_EDGE)
+    size_t last_sequence; ///< The notification sequence at the last report (edge-triggered)
+};
+
+/*!
+ * \brief A set of descriptors waited on together
+ */
+struct poll_set {
+    size_t id;                       ///< The poll set file descriptor
+    std::vector<poll_entry> entries; ///< The registered descriptors
+    size_t next = 0;                 ///< The entry to consider first on the next wait
+    wait_queue queue;                ///< The processes waiting on the set
+
+    poll_set(size_t id) : id(id) {}
+
+    /*!
+     * \brief Invalidate the poll set
+     */
+    void invalidate() {
+        id = 0xFFFFFFFF;
+    }
+
+    /*!
+     * \brief Indicates if the poll set is valid
+     */
+    bool is_valid() const {
+        return id != 0xFFFFFFFF;
+    }
+};
+
+/*!
+ * \brief Create a new poll set for the current process
+ * \return The file descriptor of the poll set
+ */
+std::expected<size_t> create();
+
+/*!
+ * \brief Close the given poll set
+ */
+std::expected<void> close(size_t set_fd);
+
+/*!
+ * \brief Add, modify or remove a descriptor of the poll set
+ * \param set_fd The poll set file descriptor
+ * \param operation The operation
+ * \param target The kind of descriptor
+ * \param fd The descriptor
+ * \param events The events of interest (ignored for removal)
+ */
+std::expected<void> control(size_t set_fd, poll_operation operation, poll_target target, size_t fd, size_t events);
+
+/*!
+ * \brief Wait until at least one descriptor of the set is ready
+ * \param set_fd The poll set file descriptor
+ * \param events The array of ready descriptors to fill
+ * \param max The capacity of the array
+ * \return The number of ready descriptors
+ */
+std::expected<size_t> wait(size_t set_fd, poll_event* events, size_t max);
+
+/*!
+ * \brief Wait at most ms milliseconds until at least one descriptor of the
+ * set is ready
+ * \param set_fd The poll set file descriptor
+ * \param events The array of ready descriptors to fill
+ * \param max The capacity of the array
+ * \param ms The timeout in milliseconds (0 only checks the readiness)
+ * \return The number of ready descriptors (0 if the timeout passed)
+ */
+std::expected<size_t> wait(size_t set_fd, poll_event* events, size_t max, size_t ms);
+
+/*!
+ * \brief Notify the poll sets watching the socket that its state changed
+ *
+ * This must be called after the state change.
+ */
+void notify(network::socket& socket);
+
+/*!
+ * \brief Remove the socket from the poll sets watching it
+ */
+void detach(network::socket& socket);
+
+/*!
+ * \brief Release the poll sets of a terminated process
+ */
+void release(std::deque<network::socket>& sockets, std::deque<poll_set>& poll_sets);
+
+} //end of namespace poll
+
+#endif
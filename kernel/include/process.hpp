@@ -14,9 +14,10 @@
 
 #include "paging.hpp"
 #include "interrupts.hpp"
-#include "conc/wait_list.hpp"
+#include "conc/wait_queue.hpp"
 
 #include "vfs/path.hpp"
+#include "poll.hpp"
 
 namespace network {
 
@@ -44,7 +45,8 @@ enum class process_state : char {
     SLEEPING= 5, ///< A sleeping process
     WAITING = 6, ///< A waiting process (for a child)
     KILLED = 7, ///< A killed process
-    BLOCKED_TIMEOUT = 8 ///< A blocked, with timeout, process
+    BLOCKED_TIMEOUT = 8, ///< A blocked, with timeout, process
+    ZOMBIE = 9 ///< A terminated thread, waiting to be joined
 };
 
 /*!
@@ -58,6 +60,7 @@ struct segment_t {
 struct process_t {
     pid_t pid;  ///< The process id
     pid_t ppid; ///< The parent's process id
+    pid_t tgid; ///< The thread group id (the pid of the main thread)
 
     bool system; ///< Indicates if the process is a system process
 
@@ -83,6 +86,8 @@ struct process_t {
 
     volatile interrupt::syscall_regs* context; ///< A pointer to the context
 
+    char* fpu_area; ///< The extended processor state (allocated on first use)
+
     wait_node wait; ///< The process's wait node
 
     std::vector<segment_t> segments; ///< The physical segments
@@ -92,6 +97,7 @@ struct process_t {
 
 constexpr const size_t program_base = 0x8000000000; ///< The virtual address of a program start
 constexpr const size_t program_break = 0x9000000000; ///< The virtual address of a program break start
+constexpr const size_t program_rings = program_base + 0x40000000; ///< The virtual address of the first packet ring of a program
 
 constexpr const auto user_stack_size = 2 * paging::PAGE_SIZE; ///< The size of the user stack
 constexpr const auto kernel_stack_size = 2 * paging::PAGE_SIZE; ///< The size of the kernel stack
@@ -99,6 +105,25 @@ constexpr const auto kernel_stack_size = 2 * paging::PAGE_SIZE; ///< The size of
 constexpr const auto user_stack_start = program_base + 0x700000; ///< The virtual address of a program user stack
 constexpr const auto user_rsp = user_stack_start + (user_stack_size - 8); ///< The initial program stack pointer
 
+constexpr const size_t accounted_system_calls = 128; ///< The number of system calls that are counted per process
+
+/*!
+ * \brief The accounting of a process, maintained by the kernel on the hot paths
+ */
+struct process_stats {
+    uint64_t user_ticks;           ///< The timer ticks spent in user mode
+    uint64_t kernel_ticks;         ///< The timer ticks spent in kernel mode
+    uint64_t voluntary_switches;   ///< The switches while the process was blocked or sleeping
+    uint64_t involuntary_switches; ///< The switches while the process could still run (preemption, yield)
+    uint64_t read_bytes;           ///< The bytes read through the VFS
+    uint64_t written_bytes;        ///< The bytes written through the VFS
+    uint64_t packets_sent;         ///< The packets sent through the sockets
+    uint64_t packets_received;     ///< The packets received through the sockets
+    uint64_t page_faults;          ///< The page faults
+
+    uint32_t system_calls[accounted_system_calls]; ///< The number of calls of each system call (indexed by slot)
+};
+
 /*!
  * \brief An entry in the Process Control Block
  */
@@ -109,7 +134,9 @@ struct process_control_t {
     size_t sleep_timeout; ///< The sleep timeout (in ticks)
     std::vector<path> handles; ///< The file handles
     std::deque<network::socket> sockets; ///< The socket handles
+    std::deque<poll::poll_set> poll_sets; ///< The poll sets
     path working_directory; ///< The current working directory
+    process_stats stats; ///< The accounting of the process
 };
 
 } //end of namespace scheduler
@@ -0,0 +1,91 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <types.hpp>
+
+#include "interrupts.hpp"
+
+/*
+ * Sampling profiler driven by the timer interrupt. When enabled (through
+ * /sys/profiler/enable), every period-th tick records the interrupted
+ * instruction pointer, the running process and the privilege level into a
+ * sample buffer, dumped through /sys/profiler/raw (see tools/profile.py for
+ * the symbolization).
+ */
+
+namespace profiler {
+
+constexpr const size_t max_frames = 7; ///< The maximum number of callers recorded with a sample
+
+constexpr const uint16_t SAMPLE_USER = 1 << 0; ///< The sample was taken in user mode
+
+/*!
+ * \brief A sample of the profiler
+ */
+struct sample_record {
+    uint64_t rip;                ///< The interrupted instruction pointer
+    uint32_t pid;                ///< The running process
+    uint16_t flags;              ///< The flags of the sample (SAMPLE_USER)
+    uint16_t depth;              ///< The number of valid callers
+    uint64_t frames[max_frames]; ///< The return addresses of the callers, innermost first
+} __attribute__((packed));
+
+static_assert(sizeof(sample_record) == 72, "A profiler sample is 72 bytes");
+
+/*!
+ * \brief The name of a process seen by the profiler
+ */
+struct process_record {
+    uint32_t pid;  ///< The process
+    char name[28]; ///< The name of the process (the path of its executable)
+} __attribute__((packed));
+
+static_assert(sizeof(process_record) == 32, "A profiler process record is 32 bytes");
+
+/*!
+ * \brief The header of a dump of the samples
+ */
+struct dump_header {
+    char magic[8];        ///< "THORPRF1"
+    uint32_t version;     ///< The version of the format
+    uint32_t sample_size; ///< The size of a sample
+    uint64_t samples;     ///< The number of samples following the process records
+    uint64_t processes;   ///< The number of process records following the header
+    uint64_t lost;        ///< The number of samples dropped because the buffer was full
+    uint64_t frequency;   ///< The sampling frequency, in Hz
+} __attribute__((packed));
+
+static_assert(sizeof(dump_header) == 48, "The profiler dump header is 48 bytes");
+
+extern volatile bool enabled; ///< Indicates if the profiler is running
+
+/*!
+ * \brief Initialize the profiler (allocate the buffer and register the sysfs values)
+ */
+void init();
+
+/*!
+ * \brief Record a sample (use tick instead)
+ */
+void sample(const interrupt::syscall_regs* regs);
+
+/*!
+ * \brief Must be called by the timer interrupt handler at each tick
+ * \param regs The registers of the interrupted context
+ */
+inline void tick(const interrupt::syscall_regs* regs){
+    if(__builtin_expect(enabled, 0)){
+        sample(regs);
+    }
+}
+
+} //end of namespace profiler
+
+#endif
@@ -26,6 +26,11 @@ constexpr const size_t MAX_PROCESS = 128;
  */
 pid_t get_pid();
 
+/*!
+ * \brief Return the id of the thread group of the current process
+ */
+pid_t get_tgid();
+
 /*!
  * \brief Return the process with the given ID
  */
@@ -36,6 +41,11 @@ scheduler::process_t& get_process(pid_t pid);
  */
 scheduler::process_state get_process_state(pid_t pid);
 
+/*!
+ * \brief Returns the accounting of the current process
+ */
+scheduler::process_stats& get_stats();
+
 /*!
  * \brief Block the given process and immediately reschedule it
  */
@@ -72,7 +82,25 @@ bool is_started();
 std::expected<pid_t> exec(const std::string& path, const std::vector<std::string>& params);
 
 /*!
- * \brief Kill the current process
+ * \brief Create a new thread in the current process.
+ *
+ * The thread shares the address space, the handles and the sockets of the
+ * process but has its own kernel stack and context.
+ *
+ * \param entry The user address of the entry point of the thread
+ * \param stack The user address of the top of the stack of the thread
+ * \param first The first argument passed to the entry point
+ * \param second The second argument passed to the entry point
+ * \return The pid of the thread, or ERROR_INVALID_REQUEST if the entry point
+ * or the stack are not mapped in the user memory of the process
+ */
+std::expected<pid_t> create_thread(size_t entry, size_t stack, size_t first, size_t second);
+
+/*!
+ * \brief Kill the current process.
+ *
+ * If the current process is the main thread of its group, the other threads
+ * are killed as well.
  */
 void kill_current_process() __attribute__((noreturn));
 
@@ -81,6 +109,18 @@ void kill_current_process() __attribute__((noreturn));
  */
 void await_termination(pid_t pid);
 
+/*!
+ * \brief Wait for the given thread to terminate.
+ *
+ * Only the thread that created the given thread can join it. A terminated
+ * thread keeps its pid (as a zombie) until it is joined or its creator
+ * terminates.
+ *
+ * \param tid The thread to wait for
+ * \return Nothing or an error if the current thread cannot join the given thread
+ */
+std::expected<void> join_thread(pid_t tid);
+
 /*!
  * \brief Allocate more memory for the process
  * \param inc The amount of memory to add
@@ -89,8 +129,9 @@ void sbrk(size_t inc);
 
 /*!
  * \brief Let the scheduler know of a timer tick
+ * \param user Indicates if the tick interrupted user code
  */
-void tick();
+void tick(bool user);
 
 /*!
  * \brief Let another process run.
@@ -176,6 +217,26 @@ std::deque<network::socket>& get_sockets();
  */
 std::deque<network::socket>& get_sockets(pid_t pid);
 
+/*!
+ * \brief Register a new poll set for the current process
+ */
+size_t register_new_poll_set();
+
+/*!
+ * \brief Get the poll set of the given file descriptor
+ */
+poll::poll_set& get_poll_set(size_t fd);
+
+/*!
+ * \brief Indicates if the current process has the given poll set
+ */
+bool has_poll_set(size_t fd);
+
+/*!
+ * \brief Release the given poll set from the current process
+ */
+void release_poll_set(size_t fd);
+
 /*!
  * \brief Returns the working directory of the current process
  */
@@ -0,0 +1,48 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef SHARED_PAGE_H
+#define SHARED_PAGE_H
+
+#include <types.hpp>
+
+#include "tlib/shared_page.hpp"
+
+//Forward declaration
+namespace scheduler {
+struct process_t;
+}
+
+/*
+ * The shared page is a single physical page, written by the kernel and mapped
+ * read-only in every process. It lets the user space read the time and the
+ * static system information with plain loads instead of system calls.
+ */
+
+namespace shared_page {
+
+/*!
+ * \brief Allocate and fill the shared page.
+ *
+ * Must be called after the initialization of the timer and of the consoles.
+ */
+void init();
+
+/*!
+ * \brief Map the shared page, read-only, in the given process
+ * \return true if the mapping succeeded, false otherwise
+ */
+bool map(scheduler::process_t& process);
+
+/*!
+ * \brief Update the time values of the shared page (at each timer tick)
+ */
+void update_time();
+
+} //end of namespace shared_page
+
+#endif
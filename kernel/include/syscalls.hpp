@@ -21,6 +21,8 @@ void _syscall7();
 void _syscall8();
 void _syscall9();
 
+void _syscall_fast();
+
 } //end of extern "C"
 
 #endif
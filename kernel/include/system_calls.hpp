@@ -5,8 +5,8 @@
 //  http://www.opensource.org/licenses/MIT)
 //=======================================================================
 
-#ifndef ATA_H
-#define ATA_H
+#ifndef SYSTEM_CALLS_H
+#define SYSTEM_CALLS_H
 
 #include "interrupts.hpp"
 
@@ -14,4 +14,14 @@ void system_call_entry(const interrupt::syscall_regs& regs);
 
 void install_system_calls();
 
+/*!
+ * \brief Returns the number of slots used to account the system calls of the processes
+ */
+size_t system_call_slots_used();
+
+/*!
+ * \brief Returns the number of the system call accounted in the given slot
+ */
+size_t system_call_number(size_t slot);
+
 #endif
@@ -10,6 +10,8 @@
 
 #include <types.hpp>
 
+#include "interrupts.hpp"
+
 namespace timer {
 
 /*!
@@ -29,8 +31,9 @@ uint64_t milliseconds();
 
 /*!
  * \brief Let the timer know of a new tick
+ * \param regs The registers of the interrupted context
  */
-void tick();
+void tick(const interrupt::syscall_regs* regs);
 
 /*!
  * \brief Return the frequency in Hz of the current timer system.
@@ -0,0 +1,109 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <types.hpp>
+
+/*
+ * Static tracepoints of the kernel. The events are recorded with their TSC
+ * timestamp in a ring of fixed-size binary records. The categories of events
+ * are enabled with a mask written in /sys/trace/enable and the ring is dumped
+ * through /sys/trace/raw (see tools/trace2json.py for the conversion).
+ *
+ * A disabled tracepoint only costs the test of the mask.
+ */
+
+namespace trace {
+
+constexpr const uint64_t SCHED   = 1 << 0; ///< Context switches
+constexpr const uint64_t SYSCALL = 1 << 1; ///< System calls entry and exit
+constexpr const uint64_t IRQ     = 1 << 2; ///< IRQs entry and exit
+constexpr const uint64_t BLOCK   = 1 << 3; ///< Block I/O requests
+constexpr const uint64_t NET     = 1 << 4; ///< Packets received and sent
+constexpr const uint64_t FAULT   = 1 << 5; ///< Page faults
+
+/*!
+ * \brief The type of an event. The high byte is the index of the category.
+ */
+enum class event : uint16_t {
+    SWITCH        = 0x0001, ///< a: old pid, b: new pid
+    SYSCALL_ENTRY = 0x0101, ///< a: system call number
+    SYSCALL_EXIT  = 0x0102, ///< a: system call number, b: result
+    IRQ_ENTRY     = 0x0201, ///< a: IRQ number
+    IRQ_EXIT      = 0x0202, ///< a: IRQ number
+    BLOCK_READ    = 0x0301, ///< a: first sector, b: number of sectors
+    BLOCK_WRITE   = 0x0302, ///< a: first sector, b: number of sectors
+    BLOCK_DONE    = 0x0303, ///< a: result
+    PACKET_RX     = 0x0401, ///< a: interface, b: size
+    PACKET_TX     = 0x0402, ///< a: interface, b: size
+    PAGE_FAULT    = 0x0501  ///< a: faulting address, b: instruction pointer
+};
+
+/*!
+ * \brief A recorded event (the format of the dump)
+ */
+struct record {
+    uint64_t tsc;   ///< The TSC at the time of the event
+    uint16_t type;  ///< The type of the event
+    uint16_t cpu;   ///< The CPU of the event
+    uint32_t pid;   ///< The running process
+    uint64_t a;     ///< The first argument
+    uint64_t b;     ///< The second argument
+} __attribute__((packed));
+
+static_assert(sizeof(record) == 32, "A trace record is 32 bytes");
+
+/*!
+ * \brief The header of the dump
+ */
+struct dump_header {
+    char magic[8];        ///< "THORTRC1"
+    uint32_t version;     ///< The version of the format
+    uint32_t record_size; ///< The size of a record
+    uint64_t records;     ///< The number of records following the header
+    uint64_t lost;        ///< The number of records overwritten
+    uint64_t base_tsc;    ///< The TSC when the tracing was initialized
+    uint64_t base_ms;     ///< The time, in ms, when the tracing was initialized
+    uint64_t now_tsc;     ///< The TSC when the dump was made
+    uint64_t now_ms;      ///< The time, in ms, when the dump was made
+} __attribute__((packed));
+
+static_assert(sizeof(dump_header) == 64, "The trace dump header is 64 bytes");
+
+extern volatile uint64_t enabled_mask; ///< The enabled categories
+
+/*!
+ * \brief Initialize the tracing (allocate the ring and register the sysfs values)
+ */
+void init();
+
+/*!
+ * \brief Record an event (use point instead)
+ */
+void record_event(event e, uint64_t a, uint64_t b);
+
+/*!
+ * \brief Returns the category of the given event
+ */
+constexpr uint64_t category(event e){
+    return uint64_t(1) << (uint16_t(e) >> 8);
+}
+
+/*!
+ * \brief A tracepoint, the event is only recorded if its category is enabled
+ */
+inline void point(event e, uint64_t a = 0, uint64_t b = 0){
+    if(__builtin_expect(enabled_mask & category(e), 0)){
+        record_event(e, a, b);
+    }
+}
+
+} //end of namespace trace
+
+#endif
@@ -27,25 +27,13 @@ scheduler::pid_t condition_variable::top_process() const {
 scheduler::pid_t condition_variable::notify_one() {
     std::lock_guard<spinlock> l(lock);
 
-    if (!queue.empty()) {
-        // Here we must use a hint since the process may have
-        // used a timeout and may have been woken up by the
-        // scheduler but not yet removed its pid from the queue
-        return queue.dequeue_hint();
-    }
-
-    return scheduler::INVALID_PID;
+    return queue.wake_one();
 }
 
 void condition_variable::notify_all() {
     std::lock_guard<spinlock> l(lock);
 
-    while (!queue.empty()) {
-        // Here we must use a hint since the process may have
-        // used a timeout and may have been woken up by the
-        // scheduler but not yet removed its pid from the queue
-        queue.dequeue_hint();
-    }
+    queue.wake_all();
 }
 
 void condition_variable::wait() {
@@ -73,23 +61,7 @@ bool condition_variable::wait_for(size_t ms) {
 
     scheduler::reschedule();
 
-    // At this point we need the lock again to check the queue
-    lock.lock();
-
-    // If the queue still contains our pid, it means a wake up
-    // from timeout
-
-    if(queue.waiting()){
-        queue.remove();
-
-        // Final release of the lock
-        lock.unlock();
-
-        return false;
-    }
-
-    // Final release of the lock
-    lock.unlock();
-
-    return true;
+    // The scheduler removes the process from the queue when the timeout is
+    // passed, there is nothing left to clean
+    return !queue.timed_out();
 }
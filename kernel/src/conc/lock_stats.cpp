@@ -0,0 +1,44 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "conc/lock_stats.hpp"
+
+#include "fs/sysfs.hpp"
+
+namespace {
+
+std::string sysfs_acquisitions(void* data){
+    return std::to_string(static_cast<lock_stats*>(data)->acquisitions);
+}
+
+std::string sysfs_contentions(void* data){
+    return std::to_string(static_cast<lock_stats*>(data)->contentions);
+}
+
+std::string sysfs_spins(void* data){
+    return std::to_string(static_cast<lock_stats*>(data)->spins);
+}
+
+std::string sysfs_sleeps(void* data){
+    return std::to_string(static_cast<lock_stats*>(data)->sleeps);
+}
+
+std::string sysfs_max_hold(void* data){
+    return std::to_string(static_cast<lock_stats*>(data)->max_hold);
+}
+
+} //end of anonymous namespace
+
+void lock_stats::publish(const std::string& name){
+    auto p = path("/locks") / name;
+
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "acquisitions", sysfs_acquisitions, this);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "contentions", sysfs_contentions, this);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "spins", sysfs_spins, this);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "sleeps", sysfs_sleeps, this);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "max_hold_cycles", sysfs_max_hold, this);
+}
@@ -0,0 +1,134 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "conc/wait_queue.hpp"
+#include "conc/int_lock.hpp"
+
+#include "scheduler.hpp"
+
+bool wait_queue::empty() const {
+    return !head;
+}
+
+size_t wait_queue::size() const {
+    return count;
+}
+
+size_t wait_queue::top() const {
+    return head->pid;
+}
+
+void wait_queue::push(wait_node& node){
+    node.next      = nullptr;
+    node.prev      = tail;
+    node.queue     = this;
+    node.timed_out = false;
+
+    if (tail) {
+        tail->next = &node;
+    } else {
+        head = &node;
+    }
+
+    tail = &node;
+    ++count;
+}
+
+void wait_queue::unlink(wait_node& node){
+    if (node.prev) {
+        node.prev->next = node.next;
+    } else {
+        head = node.next;
+    }
+
+    if (node.next) {
+        node.next->prev = node.prev;
+    } else {
+        tail = node.prev;
+    }
+
+    node.next  = nullptr;
+    node.prev  = nullptr;
+    node.queue = nullptr;
+    --count;
+}
+
+void wait_queue::enqueue(){
+    auto pid = scheduler::get_pid();
+
+    direct_int_lock lock;
+
+    push(scheduler::get_process(pid).wait);
+
+    scheduler::block_process_light(pid);
+}
+
+void wait_queue::enqueue_timeout(size_t ms){
+    auto pid = scheduler::get_pid();
+
+    direct_int_lock lock;
+
+    push(scheduler::get_process(pid).wait);
+
+    scheduler::block_process_timeout_light(pid, ms);
+}
+
+bool wait_queue::timed_out() const {
+    return scheduler::get_process(scheduler::get_pid()).wait.timed_out;
+}
+
+size_t wait_queue::wake_one(){
+    direct_int_lock lock;
+
+    if (!head) {
+        return scheduler::INVALID_PID;
+    }
+
+    auto pid = head->pid;
+
+    unlink(*head);
+
+    // The processes whose timeout is passed are removed by the scheduler,
+    // so the process is necessarily blocked
+    scheduler::unblock_process(pid);
+
+    return pid;
+}
+
+size_t wait_queue::wake_n(size_t n){
+    direct_int_lock lock;
+
+    size_t woken = 0;
+
+    while (head && woken < n) {
+        auto pid = head->pid;
+
+        unlink(*head);
+        scheduler::unblock_process(pid);
+
+        ++woken;
+    }
+
+    return woken;
+}
+
+size_t wait_queue::wake_all(){
+    // There cannot be more waiting processes than processes
+    return wake_n(scheduler::MAX_PROCESS);
+}
+
+void wait_queue::remove(wait_node& node){
+    direct_int_lock lock;
+
+    unlink(node);
+}
+
+void wait_queue::expire(wait_node& node){
+    unlink(node);
+
+    node.timed_out = true;
+}
@@ -22,6 +22,7 @@
 #include "console.hpp"
 #include "disks.hpp"
 #include "block_cache.hpp"
+#include "trace.hpp"
 
 #ifdef THOR_CONFIG_ATA_VERBOSE
 #define verbose_logf(...) logging::logf(__VA_ARGS__)
@@ -353,6 +354,7 @@ void identify(ata::drive_descriptor& drive){
 
 void ata::detect_disks(){
     ata_lock.init();
+    ata_lock.publish("ata");
 
     // Init the cache with 256 blocks
     cache.init(BLOCK_SIZE, 256);
@@ -543,7 +545,11 @@ size_t ata::read_sectors(drive_descriptor& drive, uint64_t start, uint8_t count,
         auto block = cache.block((drive.controller << 8) + drive.drive, start + i, valid);
 
         if(!valid){
-            if(!read_write_sector(drive, start + i, block, sector_operation::READ)){
+            trace::point(trace::event::BLOCK_READ, start + i, 1);
+            auto result = read_write_sector(drive, start + i, block, sector_operation::READ);
+            trace::point(trace::event::BLOCK_DONE, result);
+
+            if(!result){
                 return std::ERROR_FAILED;
             }
         }
@@ -570,7 +576,11 @@ size_t ata::write_sectors(drive_descriptor& drive, uint64_t start, uint8_t count
             std::copy_n(buffer, BLOCK_SIZE, block);
         }
 
-        if(!read_write_sector(drive, start + i, buffer, sector_operation::WRITE)){
+        trace::point(trace::event::BLOCK_WRITE, start + i, 1);
+        auto result = read_write_sector(drive, start + i, buffer, sector_operation::WRITE);
+        trace::point(trace::event::BLOCK_DONE, result);
+
+        if(!result){
             return std::ERROR_FAILED;
         }
 
@@ -591,7 +601,11 @@ size_t ata::clear_sectors(drive_descriptor& drive, uint64_t start, uint8_t count
             std::fill_n(block, BLOCK_SIZE, 0);
         }
 
-        if(!read_write_sector(drive, start + i, nullptr, sector_operation::CLEAR)){
+        trace::point(trace::event::BLOCK_WRITE, start + i, 1);
+        auto result = read_write_sector(drive, start + i, nullptr, sector_operation::CLEAR);
+        trace::point(trace::event::BLOCK_DONE, result);
+
+        if(!result){
             return std::ERROR_FAILED;
         }
 
@@ -19,10 +19,10 @@ constexpr const uint64_t PIT_FREQUENCY = 1000;
 
 size_t pit_counter = 0;
 
-void timer_handler(interrupt::syscall_regs*, void*){
+void timer_handler(interrupt::syscall_regs* regs, void*){
     ++pit_counter;
 
-    timer::tick();
+    timer::tick(regs);
 }
 
 } //End of anonymous namespace
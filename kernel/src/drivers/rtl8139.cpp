@@ -83,6 +83,8 @@ struct rtl8139_t {
     volatile uint64_t cur_tx; //Index inside the transmit buffer
     volatile uint64_t dirty_tx; //Index inside the transmit buffer
 
+    volatile bool rx_masked; //Indicates if the RX interrupts are masked (polling)
+
     tx_desc_t tx_desc[tx_buffers];
 
     mutex tx_lock;
@@ -98,50 +100,23 @@ void packet_handler(interrupt::syscall_regs*, void* data){
     // Get the interrupt status
     auto status = in_word(desc.iobase + ISR);
 
+    // While the RX thread polls, the RX status is left pending, it will
+    // raise a new interrupt if a packet arrives after the last poll
+    if(desc.rx_masked){
+        status &= ~RX_OK;
+    }
+
     // Acknowledge the handling of the packet
     out_word(desc.iobase + ISR, status);
 
     if(status & RX_OK){
         logging::logf(logging::log_level::TRACE, "rtl8139: Packet received correctly OK\n");
 
-        auto cur_rx = desc.cur_rx;
-
-        while((in_byte(desc.iobase + CMD) & CMD_NOT_EMPTY) == 0){
-            auto cur_offset = cur_rx % 0x3000;
-            auto buffer_rx = reinterpret_cast<char*>(desc.buffer_rx);
-
-            auto packet_status = *reinterpret_cast<uint32_t*>(buffer_rx + cur_offset);
-            auto packet_length = packet_status >> 16; //Extract the size from the header
-            auto packet_payload = buffer_rx + cur_offset + 4; //Skip the packet header (NIC)
-
-            if (packet_status & (RX_BAD_SYMBOL | RX_RUNT | RX_TOO_LONG | RX_CRC_ERR | RX_BAD_ALIGN)) {
-                logging::logf(logging::log_level::TRACE, "rtl8139: Packet Error, status:%u\n", uint64_t(packet_status));
-
-                //TODO We should probably reset the controller ?
-            } else if(packet_length == 0){
-                // TODO Normally this should not happen, it probably indicates a bug somewhere
-                logging::logf(logging::log_level::TRACE, "rtl8139: Packet Error Length = 0, status:%u\n", uint64_t(packet_status));
-            } else {
-                // Omit CRC from the length
-                auto packet_only_length = packet_length - 4;
-
-                logging::logf(logging::log_level::TRACE, "rtl8139: Packet OK length:%u\n", uint64_t(packet_only_length));
-
-                auto packet_buffer = new char[packet_only_length];
+        // Mask the RX interrupts and let the RX thread poll the buffer
+        desc.rx_masked = true;
+        out_word(desc.iobase + IMR, TX_OK | TX_ERR);
 
-                std::copy_n(packet_payload, packet_only_length, packet_buffer);
-
-                interface.rx_queue.emplace(std::make_shared<network::packet>(packet_buffer, packet_only_length));
-                interface.rx_sem.notify();
-            }
-
-            cur_rx = (cur_rx + packet_length + 4 + 3) & ~3; //align on 4 bytes
-            out_word(desc.iobase + RX_BUF_PTR, cur_rx - 0x10);
-
-            logging::logf(logging::log_level::TRACE, "rtl8139: Packet Handled\n");
-        }
-
-        desc.cur_rx = cur_rx;
+        interface.schedule_poll();
     }
 
     if(status & (TX_OK | TX_ERR)){
@@ -177,13 +152,70 @@ void packet_handler(interrupt::syscall_regs*, void* data){
         desc.tx_sem.notify(cleaned_up);
     }
 
-    if(!(status & (RX_OK | TX_OK | TX_ERR))){
+    if(!(status & (RX_OK | TX_OK | TX_ERR)) && !desc.rx_masked){
         // This should not happen since we only enable a few
         // interrupts
         logging::logf(logging::log_level::ERROR, "rtl8139: Receive status unhandled OK\n");
     }
 }
 
+size_t poll_packets(network::interface_descriptor& interface, size_t budget, void (*deliver)(network::interface_descriptor&, network::packet_p&)){
+    auto& desc = *static_cast<rtl8139_t*>(interface.driver_data);
+
+    // Acknowledge the RX status before looking at the buffer, a packet
+    // received after this point is either polled now or raises an
+    // interrupt once they are unmasked
+    out_word(desc.iobase + ISR, RX_OK);
+
+    size_t polled = 0;
+    auto cur_rx = desc.cur_rx;
+
+    while(polled < budget && (in_byte(desc.iobase + CMD) & CMD_NOT_EMPTY) == 0){
+        auto cur_offset = cur_rx % 0x3000;
+        auto buffer_rx = reinterpret_cast<char*>(desc.buffer_rx);
+
+        auto packet_status = *reinterpret_cast<uint32_t*>(buffer_rx + cur_offset);
+        auto packet_length = packet_status >> 16; //Extract the size from the header
+        auto packet_payload = buffer_rx + cur_offset + 4; //Skip the packet header (NIC)
+
+        if (packet_status & (RX_BAD_SYMBOL | RX_RUNT | RX_TOO_LONG | RX_CRC_ERR | RX_BAD_ALIGN)) {
+            logging::logf(logging::log_level::TRACE, "rtl8139: Packet Error, status:%u\n", uint64_t(packet_status));
+
+            //TODO We should probably reset the controller ?
+        } else if(packet_length == 0){
+            // TODO Normally this should not happen, it probably indicates a bug somewhere
+            logging::logf(logging::log_level::TRACE, "rtl8139: Packet Error Length = 0, status:%u\n", uint64_t(packet_status));
+        } else {
+            // Omit CRC from the length
+            auto packet_only_length = packet_length - 4;
+
+            auto packet = network::make_packet(packet_only_length);
+
+            std::copy_n(packet_payload, packet_only_length, packet->payload);
+
+            deliver(interface, packet);
+        }
+
+        cur_rx = (cur_rx + packet_length + 4 + 3) & ~3; //align on 4 bytes
+        out_word(desc.iobase + RX_BUF_PTR, cur_rx - 0x10);
+
+        ++polled;
+    }
+
+    desc.cur_rx = cur_rx;
+
+    return polled;
+}
+
+void poll_complete(network::interface_descriptor& interface){
+    auto& desc = *static_cast<rtl8139_t*>(interface.driver_data);
+
+    direct_int_lock lock;
+
+    desc.rx_masked = false;
+    out_word(desc.iobase + IMR, RX_OK | TX_OK | TX_ERR);
+}
+
 void send_packet(network::interface_descriptor& interface, network::packet_p& packet){
     logging::logf(logging::log_level::TRACE, "rtl8139: Start transmitting packet (%p)\n", packet.get());
 
@@ -194,8 +226,7 @@ void send_packet(network::interface_descriptor& interface, network::packet_p& pa
         {
             direct_int_lock lock;
 
-            interface.rx_queue.push(packet);
-            interface.rx_sem.notify();
+            interface.receive(packet);
         }
 
         logging::logf(logging::log_level::TRACE, "rtl8139: Packet to self transmitted correctly\n");
@@ -234,6 +265,8 @@ void rtl8139::init_driver(network::interface_descriptor& interface, pci::device_
 
     interface.driver_data = desc;
     interface.hw_send = send_packet;
+    interface.hw_poll = poll_packets;
+    interface.hw_poll_complete = poll_complete;
 
     desc->tx_sem.init(tx_buffers);
 
@@ -287,6 +320,7 @@ void rtl8139::init_driver(network::interface_descriptor& interface, pci::device_
     desc->cur_rx = 0;
     desc->cur_tx = 0;
     desc->dirty_tx = 0;
+    desc->rx_masked = false;
 
     std::fill_n(reinterpret_cast<char*>(desc->buffer_rx), 0x3000, 0);
 
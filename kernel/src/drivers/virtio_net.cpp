@@ -0,0 +1,639 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "drivers/virtio_net.hpp"
+
+#include "conc/int_lock.hpp"
+#include "conc/deferred_unique_semaphore.hpp"
+
+#include "net/ethernet_layer.hpp"
+
+#include "fs/sysfs.hpp"
+
+#include "logging.hpp"
+#include "kernel_utils.hpp"
+#include "physical_allocator.hpp"
+#include "virtual_allocator.hpp"
+#include "interrupts.hpp"
+#include "paging.hpp"
+
+// Registers of the legacy virtio PCI interface (I/O space, BAR0)
+#define DEVICE_FEATURES 0x00
+#define GUEST_FEATURES 0x04
+#define QUEUE_ADDRESS 0x08
+#define QUEUE_SIZE 0x0C
+#define QUEUE_SELECT 0x0E
+#define QUEUE_NOTIFY 0x10
+#define DEVICE_STATUS 0x12
+#define ISR_STATUS 0x13
+#define NET_MAC 0x14 // The device-specific configuration starts with the MAC
+
+#define STATUS_ACKNOWLEDGE 0x01
+#define STATUS_DRIVER 0x02
+#define STATUS_DRIVER_OK 0x04
+#define STATUS_FAILED 0x80
+
+#define F_MAC (1 << 5)        // The device has a given MAC address
+#define F_EVENT_IDX (1 << 29) // The used_event and avail_event fields are used
+
+#define DESC_F_NEXT 1  // The buffer continues in the next descriptor
+#define DESC_F_WRITE 2 // The buffer is write-only for the device
+
+#define AVAIL_F_NO_INTERRUPT 1
+#define USED_F_NO_NOTIFY 1
+
+#define ISR_QUEUE 0x1 // A queue has been updated
+
+namespace {
+
+constexpr const uint16_t rx_queue_index = 0;
+constexpr const uint16_t tx_queue_index = 1;
+
+constexpr const size_t max_chain      = 4;    ///< The maximum number of descriptors of a chain
+constexpr const size_t rx_buffer_size = 1518; ///< Ethernet frame with a VLAN tag, without the CRC
+
+struct vring_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed));
+
+struct vring_used_elem {
+    uint32_t id;
+    uint32_t len;
+} __attribute__((packed));
+
+struct net_header {
+    uint8_t flags;
+    uint8_t gso_type;
+    uint16_t header_len;
+    uint16_t gso_size;
+    uint16_t checksum_start;
+    uint16_t checksum_offset;
+} __attribute__((packed));
+
+static_assert(sizeof(vring_desc) == 16, "Invalid size for vring_desc");
+static_assert(sizeof(net_header) == 10, "Invalid size for the virtio-net header");
+
+/*!
+ * \brief A virtqueue, in the legacy layout
+ */
+struct virtqueue {
+    uint16_t index; ///< The index of the queue on the device
+    uint16_t size;  ///< The number of descriptors
+
+    vring_desc* desc;                ///< The descriptor table
+    volatile uint16_t* avail_flags;  ///< The flags of the available ring
+    volatile uint16_t* avail_idx;    ///< The next index of the available ring
+    volatile uint16_t* avail_ring;   ///< The available ring
+    volatile uint16_t* used_event;   ///< The used index after which the device interrupts (EVENT_IDX)
+    volatile uint16_t* used_flags;   ///< The flags of the used ring
+    volatile uint16_t* used_idx;     ///< The next index of the used ring
+    volatile vring_used_elem* used_ring; ///< The used ring
+    volatile uint16_t* avail_event;  ///< The avail index after which the device wants a notification (EVENT_IDX)
+
+    uint16_t free_head = 0; ///< The first free descriptor
+    uint16_t num_free  = 0; ///< The number of free descriptors
+    uint16_t last_used = 0; ///< The last used index processed by the driver
+    uint16_t added     = 0; ///< The number of chains made available since the last notification
+
+    network::packet_p* packets; ///< The packet held by each chain, indexed by head
+    net_header* headers;        ///< The virtio-net header of each chain, indexed by head
+    uint64_t headers_phys;      ///< The physical address of the headers
+};
+
+struct virtio_net_t {
+    uint32_t iobase;
+    bool event_idx;
+
+    virtqueue rx;
+    virtqueue tx;
+
+    volatile bool rx_masked;          ///< Indicates if the RX interrupts are masked (polling)
+    volatile bool tx_waiting;         ///< Indicates if the TX thread waits for free descriptors
+    deferred_unique_semaphore tx_sem; ///< Semaphore for free TX descriptors
+
+    uint64_t interrupts       = 0; ///< The number of interrupts handled
+    uint64_t kicks            = 0; ///< The number of notifications sent to the device
+    uint64_t suppressed_kicks = 0; ///< The number of notifications the device did not ask for
+
+    network::interface_descriptor* interface;
+};
+
+uint64_t dma_allocate(size_t pages, uint64_t& phys){
+    phys = physical_allocator::allocate(pages);
+
+    auto virt = virtual_allocator::allocate(pages);
+
+    if(!paging::map_pages(virt, phys, pages)){
+        logging::logf(logging::log_level::ERROR, "virtio-net: Unable to map %h into %h\n", phys, virt);
+    }
+
+    std::fill_n(reinterpret_cast<char*>(virt), pages * paging::PAGE_SIZE, 0);
+
+    return virt;
+}
+
+uint64_t to_physical(const char* address){
+    auto virt = reinterpret_cast<size_t>(address);
+    auto page = virt & ~(paging::PAGE_SIZE - 1);
+
+    return paging::physical_address(page) + (virt - page);
+}
+
+bool setup_queue(virtio_net_t& desc, virtqueue& queue, uint16_t index){
+    auto iobase = desc.iobase;
+
+    out_word(iobase + QUEUE_SELECT, index);
+
+    auto size = in_word(iobase + QUEUE_SIZE);
+
+    if(!size){
+        logging::logf(logging::log_level::ERROR, "virtio-net: Queue %u is not available\n", uint64_t(index));
+        return false;
+    }
+
+    // Legacy layout: descriptors and available ring, then the used ring on the next page
+    auto avail_offset = size_t(size) * sizeof(vring_desc);
+    auto used_offset  = (avail_offset + sizeof(uint16_t) * (3 + size) + paging::PAGE_SIZE - 1) & ~(paging::PAGE_SIZE - 1);
+    auto total_size   = used_offset + sizeof(uint16_t) * 3 + sizeof(vring_used_elem) * size;
+
+    uint64_t phys;
+    auto virt = dma_allocate(paging::pages(total_size), phys);
+
+    auto avail = reinterpret_cast<volatile uint16_t*>(virt + avail_offset);
+    auto used  = reinterpret_cast<volatile uint16_t*>(virt + used_offset);
+
+    queue.index       = index;
+    queue.size        = size;
+    queue.desc        = reinterpret_cast<vring_desc*>(virt);
+    queue.avail_flags = avail;
+    queue.avail_idx   = avail + 1;
+    queue.avail_ring  = avail + 2;
+    queue.used_event  = avail + 2 + size;
+    queue.used_flags  = used;
+    queue.used_idx    = used + 1;
+    queue.used_ring   = reinterpret_cast<volatile vring_used_elem*>(used + 2);
+    queue.avail_event = reinterpret_cast<volatile uint16_t*>(queue.used_ring + size);
+
+    // All the descriptors are free
+    for(uint16_t i = 0; i < size; ++i){
+        queue.desc[i].next = i + 1;
+    }
+
+    queue.free_head = 0;
+    queue.num_free  = size;
+
+    queue.packets = new network::packet_p[size];
+    queue.headers = reinterpret_cast<net_header*>(dma_allocate(paging::pages(size * sizeof(net_header)), queue.headers_phys));
+
+    out_dword(iobase + QUEUE_ADDRESS, phys / paging::PAGE_SIZE);
+
+    logging::logf(logging::log_level::TRACE, "virtio-net: Queue %u with %u descriptors at %h\n", uint64_t(index), uint64_t(size), phys);
+
+    return true;
+}
+
+/*!
+ * \brief Fill the descriptors for a buffer, splitting it at the page
+ * boundaries that are not physically contiguous.
+ * \return The number of descriptors used
+ */
+size_t fill_buffer(vring_desc* chain[], size_t n, const char* buffer, size_t size, uint16_t flags){
+    size_t used = 0;
+
+    while(size){
+        auto phys   = to_physical(buffer);
+        auto offset = reinterpret_cast<size_t>(buffer) & (paging::PAGE_SIZE - 1);
+        auto len    = std::min(size, paging::PAGE_SIZE - offset);
+
+        if(used && chain[used - 1]->addr + chain[used - 1]->len == phys){
+            chain[used - 1]->len += len;
+        } else {
+            thor_assert(used < n, "virtio-net: Chain too long");
+
+            chain[used]->addr  = phys;
+            chain[used]->len   = len;
+            chain[used]->flags = flags;
+
+            ++used;
+        }
+
+        buffer += len;
+        size -= len;
+    }
+
+    return used;
+}
+
+/*!
+ * \brief Make a chain available to the device: its header, followed by the
+ * packet payload.
+ *
+ * The caller must ensure that there are at least max_chain free descriptors.
+ */
+void add_chain(virtqueue& queue, network::packet_p& packet, size_t size, bool write){
+    auto head = queue.free_head;
+
+    vring_desc* chain[max_chain];
+
+    auto next = head;
+    for(size_t i = 0; i < max_chain; ++i){
+        chain[i] = &queue.desc[next];
+        next = chain[i]->next;
+    }
+
+    uint16_t flags = write ? DESC_F_WRITE : 0;
+
+    // The header has its own descriptor (no VIRTIO_F_ANY_LAYOUT)
+    chain[0]->addr  = queue.headers_phys + head * sizeof(net_header);
+    chain[0]->len   = sizeof(net_header);
+    chain[0]->flags = flags;
+
+    auto n = 1 + fill_buffer(chain + 1, max_chain - 1, packet->payload, size, flags);
+
+    for(size_t i = 0; i < n - 1; ++i){
+        chain[i]->flags |= DESC_F_NEXT;
+    }
+
+    queue.free_head = chain[n - 1]->next;
+    queue.num_free -= n;
+
+    queue.packets[head] = packet;
+
+    auto idx = *queue.avail_idx;
+    queue.avail_ring[(idx + queue.added) % queue.size] = head;
+    ++queue.added;
+}
+
+/*!
+ * \brief Publish the chains added since the last call and notify the device
+ * if it asked for it.
+ */
+void kick(virtio_net_t& desc, virtqueue& queue){
+    if(!queue.added){
+        return;
+    }
+
+    uint16_t old_idx = *queue.avail_idx;
+    uint16_t new_idx = old_idx + queue.added;
+
+    queue.added = 0;
+
+    // The ring entries must be visible before the index
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    *queue.avail_idx = new_idx;
+
+    // The index must be visible before reading the device event
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    bool notify;
+    if(desc.event_idx){
+        uint16_t event = *queue.avail_event;
+        notify = uint16_t(new_idx - event - 1) < uint16_t(new_idx - old_idx);
+    } else {
+        notify = !(*queue.used_flags & USED_F_NO_NOTIFY);
+    }
+
+    if(notify){
+        ++desc.kicks;
+        out_word(desc.iobase + QUEUE_NOTIFY, queue.index);
+    } else {
+        ++desc.suppressed_kicks;
+    }
+}
+
+/*!
+ * \brief Return the descriptors of a used chain to the free list
+ * \return The packet held by the chain
+ */
+network::packet_p free_chain(virtqueue& queue, uint16_t head){
+    auto last = head;
+    uint16_t n = 1;
+
+    while(queue.desc[last].flags & DESC_F_NEXT){
+        last = queue.desc[last].next;
+        ++n;
+    }
+
+    queue.desc[last].next = queue.free_head;
+    queue.free_head = head;
+    queue.num_free += n;
+
+    return std::move(queue.packets[head]);
+}
+
+/*!
+ * \brief Give new receive buffers to the device, in a single batch.
+ *
+ * This is called by the RX thread after each poll, and once at startup.
+ */
+void refill_rx(virtio_net_t& desc){
+    auto& rx = desc.rx;
+
+    while(rx.num_free >= max_chain){
+        auto packet = network::make_packet(rx_buffer_size);
+
+        add_chain(rx, packet, rx_buffer_size, true);
+    }
+
+    kick(desc, rx);
+}
+
+/*!
+ * \brief Collect the transmitted chains and release their packets
+ */
+void reclaim_tx(virtio_net_t& desc){
+    auto& tx = desc.tx;
+
+    while(tx.last_used != *tx.used_idx){
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        auto head = tx.used_ring[tx.last_used % tx.size].id;
+
+        free_chain(tx, head);
+
+        ++tx.last_used;
+    }
+}
+
+void mask_rx(virtio_net_t& desc){
+    desc.rx_masked = true;
+
+    // With the event index, the device does not interrupt again until
+    // used_event is moved forward
+    *desc.rx.avail_flags = AVAIL_F_NO_INTERRUPT;
+}
+
+void packet_handler(interrupt::syscall_regs*, void* data){
+    auto& desc = *static_cast<virtio_net_t*>(data);
+    auto& interface = *desc.interface;
+    auto& rx = desc.rx;
+
+    // Reading the ISR acknowledges the interrupt
+    auto status = in_byte(desc.iobase + ISR_STATUS);
+
+    if(!(status & ISR_QUEUE)){
+        // The line may be shared with another device
+        return;
+    }
+
+    ++desc.interrupts;
+
+    // Let the RX thread poll the used ring
+    if(!desc.rx_masked && rx.last_used != *rx.used_idx){
+        mask_rx(desc);
+
+        interface.schedule_poll();
+    }
+
+    if(desc.tx_waiting){
+        desc.tx_waiting = false;
+        desc.tx_sem.notify();
+    }
+}
+
+size_t poll_packets(network::interface_descriptor& interface, size_t budget, void (*deliver)(network::interface_descriptor&, network::packet_p&)){
+    auto& desc = *static_cast<virtio_net_t*>(interface.driver_data);
+    auto& rx = desc.rx;
+
+    size_t polled = 0;
+
+    while(polled < budget && rx.last_used != *rx.used_idx){
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        auto& elem = rx.used_ring[rx.last_used % rx.size];
+
+        auto len    = elem.len;
+        auto packet = free_chain(rx, elem.id);
+
+        ++rx.last_used;
+        ++polled;
+
+        if(len <= sizeof(net_header)){
+            logging::logf(logging::log_level::TRACE, "virtio-net: Packet Error Length = %u\n", uint64_t(len));
+            continue;
+        }
+
+        packet->payload_size = len - sizeof(net_header);
+
+        deliver(interface, packet);
+    }
+
+    refill_rx(desc);
+
+    return polled;
+}
+
+void poll_complete(network::interface_descriptor& interface){
+    auto& desc = *static_cast<virtio_net_t*>(interface.driver_data);
+    auto& rx = desc.rx;
+
+    direct_int_lock lock;
+
+    // Ask for an interrupt on the next packet
+    desc.rx_masked = false;
+    *rx.avail_flags = 0;
+    *rx.used_event = rx.last_used;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // A packet used before the interrupts were enabled would not raise one
+    if(rx.last_used != *rx.used_idx){
+        mask_rx(desc);
+
+        interface.schedule_poll();
+    }
+}
+
+void send_packet(network::interface_descriptor& interface, network::packet_p& packet){
+    logging::logf(logging::log_level::TRACE, "virtio-net: Start transmitting packet (%p)\n", packet.get());
+
+    auto* ether_header = reinterpret_cast<network::ethernet::header*>(packet->payload);
+
+    // Shortcut packet to self directly to the rx queue
+    if(network::ethernet::mac6_to_mac64(ether_header->target.mac) == interface.mac_address){
+        {
+            direct_int_lock lock;
+
+            interface.receive(packet);
+        }
+
+        logging::logf(logging::log_level::TRACE, "virtio-net: Packet to self transmitted correctly\n");
+
+        return;
+    }
+
+    auto& desc = *reinterpret_cast<virtio_net_t*>(interface.driver_data);
+    auto& tx = desc.tx;
+
+    // The TX queue is only used by the TX thread, the completions are
+    // collected lazily, without interrupts
+    reclaim_tx(desc);
+
+    while(tx.num_free < max_chain){
+        desc.tx_sem.claim();
+        desc.tx_waiting = true;
+
+        // Ask for an interrupt on the next completion
+        if(desc.event_idx){
+            *tx.used_event = tx.last_used;
+        } else {
+            *tx.avail_flags = 0;
+        }
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        reclaim_tx(desc);
+
+        if(tx.num_free >= max_chain){
+            desc.tx_waiting = false;
+            break;
+        }
+
+        desc.tx_sem.wait();
+
+        reclaim_tx(desc);
+    }
+
+    // Push the interrupt threshold as far away as possible
+    if(desc.event_idx){
+        *tx.used_event = tx.last_used - 1;
+    } else {
+        *tx.avail_flags = AVAIL_F_NO_INTERRUPT;
+    }
+
+    add_chain(tx, packet, packet->payload_size, false);
+
+    // Batching is done by the TX thread draining its ring, but the
+    // device only wants a notification when it is idle
+    kick(desc, tx);
+}
+
+std::string sysfs_interrupts(void* data){
+    return std::to_string(static_cast<virtio_net_t*>(data)->interrupts);
+}
+
+std::string sysfs_kicks(void* data){
+    return std::to_string(static_cast<virtio_net_t*>(data)->kicks);
+}
+
+std::string sysfs_suppressed_kicks(void* data){
+    return std::to_string(static_cast<virtio_net_t*>(data)->suppressed_kicks);
+}
+
+} //end of anonymous namespace
+
+bool virtio_net::is_supported(pci::device_descriptor& pci_device){
+    // Only the transitional device has the legacy interface
+    return pci_device.vendor_id == 0x1AF4 && pci_device.device_id == 0x1000;
+}
+
+void virtio_net::init_driver(network::interface_descriptor& interface, pci::device_descriptor& pci_device){
+    logging::logf(logging::log_level::TRACE, "virtio-net: Initialize virtio-net driver on pci:%u:%u:%u\n", uint64_t(pci_device.bus), uint64_t(pci_device.device), uint64_t(pci_device.function));
+
+    virtio_net_t* desc = new virtio_net_t();
+
+    interface.driver_data = desc;
+    interface.hw_send = send_packet;
+    interface.hw_poll = poll_packets;
+    interface.hw_poll_complete = poll_complete;
+
+    desc->rx_masked = false;
+    desc->tx_waiting = false;
+    desc->tx_sem.init(0);
+
+    // 1. Enable PCI Bus Mastering (allows DMA)
+
+    auto command_register = pci::read_config_dword(pci_device.bus, pci_device.device, pci_device.function, 0x4);
+    command_register |= 0x4; // Set Bus Mastering Bit
+    pci::write_config_dword(pci_device.bus, pci_device.device, pci_device.function, 0x4, command_register);
+
+    // 2. Get the I/O base address
+
+    auto iobase = pci::read_config_dword(pci_device.bus, pci_device.device, pci_device.function, 0x10) & (~0x3);
+    desc->iobase = iobase;
+
+    logging::logf(logging::log_level::TRACE, "virtio-net: I/O Base address :%h\n", uint64_t(iobase));
+
+    // 3. Reset the device and acknowledge it
+
+    out_byte(iobase + DEVICE_STATUS, 0);
+    out_byte(iobase + DEVICE_STATUS, STATUS_ACKNOWLEDGE);
+    out_byte(iobase + DEVICE_STATUS, STATUS_ACKNOWLEDGE | STATUS_DRIVER);
+
+    // 4. Negotiate the features
+
+    auto features = in_dword(iobase + DEVICE_FEATURES);
+    auto guest_features = features & (F_MAC | F_EVENT_IDX);
+
+    out_dword(iobase + GUEST_FEATURES, guest_features);
+
+    desc->event_idx = guest_features & F_EVENT_IDX;
+
+    logging::logf(logging::log_level::TRACE, "virtio-net: Features :%h (event index: %u)\n", uint64_t(features), uint64_t(desc->event_idx));
+
+    // 5. Setup the queues
+
+    if(!setup_queue(*desc, desc->rx, rx_queue_index) || !setup_queue(*desc, desc->tx, tx_queue_index)){
+        out_byte(iobase + DEVICE_STATUS, STATUS_FAILED);
+        interface.enabled = false;
+        return;
+    }
+
+    if(!desc->event_idx){
+        // Without event index, only the flags can suppress the interrupts
+        *desc->tx.avail_flags = AVAIL_F_NO_INTERRUPT;
+    }
+
+    // 6. Register IRQ handler
+
+    auto irq = pci::read_config_dword(pci_device.bus, pci_device.device, pci_device.function, 0x3c) & 0xFF;
+    if(!interrupt::register_irq_handler(irq, packet_handler, desc)){
+        logging::logf(logging::log_level::ERROR, "virtio-net: Unable to register IRQ handler %u\n", irq);
+    }
+
+    logging::logf(logging::log_level::TRACE, "virtio-net: IRQ :%u\n", uint64_t(irq));
+
+    // 7. Get the mac address
+
+    size_t mac = 0;
+
+    if(guest_features & F_MAC){
+        for(size_t i = 0; i < 6; ++i){
+            mac |= uint64_t(in_byte(iobase + NET_MAC + i)) << ((5 - i) * 8);
+        }
+    } else {
+        logging::logf(logging::log_level::ERROR, "virtio-net: The device has no MAC address\n");
+    }
+
+    interface.mac_address = mac;
+
+    logging::logf(logging::log_level::TRACE, "virtio-net: MAC Address %h \n", mac);
+}
+
+void virtio_net::finalize_driver(network::interface_descriptor& interface){
+    auto* desc = static_cast<virtio_net_t*>(interface.driver_data);
+    desc->interface = &interface;
+
+    out_byte(desc->iobase + DEVICE_STATUS, STATUS_ACKNOWLEDGE | STATUS_DRIVER | STATUS_DRIVER_OK);
+
+    // The receive buffers can only be given once the interface is known
+    {
+        direct_int_lock lock;
+
+        refill_rx(*desc);
+    }
+
+    auto p = path("/net") / interface.name / "virtio";
+
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "interrupts", sysfs_interrupts, desc);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "kicks", sysfs_kicks, desc);
+    sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "suppressed_kicks", sysfs_suppressed_kicks, desc);
+}
@@ -0,0 +1,221 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithms.hpp>
+
+#include "fpu.hpp"
+#include "arch.hpp"
+#include "scheduler.hpp"
+#include "kalloc.hpp"
+#include "logging.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
+
+namespace {
+
+enum class save_mode : char {
+    FXSAVE,
+    XSAVE,
+    XSAVEOPT
+};
+
+constexpr const size_t AREA_ALIGNMENT   = 64;  ///< XSAVE needs 64 bytes alignment
+constexpr const size_t FXSAVE_AREA_SIZE = 512; ///< The size of the legacy area
+
+constexpr const uint64_t XCR0_X87 = 1 << 0;
+constexpr const uint64_t XCR0_SSE = 1 << 1;
+constexpr const uint64_t XCR0_AVX = 1 << 2;
+
+constexpr const uint16_t DEFAULT_FCW   = 0x37F;  ///< All x87 exceptions masked
+constexpr const uint32_t DEFAULT_MXCSR = 0x1F80; ///< All SSE exceptions masked
+
+save_mode mode = save_mode::FXSAVE;
+uint64_t xcr0 = 0;
+size_t _area_size = FXSAVE_AREA_SIZE;
+
+volatile size_t owner = scheduler::INVALID_PID; ///< The process whose state is in the registers
+volatile bool ts = false;                       ///< Indicates if CR0.TS is set
+volatile uint64_t restores = 0;                 ///< The number of lazy restores
+
+void set_ts(){
+    size_t cr0;
+    asm volatile("mov %0, cr0" : "=r" (cr0));
+    asm volatile("mov cr0, %0" : : "r" (cr0 | 0x8));
+    ts = true;
+}
+
+void clear_ts(){
+    asm volatile("clts");
+    ts = false;
+}
+
+char* aligned_area(char* area){
+    return reinterpret_cast<char*>((reinterpret_cast<size_t>(area) + AREA_ALIGNMENT - 1) & ~(AREA_ALIGNMENT - 1));
+}
+
+void save(char* area){
+    uint32_t low  = xcr0 & 0xFFFFFFFF;
+    uint32_t high = xcr0 >> 32;
+
+    switch(mode){
+        case save_mode::XSAVEOPT:
+            asm volatile("xsaveopt64 [%0]" : : "r" (area), "a" (low), "d" (high) : "memory");
+            break;
+        case save_mode::XSAVE:
+            asm volatile("xsave64 [%0]" : : "r" (area), "a" (low), "d" (high) : "memory");
+            break;
+        case save_mode::FXSAVE:
+            asm volatile("fxsave64 [%0]" : : "r" (area) : "memory");
+            break;
+    }
+}
+
+void restore(char* area){
+    uint32_t low  = xcr0 & 0xFFFFFFFF;
+    uint32_t high = xcr0 >> 32;
+
+    if(mode == save_mode::FXSAVE){
+        asm volatile("fxrstor64 [%0]" : : "r" (area) : "memory");
+    } else {
+        asm volatile("xrstor64 [%0]" : : "r" (area), "a" (low), "d" (high) : "memory");
+    }
+}
+
+char* allocate_area(){
+    auto area = reinterpret_cast<char*>(kalloc::k_malloc(_area_size + AREA_ALIGNMENT));
+    auto state = aligned_area(area);
+
+    // An empty XSAVE header puts every component in its initial state, only
+    // the legacy control registers need to be valid
+    std::fill_n(state, _area_size, 0);
+    *reinterpret_cast<uint16_t*>(state) = DEFAULT_FCW;
+    *reinterpret_cast<uint32_t*>(state + 24) = DEFAULT_MXCSR;
+
+    return area;
+}
+
+const char* mode_name(){
+    switch(mode){
+        case save_mode::XSAVEOPT:
+            return "xsaveopt";
+        case save_mode::XSAVE:
+            return "xsave";
+        case save_mode::FXSAVE:
+            return "fxsave";
+    }
+
+    return "unknown";
+}
+
+std::string sysfs_restores(){
+    return std::to_string(restores);
+}
+
+} //end of anonymous namespace
+
+extern "C" {
+
+void _nm_handler(){
+    // The current process is now allowed to use the FPU
+    clear_ts();
+
+    auto pid = scheduler::get_pid();
+
+    if(owner == pid){
+        return;
+    }
+
+    if(owner != scheduler::INVALID_PID){
+        save(aligned_area(scheduler::get_process(owner).fpu_area));
+    }
+
+    auto& process = scheduler::get_process(pid);
+
+    if(!process.fpu_area){
+        process.fpu_area = allocate_area();
+    }
+
+    restore(aligned_area(process.fpu_area));
+
+    owner = pid;
+    ++restores;
+}
+
+} //end of extern "C"
+
+void fpu::init(){
+    uint32_t eax, ebx, ecx, edx;
+    arch::cpuid(1, 0, eax, ebx, ecx, edx);
+
+    if(ecx & (1 << 26)){
+        // Enable CR4.OSXSAVE
+        size_t cr4;
+        asm volatile("mov %0, cr4" : "=r" (cr4));
+        asm volatile("mov cr4, %0" : : "r" (cr4 | (1 << 18)));
+
+        xcr0 = XCR0_X87 | XCR0_SSE;
+
+        if(ecx & (1 << 28)){
+            xcr0 |= XCR0_AVX;
+        }
+
+        asm volatile("xsetbv" : : "c" (0), "a" (uint32_t(xcr0 & 0xFFFFFFFF)), "d" (uint32_t(xcr0 >> 32)));
+
+        // Size of the area for the components enabled in XCR0
+        arch::cpuid(0xD, 0, eax, ebx, ecx, edx);
+        _area_size = ebx;
+
+        arch::cpuid(0xD, 1, eax, ebx, ecx, edx);
+        mode = (eax & 1) ? save_mode::XSAVEOPT : save_mode::XSAVE;
+    }
+
+    // No process owns the FPU for now
+    set_ts();
+
+    logging::logf(logging::log_level::TRACE, "fpu: %s mode (xcr0:%h area:%u)\n", mode_name(), xcr0, _area_size);
+}
+
+void fpu::finalize(){
+    sysfs::set_constant_value(sysfs::get_sys_path(), path("/fpu/mode"), mode_name());
+    sysfs::set_constant_value(sysfs::get_sys_path(), path("/fpu/area_size"), std::to_string(_area_size));
+    sysfs::set_constant_value(sysfs::get_sys_path(), path("/fpu/avx"), (xcr0 & XCR0_AVX) ? "true" : "false");
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/fpu/restores"), &sysfs_restores);
+}
+
+void fpu::switched(size_t pid){
+    // Only trap if the state in the registers is not the one of the process
+    if(pid == owner){
+        if(ts){
+            clear_ts();
+        }
+    } else if(!ts){
+        set_ts();
+    }
+}
+
+void fpu::release(size_t pid){
+    auto& process = scheduler::get_process(pid);
+
+    {
+        direct_int_lock lock;
+
+        if(owner == pid){
+            owner = scheduler::INVALID_PID;
+        }
+    }
+
+    if(process.fpu_area){
+        kalloc::k_free(process.fpu_area);
+        process.fpu_area = nullptr;
+    }
+}
+
+size_t fpu::area_size(){
+    return _area_size;
+}
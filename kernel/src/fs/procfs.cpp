@@ -16,6 +16,8 @@
 
 #include "scheduler.hpp"
 #include "logging.hpp"
+#include "print.hpp"
+#include "system_calls.hpp"
 
 namespace {
 
@@ -34,13 +36,35 @@ size_t read(const std::string& value, char* buffer, size_t count, size_t offset,
     return 0;
 }
 
+std::string get_system_calls(const scheduler::process_stats& stats){
+    uint64_t total = 0;
+
+    for(size_t slot = 0; slot < system_call_slots_used(); ++slot){
+        total += stats.system_calls[slot];
+    }
+
+    auto value = sprintf("total %u\n", total);
+
+    // Only the system calls that were used by the process
+    for(size_t slot = 0; slot < system_call_slots_used(); ++slot){
+        if(stats.system_calls[slot]){
+            value += sprintf("%h %u\n", system_call_number(slot), size_t(stats.system_calls[slot]));
+        }
+    }
+
+    return value;
+}
+
 std::string get_value(uint64_t pid, std::string_view name){
     auto& process = pcb[pid];
+    auto& stats   = process.stats;
 
     if(name == "pid"){
         return std::to_string(process.process.pid);
     } else if(name == "ppid"){
         return std::to_string(process.process.ppid);
+    } else if(name == "tgid"){
+        return std::to_string(process.process.tgid);
     } else if(name == "state"){
         return std::to_string(static_cast<uint8_t>(process.state));
     } else if(name == "system"){
@@ -51,6 +75,26 @@ std::string get_value(uint64_t pid, std::string_view name){
         return process.process.name;
     } else if(name == "memory"){
         return std::to_string(process.process.brk_end - process.process.brk_start);
+    } else if(name == "user_ticks"){
+        return std::to_string(stats.user_ticks);
+    } else if(name == "kernel_ticks"){
+        return std::to_string(stats.kernel_ticks);
+    } else if(name == "voluntary_switches"){
+        return std::to_string(stats.voluntary_switches);
+    } else if(name == "involuntary_switches"){
+        return std::to_string(stats.involuntary_switches);
+    } else if(name == "read_bytes"){
+        return std::to_string(stats.read_bytes);
+    } else if(name == "written_bytes"){
+        return std::to_string(stats.written_bytes);
+    } else if(name == "packets_sent"){
+        return std::to_string(stats.packets_sent);
+    } else if(name == "packets_received"){
+        return std::to_string(stats.packets_received);
+    } else if(name == "page_faults"){
+        return std::to_string(stats.page_faults);
+    } else if(name == "system_calls"){
+        return get_system_calls(stats);
     } else {
         return "";
     }
@@ -63,14 +107,25 @@ void procfs::set_pcb(const scheduler::process_control_t* pcb_ptr){
 }
 
 procfs::procfs_file_system::procfs_file_system(path mp) : mount_point(mp) {
-    standard_contents.reserve(7);
+    standard_contents.reserve(18);
     standard_contents.emplace_back("pid", false, false, false, 0UL);
     standard_contents.emplace_back("ppid", false, false, false, 0UL);
+    standard_contents.emplace_back("tgid", false, false, false, 0UL);
     standard_contents.emplace_back("state", false, false, false, 0UL);
     standard_contents.emplace_back("system", false, false, false, 0UL);
     standard_contents.emplace_back("priority", false, false, false, 0UL);
     standard_contents.emplace_back("name", false, false, false, 0UL);
     standard_contents.emplace_back("memory", false, false, false, 0UL);
+    standard_contents.emplace_back("user_ticks", false, false, false, 0UL);
+    standard_contents.emplace_back("kernel_ticks", false, false, false, 0UL);
+    standard_contents.emplace_back("voluntary_switches", false, false, false, 0UL);
+    standard_contents.emplace_back("involuntary_switches", false, false, false, 0UL);
+    standard_contents.emplace_back("read_bytes", false, false, false, 0UL);
+    standard_contents.emplace_back("written_bytes", false, false, false, 0UL);
+    standard_contents.emplace_back("packets_sent", false, false, false, 0UL);
+    standard_contents.emplace_back("packets_received", false, false, false, 0UL);
+    standard_contents.emplace_back("page_faults", false, false, false, 0UL);
+    standard_contents.emplace_back("system_calls", false, false, false, 0UL);
 }
 
 procfs::procfs_file_system::~procfs_file_system(){
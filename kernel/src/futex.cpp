@@ -0,0 +1,234 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <array.hpp>
+
+#include "futex.hpp"
+#include "scheduler.hpp"
+#include "logging.hpp"
+
+#include "conc/int_lock.hpp"
+#include "conc/wait_queue.hpp"
+
+#include "fs/sysfs.hpp"
+
+#include "tlib/errors.hpp"
+
+namespace {
+
+constexpr const size_t BUCKETS = 64; ///< The number of hash buckets
+
+/*!
+ * \brief The wait queue of a single futex word
+ */
+struct futex_queue {
+    scheduler::pid_t tgid; ///< The thread group owning the word
+    size_t address;        ///< The user address of the word
+    wait_queue queue;      ///< The waiting processes
+    futex_queue* next;     ///< The next queue in the bucket (or in the free list)
+};
+
+// A process can only wait on one futex at a time, so there can never be more
+// non-empty queues than processes
+std::array<futex_queue, scheduler::MAX_PROCESS> queues;
+std::array<futex_queue*, BUCKETS> buckets;
+futex_queue* free_queues = nullptr;
+bool init = false;
+
+volatile uint64_t waits    = 0; ///< The number of blocking waits
+volatile uint64_t wakes    = 0; ///< The number of processes woken up
+volatile uint64_t timeouts = 0; ///< The number of waits that timed out
+
+void init_queues(){
+    for(auto& q : queues){
+        q.next = free_queues;
+        free_queues = &q;
+    }
+
+    init = true;
+}
+
+size_t bucket_index(scheduler::pid_t tgid, size_t address){
+    // The words are aligned on 4 bytes
+    return ((address >> 2) ^ (address >> 12) ^ (tgid * 31)) % BUCKETS;
+}
+
+futex_queue* find_queue(scheduler::pid_t tgid, size_t address){
+    auto q = buckets[bucket_index(tgid, address)];
+
+    while(q){
+        if(q->tgid == tgid && q->address == address){
+            return q;
+        }
+
+        q = q->next;
+    }
+
+    return nullptr;
+}
+
+void release_queue(futex_queue* q){
+    auto& bucket = buckets[bucket_index(q->tgid, q->address)];
+
+    if(bucket == q){
+        bucket = q->next;
+    } else {
+        auto node = bucket;
+
+        while(node->next != q){
+            node = node->next;
+        }
+
+        node->next = q->next;
+    }
+
+    q->next = free_queues;
+    free_queues = q;
+}
+
+futex_queue* get_queue(scheduler::pid_t tgid, size_t address){
+    if(auto q = find_queue(tgid, address)){
+        return q;
+    }
+
+    if(!init){
+        init_queues();
+    }
+
+    if(!free_queues){
+        return nullptr;
+    }
+
+    auto q = free_queues;
+    free_queues = q->next;
+
+    auto& bucket = buckets[bucket_index(tgid, address)];
+
+    q->tgid    = tgid;
+    q->address = address;
+    q->next    = bucket;
+
+    bucket = q;
+
+    return q;
+}
+
+std::string sysfs_waits(){
+    return std::to_string(waits);
+}
+
+std::string sysfs_wakes(){
+    return std::to_string(wakes);
+}
+
+std::string sysfs_timeouts(){
+    return std::to_string(timeouts);
+}
+
+} //end of anonymous namespace
+
+void futex::finalize(){
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/futex/waits"), &sysfs_waits);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/futex/wakes"), &sysfs_wakes);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/futex/timeouts"), &sysfs_timeouts);
+}
+
+void futex::release_group(scheduler::pid_t tgid){
+    direct_int_lock lock;
+
+    for(auto& bucket : buckets){
+        auto q = bucket;
+
+        while(q){
+            auto next = q->next;
+
+            // The killed threads have already been removed from the queues
+            if(q->tgid == tgid && q->queue.empty()){
+                release_queue(q);
+            }
+
+            q = next;
+        }
+    }
+}
+
+std::expected<void> futex::wait(size_t address, uint32_t value, size_t ms){
+    if(!address || (address & 3)){
+        return std::make_unexpected<void>(std::ERROR_INVALID_REQUEST);
+    }
+
+    auto tgid = scheduler::get_tgid();
+
+    futex_queue* q;
+
+    {
+        direct_int_lock lock;
+
+        // The check and the enqueue are atomic with respect to wake
+        if(*reinterpret_cast<volatile uint32_t*>(address) != value){
+            return std::make_unexpected<void>(std::ERROR_WOULD_BLOCK);
+        }
+
+        q = get_queue(tgid, address);
+
+        if(!q){
+            return std::make_unexpected<void>(std::ERROR_BUSY);
+        }
+
+        ++waits;
+
+        if(ms){
+            q->queue.enqueue_timeout(ms);
+        } else {
+            q->queue.enqueue();
+        }
+    }
+
+    scheduler::reschedule();
+
+    // The scheduler removes the process from the queue when the timeout is passed
+    if(ms && q->queue.timed_out()){
+        direct_int_lock lock;
+
+        // The queue may have been released and reused in the meantime
+        if(q->queue.empty() && find_queue(tgid, address) == q){
+            release_queue(q);
+        }
+
+        ++timeouts;
+
+        return std::make_unexpected<void>(std::ERROR_TIMEOUT);
+    }
+
+    return {};
+}
+
+std::expected<size_t> futex::wake(size_t address, size_t n){
+    if(!address || (address & 3)){
+        return std::make_unexpected<size_t>(std::ERROR_INVALID_REQUEST);
+    }
+
+    auto tgid = scheduler::get_tgid();
+
+    direct_int_lock lock;
+
+    auto q = find_queue(tgid, address);
+
+    if(!q){
+        return 0;
+    }
+
+    auto woken = q->queue.wake_n(n);
+
+    if(q->queue.empty()){
+        release_queue(q);
+    }
+
+    wakes += woken;
+
+    return woken;
+}
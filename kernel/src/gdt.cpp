@@ -8,6 +8,8 @@
 #include "gdt.hpp"
 #include "early_memory.hpp"
 
+const uint64_t tss_rsp0_address = early::tss_address + __builtin_offsetof(gdt::task_state_segment_t, rsp0_low);
+
 void gdt::flush_tss(){
     asm volatile("mov ax, %0; ltr ax;" : : "i" (gdt::TSS_SELECTOR + 0x3) : "rax");
 }
@@ -11,8 +11,15 @@
 #include "print.hpp"
 #include "kernel_utils.hpp"
 #include "gdt.hpp"
+#include "arch.hpp"
 #include "scheduler.hpp"
 #include "logging.hpp"
+#include "trace.hpp"
+#include "latency_histogram.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
 
 #include "isrs.hpp"
 #include "irqs.hpp"
@@ -46,11 +53,23 @@ struct idtr {
     uint64_t base;
 } __attribute__((packed));
 
+constexpr const uint32_t MSR_EFER  = 0xC0000080; ///< Extended Feature Enable Register
+constexpr const uint32_t MSR_STAR  = 0xC0000081; ///< SYSCALL/SYSRET segments
+constexpr const uint32_t MSR_LSTAR = 0xC0000082; ///< SYSCALL entry point
+constexpr const uint32_t MSR_FMASK = 0xC0000084; ///< RFLAGS bits cleared by SYSCALL
+
+constexpr const uint64_t EFER_SCE = 1 << 0; ///< SYSCALL/SYSRET enable
+
+constexpr const uint64_t RFLAGS_TF = 1 << 8;  ///< Trap flag
+constexpr const uint64_t RFLAGS_IF = 1 << 9;  ///< Interrupt flag
+constexpr const uint64_t RFLAGS_DF = 1 << 10; ///< Direction flag
+
 idt_entry idt_64[64];
 idtr idtr_64;
 
 void (*irq_handlers[16])(interrupt::syscall_regs*, void*);
 void* irq_handler_data[16];
+latency::histogram irq_latencies[16];
 void (*syscall_handlers[interrupt::SYSCALL_MAX])(interrupt::syscall_regs*);
 
 void idt_set_gate(size_t gate, void (*function)(void), uint16_t gdt_selector, idt_flags flags){
@@ -183,6 +202,18 @@ void install_syscalls(){
     idt_set_gate(interrupt::SYSCALL_FIRST+7, _syscall7, gdt::LONG_SELECTOR, {gdt::SEG_INTERRUPT_GATE, 0, 3, 1});
     idt_set_gate(interrupt::SYSCALL_FIRST+8, _syscall8, gdt::LONG_SELECTOR, {gdt::SEG_INTERRUPT_GATE, 0, 3, 1});
     idt_set_gate(interrupt::SYSCALL_FIRST+9, _syscall9, gdt::LONG_SELECTOR, {gdt::SEG_INTERRUPT_GATE, 0, 3, 1});
+
+    // The SYSCALL instruction enters directly in _syscall_fast. It uses the
+    // handler of the first system call gate.
+
+    // SYSCALL loads CS from STAR[47:32] and SYSRET loads SS and CS from
+    // STAR[63:48] + 8 and + 16
+    uint64_t star = (uint64_t(gdt::LONG_SELECTOR) << 32) | (uint64_t(gdt::LONG_SELECTOR | 0x3) << 48);
+
+    arch::write_msr(MSR_STAR, star);
+    arch::write_msr(MSR_LSTAR, reinterpret_cast<uint64_t>(&_syscall_fast));
+    arch::write_msr(MSR_FMASK, RFLAGS_IF | RFLAGS_DF | RFLAGS_TF);
+    arch::write_msr(MSR_EFER, arch::read_msr(MSR_EFER) | EFER_SCE);
 }
 
 void enable_interrupts(){
@@ -224,6 +255,38 @@ const char* exceptions_title[32] {
     "Reserved"
 };
 
+std::string sysfs_latencies(void*){
+    std::string value = "# irq count mean max log2(cycles):count...\n";
+
+    for(size_t irq = 0; irq < 16; ++irq){
+        latency::histogram h;
+
+        {
+            direct_int_lock lock;
+            h = irq_latencies[irq];
+        }
+
+        if(h.count){
+            value += std::to_string(irq);
+            value += ' ';
+            value += latency::to_string(h);
+            value += '\n';
+        }
+    }
+
+    return value;
+}
+
+size_t sysfs_clear_latencies(void*, const std::string&){
+    direct_int_lock lock;
+
+    for(auto& h : irq_latencies){
+        latency::clear(h);
+    }
+
+    return 0;
+}
+
 } //end of anonymous namespace
 
 extern "C" {
@@ -232,6 +295,12 @@ extern "C" {
     logging::logf(logging::log_level::ERROR, __VA_ARGS__);
 
 void _fault_handler(interrupt::fault_regs regs){
+    if(regs.error_no == 14){
+        ++scheduler::get_stats().page_faults;
+
+        trace::point(trace::event::PAGE_FAULT, get_cr2(), regs.rip);
+    }
+
     fault_printf("Exception %u (%s) occured\n", regs.error_no, exceptions_title[regs.error_no]);
     fault_printf("error_code=%u\n", regs.error_code);
     fault_printf("rip=%h\n", regs.rip);
@@ -277,7 +346,15 @@ void _irq_handler(interrupt::syscall_regs* regs){
 
     //If there is an handler, call it
     if(irq_handlers[regs->code]){
+        trace::point(trace::event::IRQ_ENTRY, regs->code);
+
+        // Note: The timer handler may switch to another process, in which
+        // case the latency includes the time until it is switched back
+        auto start = arch::rdtsc();
         irq_handlers[regs->code](regs, irq_handler_data[regs->code]);
+        latency::record(irq_latencies[regs->code], arch::rdtsc() - start);
+
+        trace::point(trace::event::IRQ_EXIT, regs->code);
     }
 }
 
@@ -369,6 +446,10 @@ bool interrupt::unregister_syscall_handler(size_t syscall, void (*handler)(inter
     return true;
 }
 
+void interrupt::finalize(){
+    sysfs::set_writable_value_data(sysfs::get_sys_path(), path("/kernel/stats/irqs"), &sysfs_latencies, &sysfs_clear_latencies, nullptr);
+}
+
 void interrupt::setup_interrupts(){
     install_idt();
     install_isrs();
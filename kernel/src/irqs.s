@@ -12,7 +12,6 @@
 .macro create_irq number
 .global _irq\number
 _irq\number:
-    push rax
     push \number
 
     jmp irq_common_handler
@@ -42,12 +41,17 @@ irq_common_handler:
 
     restore_kernel_segments
 
+    // The frame is interrupt::syscall_regs. The CPU aligned the stack
+    // before pushing its 5 quadwords, the 16 pushed since then leave it
+    // misaligned for the call
     mov rdi, rsp
+    sub rsp, 8
     call _irq_handler
+    add rsp, 8
 
     restore_context
 
     //Was pushed by the base handler code
-    add rsp, 16
+    add rsp, 8
 
     iretq // iret will clean the other automatically pushed stuff
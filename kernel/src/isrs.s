@@ -37,7 +37,6 @@ create_irq_dummy 3
 create_irq_dummy 4
 create_irq_dummy 5
 create_irq_dummy 6
-create_irq_dummy 7
 create_irq 8
 create_irq_dummy 9
 create_irq 10
@@ -63,6 +62,35 @@ create_irq_dummy 29
 create_irq_dummy 30
 create_irq_dummy 31
 
+// Device not available (#NM) is not a fault, it is used to lazily switch the
+// FPU state. Only the registers clobbered by a C call are saved.
+
+.global _isr7
+_isr7:
+    push rax
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push r8
+    push r9
+    push r10
+    push r11
+
+    call _nm_handler
+
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
+    pop rax
+
+    iretq
+
 isr_common_handler:
     //TODO Kernel segments should be restored
 
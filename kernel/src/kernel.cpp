@@ -20,6 +20,11 @@
 #include "interrupts.hpp"
 #include "system_calls.hpp"
 #include "arch.hpp"
+#include "fpu.hpp"
+#include "futex.hpp"
+#include "shared_page.hpp"
+#include "trace.hpp"
+#include "profiler.hpp"
 #include "vesa.hpp"
 #include "console.hpp"
 #include "print.hpp"
@@ -83,6 +88,9 @@ void kernel_main(){
     //Call global constructors
     _init();
 
+    //Prepare the lazy switching of the extended processor state
+    fpu::init();
+
     //Try to init VESA
     if(vesa::enabled() && !vesa::init()){
         vesa::disable();
@@ -100,6 +108,9 @@ void kernel_main(){
     physical_allocator::finalize();
     virtual_allocator::finalize();
     kalloc::finalize();
+    fpu::finalize();
+    futex::finalize();
+    interrupt::finalize();
 
     // Asynchronously initialized drivers
     acpi::init();
@@ -117,6 +128,13 @@ void kernel_main(){
     //Init the virtual file system
     vfs::init();
 
+    //Prepare the page shared with all the processes
+    shared_page::init();
+
+    //Prepare the tracepoints and the profiler
+    trace::init();
+    profiler::init();
+
     //Only install system calls when everything else is ready
     install_system_calls();
 
@@ -129,6 +147,7 @@ void kernel_main(){
     // Start the secondary kernel processes
     network::finalize();
     stdio::finalize();
+    logging::start_drainer();
 
     // Report some information before starting the scheduler
     logging::logf(logging::log_level::TRACE, "Allocations before start of scheduler: %u\n", kalloc::allocations());
@@ -0,0 +1,21 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "latency_histogram.hpp"
+#include "print.hpp"
+
+std::string latency::to_string(const histogram& h){
+    auto value = sprintf("%u %u %u", h.count, h.count ? h.total / h.count : 0, h.max);
+
+    for(size_t i = 0; i < buckets; ++i){
+        if(h.counts[i]){
+            value += sprintf(" %u:%u", i, h.counts[i]);
+        }
+    }
+
+    return value;
+}
@@ -18,12 +18,59 @@
 
 #include "vfs/vfs.hpp"
 
+#include "fs/sysfs.hpp"
+
+/*
+ * Once the drainer is started, the messages are not formatted by the callers.
+ * They are recorded with their arguments in a ring written without locks and
+ * the drainer task formats them, writes them to the debug output and appends
+ * them to the log file in batches.
+ *
+ * When the ring is full, the oldest messages are overwritten.
+ */
+
 namespace {
 
+constexpr const size_t ring_size  = 1024; ///< The number of records of the ring
+constexpr const size_t text_size  = 160;  ///< The text of a record (plain message or string arguments)
+constexpr const size_t max_chunks = 8;    ///< The maximum number of records of a plain message
+constexpr const size_t line_size  = 1024; ///< The maximum length of a formatted message
+constexpr const size_t batch_size = 8192; ///< The size of a batch of the log file
+constexpr const size_t drain_ms   = 20;   ///< The time between two passes of the drainer
+
+/*!
+ * \brief A message in the log ring
+ */
+struct log_record {
+    uint64_t sequence;                ///< 2 * position + 2 once written, odd while being written
+    const char* format;               ///< The format of the message, nullptr for a plain message
+    uint64_t pid;                     ///< The process that logged the message
+    uint64_t args[logging::max_args]; ///< The arguments of the message
+    logging::log_level level;         ///< The level of the message
+    bool raw;                         ///< Indicates if the message is written without prefix
+    uint8_t strings;                  ///< The arguments that are offsets in the text (one bit per argument)
+    char text[text_size];             ///< The plain message or the copied string arguments
+};
+
+static_assert(sizeof(log_record) == 256, "A log record should fit in four cache lines");
+
 bool early_mode = true;
 bool file = false;
 
-std::string buffer;
+log_record* ring = nullptr;       ///< The records (nullptr until the drainer is started)
+volatile uint64_t head = 0;       ///< The next position to write
+uint64_t tail = 0;                ///< The next position to read
+bool draining = false;            ///< Indicates if the ring is being read
+scheduler::pid_t drainer_pid = 0; ///< The pid of the drainer
+
+volatile uint64_t lost = 0; ///< The messages overwritten before being read or not appended to the file
+
+// These buffers are only used while draining
+char message_buffer[line_size];
+char line_buffer[line_size + 32];
+char batch[batch_size];
+char file_batch[batch_size];
+size_t batch_length = 0;
 
 inline const char* level_to_string(logging::log_level level){
     switch(level){
@@ -48,11 +95,8 @@ void append_to_file(const char* s, size_t length){
     if(fd){
         vfs::stat_info info;
         if(vfs::stat(*fd, info)){
-            if(vfs::truncate(*fd, info.size + length + 1)){
-                std::string buffer = s;
-                buffer += '\n';
-
-                vfs::write(*fd, buffer.c_str(), buffer.size(), info.size);
+            if(vfs::truncate(*fd, info.size + length)){
+                vfs::write(*fd, s, length, info.size);
             }
         }
 
@@ -60,6 +104,291 @@ void append_to_file(const char* s, size_t length){
     }
 }
 
+void format_message(char* buffer, const char* format, const uint64_t* a){
+    sprintf_raw(buffer, line_size, format, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+}
+
+/*!
+ * \brief Write a message to the debug output (and to the file batch)
+ */
+void write_message(logging::log_level level, bool raw, uint64_t pid, const char* message, char* buffer){
+    const char* line = message;
+
+    if(!raw){
+        sprintf_raw(buffer, line_size + 32, "%s:%u: %s", level_to_string(level), pid, message);
+        line = buffer;
+    }
+
+    // Print to the virtual debugger
+    virtual_debug(line);
+
+    // The messages of the drainer itself would be appended forever
+    if(file && ring && pid != drainer_pid){
+        auto length = std::str_len(line);
+
+        if(batch_length + length <= batch_size){
+            std::copy_n(line, length, batch + batch_length);
+            batch_length += length;
+        } else {
+            ++lost;
+        }
+    }
+}
+
+void write_record(log_record& record){
+    if(!record.format){
+        write_message(record.level, record.raw, record.pid, record.text, line_buffer);
+        return;
+    }
+
+    for(size_t i = 0; i < logging::max_args; ++i){
+        if(record.strings & (1 << i)){
+            record.args[i] = reinterpret_cast<uint64_t>(record.text + record.args[i]);
+        }
+    }
+
+    format_message(message_buffer, record.format, record.args);
+    write_message(record.level, record.raw, record.pid, message_buffer, line_buffer);
+}
+
+/*!
+ * \brief Write the committed records of the ring
+ * \return false if the ring was already being read
+ */
+bool drain(){
+    if(__atomic_test_and_set(&draining, __ATOMIC_ACQUIRE)){
+        return false;
+    }
+
+    log_record record;
+
+    while(true){
+        auto current = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+        if(tail == current){
+            break;
+        }
+
+        // Skip what has been overwritten
+        if(current - tail > ring_size){
+            lost += current - tail - ring_size;
+            tail = current - ring_size;
+        }
+
+        auto& slot    = ring[tail % ring_size];
+        auto expected = 2 * tail + 2;
+        auto sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+
+        // The record is still being written
+        if(sequence < expected){
+            break;
+        }
+
+        record = slot;
+
+        // The record was overwritten before or while it was copied
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(sequence != expected || __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != expected){
+            ++lost;
+            ++tail;
+            continue;
+        }
+
+        ++tail;
+
+        write_record(record);
+    }
+
+    __atomic_clear(&draining, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void write_batch(){
+    if(__atomic_test_and_set(&draining, __ATOMIC_ACQUIRE)){
+        return;
+    }
+
+    auto length = batch_length;
+
+    std::copy_n(batch, length, file_batch);
+    batch_length = 0;
+
+    __atomic_clear(&draining, __ATOMIC_RELEASE);
+
+    // The file is written without blocking the writers of the ring
+    if(length){
+        append_to_file(file_batch, length);
+    }
+}
+
+void drainer_thread(){
+    while(true){
+        drain();
+
+        if(file){
+            write_batch();
+        }
+
+        scheduler::sleep_ms(drain_ms);
+    }
+}
+
+log_record& begin_record(uint64_t position){
+    auto& record = ring[position % ring_size];
+
+    __atomic_store_n(&record.sequence, 2 * position + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return record;
+}
+
+void commit_record(log_record& record, uint64_t position){
+    __atomic_store_n(&record.sequence, 2 * position + 2, __ATOMIC_RELEASE);
+}
+
+/*!
+ * \brief Record a plain message, in several records if necessary
+ */
+void record_text(logging::log_level level, bool raw, const char* s){
+    auto length = std::str_len(s);
+    auto chunks = std::min(length / (text_size - 1) + 1, max_chunks);
+
+    // The records of a message are consecutive
+    auto position = __atomic_fetch_add(&head, chunks, __ATOMIC_RELAXED);
+    auto pid      = scheduler::get_pid();
+
+    for(size_t i = 0; i < chunks; ++i){
+        auto& record = begin_record(position + i);
+
+        auto chunk = std::min(length - std::min(length, i * (text_size - 1)), text_size - 1);
+
+        record.format  = nullptr;
+        record.pid     = pid;
+        record.level   = level;
+        record.raw     = raw || i > 0;
+        record.strings = 0;
+
+        std::copy_n(s + i * (text_size - 1), chunk, record.text);
+        record.text[chunk] = '\0';
+
+        commit_record(record, position + i);
+    }
+}
+
+/*!
+ * \brief Record a message with its arguments. The string arguments are
+ * copied in the record since they may not live until the message is written.
+ */
+void record_args(logging::log_level level, bool raw, const char* format, const uint64_t* args, size_t n){
+    auto position = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    auto& record  = begin_record(position);
+
+    record.format  = format;
+    record.pid     = scheduler::get_pid();
+    record.level   = level;
+    record.raw     = raw;
+    record.strings = 0;
+
+    for(size_t i = 0; i < logging::max_args; ++i){
+        record.args[i] = i < n ? args[i] : 0;
+    }
+
+    size_t used = 0;
+    size_t a    = 0;
+
+    // Find the string arguments, the same way as the formatting
+    for(size_t i = 0; format[i] && a < n; ++i){
+        if(format[i] != '%'){
+            continue;
+        }
+
+        ++i;
+
+        while(format[i] >= '0' && format[i] <= '9'){
+            ++i;
+        }
+
+        bool variable_length = false;
+
+        if(format[i] == '.'){
+            ++i;
+
+            if(format[i] == '*'){
+                variable_length = true;
+                ++a;
+                ++i;
+            } else {
+                while(format[i] >= '0' && format[i] <= '9'){
+                    ++i;
+                }
+            }
+        }
+
+        auto ch = format[i];
+
+        if(!ch){
+            break;
+        }
+
+        if(ch == 's'){
+            if(a < n && args[a]){
+                auto* source = reinterpret_cast<const char*>(args[a]);
+                auto length  = variable_length ? args[a - 1] : std::str_len(source);
+                auto copied  = std::min(length, text_size - 1 - used);
+
+                std::copy_n(source, copied, record.text + used);
+                record.text[used + copied] = '\0';
+
+                record.args[a] = used;
+                record.strings |= 1 << a;
+
+                if(variable_length){
+                    record.args[a - 1] = copied;
+                }
+
+                used += copied + 1;
+            }
+
+            ++a;
+        } else if(ch == 'd' || ch == 'u' || ch == 'h' || ch == 'x' || ch == 'p' || ch == 'm' || ch == 'b' || ch == 'B'){
+            ++a;
+        }
+    }
+
+    commit_record(record, position);
+}
+
+void write_direct(logging::log_level level, bool raw, const char* message){
+    char buffer[line_size + 32];
+    write_message(level, raw, scheduler::get_pid(), message, buffer);
+}
+
+void log_direct(logging::log_level level, bool raw, const char* format, const uint64_t* args, size_t n){
+    if(early_mode){
+        return;
+    }
+
+    uint64_t all_args[logging::max_args];
+
+    for(size_t i = 0; i < logging::max_args; ++i){
+        all_args[i] = i < n ? args[i] : 0;
+    }
+
+    char buffer[line_size];
+    format_message(buffer, format, all_args);
+
+    write_direct(level, raw, buffer);
+}
+
+std::string sysfs_records(){
+    return std::to_string(head);
+}
+
+std::string sysfs_lost(){
+    return std::to_string(lost);
+}
+
 } //end of anonymous namespace
 
 bool logging::is_early(){
@@ -89,84 +418,112 @@ void logging::finalize(){
 }
 
 void logging::to_file(){
-    thor_assert(false, "logging to file needs revision");
-
-    //Starting from there, the messages will be sent to the log file
+    //Starting from there, the messages will be appended to the log file by the drainer
     file = true;
 }
 
-// Versions with log_level
-
-void logging::log(log_level level, const char* s){
-    if(!is_early()){
-        // Get a nice message
-        char buffer[1024];
-        sprintf_raw(buffer, 1024, "%s:%u: %s", level_to_string(level), scheduler::get_pid(), s);
+void logging::start_drainer(){
+    ring = new log_record[ring_size];
 
-        // Print to the virtual debugger
-        virtual_debug(buffer);
+    for(size_t i = 0; i < ring_size; ++i){
+        ring[i].sequence = 0;
     }
 
-    if(is_file()){
-        append_to_file(s, std::str_len(s));
+    // The messages logged before are already written
+    tail = head;
+
+    auto& process = scheduler::create_kernel_task("log_drainer", new char[scheduler::user_stack_size], new char[scheduler::kernel_stack_size], &drainer_thread);
+
+    process.ppid     = 1;
+    process.priority = scheduler::DEFAULT_PRIORITY;
+
+    drainer_pid = process.pid;
+
+    scheduler::queue_system_process(process.pid);
+
+    sysfs::set_constant_value(sysfs::get_sys_path(), path("/logging/level"), level_to_string(min_level));
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/logging/records"), &sysfs_records);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/logging/lost"), &sysfs_lost);
+}
+
+void logging::flush(){
+    if(ring){
+        drain();
     }
 }
 
-void logging::log(log_level level, const std::string& s){
-    thor_assert(!is_early(), "log(level,string) is not valid in early mode");
+// Versions with log_level
 
-    log(level, s.c_str());
-}
+void logging::log_message(log_level level, const char* s){
+    if(is_early()){
+        return;
+    }
 
-void logging::logf(log_level level, const char* s, va_list va){
-    char buffer[1024];
-    vsprintf_raw(buffer, 1024, s, va);
-    log(level, buffer);
+    if(!ring){
+        write_direct(level, false, s);
+        return;
+    }
+
+    record_text(level, false, s);
+
+    // Make sure the errors are visible right away
+    if(level >= log_level::ERROR){
+        flush();
+    }
 }
 
-void logging::logf(log_level level, const char* s, ...){
-    va_list va;
-    va_start(va, s);
+void logging::log_args(log_level level, const char* format, const uint64_t* args, size_t n){
+    if(!ring){
+        log_direct(level, false, format, args, n);
+        return;
+    }
 
-    char buffer[1024];
-    vsprintf_raw(buffer, 1024, s, va);
-    log(level, buffer);
+    record_args(level, false, format, args, n);
 
-    va_end(va);
+    // Make sure the errors are visible right away
+    if(level >= log_level::ERROR){
+        flush();
+    }
+}
+
+void logging::logf(log_level level, const char* s, va_list va){
+    if(enabled(level)){
+        char buffer[line_size];
+        vsprintf_raw(buffer, line_size, s, va);
+        log_message(level, buffer);
+    }
 }
 
 // Versions without log_level
 
 void logging::log(const char* s){
-    if(!is_early()){
-        // Print to the virtual debugger
-        virtual_debug(s);
+    if(is_early()){
+        return;
     }
 
-    if(is_file()){
-        append_to_file(s, std::str_len(s));
+    if(!ring){
+        write_direct(log_level::USER, true, s);
+        return;
     }
+
+    record_text(log_level::USER, true, s);
 }
 
 void logging::log(const std::string& s){
-    thor_assert(!is_early(), "log(level,string) is not valid in early mode");
-
     log(s.c_str());
 }
 
-void logging::logf(const char* s, va_list va){
-    char buffer[1024];
-    vsprintf_raw(buffer, 1024, s, va);
-    log(buffer);
-}
+void logging::log_args(const char* format, const uint64_t* args, size_t n){
+    if(!ring){
+        log_direct(log_level::USER, true, format, args, n);
+        return;
+    }
 
-void logging::logf(const char* s, ...){
-    va_list va;
-    va_start(va, s);
+    record_args(log_level::USER, true, format, args, n);
+}
 
-    char buffer[1024];
-    vsprintf_raw(buffer, 1024, s, va);
+void logging::logf(const char* s, va_list va){
+    char buffer[line_size];
+    vsprintf_raw(buffer, line_size, s, va);
     log(buffer);
-
-    va_end(va);
 }
@@ -10,33 +10,239 @@
 #include "net/arp_cache.hpp"
 #include "net/arp_layer.hpp"
 #include "net/ethernet_layer.hpp"
+#include "net/network.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
 
 #include "logging.hpp"
 #include "kernel_utils.hpp"
 #include "assert.hpp"
 #include "timer.hpp"
 
+namespace {
+
+volatile uint64_t hits        = 0; ///< The lookups answered by a resolved entry
+volatile uint64_t misses      = 0; ///< The lookups that started a resolution
+volatile uint64_t requests    = 0; ///< The requests sent (including the retries)
+volatile uint64_t coalesced   = 0; ///< The lookups of a neighbour already being resolved
+volatile uint64_t parked      = 0; ///< The packets parked until a resolution
+volatile uint64_t dropped     = 0; ///< The parked packets that were dropped
+volatile uint64_t failures    = 0; ///< The resolutions that failed after all the requests
+volatile uint64_t expirations = 0; ///< The resolved entries that expired
+volatile uint64_t evictions   = 0; ///< The entries evicted to make room for another neighbour
+volatile uint64_t used        = 0; ///< The number of entries in use
+
+std::string sysfs_hits(){
+    return std::to_string(hits);
+}
+
+std::string sysfs_misses(){
+    return std::to_string(misses);
+}
+
+std::string sysfs_requests(){
+    return std::to_string(requests);
+}
+
+std::string sysfs_coalesced(){
+    return std::to_string(coalesced);
+}
+
+std::string sysfs_parked(){
+    return std::to_string(parked);
+}
+
+std::string sysfs_dropped(){
+    return std::to_string(dropped);
+}
+
+std::string sysfs_failures(){
+    return std::to_string(failures);
+}
+
+std::string sysfs_expirations(){
+    return std::to_string(expirations);
+}
+
+std::string sysfs_evictions(){
+    return std::to_string(evictions);
+}
+
+std::string sysfs_entries(){
+    return std::to_string(used);
+}
+
+size_t bucket_index(network::ip::address ip){
+    // Knuth multiplicative hashing, the last bytes of the addresses vary the most
+    return (uint32_t(ip.raw_address * 2654435761u) >> 16) % network::arp::cache_buckets;
+}
+
+} // end of anonymous namespace
+
 network::arp::cache::cache(network::arp::layer* layer, network::ethernet::layer* parent) : arp_layer(layer), ethernet_layer(parent) {
-    // Nothing else to init
+    for(auto& entry : entries){
+        entry.state = entry_state::EMPTY;
+        entry.next  = free_entries;
+        free_entries = &entry;
+    }
+
+    for(auto& bucket : buckets){
+        bucket = nullptr;
+    }
+
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/hits"), &sysfs_hits);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/misses"), &sysfs_misses);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/requests"), &sysfs_requests);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/coalesced"), &sysfs_coalesced);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/parked"), &sysfs_parked);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/dropped"), &sysfs_dropped);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/failures"), &sysfs_failures);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/expirations"), &sysfs_expirations);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/evictions"), &sysfs_evictions);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/arp/entries"), &sysfs_entries);
+}
+
+network::arp::cache_entry* network::arp::cache::find_entry(network::ip::address ip){
+    for(auto* e = buckets[bucket_index(ip)]; e; e = e->next){
+        if(e->ip == ip){
+            return e;
+        }
+    }
+
+    return nullptr;
+}
+
+void network::arp::cache::unlink_entry(cache_entry* entry){
+    auto& bucket = buckets[bucket_index(entry->ip)];
+
+    if(bucket == entry){
+        bucket = entry->next;
+    } else {
+        auto* node = bucket;
+
+        while(node->next != entry){
+            node = node->next;
+        }
+
+        node->next = entry->next;
+    }
 }
 
-void network::arp::cache::update_cache(uint64_t mac, network::ip::address ip){
-    for(auto& entry : mac_cache){
-        if(entry.mac == mac && entry.ip == ip){
-            return;
-        } else if(entry.mac == mac || entry.ip == ip){
-            logging::logf(logging::log_level::TRACE, "arp: Update cache %h->%u.%u.%u.%u \n",
-                mac, ip(0), ip(1), ip(2), ip(3));
+/*!
+ * \brief Find room for a new neighbour, evicting the least recently used
+ * entry if necessary. The entries being resolved are never evicted.
+ */
+network::arp::cache_entry* network::arp::cache::new_entry(network::ip::address ip, uint64_t now){
+    cache_entry* entry = free_entries;
 
-            entry.mac = mac;
-            entry.ip = ip;
-            return;
+    if(entry){
+        free_entries = entry->next;
+        ++used;
+    } else {
+        for(auto& e : entries){
+            if(e.state == entry_state::INCOMPLETE){
+                continue;
+            }
+
+            if(!entry || e.last_used < entry->last_used){
+                entry = &e;
+            }
         }
+
+        if(!entry){
+            return nullptr;
+        }
+
+        unlink_entry(entry);
+        ++evictions;
     }
 
-    logging::logf(logging::log_level::TRACE, "arp: Insert new entry into cache %h->%u.%u.%u.%u \n", mac, ip(0), ip(1), ip(2), ip(3));
+    entry->ip           = ip;
+    entry->mac          = unresolved_mac;
+    entry->state        = entry_state::EMPTY;
+    entry->last_used    = now;
+    entry->requests     = 0;
+    entry->parked_count = 0;
+
+    auto& bucket = buckets[bucket_index(ip)];
 
-    mac_cache.emplace_back(mac, ip);
+    entry->next = bucket;
+    bucket      = entry;
+
+    return entry;
+}
+
+void network::arp::cache::enqueue_packet(cache_entry& entry, network::packet_p& packet){
+    // Keep the most recent packets
+    if(entry.parked_count == max_parked){
+        ++dropped;
+
+        for(size_t i = 1; i < max_parked; ++i){
+            entry.parked[i - 1] = std::move(entry.parked[i]);
+        }
+
+        --entry.parked_count;
+    }
+
+    entry.parked[entry.parked_count++] = std::move(packet);
+    ++parked;
+}
+
+void network::arp::cache::send_resolved(network::packet_p& packet, uint64_t mac){
+    auto* ether_header = reinterpret_cast<network::ethernet::header*>(packet->payload);
+    network::ethernet::mac64_to_mac6(mac, ether_header->target.mac);
+
+    ethernet_layer->finalize_packet(network::interface(packet->interface), packet);
+}
+
+void network::arp::cache::update_cache(uint64_t mac, network::ip::address ip, bool create){
+    std::array<network::packet_p, max_parked> packets;
+    size_t count = 0;
+
+    {
+        direct_int_lock lock;
+
+        auto now    = timer::milliseconds();
+        auto* entry = find_entry(ip);
+
+        if(!entry){
+            // Only the neighbours talking to us are added to the cache
+            if(!create){
+                return;
+            }
+
+            entry = new_entry(ip, now);
+
+            if(!entry){
+                return;
+            }
+
+            logging::logf(logging::log_level::TRACE, "arp: Insert new entry into cache %h->%u.%u.%u.%u \n", mac, ip(0), ip(1), ip(2), ip(3));
+        } else if(entry->state != entry_state::REACHABLE || entry->mac != mac){
+            logging::logf(logging::log_level::TRACE, "arp: Update cache %h->%u.%u.%u.%u \n", mac, ip(0), ip(1), ip(2), ip(3));
+        }
+
+        if(entry->state == entry_state::INCOMPLETE){
+            --incomplete;
+        }
+
+        entry->mac     = mac;
+        entry->state   = entry_state::REACHABLE;
+        entry->expires = now + reachable_time;
+
+        for(size_t i = 0; i < entry->parked_count; ++i){
+            packets[i] = std::move(entry->parked[i]);
+        }
+
+        count = entry->parked_count;
+        entry->parked_count = 0;
+    }
+
+    for(size_t i = 0; i < count; ++i){
+        send_resolved(packets[i], mac);
+    }
 }
 
 std::expected<void> network::arp::cache::arp_request(network::interface_descriptor& interface, network::ip::address ip){
@@ -61,6 +267,8 @@ std::expected<void> network::arp::cache::arp_request(network::interface_descript
         network::arp::ip_to_ip2(interface.ip_address, arp_request_header->source_protocol_addr);
         network::arp::ip_to_ip2(ip, arp_request_header->target_protocol_addr);
 
+        ++requests;
+
         ethernet_layer->finalize_packet(interface, packet);
 
         return {};
@@ -69,59 +277,79 @@ std::expected<void> network::arp::cache::arp_request(network::interface_descript
     }
 }
 
-bool network::arp::cache::is_mac_cached(uint64_t mac) const {
-    for(auto& entry : mac_cache){
-        if(entry.mac == mac){
-            return true;
-        }
-    }
+bool network::arp::cache::is_ip_cached(network::ip::address ip){
+    direct_int_lock lock;
 
-    return false;
+    auto* entry = find_entry(ip);
+
+    return entry && entry->state == entry_state::REACHABLE && timer::milliseconds() < entry->expires;
 }
 
-bool network::arp::cache::is_ip_cached(network::ip::address ip) const {
-    for(auto& entry : mac_cache){
-        if(entry.ip == ip){
-            return true;
-        }
-    }
+uint64_t network::arp::cache::get_mac(network::ip::address ip){
+    direct_int_lock lock;
 
-    return false;
-}
+    auto* entry = find_entry(ip);
 
-network::ip::address network::arp::cache::get_ip(uint64_t mac) const {
-    thor_assert(is_mac_cached(mac), "The MAC is not cached in the ARP table");
+    thor_assert(entry && entry->state == entry_state::REACHABLE, "The IP is not cached in the ARP table");
 
-    for(auto& entry : mac_cache){
-        if(entry.mac == mac){
-            return entry.ip;
-        }
+    return entry->mac;
+}
+
+std::expected<uint64_t> network::arp::cache::resolve(network::interface_descriptor& interface, network::ip::address ip){
+    // Ask for self MAC address
+    if(interface.ip_address == ip){
+        return std::make_expected<uint64_t>(interface.mac_address);
     }
 
-    thor_unreachable("The MAC is not cached in the ARP table");
-}
+    {
+        direct_int_lock lock;
 
-uint64_t network::arp::cache::get_mac(network::ip::address ip) const {
-    thor_assert(is_ip_cached(ip), "The IP is not cached in the ARP table");
+        auto now    = timer::milliseconds();
+        auto* entry = find_entry(ip);
 
-    for(auto& entry : mac_cache){
-        if(entry.ip == ip){
-            return entry.mac;
-        }
-    }
+        if(entry){
+            entry->last_used = now;
 
-    thor_unreachable("The IP is not cached in the ARP table");
-}
+            switch(entry->state){
+                case entry_state::REACHABLE:
+                    if(now < entry->expires){
+                        ++hits;
+                        return std::make_expected<uint64_t>(entry->mac);
+                    }
 
-std::expected<uint64_t> network::arp::cache::get_mac_force(network::interface_descriptor& interface, network::ip::address ip){
-    // Check cache first
-    if(is_ip_cached(ip)){
-        return get_mac(ip);
-    }
+                    // Resolve the address again, the MAC may have changed
+                    ++expirations;
+                    break;
 
-    // Ask for self MAC address
-    if(interface.ip_address == ip){
-        return interface.mac_address;
+                case entry_state::INCOMPLETE:
+                    ++coalesced;
+                    return std::make_expected<uint64_t>(unresolved_mac);
+
+                case entry_state::FAILED:
+                    if(now < entry->expires){
+                        return std::make_expected_from_error<uint64_t>(std::ERROR_SOCKET_TIMEOUT);
+                    }
+
+                    break;
+
+                case entry_state::EMPTY:
+                    break;
+            }
+        } else {
+            entry = new_entry(ip, now);
+
+            if(!entry){
+                return std::make_expected_from_error<uint64_t>(std::ERROR_BUFFER_SMALL);
+            }
+        }
+
+        ++misses;
+        ++incomplete;
+
+        entry->state     = entry_state::INCOMPLETE;
+        entry->interface = interface.id;
+        entry->requests  = 1;
+        entry->deadline  = now + request_timeout;
     }
 
     // At this point we need to send a request for the IP
@@ -129,56 +357,131 @@ std::expected<uint64_t> network::arp::cache::get_mac_force(network::interface_de
     logging::logf(logging::log_level::TRACE, "arp: IP %u.%u.%u.%u not cached, generate ARP Request\n",
         ip(0), ip(1), ip(2), ip(3));
 
+    // If the request cannot be sent, the timer will send it again
     auto arp_result = arp_request(interface, ip);
     if(!arp_result){
-        return std::make_expected_from_error<uint64_t>(arp_result.error());
+        logging::logf(logging::log_level::ERROR, "arp: Impossible to send ARP Request: %s\n", std::error_message(arp_result.error()));
     }
 
-    while(!is_ip_cached(ip)){
-        arp_layer->wait_for_reply();
+    return std::make_expected<uint64_t>(unresolved_mac);
+}
+
+std::expected<void> network::arp::cache::park(network::interface_descriptor& interface, network::ip::address ip, network::packet_p& packet){
+    network::packet_p p;
+
+    if(packet->user){
+        // The packet will be sent from another process, needs to be copied
+        // to kernel memory
+        p = network::make_packet(packet->payload_size);
+        std::copy_n(packet->payload, packet->payload_size, p->payload);
+
+        p->index     = packet->index;
+        p->tags      = packet->tags;
+        p->interface = packet->interface;
+    } else {
+        p = packet;
     }
 
-    logging::logf(logging::log_level::TRACE, "arp: received ARP Reply\n");
+    uint64_t mac = unresolved_mac;
 
-    return get_mac(ip);
-}
+    for(size_t i = 0; i < 2; ++i){
+        {
+            direct_int_lock lock;
+
+            auto* entry = find_entry(ip);
+
+            if(entry){
+                if(entry->state == entry_state::INCOMPLETE){
+                    enqueue_packet(*entry, p);
+                    return {};
+                }
+
+                // The reply arrived since the packet was prepared
+                if(entry->state == entry_state::REACHABLE && timer::milliseconds() < entry->expires){
+                    mac = entry->mac;
+                    break;
+                }
+
+                if(entry->state == entry_state::FAILED && timer::milliseconds() < entry->expires){
+                    ++dropped;
+                    return std::make_expected_from_error<void>(std::ERROR_SOCKET_TIMEOUT);
+                }
+            }
+        }
+
+        // The entry expired or was evicted since the packet was prepared
+        auto result = resolve(interface, ip);
+
+        if(!result){
+            ++dropped;
+            return std::make_expected_from_error<void>(result.error());
+        }
 
-std::expected<uint64_t> network::arp::cache::get_mac_force(network::interface_descriptor& interface, network::ip::address ip, size_t ms){
-    // Check cache first
-    if(is_ip_cached(ip)){
-        return std::make_expected<uint64_t>(get_mac(ip));
+        if(*result != unresolved_mac){
+            mac = *result;
+            break;
+        }
     }
 
-    // Ask for self MAC address
-    if(interface.ip_address == ip){
-        return std::make_expected<uint64_t>(interface.mac_address);
+    if(mac == unresolved_mac){
+        ++dropped;
+        return std::make_expected_from_error<void>(std::ERROR_SOCKET_TIMEOUT);
     }
 
-    // At this point we need to send a request for the IP
+    send_resolved(p, mac);
 
-    logging::logf(logging::log_level::TRACE, "arp: IP %u.%u.%u.%u not cached, generate ARP Request (timeout)\n",
-        ip(0), ip(1), ip(2), ip(3));
+    return {};
+}
 
-    auto arp_result = arp_request(interface, ip);
-    if(!arp_result){
-        return std::make_expected_from_error<uint64_t>(arp_result.error());
+void network::arp::cache::timer(){
+    if(!incomplete){
+        return;
     }
 
-    auto start = timer::milliseconds();
+    std::array<network::ip::address, cache_entries> retries;
+    std::array<size_t, cache_entries> interfaces;
+    size_t n = 0;
+
+    {
+        direct_int_lock lock;
+
+        auto now = timer::milliseconds();
+
+        for(auto& entry : entries){
+            if(entry.state != entry_state::INCOMPLETE || now < entry.deadline){
+                continue;
+            }
+
+            if(entry.requests < max_requests){
+                ++entry.requests;
+                entry.deadline = now + request_timeout;
 
-    while(!is_ip_cached(ip)){
-        arp_layer->wait_for_reply(ms);
+                retries[n]    = entry.ip;
+                interfaces[n] = entry.interface;
+                ++n;
 
-        if(!is_ip_cached(ip)){
-            auto end = timer::milliseconds();
-            if(start - end > ms){
-                logging::logf(logging::log_level::TRACE, "arp: reached timeout, exiting\n");
-                return std::make_expected_from_error<uint64_t>(std::ERROR_SOCKET_TIMEOUT);
+                continue;
             }
+
+            logging::logf(logging::log_level::TRACE, "arp: No reply for %u.%u.%u.%u, giving up\n",
+                entry.ip(0), entry.ip(1), entry.ip(2), entry.ip(3));
+
+            --incomplete;
+            ++failures;
+
+            dropped += entry.parked_count;
+
+            for(size_t i = 0; i < entry.parked_count; ++i){
+                entry.parked[i] = network::packet_p();
+            }
+
+            entry.parked_count = 0;
+            entry.state        = entry_state::FAILED;
+            entry.expires      = now + failed_time;
         }
     }
 
-    logging::logf(logging::log_level::TRACE, "arp: received ARP Reply\n");
-
-    return std::make_expected<uint64_t>(get_mac(ip));
+    for(size_t i = 0; i < n; ++i){
+        arp_request(network::interface(interfaces[i]), retries[i]);
+    }
 }
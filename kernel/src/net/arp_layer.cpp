@@ -103,9 +103,10 @@ void network::arp::layer::decode(network::interface_descriptor& interface, netwo
     logging::logf(logging::log_level::TRACE, "arp: Target Protocol Address %u.%u.%u.%u \n",
         uint64_t(target_prot(0)), uint64_t(target_prot(1)), uint64_t(target_prot(2)), uint64_t(target_prot(3)));
 
-    // If not an ARP Probe, update the ARP cache
+    // If not an ARP Probe, update the ARP cache (only the neighbours
+    // talking to us are added, the others are only refreshed)
     if(source_prot.raw_address != 0x0){
-        _cache.update_cache(source_hw, source_prot);
+        _cache.update_cache(source_hw, source_prot, target_prot == interface.ip_address);
     }
 
     if(operation == 0x1){
@@ -142,19 +143,9 @@ void network::arp::layer::decode(network::interface_descriptor& interface, netwo
         }
     } else if(operation == 0x2){
         logging::logf(logging::log_level::TRACE, "arp: Handle Reply\n");
-
-        wait_queue.notify_all();
     }
 }
 
-void network::arp::layer::wait_for_reply(){
-    wait_queue.wait();
-}
-
-void network::arp::layer::wait_for_reply(size_t ms){
-    wait_queue.wait_for(ms);
-}
-
 network::arp::cache& network::arp::layer::get_cache(){
     return _cache;
 }
@@ -6,17 +6,319 @@
 //=======================================================================
 
 #include <bit_field.hpp>
+#include <array.hpp>
+#include <algorithms.hpp>
 
 #include "net/dns_layer.hpp"
+#include "net/dns_message.hpp"
 #include "net/udp_layer.hpp"
 #include "net/ip_layer.hpp"
+#include "net/network.hpp"
 
+#include "conc/int_lock.hpp"
+#include "conc/wait_queue.hpp"
+
+#include "fs/sysfs.hpp"
+
+#include "arch.hpp"
 #include "kernel_utils.hpp"
+#include "scheduler.hpp"
+#include "timer.hpp"
 
 #include "tlib/errors.hpp"
 
 namespace {
 
+constexpr const size_t CACHE_ENTRIES   = 64;    ///< The number of cached names
+constexpr const size_t CACHE_BUCKETS   = 32;    ///< The number of hash buckets
+constexpr const size_t resolver_port   = 49153; ///< The local port of the queries of the kernel
+constexpr const size_t max_ttl         = 86400; ///< The maximum time an answer is cached, in seconds
+constexpr const size_t default_neg_ttl = 30;    ///< The time a negative answer without SOA is cached, in seconds
+
+enum class entry_state {
+    EMPTY,    ///< The entry is not used
+    PENDING,  ///< A query is in flight
+    POSITIVE, ///< The address is known
+    NEGATIVE, ///< The name does not exist (or has no address)
+    FAILED    ///< The last query failed, nothing is cached
+};
+
+/*!
+ * \brief A name of the DNS cache
+ */
+struct cache_entry {
+    char name[network::dns::max_name_length + 1]; ///< The name, in lower case
+    size_t length;                               ///< The length of the name
+    entry_state state;                           ///< The state of the entry
+    network::ip::address address;                ///< The address (POSITIVE)
+    size_t error;                                ///< The error of the query (FAILED)
+    uint64_t expires;                            ///< The time at which the answer expires, in ms
+    uint64_t last_used;                          ///< The last time the entry was used, in ms
+
+    uint16_t identification; ///< The identification of the pending query
+    uint64_t generation;     ///< Incremented at each new query, to detect reuse
+    size_t tries;            ///< The number of queries sent for the pending query
+    size_t max_tries;        ///< The maximum number of queries for the pending query
+    size_t timeout;          ///< The timeout of each query, in ms
+    uint64_t deadline;       ///< The time at which the current query times out
+    network::ip::address server; ///< The server of the pending query
+
+    wait_queue queue;  ///< The processes waiting for the pending query
+    cache_entry* next; ///< The next entry in the bucket (or in the free list)
+};
+
+std::array<cache_entry, CACHE_ENTRIES> entries;
+std::array<cache_entry*, CACHE_BUCKETS> buckets;
+cache_entry* free_entries = nullptr;
+
+uint64_t identification_state = 0; ///< The state of the generator of the identifications
+bool rdrand = false;               ///< Indicates if the CPU supports RDRAND
+
+volatile uint64_t hits          = 0; ///< The resolutions answered by a positive entry
+volatile uint64_t negative_hits = 0; ///< The resolutions answered by a negative entry
+volatile uint64_t misses        = 0; ///< The resolutions that started a query
+volatile uint64_t coalesced     = 0; ///< The resolutions that waited for the query of another one
+volatile uint64_t queries       = 0; ///< The queries sent (including the retries)
+volatile uint64_t timeouts      = 0; ///< The resolutions that failed after all the tries
+volatile uint64_t evictions     = 0; ///< The entries evicted to make room for another name
+
+size_t bucket_index(const char* name, size_t length){
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    for(size_t i = 0; i < length; ++i){
+        hash ^= uint8_t(name[i]);
+        hash *= 16777619u;
+    }
+
+    return hash % CACHE_BUCKETS;
+}
+
+cache_entry* find_entry(const char* name, size_t length){
+    for(auto* e = buckets[bucket_index(name, length)]; e; e = e->next){
+        if(network::dns::names_equal(e->name, e->length, name, length)){
+            return e;
+        }
+    }
+
+    return nullptr;
+}
+
+void unlink_entry(cache_entry* entry){
+    auto& bucket = buckets[bucket_index(entry->name, entry->length)];
+
+    if(bucket == entry){
+        bucket = entry->next;
+    } else {
+        auto* node = bucket;
+
+        while(node->next != entry){
+            node = node->next;
+        }
+
+        node->next = entry->next;
+    }
+}
+
+/*!
+ * \brief Find room for a new name, evicting the least recently used entry
+ * if necessary. Entries with a pending query or waiters are never evicted.
+ */
+cache_entry* new_entry(const char* name, size_t length){
+    cache_entry* entry = free_entries;
+
+    if(entry){
+        free_entries = entry->next;
+    } else {
+        for(auto& e : entries){
+            if(e.state == entry_state::PENDING || !e.queue.empty()){
+                continue;
+            }
+
+            if(!entry || e.last_used < entry->last_used){
+                entry = &e;
+            }
+        }
+
+        if(!entry){
+            return nullptr;
+        }
+
+        unlink_entry(entry);
+        ++evictions;
+    }
+
+    for(size_t i = 0; i < length; ++i){
+        entry->name[i] = network::dns::to_lower(name[i]);
+    }
+
+    entry->name[length] = '\0';
+    entry->length       = length;
+    entry->state        = entry_state::EMPTY;
+
+    auto& bucket = buckets[bucket_index(entry->name, length)];
+
+    entry->next = bucket;
+    bucket      = entry;
+
+    return entry;
+}
+
+/*!
+ * \brief Returns a new identification for a query.
+ *
+ * A response is only accepted for a known identification, so they must not
+ * be predictable. RDRAND is used when the CPU has it, otherwise the TSC is
+ * mixed into a splitmix64 generator.
+ */
+uint16_t random_identification(){
+    if(rdrand){
+        for(size_t i = 0; i < 10; ++i){
+            uint64_t value;
+            uint8_t ok;
+
+            asm volatile("rdrand %0; setc %1" : "=r" (value), "=qm" (ok) : : "cc");
+
+            if(ok){
+                return value;
+            }
+        }
+    }
+
+    uint64_t z = (identification_state += 0x9E3779B97F4A7C15ULL ^ arch::rdtsc());
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+void start_query(cache_entry& entry, network::ip::address server, size_t timeout_ms, size_t tries, uint64_t now){
+    entry.state          = entry_state::PENDING;
+    entry.identification = random_identification();
+    entry.server         = server;
+    entry.tries          = 1;
+    entry.max_tries      = tries;
+    entry.timeout        = timeout_ms;
+    entry.deadline       = now + timeout_ms;
+
+    ++entry.generation;
+}
+
+/*!
+ * \brief Complete the pending query answered by the given message.
+ *
+ * Only the responses sent by the server of the query to the port of the
+ * resolver are accepted.
+ */
+void complete_query(const char* message, size_t length, network::ip::address source, size_t source_port, size_t target_port){
+    if(length < network::dns::header_length || source_port != 53 || target_port != resolver_port){
+        return;
+    }
+
+    auto identification = network::dns::read_16(reinterpret_cast<const uint8_t*>(message));
+
+    direct_int_lock lock;
+
+    for(auto& entry : entries){
+        if(entry.state != entry_state::PENDING || entry.identification != identification || !(entry.server == source)){
+            continue;
+        }
+
+        network::dns::response_info info;
+
+        if(!network::dns::decode_response(message, length, entry.name, entry.length, info)){
+            logging::logf(logging::log_level::DEBUG, "dns: Invalid response for %s\n", entry.name);
+            return;
+        }
+
+        auto now = timer::milliseconds();
+
+        if(info.rcode == network::dns::rcode_ok && info.address_found){
+            auto ttl = std::min(size_t(info.ttl), max_ttl);
+
+            entry.state   = entry_state::POSITIVE;
+            entry.address = network::ip::address(info.address);
+            entry.expires = now + ttl * 1000;
+        } else if(info.rcode == network::dns::rcode_nxdomain || info.rcode == network::dns::rcode_ok){
+            // The name does not exist or has no address
+            auto ttl = info.soa_found ? std::min(size_t(info.negative_ttl), max_ttl) : default_neg_ttl;
+
+            entry.state   = entry_state::NEGATIVE;
+            entry.expires = now + ttl * 1000;
+        } else {
+            // Server errors are not cached
+            entry.state = entry_state::FAILED;
+            entry.error = std::ERROR_FAILED;
+        }
+
+        entry.last_used = now;
+        entry.queue.wake_all();
+
+        return;
+    }
+}
+
+std::string sysfs_hits(){
+    return std::to_string(hits);
+}
+
+std::string sysfs_negative_hits(){
+    return std::to_string(negative_hits);
+}
+
+std::string sysfs_misses(){
+    return std::to_string(misses);
+}
+
+std::string sysfs_coalesced(){
+    return std::to_string(coalesced);
+}
+
+std::string sysfs_queries(){
+    return std::to_string(queries);
+}
+
+std::string sysfs_timeouts(){
+    return std::to_string(timeouts);
+}
+
+std::string sysfs_evictions(){
+    return std::to_string(evictions);
+}
+
+std::string sysfs_entries(){
+    std::string value;
+
+    direct_int_lock lock;
+
+    auto now = timer::milliseconds();
+
+    for(auto& entry : entries){
+        switch(entry.state){
+            case entry_state::PENDING:
+                value += entry.name;
+                value += " pending\n";
+                break;
+
+            case entry_state::POSITIVE:
+            case entry_state::NEGATIVE:
+                value += entry.name;
+                value += ' ';
+                value += entry.state == entry_state::POSITIVE ? network::ip::ip_to_str(entry.address) : "nxdomain";
+                value += " ttl:";
+                value += std::to_string(entry.expires > now ? (entry.expires - now) / 1000 : 0);
+                value += '\n';
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return value;
+}
+
 using flag_qr     = std::bit_field<uint16_t, uint8_t, 15, 1>;
 using flag_opcode = std::bit_field<uint16_t, uint8_t, 11, 4>;
 using flag_aa     = std::bit_field<uint16_t, uint8_t, 10, 1>;
@@ -89,11 +391,47 @@ std::string decode_domain(char* payload, size_t& offset) {
 
 network::dns::layer::layer(network::udp::layer* parent) : parent(parent) {
     parent->register_dns_layer(this);
+
+    for(auto& entry : entries){
+        entry.state = entry_state::EMPTY;
+        entry.next  = free_entries;
+        free_entries = &entry;
+    }
+
+    // RDRAND is indicated by the bit 30 of ECX of the leaf 1
+    uint32_t a, b, c, d;
+    arch::cpuid(1, 0, a, b, c, d);
+    rdrand = c & (1 << 30);
+
+    identification_state = arch::rdtsc();
+
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/hits"), &sysfs_hits);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/negative_hits"), &sysfs_negative_hits);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/misses"), &sysfs_misses);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/coalesced"), &sysfs_coalesced);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/queries"), &sysfs_queries);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/timeouts"), &sysfs_timeouts);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/evictions"), &sysfs_evictions);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/dns/entries"), &sysfs_entries);
 }
 
 void network::dns::layer::decode(network::interface_descriptor& /*interface*/, network::packet_p& packet) {
     packet->tag(3, packet->index);
 
+    // Complete the queries of the resolver
+    {
+        auto* ip_header  = reinterpret_cast<network::ip::header*>(packet->payload + packet->tag(1));
+        auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
+
+        size_t length = switch_endian_16(udp_header->length);
+        length = length > sizeof(network::udp::header) ? length - sizeof(network::udp::header) : 0;
+        length = std::min(length, packet->payload_size - packet->index);
+
+        network::ip::address source = switch_endian_32(ip_header->source_ip);
+
+        complete_query(packet->payload + packet->index, length, source, switch_endian_16(udp_header->source_port), switch_endian_16(udp_header->target_port));
+    }
+
     auto* dns_header = reinterpret_cast<header*>(packet->payload + packet->index);
 
     logging::logf(logging::log_level::TRACE, "dns: Start DNS packet handling\n");
@@ -224,3 +562,165 @@ std::expected<void> network::dns::layer::finalize_packet(network::interface_desc
 std::expected<void> network::dns::layer::finalize_packet(network::interface_descriptor& interface, network::socket& /*sock*/, network::packet_p& p) {
     return this->finalize_packet(interface, p);
 }
+
+std::expected<network::ip::address> network::dns::layer::resolve(const char* name, size_t length, network::ip::address server, size_t timeout_ms, size_t tries) {
+    // The root label is implicit
+    if(length && name[length - 1] == '.'){
+        --length;
+    }
+
+    if(!valid_name(name, length) || !timeout_ms || !tries){
+        return std::make_unexpected<network::ip::address>(std::ERROR_INVALID_REQUEST);
+    }
+
+    bool waited = false;
+
+    while(true){
+        cache_entry* entry;
+        uint64_t generation;
+        uint16_t identification;
+        bool send = false;
+
+        {
+            direct_int_lock lock;
+
+            auto now = timer::milliseconds();
+
+            entry = find_entry(name, length);
+
+            if(entry && (entry->state == entry_state::POSITIVE || entry->state == entry_state::NEGATIVE) && now < entry->expires){
+                entry->last_used = now;
+
+                if(entry->state == entry_state::POSITIVE){
+                    ++hits;
+                    return entry->address;
+                }
+
+                ++negative_hits;
+                return std::make_unexpected<network::ip::address>(std::ERROR_NOT_EXISTS);
+            }
+
+            if(!entry){
+                entry = new_entry(name, length);
+
+                if(!entry){
+                    return std::make_unexpected<network::ip::address>(std::ERROR_FAILED);
+                }
+            }
+
+            if(entry->state != entry_state::PENDING){
+                // Miss or expired answer
+                start_query(*entry, server, timeout_ms, tries, now);
+
+                ++misses;
+                send = true;
+            } else if(now >= entry->deadline){
+                // The query timed out, the first waiter to notice it sends it again
+                if(entry->tries >= entry->max_tries){
+                    entry->state = entry_state::FAILED;
+                    entry->error = std::ERROR_SOCKET_TIMEOUT;
+
+                    ++timeouts;
+
+                    entry->queue.wake_all();
+
+                    return std::make_unexpected<network::ip::address>(std::ERROR_SOCKET_TIMEOUT);
+                }
+
+                ++entry->tries;
+                entry->deadline = now + entry->timeout;
+
+                send = true;
+            } else if(!waited){
+                ++coalesced;
+            }
+
+            entry->last_used = now;
+
+            generation     = entry->generation;
+            identification = entry->identification;
+            server         = entry->server;
+        }
+
+        if(send){
+            ++queries;
+
+            auto status = send_query(name, length, identification, server);
+
+            if(!status){
+                direct_int_lock lock;
+
+                if(entry->generation == generation && entry->state == entry_state::PENDING){
+                    entry->state = entry_state::FAILED;
+                    entry->error = status.error();
+                    entry->queue.wake_all();
+                }
+
+                return std::make_unexpected<network::ip::address>(status.error());
+            }
+        }
+
+        {
+            direct_int_lock lock;
+
+            // The check and the enqueue are atomic with respect to the response
+            if(entry->generation == generation && entry->state == entry_state::PENDING){
+                auto now = timer::milliseconds();
+
+                entry->queue.enqueue_timeout(entry->deadline > now ? entry->deadline - now : 1);
+            }
+        }
+
+        scheduler::reschedule();
+
+        waited = true;
+
+        {
+            direct_int_lock lock;
+
+            // The answer of the query is used even if its TTL is zero
+            if(entry->generation == generation){
+                switch(entry->state){
+                    case entry_state::POSITIVE:
+                        return entry->address;
+
+                    case entry_state::NEGATIVE:
+                        return std::make_unexpected<network::ip::address>(std::ERROR_NOT_EXISTS);
+
+                    case entry_state::FAILED:
+                        return std::make_unexpected<network::ip::address>(entry->error);
+
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+std::expected<void> network::dns::layer::send_query(const char* name, size_t length, uint16_t identification, network::ip::address server) {
+    char query[max_name_length + 2 + header_length + 4];
+
+    auto size = encode_query(query, sizeof(query), identification, name, length);
+
+    if(!size){
+        return std::make_unexpected<void>(std::ERROR_INVALID_REQUEST);
+    }
+
+    auto& interface = network::select_interface(server);
+
+    network::udp::kernel_packet_descriptor desc{size, resolver_port, 53, server};
+    auto packet_e = parent->kernel_prepare_packet(interface, desc);
+
+    if(!packet_e){
+        return std::make_unexpected<void>(packet_e.error());
+    }
+
+    auto& packet = *packet_e;
+
+    std::copy_n(query, size, packet->payload + packet->index);
+
+    logging::logf(logging::log_level::TRACE, "dns: Query %s (id %u)\n", name, size_t(identification));
+
+    return parent->finalize_packet(interface, packet);
+}
@@ -127,7 +127,7 @@ void network::ethernet::layer::decode(network::interface_descriptor& interface,
 std::expected<network::packet_p> network::ethernet::layer::kernel_prepare_packet(network::interface_descriptor& interface, const packet_descriptor& descriptor){
     auto total_size = descriptor.size + sizeof(header);
 
-    auto p = std::make_shared<network::packet>(new char[total_size], total_size);
+    auto p = network::make_packet(total_size);
 
     ::prepare_packet(*p, interface, descriptor);
 
@@ -137,8 +137,7 @@ std::expected<network::packet_p> network::ethernet::layer::kernel_prepare_packet
 std::expected<network::packet_p> network::ethernet::layer::user_prepare_packet(char* buffer, network::interface_descriptor& interface, const packet_descriptor* descriptor){
     auto total_size = descriptor->size + sizeof(header);
 
-    auto p = std::make_shared<network::packet>(buffer, total_size);
-    p->user = true;
+    auto p = network::make_user_packet(buffer, total_size);
 
     ::prepare_packet(*p, interface, *descriptor);
 
@@ -150,7 +149,7 @@ std::expected<void> network::ethernet::layer::finalize_packet(network::interface
         // The packet will be handled by a kernel thread, needs to
         // be copied to kernel memory
 
-        auto kernel_packet = std::make_shared<network::packet>(new char[p->payload_size], p->payload_size);
+        auto kernel_packet = network::make_packet(p->payload_size);
         std::copy_n(p->payload, p->payload_size, kernel_packet->payload);
 
         interface.send(kernel_packet);
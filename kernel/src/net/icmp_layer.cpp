@@ -10,6 +10,7 @@
 #include "net/icmp_layer.hpp"
 #include "net/ip_layer.hpp"
 #include "net/network.hpp"
+#include "net/checksum.hpp"
 
 #include "logging.hpp"
 #include "kernel_utils.hpp"
@@ -20,22 +21,9 @@ namespace {
 void compute_checksum(network::icmp::header* icmp_header, size_t payload_size){
     icmp_header->checksum = 0;
 
-    auto sum = std::accumulate(
-        reinterpret_cast<uint16_t*>(icmp_header),
-        reinterpret_cast<uint16_t*>(icmp_header) + sizeof(network::icmp::header) / 2 + payload_size * 2,
-        uint32_t(0));
+    auto sum = network::checksum_add_bytes(icmp_header, sizeof(network::icmp::header) + payload_size);
 
-    uint32_t value = sum & 0xFFFF;
-    uint32_t carry = (sum - value) >> 16;
-
-    while(carry){
-        value += carry;
-        auto sub = value & 0xFFFF;
-        carry = (value - sub) >> 16;
-        value = sub;
-    }
-
-    icmp_header->checksum = ~value;
+    icmp_header->checksum = switch_endian_16(network::checksum_finalize(sum));
 }
 
 void prepare_packet(network::packet& packet, network::icmp::type t, size_t code){
@@ -13,33 +13,43 @@
 #include "net/udp_layer.hpp"
 #include "net/tcp_layer.hpp"
 #include "net/arp_layer.hpp"
+#include "net/checksum.hpp"
 
 #include "logging.hpp"
 #include "kernel_utils.hpp"
 
 namespace {
 
-constexpr const size_t ARP_TIMEOUT = 5000;
 constexpr size_t default_ip_header_len = 20;
 
+/*!
+ * \brief Returns the address of the neighbour the packets for the given address are sent to
+ */
+network::ip::address next_hop(network::interface_descriptor& interface, network::ip::address target_ip){
+    auto& interface_ip = interface.ip_address;
+
+    // At this point, we have no gateway, neither IP
+    if(interface_ip == network::ip::make_address(0, 0, 0, 0)){
+        return target_ip;
+    }
+
+    // If it is the same network, use ARP to get the MAC address
+    if(network::ip::same_network(interface_ip, target_ip)){
+        return target_ip;
+    }
+
+    // If it is another network, use the gateway
+    return interface.gateway;
+}
+
 void compute_checksum(network::ip::header* header){
     auto ihl = header->version_ihl & 0xF;
 
     header->header_checksum = 0;
 
-    auto sum = std::accumulate(reinterpret_cast<uint16_t*>(header),reinterpret_cast<uint16_t*>(header) + ihl * 2, uint32_t(0));
+    auto sum = network::checksum_add_bytes(header, ihl * 4);
 
-    uint32_t value = sum & 0xFFFF;
-    uint32_t carry = (sum - value) >> 16;
-
-    while(carry){
-        value += carry;
-        auto sub = value & 0xFFFF;
-        carry = (value - sub) >> 16;
-        value = sub;
-    }
-
-    header->header_checksum = ~uint16_t(value);
+    header->header_checksum = switch_endian_16(network::checksum_finalize(sum));
 }
 
 void prepare_packet(network::packet& packet, network::interface_descriptor& interface, size_t size, network::ip::address target_ip, size_t protocol){
@@ -175,6 +185,18 @@ std::expected<network::packet_p> network::ip::layer::user_prepare_packet(char* b
 }
 
 std::expected<void> network::ip::layer::finalize_packet(network::interface_descriptor& interface, network::packet_p& p){
+    if(!interface.is_loopback()){
+        auto* ether_header = reinterpret_cast<network::ethernet::header*>(p->payload);
+
+        // The packet was prepared before the target was resolved, it is sent
+        // by the ARP cache when the reply arrives
+        if(network::ethernet::mac6_to_mac64(ether_header->target.mac) == network::arp::unresolved_mac){
+            auto* ip_header = reinterpret_cast<network::ip::header*>(p->payload + sizeof(network::ethernet::header));
+
+            return arp_layer->get_cache().park(interface, next_hop(interface, ip32_to_ip(ip_header->target_ip)), p);
+        }
+    }
+
     // Send the packet to the ethernet layer
     return parent->finalize_packet(interface, p);
 }
@@ -185,27 +207,15 @@ std::expected<uint64_t> network::ip::layer::get_target_mac(network::interface_de
         return 0xFFFFFFFFFFFF;
     }
 
-    // For loopback, there is no gateway
+    // For loopback, there is no neighbour
     if(interface.is_loopback()){
-        return arp_layer->get_cache().get_mac_force(interface, target_ip, ARP_TIMEOUT);
-    }
-
-    auto& interface_ip = interface.ip_address;
-
-    // At this point, we have no gateway, neither IP
-    if(interface_ip == network::ip::make_address(0, 0, 0, 0)){
-        return arp_layer->get_cache().get_mac_force(interface, target_ip, ARP_TIMEOUT);
-    }
-
-    // If it is the same network, use ARP to get the MAC address
-    if(network::ip::same_network(interface_ip, target_ip)){
-        return arp_layer->get_cache().get_mac_force(interface, target_ip, ARP_TIMEOUT);
+        return interface.mac_address;
     }
 
-    // If it is another network, use the gateway
-
-    return arp_layer->get_cache().get_mac_force(interface, interface.gateway, ARP_TIMEOUT);
+    // Does not wait for the resolution, the packet is parked when finalized
+    return arp_layer->get_cache().resolve(interface, next_hop(interface, target_ip));
 }
+
 void network::ip::layer::register_icmp_layer(network::icmp::layer* layer){
     this->icmp_layer = layer;
 }
@@ -18,8 +18,10 @@
 #include "net/dns_layer.hpp"
 #include "net/udp_layer.hpp"
 #include "net/tcp_layer.hpp"
+#include "net/packet_ring.hpp"
 
 #include "drivers/rtl8139.hpp"
+#include "drivers/virtio_net.hpp"
 #include "drivers/pci.hpp"
 #include "drivers/loopback.hpp"
 
@@ -27,6 +29,8 @@
 #include "scheduler.hpp"
 #include "logging.hpp"
 #include "kernel_utils.hpp"
+#include "poll.hpp"
+#include "trace.hpp"
 
 #include "fs/sysfs.hpp"
 
@@ -60,6 +64,53 @@ network::dns::layer* dns_layer;
 network::dhcp::layer* dhcp_layer;
 network::tcp::layer* tcp_layer;
 
+constexpr size_t net_timer_ms = 10; ///< The granularity of the TCP retransmission and ARP request timers
+
+void deliver_packet(network::interface_descriptor& interface, network::packet_p& packet){
+    trace::point(trace::event::PACKET_RX, interface.id, packet->payload_size);
+
+    ethernet_layer->decode(interface, packet);
+
+    ++interface.rx_packets_counter;
+    interface.rx_bytes_counter += packet->payload_size;
+}
+
+void drain_rx_ring(network::interface_descriptor& interface){
+    while(true){
+        network::packet_p packet;
+
+        if(!interface.rx_ring.pop(packet)){
+            break;
+        }
+
+        deliver_packet(interface, packet);
+    }
+}
+
+void poll_driver(network::interface_descriptor& interface){
+    while(true){
+        ++interface.rx_polls;
+
+        auto budget = interface.poll_budget;
+        auto polled = interface.hw_poll(interface, budget, &deliver_packet);
+
+        // The packets to self still go through the ring
+        drain_rx_ring(interface);
+
+        if(polled < budget){
+            // The next interrupt will schedule a new poll
+            interface.poll_scheduled = false;
+            interface.hw_poll_complete(interface);
+
+            return;
+        }
+
+        // The driver may have more packets, but let the other threads run
+        // before polling again
+        scheduler::yield();
+    }
+}
+
 void rx_thread(void* data){
     auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
 
@@ -72,15 +123,13 @@ void rx_thread(void* data){
     while(true){
         interface.rx_sem.wait();
 
-        //TODO This is highly unsafe since back() and pop_back() can suffer interleaving
-
-        auto packet = interface.rx_queue.top();
-        interface.rx_queue.pop();
+        // Handle all the packets received since the last wake up
 
-        ethernet_layer->decode(interface, packet);
+        drain_rx_ring(interface);
 
-        ++interface.rx_packets_counter;
-        interface.rx_bytes_counter += packet->payload_size;
+        if(interface.poll_scheduled){
+            poll_driver(interface);
+        }
     }
 }
 
@@ -94,14 +143,35 @@ void tx_thread(void* data){
     while(true){
         interface.tx_sem.lock();
 
-        auto packet = interface.tx_queue.top();
-        interface.tx_queue.pop();
-        interface.hw_send(interface, packet);
+        // Send all the packets queued since the last wake up
+
+        while(true){
+            network::packet_p packet;
+
+            if(!interface.tx_ring.pop(packet)){
+                break;
+            }
 
-        thor_assert(!packet->user);
+            trace::point(trace::event::PACKET_TX, interface.id, packet->payload_size);
 
-        ++interface.tx_packets_counter;
-        interface.tx_bytes_counter += packet->payload_size;
+            interface.hw_send(interface, packet);
+
+            thor_assert(!packet->user);
+
+            ++interface.tx_packets_counter;
+            interface.tx_bytes_counter += packet->payload_size;
+        }
+    }
+}
+
+void net_timer_thread(){
+    logging::logf(logging::log_level::TRACE, "network: Timer Thread started (pid:%u)\n", scheduler::get_pid());
+
+    while(true){
+        tcp_layer->timer();
+        arp_layer->get_cache().timer();
+
+        scheduler::sleep_ms(net_timer_ms);
     }
 }
 
@@ -125,6 +195,55 @@ std::string sysfs_tx_bytes(void* data){
     return std::to_string(interface.tx_bytes_counter);
 }
 
+std::string sysfs_rx_interrupts(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.rx_interrupts);
+}
+
+std::string sysfs_rx_polls(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.rx_polls);
+}
+
+std::string sysfs_poll_budget(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.poll_budget);
+}
+
+size_t sysfs_store_poll_budget(void* data, const std::string& value){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+
+    auto budget = std::atoui(value);
+
+    if(!budget){
+        return std::ERROR_INVALID_REQUEST;
+    }
+
+    interface.poll_budget = budget;
+
+    return 0;
+}
+
+std::string sysfs_rx_drops(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.rx_drops);
+}
+
+std::string sysfs_tx_drops(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.tx_drops);
+}
+
+std::string sysfs_rx_queue_max(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.rx_queue_max);
+}
+
+std::string sysfs_tx_queue_max(void* data){
+    auto& interface = *reinterpret_cast<network::interface_descriptor*>(data);
+    return std::to_string(interface.tx_queue_max);
+}
+
 void sysfs_publish(network::interface_descriptor& interface){
     auto p = path("/net") / interface.name;
 
@@ -151,6 +270,18 @@ void sysfs_publish(network::interface_descriptor& interface){
         sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "rx_bytes", sysfs_rx_bytes, &interface);
         sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "tx_packets", sysfs_tx_packets, &interface);
         sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "tx_bytes", sysfs_tx_bytes, &interface);
+        sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "rx_drops", sysfs_rx_drops, &interface);
+        sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "tx_drops", sysfs_tx_drops, &interface);
+        sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "rx_queue_max", sysfs_rx_queue_max, &interface);
+        sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "tx_queue_max", sysfs_tx_queue_max, &interface);
+
+        if(interface.hw_poll){
+            sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "rx_interrupts", sysfs_rx_interrupts, &interface);
+            sysfs::set_dynamic_value_data(sysfs::get_sys_path(), p / "rx_polls", sysfs_rx_polls, &interface);
+            sysfs::set_writable_value_data(sysfs::get_sys_path(), p / "poll_budget", sysfs_poll_budget, sysfs_store_poll_budget, &interface);
+        }
+
+        interface.tx_lock.publish(interface.name + "_tx");
     }
 }
 
@@ -221,9 +352,56 @@ void network_discovery() {
     }
 }
 
+/*!
+ * \brief Account a packet sent by the current process
+ */
+std::expected<void> count_sent(const std::expected<void>& result){
+    if(result){
+        ++scheduler::get_stats().packets_sent;
+    }
+
+    return result;
+}
+
+/*!
+ * \brief Account a packet received by the current process
+ */
+std::expected<size_t> count_received(const std::expected<size_t>& result){
+    if(result){
+        ++scheduler::get_stats().packets_received;
+    }
+
+    return result;
+}
+
+/*!
+ * \brief Account several packets sent by the current process
+ */
+std::expected<size_t> count_sent_many(const std::expected<size_t>& result){
+    if(result){
+        scheduler::get_stats().packets_sent += *result;
+    }
+
+    return result;
+}
+
+/*!
+ * \brief Account several packets received by the current process
+ */
+std::expected<size_t> count_received_many(const std::expected<size_t>& result){
+    if(result){
+        scheduler::get_stats().packets_received += *result;
+    }
+
+    return result;
+}
+
 } //end of anonymous namespace
 
 void network::init(){
+    // The drivers allocate packets as soon as they are started
+    network::init_packet_pool();
+
     size_t index = 0;
 
     for(size_t i = 0; i < pci::number_of_devices(); ++i){
@@ -243,6 +421,11 @@ void network::init(){
                 interface.driver = "rtl8139";
 
                 rtl8139::init_driver(interface, pci_device);
+            } else if(virtio_net::is_supported(pci_device)){
+                interface.enabled = true;
+                interface.driver = "virtio-net";
+
+                virtio_net::init_driver(interface, pci_device);
             }
 
             // No IP address by default
@@ -279,6 +462,8 @@ void network::init(){
                 loopback::finalize_driver(interface);
             } else if(interface.driver == "rtl8139"){
                 rtl8139::finalize_driver(interface);
+            } else if(interface.driver == "virtio-net"){
+                virtio_net::finalize_driver(interface);
             }
         }
     }
@@ -330,6 +515,15 @@ void network::finalize(){
         }
     }
 
+    // The retransmission timers of the TCP connections and of the ARP requests
+
+    auto& timer_process = scheduler::create_kernel_task("net_timer", new char[scheduler::user_stack_size], new char[scheduler::kernel_stack_size], &net_timer_thread);
+
+    timer_process.ppid     = 1;
+    timer_process.priority = scheduler::DEFAULT_PRIORITY;
+
+    scheduler::queue_system_process(timer_process.pid);
+
     scheduler::queue_async_init_task(network_discovery);
 }
 
@@ -392,6 +586,8 @@ std::expected<network::socket_fd_t> network::open(network::socket_domain domain,
 
 void network::close(size_t fd){
     if(scheduler::has_socket(fd)){
+        network::close_ring(scheduler::get_socket(fd), true);
+        poll::detach(scheduler::get_socket(fd));
         scheduler::release_socket(fd);
     }
 }
@@ -464,10 +660,10 @@ std::expected<void> network::send(socket_fd_t socket_fd, const char* buffer, siz
 
     switch (socket.protocol) {
         case network::socket_protocol::TCP:
-            return tcp_layer->send(target_buffer, socket, buffer, n);
+            return count_sent(tcp_layer->send(target_buffer, socket, buffer, n));
 
         case network::socket_protocol::UDP:
-            return udp_layer->send(target_buffer, socket, buffer, n);
+            return count_sent(udp_layer->send(target_buffer, socket, buffer, n));
 
         default:
             return std::make_unexpected<void>(std::ERROR_SOCKET_UNIMPLEMENTED);
@@ -487,7 +683,7 @@ std::expected<void> network::send_to(socket_fd_t socket_fd, const char* buffer,
 
     switch (socket.protocol) {
         case network::socket_protocol::UDP:
-            return udp_layer->send_to(target_buffer, socket, buffer, n, address);
+            return count_sent(udp_layer->send_to(target_buffer, socket, buffer, n, address));
 
         default:
             return std::make_unexpected<void>(std::ERROR_SOCKET_UNIMPLEMENTED);
@@ -511,10 +707,10 @@ std::expected<size_t> network::receive(socket_fd_t socket_fd, char* buffer, size
 
     switch (socket.protocol) {
         case network::socket_protocol::UDP:
-            return udp_layer->receive(buffer, socket, n);
+            return count_received(udp_layer->receive(buffer, socket, n));
 
         case network::socket_protocol::TCP:
-            return tcp_layer->receive(buffer, socket, n);
+            return count_received(tcp_layer->receive(buffer, socket, n));
 
         default:
             return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
@@ -538,10 +734,10 @@ std::expected<size_t> network::receive(socket_fd_t socket_fd, char* buffer, size
 
     switch (socket.protocol) {
         case network::socket_protocol::UDP:
-            return udp_layer->receive(buffer, socket, n, ms);
+            return count_received(udp_layer->receive(buffer, socket, n, ms));
 
         case network::socket_protocol::TCP:
-            return tcp_layer->receive(buffer, socket, n, ms);
+            return count_received(tcp_layer->receive(buffer, socket, n, ms));
 
         default:
             return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
@@ -565,7 +761,7 @@ std::expected<size_t> network::receive_from(socket_fd_t socket_fd, char* buffer,
 
     switch (socket.protocol) {
         case network::socket_protocol::UDP:
-            return udp_layer->receive_from(buffer, socket, n, address);
+            return count_received(udp_layer->receive_from(buffer, socket, n, address));
 
         default:
             return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
@@ -589,13 +785,182 @@ std::expected<size_t> network::receive_from(socket_fd_t socket_fd, char* buffer,
 
     switch (socket.protocol) {
         case network::socket_protocol::UDP:
-            return udp_layer->receive_from(buffer, socket, n, ms, address);
+            return count_received(udp_layer->receive_from(buffer, socket, n, ms, address));
+
+        default:
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
+    }
+}
+
+std::expected<size_t> network::send_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n, char* target_buffer, bool addressed){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    if(!network::number_of_interfaces()){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NO_INTERFACE);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    switch (socket.protocol) {
+        case network::socket_protocol::UDP:
+            return count_sent_many(udp_layer->send_many(target_buffer, socket, datagrams, n, addressed));
+
+        default:
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
+    }
+}
+
+std::expected<size_t> network::receive_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    if(!network::number_of_interfaces()){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NO_INTERFACE);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    if(!socket.listen){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_LISTEN);
+    }
+
+    switch (socket.protocol) {
+        case network::socket_protocol::UDP:
+            return count_received_many(udp_layer->receive_many(socket, datagrams, n));
 
         default:
             return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
     }
 }
 
+std::expected<size_t> network::receive_many(socket_fd_t socket_fd, network::datagram* datagrams, size_t n, size_t ms){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    if(!network::number_of_interfaces()){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NO_INTERFACE);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    if(!socket.listen){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_LISTEN);
+    }
+
+    switch (socket.protocol) {
+        case network::socket_protocol::UDP:
+            return count_received_many(udp_layer->receive_many(socket, datagrams, n, ms));
+
+        default:
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
+    }
+}
+
+std::expected<size_t> network::open_ring(socket_fd_t socket_fd){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    switch (socket.protocol) {
+        case network::socket_protocol::TCP:
+        case network::socket_protocol::UDP:
+            return network::create_ring(socket);
+
+        default:
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_UNIMPLEMENTED);
+    }
+}
+
+std::expected<size_t> network::ring_send(socket_fd_t socket_fd){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    if(!network::number_of_interfaces()){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NO_INTERFACE);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    if(!socket.ring){
+        return std::make_unexpected<size_t>(std::ERROR_INVALID_REQUEST);
+    }
+
+    auto& ring = *socket.ring;
+
+    network::begin_ring_send(ring);
+
+    // The header is writable by the process, it is only trusted after validation
+    uint64_t head = ring.header().head;
+
+    if(head < ring.sent || head > ring.sent + packet_ring_slots){
+        network::end_ring_send(ring);
+
+        return std::make_unexpected<size_t>(std::ERROR_INVALID_COUNT);
+    }
+
+    size_t sent = 0;
+
+    // The ring may be closed by another thread while a send is blocked
+    while(ring.sent < head && !ring.closed){
+        // The size is read once, the layers only use this value
+        size_t n = ring.header().sizes[ring.sent % packet_ring_slots];
+
+        std::expected<void> status;
+
+        if(n > packet_ring_max_payload){
+            status = std::make_unexpected<void>(std::ERROR_BUFFER_SMALL);
+        } else if(socket.protocol == network::socket_protocol::TCP){
+            status = tcp_layer->ring_send(socket, ring, n);
+        } else if(socket.protocol == network::socket_protocol::UDP){
+            status = udp_layer->ring_send(socket, ring, n);
+        } else {
+            status = std::make_unexpected<void>(std::ERROR_SOCKET_UNIMPLEMENTED);
+        }
+
+        if(!status){
+            network::end_ring_send(ring);
+
+            if(sent){
+                scheduler::get_stats().packets_sent += sent;
+                return sent;
+            }
+
+            return std::make_unexpected<size_t>(status.error());
+        }
+
+        ++sent;
+    }
+
+    network::end_ring_send(ring);
+
+    scheduler::get_stats().packets_sent += sent;
+
+    return sent;
+}
+
+std::expected<void> network::ring_wait(socket_fd_t socket_fd){
+    if(!scheduler::has_socket(socket_fd)){
+        return std::make_unexpected<void>(std::ERROR_SOCKET_INVALID_FD);
+    }
+
+    auto& socket = scheduler::get_socket(socket_fd);
+
+    if(!socket.ring){
+        return std::make_unexpected<void>(std::ERROR_INVALID_REQUEST);
+    }
+
+    network::wait_ring(socket);
+
+    return std::make_expected();
+}
+
 std::expected<void> network::finalize_packet(socket_fd_t socket_fd, size_t packet_fd){
     if(!scheduler::has_socket(socket_fd)){
         return std::make_unexpected<void>(std::ERROR_SOCKET_INVALID_FD);
@@ -615,7 +980,7 @@ std::expected<void> network::finalize_packet(socket_fd_t socket_fd, size_t packe
             socket.erase_packet(packet_fd);
         }
 
-        return ret;
+        return count_sent(ret);
     };
 
     switch(socket.protocol){
@@ -886,6 +1251,8 @@ std::expected<size_t> network::wait_for_packet(char* buffer, socket_fd_t socket_
 
     std::copy_n(packet->payload, packet->payload_size, buffer);
 
+    ++scheduler::get_stats().packets_received;
+
     logging::logf(logging::log_level::TRACE, "network: %u received packet on socket %u\n", scheduler::get_pid(), socket_fd);
 
     return {packet->index};
@@ -919,17 +1286,34 @@ std::expected<size_t> network::wait_for_packet(char* buffer, socket_fd_t socket_
 
     std::copy_n(packet->payload, packet->payload_size, buffer);
 
+    ++scheduler::get_stats().packets_received;
+
     logging::logf(logging::log_level::TRACE, "network: %u received packet on socket %u\n", scheduler::get_pid(), socket_fd);
 
     return {packet->index};
 }
 
+size_t network::poll_events(network::socket& socket){
+    if(socket.protocol == socket_protocol::TCP){
+        return tcp_layer->poll_events(socket);
+    }
+
+    // The other sockets can always send and receive in listen mode
+    size_t events = poll::POLL_OUT;
+
+    if(!socket.listen_packets.empty()){
+        events |= poll::POLL_IN;
+    }
+
+    return events;
+}
+
 void network::propagate_packet(const packet_p& packet, socket_protocol protocol){
     // TODO Need something better for this
 
     for(size_t pid = 0; pid < scheduler::MAX_PROCESS; ++pid){
         auto state = scheduler::get_process_state(pid);
-        if(state != scheduler::process_state::EMPTY && state != scheduler::process_state::NEW && state != scheduler::process_state::KILLED){
+        if(state != scheduler::process_state::EMPTY && state != scheduler::process_state::NEW && state != scheduler::process_state::KILLED && state != scheduler::process_state::ZOMBIE){
             for(auto& socket : scheduler::get_sockets(pid)){
                 if(socket.listen){
                     bool propagate = false;
@@ -944,6 +1328,7 @@ void network::propagate_packet(const packet_p& packet, socket_protocol protocol)
                     if (propagate) {
                         socket.listen_packets.push(packet);
                         socket.listen_queue.notify_one();
+                        poll::notify(socket);
                     }
                 }
             }
@@ -951,6 +1336,18 @@ void network::propagate_packet(const packet_p& packet, socket_protocol protocol)
     }
 }
 
+std::expected<network::ip::address> network::resolve(const char* name, size_t length, network::ip::address server, size_t timeout_ms, size_t tries){
+    if(!network::number_of_interfaces()){
+        return std::make_unexpected<network::ip::address>(std::ERROR_SOCKET_NO_INTERFACE);
+    }
+
+    if(!server.raw_address){
+        server = dns_address;
+    }
+
+    return dns_layer->resolve(name, length, server, timeout_ms, tries);
+}
+
 network::ip::address network::dns_server(){
     return dns_address;
 }
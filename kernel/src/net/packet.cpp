@@ -0,0 +1,162 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "net/packet.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
+
+#include "logging.hpp"
+
+namespace {
+
+constexpr const size_t pool_size = 256; ///< The number of pooled packets
+
+/*!
+ * \brief A pooled packet, with its buffer
+ */
+struct pool_slot {
+    network::packet packet;                   ///< The packet descriptor (must be the first member)
+    char buffer[network::packet_buffer_size]; ///< The buffer of the payload
+    pool_slot* next;                          ///< The next free slot
+};
+
+pool_slot* slots      = nullptr; ///< All the slots
+pool_slot* free_slots = nullptr; ///< The list of free slots
+
+volatile uint64_t allocations = 0; ///< The number of packets taken from the pool
+volatile uint64_t fallbacks   = 0; ///< The number of packets allocated on the heap
+volatile uint64_t in_use      = 0; ///< The number of pooled packets currently used
+volatile uint64_t max_in_use  = 0; ///< The maximum number of pooled packets used at the same time
+
+std::string sysfs_size(){
+    return std::to_string(pool_size);
+}
+
+std::string sysfs_in_use(){
+    return std::to_string(in_use);
+}
+
+std::string sysfs_max_in_use(){
+    return std::to_string(max_in_use);
+}
+
+std::string sysfs_allocations(){
+    return std::to_string(allocations);
+}
+
+std::string sysfs_fallbacks(){
+    return std::to_string(fallbacks);
+}
+
+pool_slot* take_slot(){
+    pool_slot* slot;
+
+    {
+        // Packets are allocated from the IRQ handlers too
+        direct_int_lock lock;
+
+        slot = free_slots;
+
+        if(!slot){
+            return nullptr;
+        }
+
+        free_slots = slot->next;
+
+        ++allocations;
+
+        if(++in_use > max_in_use){
+            max_in_use = in_use;
+        }
+    }
+
+    auto& p = slot->packet;
+
+    p.index     = 0;
+    p.fd        = 0;
+    p.tags      = 0;
+    p.interface = 0;
+    p.refs      = 0;
+    p.pooled    = true;
+
+    return slot;
+}
+
+} //end of anonymous namespace
+
+void network::init_packet_pool(){
+    slots = new pool_slot[pool_size];
+
+    for(size_t i = 0; i < pool_size; ++i){
+        slots[i].next = free_slots;
+        free_slots = &slots[i];
+    }
+
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/pool/size"), &sysfs_size);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/pool/in_use"), &sysfs_in_use);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/pool/max_in_use"), &sysfs_max_in_use);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/pool/allocations"), &sysfs_allocations);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/net/pool/fallbacks"), &sysfs_fallbacks);
+}
+
+network::packet_p network::make_packet(size_t size){
+    if(size <= packet_buffer_size){
+        if(auto* slot = take_slot()){
+            auto& p = slot->packet;
+
+            p.payload      = slot->buffer;
+            p.payload_size = size;
+            p.user         = false;
+
+            return packet_p(&p);
+        }
+    }
+
+    ++fallbacks;
+
+    return packet_p(new packet(new char[size], size));
+}
+
+network::packet_p network::make_user_packet(char* buffer, size_t size){
+    // The buffer of the slot is not used, but this saves a heap allocation
+    if(auto* slot = take_slot()){
+        auto& p = slot->packet;
+
+        p.payload      = buffer;
+        p.payload_size = size;
+        p.user         = true;
+
+        return packet_p(&p);
+    }
+
+    ++fallbacks;
+
+    auto* p = new packet(buffer, size);
+
+    p->user = true;
+
+    return packet_p(p);
+}
+
+void network::release_packet(packet* p){
+    if(!p->pooled){
+        delete p;
+        return;
+    }
+
+    // The packet is the first member of its slot
+    auto* slot = reinterpret_cast<pool_slot*>(p);
+
+    direct_int_lock lock;
+
+    slot->next = free_slots;
+    free_slots = slot;
+
+    --in_use;
+}
@@ -0,0 +1,172 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithms.hpp>
+
+#include "net/packet_ring.hpp"
+#include "net/socket.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "scheduler.hpp"
+#include "paging.hpp"
+#include "physical_allocator.hpp"
+#include "virtual_allocator.hpp"
+#include "logging.hpp"
+
+#include "tlib/errors.hpp"
+
+namespace {
+
+constexpr const size_t ring_pages  = network::packet_ring_size / paging::PAGE_SIZE; ///< The number of pages of a ring
+constexpr const size_t ring_stride = 0x20000;                                  ///< The virtual space reserved for each ring of a process
+
+void free_ring(network::packet_ring* ring){
+    paging::unmap_pages(ring->virtual_address, ring_pages);
+    virtual_allocator::free(ring->virtual_address, ring_pages);
+    physical_allocator::free(ring->physical, ring_pages);
+
+    delete ring;
+}
+
+} //end of anonymous namespace
+
+std::expected<size_t> network::create_ring(socket& socket){
+    if(socket.ring){
+        return std::make_unexpected<size_t>(std::ERROR_EXISTS);
+    }
+
+    auto physical = physical_allocator::allocate(ring_pages);
+
+    if(!physical){
+        return std::make_unexpected<size_t>(std::ERROR_FAILED);
+    }
+
+    auto virt = virtual_allocator::allocate(ring_pages);
+
+    if(!paging::map_pages(virt, physical, ring_pages)){
+        virtual_allocator::free(virt, ring_pages);
+        physical_allocator::free(physical, ring_pages);
+
+        return std::make_unexpected<size_t>(std::ERROR_FAILED);
+    }
+
+    // The ring is shared with all the threads of the process
+    auto& process     = scheduler::get_process(scheduler::get_tgid());
+    auto user_address = scheduler::program_rings + (socket.id - 1) * ring_stride;
+
+    if(!paging::user_map_pages(process, user_address, physical, ring_pages)){
+        paging::user_unmap_pages(process, user_address, ring_pages);
+        paging::unmap_pages(virt, ring_pages);
+        virtual_allocator::free(virt, ring_pages);
+        physical_allocator::free(physical, ring_pages);
+
+        return std::make_unexpected<size_t>(std::ERROR_FAILED);
+    }
+
+    std::fill_n(reinterpret_cast<char*>(virt), packet_ring_slots_offset, 0);
+
+    auto* ring = new packet_ring;
+
+    ring->physical        = physical;
+    ring->virtual_address = virt;
+    ring->user_address    = user_address;
+
+    socket.ring = ring;
+
+    logging::logf(logging::log_level::TRACE, "net: Packet ring of socket %u mapped at %h\n", socket.id, user_address);
+
+    return user_address;
+}
+
+void network::close_ring(socket& socket, bool unmap){
+    auto* ring = socket.ring;
+
+    if(!ring){
+        return;
+    }
+
+    socket.ring = nullptr;
+
+    if(unmap){
+        paging::user_unmap_pages(scheduler::get_process(scheduler::get_tgid()), ring->user_address, ring_pages);
+    }
+
+    direct_int_lock lock;
+
+    ring->closed = true;
+
+    // The waiters will see the ring is closed
+    ring->queue.wake_all();
+
+    // A send in progress releases the ring when it ends
+    if(!ring->senders){
+        free_ring(ring);
+    }
+}
+
+void network::begin_ring_send(packet_ring& ring){
+    {
+        direct_int_lock lock;
+
+        ++ring.senders;
+    }
+
+    ring.send_lock.lock();
+}
+
+void network::end_ring_send(packet_ring& ring){
+    ring.send_lock.unlock();
+
+    direct_int_lock lock;
+
+    --ring.senders;
+
+    if(ring.closed){
+        if(!ring.senders){
+            free_ring(&ring);
+        }
+
+        return;
+    }
+
+    // The waiters check again if they have to wait for another send
+    ring.queue.wake_all();
+}
+
+void network::take_ring_payload(packet_ring& ring, char* destination, size_t n){
+    std::copy_n(ring.next_slot() + packet_ring_headroom, n, destination);
+
+    direct_int_lock lock;
+
+    ++ring.sent;
+
+    ring.header().tail = ring.sent;
+
+    ring.queue.wake_all();
+}
+
+void network::wait_ring(socket& socket){
+    while(true){
+        {
+            direct_int_lock lock;
+
+            // The ring may have been closed by another thread
+            auto* ring = socket.ring;
+
+            // The check and the enqueue are atomic with respect to the sends
+            // (the slots are only given back by a send in progress)
+            if(!ring || !ring->senders || ring->header().head < ring->sent + packet_ring_slots){
+                return;
+            }
+
+            ring->queue.enqueue();
+        }
+
+        scheduler::reschedule();
+    }
+}
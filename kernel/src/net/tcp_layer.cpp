@@ -13,8 +13,10 @@
 #include "net/ip_layer.hpp"
 #include "net/checksum.hpp"
 #include "net/network.hpp"
+#include "net/packet_ring.hpp"
 
 #include "kernel_utils.hpp"
+#include "poll.hpp"
 #include "timer.hpp"
 
 namespace {
@@ -23,6 +25,16 @@ static constexpr size_t timeout_ms = 1000;
 static constexpr size_t max_tries  = 5;
 constexpr size_t default_tcp_header_length = 20;
 
+constexpr size_t tcp_mss             = 1460;          ///< The maximum segment size
+constexpr size_t max_ooo_ranges      = 16;            ///< The out-of-order ranges kept per connection
+constexpr size_t initial_cwnd        = 3 * tcp_mss;   ///< The initial congestion window
+constexpr size_t initial_rto_ms      = 1000;          ///< The RTO before the first RTT sample
+constexpr size_t min_rto_ms          = 200;           ///< The lower bound of the RTO
+constexpr size_t max_rto_ms          = 60000;         ///< The upper bound of the RTO
+constexpr size_t dup_ack_threshold   = 3;             ///< The duplicate ACKs triggering a fast retransmit
+constexpr size_t max_retransmissions = 8;             ///< The timeouts before the connection is dropped
+constexpr size_t accept_backlog      = 16;            ///< The connection requests queued on a listening socket
+
 using flag_data_offset = std::bit_field<uint16_t, uint8_t, 12, 4>;
 using flag_reserved    = std::bit_field<uint16_t, uint8_t, 9, 3>;
 using flag_ns          = std::bit_field<uint16_t, uint8_t, 8, 1>;
@@ -35,25 +47,46 @@ using flag_rst         = std::bit_field<uint16_t, uint8_t, 2, 1>;
 using flag_syn         = std::bit_field<uint16_t, uint8_t, 1, 1>;
 using flag_fin         = std::bit_field<uint16_t, uint8_t, 0, 1>;
 
+uint32_t pseudo_header_sum(const network::ip::header* ip_header, size_t tcp_len){
+    // Accumulate the IP addresses
+    auto sum = network::checksum_add_bytes(&ip_header->source_ip, 8);
+
+    // Accumulate the IP Protocol
+    sum += ip_header->protocol;
+
+    // Accumulate the TCP length
+    sum += tcp_len;
+
+    return sum;
+}
+
+/*!
+ * \brief Returns the TCP length (header and payload) of an outgoing packet.
+ *
+ * The length is the one of the packet allocated by the kernel. The IP header
+ * cannot be trusted, it may be in the buffer of the process, so its total
+ * length is rewritten from the kernel one.
+ */
+size_t segment_length(network::packet& packet){
+    auto* ip_header = reinterpret_cast<network::ip::header*>(packet.payload + packet.tag(1));
+
+    ip_header->total_len = switch_endian_16(uint16_t(packet.payload_size - packet.tag(1)));
+
+    return packet.payload_size - packet.tag(2);
+}
+
 void compute_checksum(network::packet& packet) {
     auto* ip_header  = reinterpret_cast<network::ip::header*>(packet.payload + packet.tag(1));
     auto* tcp_header = reinterpret_cast<network::tcp::header*>(packet.payload + packet.tag(2));
 
-    auto tcp_len = switch_endian_16(ip_header->total_len) - (ip_header->version_ihl & 0xF) * 4;
+    auto tcp_len = segment_length(packet);
 
     tcp_header->checksum = 0;
 
     // Accumulate the Payload
-    auto sum = network::checksum_add_bytes(packet.payload + packet.index, tcp_len);
-
-    // Accumulate the IP addresses
-    sum += network::checksum_add_bytes(&ip_header->source_ip, 8);
+    auto sum = network::checksum_add_bytes(packet.payload + packet.tag(2), tcp_len);
 
-    // Accumulate the IP Protocol
-    sum += ip_header->protocol;
-
-    // Accumulate the TCP length
-    sum += tcp_len;
+    sum += pseudo_header_sum(ip_header, tcp_len);
 
     // Complete the 1-complement sum
     tcp_header->checksum = switch_endian_16(network::checksum_finalize_nz(sum));
@@ -76,30 +109,227 @@ void prepare_packet(network::packet& packet, size_t source, size_t target) {
 
     tcp_header->source_port    = switch_endian_16(source);
     tcp_header->target_port    = switch_endian_16(target);
-    tcp_header->window_size    = switch_endian_16(1024);
+    tcp_header->window_size    = switch_endian_16(network::tcp::receive_buffer_size);
     tcp_header->urgent_pointer = 0;
 
     packet.index += default_tcp_header_length;
 }
 
-size_t tcp_data_offset(const network::packet_p& packet){
+size_t tcp_payload_len(const network::packet_p& packet){
+    auto* ip_header  = reinterpret_cast<const network::ip::header*>(packet->payload + packet->tag(1));
     auto* tcp_header = reinterpret_cast<const network::tcp::header*>(packet->payload + packet->tag(2));
+
     auto tcp_flags = switch_endian_16(tcp_header->flags);
-    return *flag_data_offset(&tcp_flags) * 4;
+
+    // The frame can be padded, but the IP length cannot go past its end
+    size_t ip_len     = std::min(size_t(switch_endian_16(ip_header->total_len)), packet->payload_size - packet->tag(1));
+    size_t header_len  = (packet->tag(2) - packet->tag(1)) + *flag_data_offset(&tcp_flags) * 4;
+
+    if(ip_len < header_len){
+        return 0;
+    }
+
+    return ip_len - header_len;
 }
 
-size_t tcp_payload_len(const network::packet_p& packet){
-    auto* ip_header  = reinterpret_cast<const network::ip::header*>(packet->payload + packet->tag(1));
-    auto* tcp_header = reinterpret_cast<const network::tcp::header*>(packet->payload + packet->tag(2));
+/*!
+ * \brief Returns the payload length of an outgoing segment, from the size of
+ * the packet allocated by the kernel.
+ */
+size_t segment_payload_len(const network::packet& packet){
+    auto* tcp_header = reinterpret_cast<const network::tcp::header*>(packet.payload + packet.tag(2));
 
     auto tcp_flags = switch_endian_16(tcp_header->flags);
 
-    auto ip_header_len   = (ip_header->version_ihl & 0xF) * 4;
-    auto tcp_len         = switch_endian_16(ip_header->total_len) - ip_header_len;
-    auto tcp_data_offset = *flag_data_offset(&tcp_flags) * 4;
-    auto payload_len     = tcp_len - tcp_data_offset;
+    size_t tcp_len     = packet.payload_size - packet.tag(2);
+    size_t data_offset = std::min(size_t(*flag_data_offset(&tcp_flags) * 4), tcp_len);
+
+    return tcp_len - data_offset;
+}
+
+// Compare sequence numbers, taking wrap around into account
+bool seq_after(uint32_t a, uint32_t b){
+    return static_cast<int32_t>(a - b) > 0;
+}
+
+network::packet_p copy_packet(const network::packet& source){
+    auto copy = network::make_packet(source.payload_size);
+
+    std::copy_n(source.payload, source.payload_size, copy->payload);
+
+    copy->index     = source.index;
+    copy->tags      = source.tags;
+    copy->interface = source.interface;
+
+    return copy;
+}
+
+/*!
+ * \brief Copy a packet to kernel memory, computing the TCP checksum while
+ * copying the TCP header and payload. The checksum is only set in the copy.
+ *
+ * The length is the one of the packet allocated by the kernel, not the one
+ * of the IP header, written by the process.
+ */
+network::packet_p copy_and_checksum(network::packet& source){
+    auto* ip_header  = reinterpret_cast<network::ip::header*>(source.payload + source.tag(1));
+    auto* tcp_header = reinterpret_cast<network::tcp::header*>(source.payload + source.tag(2));
+
+    auto offset  = source.tag(2);
+    auto tcp_len = segment_length(source);
+
+    tcp_header->checksum = 0;
+
+    auto copy = network::make_packet(source.payload_size);
+
+    std::copy_n(source.payload, offset, copy->payload);
+
+    auto sum = network::checksum_copy(copy->payload + offset, source.payload + offset, tcp_len);
+
+    sum += pseudo_header_sum(ip_header, tcp_len);
+
+    copy->index     = source.index;
+    copy->tags      = source.tags;
+    copy->interface = source.interface;
+
+    auto* copy_header = reinterpret_cast<network::tcp::header*>(copy->payload + offset);
+
+    copy_header->checksum = switch_endian_16(network::checksum_finalize_nz(sum));
+
+    return copy;
+}
+
+uint32_t flight_size(const network::tcp::tcp_connection& connection){
+    return connection.seq_number - connection.snd_una;
+}
+
+uint32_t send_window(const network::tcp::tcp_connection& connection){
+    return std::min(connection.cwnd, connection.snd_wnd);
+}
+
+// Must be called after each change of the readiness of the connection
+void notify_pollers(network::tcp::tcp_connection& connection){
+    if(connection.socket){
+        poll::notify(*connection.socket);
+    }
+}
+
+// Must be called once the sequence numbers of the handshake are settled
+void init_send_state(network::tcp::tcp_connection& connection, uint32_t window){
+    std::lock_guard<mutex> l(connection.send_lock);
+
+    connection.snd_una         = connection.seq_number;
+    connection.snd_wnd         = window;
+    connection.cwnd            = initial_cwnd;
+    connection.ssthresh        = 0xFFFFFFFF;
+    connection.dup_acks        = 0;
+    connection.srtt            = 0;
+    connection.rttvar          = 0;
+    connection.rto             = initial_rto_ms;
+    connection.rto_deadline    = 0;
+    connection.retransmissions = 0;
+    connection.probes          = 0;
+    connection.established     = true;
+}
+
+// Must be called with the receive lock (or when an approximate value is enough)
+uint16_t advertise_window(network::tcp::tcp_connection& connection){
+    connection.rcv_wnd = connection.rcv_buffer.free_size();
+    return connection.rcv_wnd;
+}
+
+/*!
+ * \brief Store the payload of a segment in the receive buffer of the connection
+ * \return true if new data is available to the reader
+ */
+bool receive_data(network::tcp::tcp_connection& connection, uint32_t seq, const char* data, size_t len){
+    std::lock_guard<mutex> l(connection.receive_lock);
+
+    // Skip the bytes that were already received
+    if(seq_after(connection.ack_number, seq)){
+        size_t skip = connection.ack_number - seq;
+
+        if(skip >= len){
+            return false;
+        }
+
+        seq  += skip;
+        data += skip;
+        len  -= skip;
+    }
+
+    size_t offset = seq - connection.ack_number;
+    auto free     = connection.rcv_buffer.free_size();
+
+    // Drop what does not fit in the window
+    if(offset >= free){
+        return false;
+    }
+
+    len = std::min(len, free - offset);
+
+    connection.rcv_buffer.write_at(offset, data, len);
+
+    // Out-of-order data stays after the end of the buffer until the hole is filled
+    if(offset){
+        if(connection.ooo_ranges.size() < max_ooo_ranges){
+            connection.ooo_ranges.push_back({seq, uint32_t(seq + len)});
+        }
+
+        return false;
+    }
+
+    connection.rcv_buffer.commit(len);
+    connection.ack_number += len;
+
+    // Reassemble the ranges that are now contiguous
+    bool merged = true;
+
+    while(merged){
+        merged = false;
+
+        for(size_t i = 0; i < connection.ooo_ranges.size(); ++i){
+            auto range = connection.ooo_ranges[i];
 
-    return payload_len;
+            if(!seq_after(range.start, connection.ack_number)){
+                if(seq_after(range.end, connection.ack_number)){
+                    connection.rcv_buffer.commit(range.end - connection.ack_number);
+                    connection.ack_number = range.end;
+                }
+
+                connection.ooo_ranges.erase(i);
+                merged = true;
+
+                break;
+            }
+        }
+    }
+
+    connection.receive_queue.wake_all();
+    notify_pollers(connection);
+
+    return true;
+}
+
+// Jacobson/Karels estimation of the retransmission timeout (RFC 6298)
+void update_rto(network::tcp::tcp_connection& connection, size_t sample){
+    if(!connection.srtt){
+        connection.srtt   = sample << 3;
+        connection.rttvar = sample << 1;
+    } else {
+        int64_t delta = int64_t(sample) - int64_t(connection.srtt >> 3);
+
+        connection.srtt += delta;
+
+        if(delta < 0){
+            delta = -delta;
+        }
+
+        connection.rttvar -= connection.rttvar >> 2;
+        connection.rttvar += delta;
+    }
+
+    connection.rto = std::max(min_rto_ms, std::min(max_rto_ms, (connection.srtt >> 3) + connection.rttvar));
 }
 
 } //end of anonymous namespace
@@ -138,6 +368,8 @@ void network::tcp::layer::decode(network::interface_descriptor& interface, netwo
     const bool is_fin = *flag_fin(&flags);
     const bool is_psh = *flag_psh(&flags);
 
+    auto window = switch_endian_16(tcp_header->window_size);
+
     logging::logf(logging::log_level::TRACE, "tcp:decode: SYN:%b ACK:%b FIN:%b PSH:%b \n", is_syn, is_ack, is_fin, is_psh);
 
     auto next_seq = ack;
@@ -146,7 +378,12 @@ void network::tcp::layer::decode(network::interface_descriptor& interface, netwo
     logging::logf(logging::log_level::TRACE, "tcp:decode: Next Seq Number %u \n", size_t(next_seq));
     logging::logf(logging::log_level::TRACE, "tcp:decode: Next Ack Number %u \n", size_t(next_ack));
 
-    connections.for_each_connection_for_packet(source_port, target_port, [&](tcp_connection& connection) {
+    // Indicates if the data was acknowledged by a connection
+    bool acked = false;
+
+    network::ip::address source_address = switch_endian_32(ip_header->source_ip);
+
+    connections.for_each_connection_for_packet(source_address, source_port, target_port, [&](tcp_connection& connection) {
         if(connection.socket){
             logging::logf(logging::log_level::TRACE, "tcp:decode: Found connection with socket\n");
         } else {
@@ -156,18 +393,52 @@ void network::tcp::layer::decode(network::interface_descriptor& interface, netwo
         logging::logf(logging::log_level::TRACE, "tcp:decode: connection (server:%b,connected:%b,child:%b)\n", connection.server, connection.connected, connection.child);
         logging::logf(logging::log_level::TRACE, "            src:%u dest:%u server:%h\n", connection.local_port, connection.server_port, connection.server_address.raw_address);
 
-        // Update the connection status
+        // Update the connection status. The sequence number only moves
+        // forward since segments can be duplicated or acknowledge older data
 
-        connection.seq_number = next_seq;
-        connection.ack_number = next_ack;
+        if(is_ack){
+            std::lock_guard<mutex> l(connection.send_lock);
+
+            if(seq_after(next_seq, connection.seq_number)){
+                connection.seq_number = next_seq;
+            }
+        }
+
+        if(is_ack && connection.established){
+            process_ack(connection, ack, window, !len && !is_syn && !is_fin);
+        }
+
+        // Store the data in the receive buffer and acknowledge it
+
+        if(len && !is_syn && !connection.server && connection.connected){
+            auto* data = reinterpret_cast<const char*>(tcp_header) + *flag_data_offset(&flags) * 4;
+
+            if(receive_data(connection, seq, data, len)){
+                logging::logf(logging::log_level::TRACE, "tcp:decode: Propagated to receive buffer\n");
+            }
+
+            send_ack(interface, connection);
+
+            acked = true;
+        }
+
+        if(is_syn || is_fin){
+            std::lock_guard<mutex> l(connection.receive_lock);
+
+            connection.ack_number = next_ack;
+        }
 
         // Propagate to kernel connections
 
-        if (connection.listening.load()) {
+        // Listening sockets only keep a bounded backlog of connection requests
+        bool request = !connection.server || (is_syn && connection.packets.size() < accept_backlog);
+
+        if (connection.listening.load() && request) {
             logging::logf(logging::log_level::TRACE, "tcp:decode: Propagated to connection\n");
 
             connection.packets.push(packet);
             connection.queue.notify_one();
+            notify_pollers(connection);
         }
 
         if(connection.child && is_fin){
@@ -199,31 +470,14 @@ void network::tcp::layer::decode(network::interface_descriptor& interface, netwo
 
             connection.connected = false;
             connection.queue.notify_all();
-
-            if(connection.socket){
-                connection.socket->listen_queue.notify_all();
-            }
-        }
-
-        // Propagate to the kernel socket
-
-        if (is_psh && connection.socket) {
-            auto& socket = *connection.socket;
-
-            packet->index += *flag_data_offset(&flags) * 4;
-
-            if (socket.listen) {
-                logging::logf(logging::log_level::TRACE, "tcp:decode: Propagated to socket\n");
-
-                socket.listen_packets.push(packet);
-                socket.listen_queue.notify_one();
-            }
+            connection.receive_queue.wake_all();
+            notify_pollers(connection);
         }
     });
 
-    // Acknowledge if necessary
+    // Acknowledge data for unknown connections
 
-    if (is_psh) {
+    if (len && !acked) {
         logging::logf(logging::log_level::TRACE, "tcp:decode: Acknowledge directly\n");
 
         auto p = kernel_prepare_packet(interface, switch_endian_32(ip_header->source_ip), target_port, source_port, 0);
@@ -278,84 +532,109 @@ std::expected<void> network::tcp::layer::send(char* target_buffer, network::sock
     return std::make_unexpected<void>(p.error());
 }
 
-std::expected<size_t> network::tcp::layer::receive(char* buffer, network::socket& socket, size_t n){
+std::expected<void> network::tcp::layer::ring_send(network::socket& socket, network::packet_ring& ring, size_t n){
     auto& connection = socket.get_connection_data<tcp_connection>();
 
     // Make sure stream sockets are connected
     if(!connection.connected){
-        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
+        return std::make_unexpected<void>(std::ERROR_SOCKET_NOT_CONNECTED);
     }
 
-    logging::logf(logging::log_level::TRACE, "tcp:receive: Wait for packet\n");
+    auto target_ip  = connection.server_address;
+    auto& interface = network::select_interface(target_ip);
 
-    if(socket.listen_packets.empty()){
-        socket.listen_queue.wait();
+    // The slot is writable by the process, the headers are built in a kernel
+    // packet and only the payload is taken from the slot. The slot is given
+    // back before waiting for the window.
+    auto p = kernel_prepare_packet(interface, connection, n);
 
-        if(!connection.connected){
-            logging::logf(logging::log_level::TRACE, "tcp:receive: Disconnected while waiting\n");
-            return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
-        }
-    }
+    if (p) {
+        auto& packet = *p;
 
-    auto packet = socket.listen_packets.top();
-    socket.listen_packets.pop();
+        auto* tcp_header = reinterpret_cast<header*>(packet->payload + packet->tag(2));
 
-    logging::logf(logging::log_level::TRACE, "tcp:receive: Received packet\n");
+        auto flags = get_default_flags();
+        (flag_psh(&flags)) = 1;
+        (flag_ack(&flags)) = 1;
+        tcp_header->flags = switch_endian_16(flags);
 
-    auto payload_len = tcp_payload_len(packet);
+        network::take_ring_payload(ring, packet->payload + packet->index, n);
 
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
+        return send_segment(interface, socket, packet);
     }
 
-    auto offset = packet->tag(2) + tcp_data_offset(packet);
+    return std::make_unexpected<void>(p.error());
+}
+
+std::expected<size_t> network::tcp::layer::receive(char* buffer, network::socket& socket, size_t n){
+    auto& connection = socket.get_connection_data<tcp_connection>();
+
+    logging::logf(logging::log_level::TRACE, "tcp:receive: Wait for data\n");
+
+    connection.receive_lock.lock();
+
+    // The data received before the disconnection can still be read
+    while(connection.rcv_buffer.empty()){
+        if(!connection.connected){
+            connection.receive_lock.unlock();
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
+        }
+
+        connection.receive_queue.enqueue();
+        connection.receive_lock.unlock();
 
-    std::copy_n(packet->payload + offset, payload_len, buffer);
+        scheduler::reschedule();
 
-    return payload_len;
+        connection.receive_lock.lock();
+    }
+
+    return read_data(connection, buffer, n);
 }
 
 std::expected<size_t> network::tcp::layer::receive(char* buffer, network::socket& socket, size_t n, size_t ms){
     auto& connection = socket.get_connection_data<tcp_connection>();
 
-    // Make sure stream sockets are connected
-    if(!connection.connected){
-        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
-    }
+    logging::logf(logging::log_level::TRACE, "tcp:receive: Wait for data (timeout)\n");
 
-    logging::logf(logging::log_level::TRACE, "tcp:receive: Wait for packet (timeout)\n");
+    connection.receive_lock.lock();
 
-    if(socket.listen_packets.empty()){
-        if(!ms){
-            return std::make_unexpected<size_t>(std::ERROR_SOCKET_TIMEOUT);
-        }
+    if(connection.rcv_buffer.empty() && connection.connected && ms){
+        connection.receive_queue.enqueue_timeout(ms);
+        connection.receive_lock.unlock();
 
-        if(!socket.listen_queue.wait_for(ms)){
-            return std::make_unexpected<size_t>(std::ERROR_SOCKET_TIMEOUT);
-        }
+        scheduler::reschedule();
+
+        connection.receive_lock.lock();
+    }
+
+    if(connection.rcv_buffer.empty()){
+        connection.receive_lock.unlock();
 
         if(!connection.connected){
-            logging::logf(logging::log_level::TRACE, "tcp:receive: Disconnected while waiting\n");
             return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
         }
+
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_TIMEOUT);
     }
 
-    auto packet = socket.listen_packets.top();
-    socket.listen_packets.pop();
+    return read_data(connection, buffer, n);
+}
 
-    logging::logf(logging::log_level::TRACE, "tcp:receive: Received packet\n");
+std::expected<size_t> network::tcp::layer::read_data(tcp_connection& connection, char* buffer, size_t n){
+    auto read = connection.rcv_buffer.pop(buffer, n);
 
-    auto payload_len = tcp_payload_len(packet);
+    // Tell the peer when the window opens again after being (almost) closed
+    bool update = connection.rcv_wnd < tcp_mss && connection.rcv_buffer.free_size() >= tcp_mss;
 
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
-    }
+    connection.receive_lock.unlock();
 
-    auto offset = packet->tag(2) + tcp_data_offset(packet);
+    logging::logf(logging::log_level::TRACE, "tcp:receive: Read %u bytes\n", read);
 
-    std::copy_n(packet->payload + offset, payload_len, buffer);
+    if(update && connection.connected){
+        send_ack(network::select_interface(connection.server_address), connection);
+    }
 
-    return payload_len;
+    return read;
 }
 
 std::expected<network::packet_p> network::tcp::layer::user_prepare_packet(char* buffer, network::socket& socket, const packet_descriptor* descriptor) {
@@ -390,6 +669,7 @@ std::expected<network::packet_p> network::tcp::layer::user_prepare_packet(char*
 
         tcp_header->sequence_number = switch_endian_32(connection.seq_number);
         tcp_header->ack_number      = switch_endian_32(connection.ack_number);
+        tcp_header->window_size     = switch_endian_16(advertise_window(connection));
     }
 
     return p;
@@ -398,6 +678,231 @@ std::expected<network::packet_p> network::tcp::layer::user_prepare_packet(char*
 std::expected<void> network::tcp::layer::finalize_packet(network::interface_descriptor& interface, network::socket& socket, network::packet_p& p) {
     auto* tcp_header = reinterpret_cast<network::tcp::header*>(p->payload + p->tag(2));
 
+    auto flags = switch_endian_16(tcp_header->flags);
+
+    // The handshake is still done one segment at a time
+    if(*flag_syn(&flags)){
+        return finalize_handshake(interface, socket, p);
+    }
+
+    return send_segment(interface, socket, p);
+}
+
+std::expected<void> network::tcp::layer::send_segment(network::interface_descriptor& interface, network::socket& socket, network::packet_p& p) {
+    auto* tcp_header = reinterpret_cast<network::tcp::header*>(p->payload + p->tag(2));
+
+    p->index = p->tag(2);
+
+    auto& connection = socket.get_connection_data<tcp_connection>();
+
+    uint32_t len = segment_payload_len(*p);
+
+    connection.send_lock.lock();
+
+    // Wait for the window to open (a segment can always be sent when nothing is in flight)
+    while(connection.connected && !connection.rtx_queue.empty() && flight_size(connection) + len > send_window(connection)){
+        logging::logf(logging::log_level::TRACE, "tcp:send: Wait for the window (flight:%u)\n", size_t(flight_size(connection)));
+
+        connection.window_queue.enqueue();
+        connection.send_lock.unlock();
+
+        scheduler::reschedule();
+
+        connection.send_lock.lock();
+    }
+
+    if(!connection.connected){
+        connection.send_lock.unlock();
+        return std::make_unexpected<void>(std::ERROR_SOCKET_NOT_CONNECTED);
+    }
+
+    tcp_header->sequence_number = switch_endian_32(connection.seq_number);
+    tcp_header->ack_number      = switch_endian_32(connection.ack_number);
+    tcp_header->window_size     = switch_endian_16(advertise_window(connection));
+
+    auto now = timer::milliseconds();
+
+    network::packet_p segment;
+
+    if(!p->user){
+        // A kernel packet is only referenced here, it can be kept as is until
+        // it is acknowledged
+        compute_checksum(*p);
+        segment = p;
+    } else {
+        // Keep a copy of the segment until it is acknowledged, the checksum is
+        // computed while copying the data
+        segment = copy_and_checksum(*p);
+    }
+
+    connection.rtx_queue.push({segment, connection.seq_number, len, now, false});
+    connection.seq_number += len;
+
+    if(!connection.rto_deadline){
+        connection.rto_deadline = now + connection.rto;
+    }
+
+    connection.send_lock.unlock();
+
+    logging::logf(logging::log_level::TRACE, "tcp:send: Send segment (len:%u)\n", size_t(len));
+
+    // The stored segment must not be handed to the interface
+    auto copy = copy_packet(*segment);
+    return parent->finalize_packet(interface, copy);
+}
+
+void network::tcp::layer::process_ack(tcp_connection& connection, uint32_t ack, uint32_t window, bool duplicate) {
+    std::lock_guard<mutex> l(connection.send_lock);
+
+    // The pollers are only notified when the connection becomes writable
+    bool window_full = !connection.rtx_queue.empty() && flight_size(connection) >= send_window(connection);
+
+    auto old_window = connection.snd_wnd;
+
+    connection.snd_wnd = window;
+
+    // The peer is alive, even if its window is still closed
+    connection.probes = 0;
+
+    bool advanced = seq_after(ack, connection.snd_una);
+
+    if(advanced){
+        auto now   = timer::milliseconds();
+        auto acked = ack - connection.snd_una;
+
+        // Release the segments covered by the cumulative ACK
+        while(!connection.rtx_queue.empty()){
+            auto& segment = connection.rtx_queue.top();
+
+            if(seq_after(segment.seq + segment.len, ack)){
+                break;
+            }
+
+            // Karn's algorithm: retransmitted segments give ambiguous samples
+            if(!segment.retransmitted){
+                update_rto(connection, now - segment.sent);
+            }
+
+            connection.rtx_queue.pop();
+        }
+
+        connection.snd_una         = ack;
+        connection.dup_acks        = 0;
+        connection.retransmissions = 0;
+
+        // Slow start or congestion avoidance
+        if(connection.cwnd < connection.ssthresh){
+            connection.cwnd += std::min(size_t(acked), tcp_mss);
+        } else {
+            connection.cwnd += std::max(size_t(1), tcp_mss * tcp_mss / connection.cwnd);
+        }
+
+        connection.rto_deadline = connection.rtx_queue.empty() ? 0 : now + connection.rto;
+    } else if(duplicate && window && window == old_window && ack == connection.snd_una && !connection.rtx_queue.empty()){
+        if(++connection.dup_acks == dup_ack_threshold){
+            logging::logf(logging::log_level::TRACE, "tcp: Fast retransmit (seq:%u)\n", size_t(ack));
+
+            connection.ssthresh = std::max(flight_size(connection) / 2, uint32_t(2 * tcp_mss));
+            connection.cwnd     = connection.ssthresh;
+
+            retransmit(connection);
+        }
+    }
+
+    // New data acknowledged or a window update (without new data) can unblock
+    // the senders
+    if(advanced || window > old_window){
+        connection.window_queue.wake_all();
+
+        if(window_full){
+            notify_pollers(connection);
+        }
+    }
+}
+
+void network::tcp::layer::retransmit(tcp_connection& connection) {
+    auto& segment = connection.rtx_queue.top();
+
+    segment.sent          = timer::milliseconds();
+    segment.retransmitted = true;
+
+    auto& interface = network::select_interface(connection.server_address);
+
+    auto copy = copy_packet(*segment.packet);
+
+    // Acknowledge the latest data and advertise the current window, patching
+    // the checksum rather than computing it again
+    auto* tcp_header = reinterpret_cast<network::tcp::header*>(copy->payload + copy->tag(2));
+
+    auto ack_number  = switch_endian_32(connection.ack_number);
+    auto window_size = switch_endian_16(advertise_window(connection));
+
+    auto checksum = tcp_header->checksum;
+    checksum = network::checksum_update_32(checksum, tcp_header->ack_number, ack_number);
+    checksum = network::checksum_update(checksum, tcp_header->window_size, window_size);
+
+    tcp_header->ack_number  = ack_number;
+    tcp_header->window_size = window_size;
+    tcp_header->checksum    = checksum;
+
+    parent->finalize_packet(interface, copy);
+}
+
+void network::tcp::layer::timer() {
+    auto now = timer::milliseconds();
+
+    connections.for_each_connection([&](tcp_connection& connection) {
+        std::lock_guard<mutex> l(connection.send_lock);
+
+        if(!connection.rto_deadline || now < connection.rto_deadline){
+            return;
+        }
+
+        // While the peer advertises a zero window, the first segment is a
+        // window probe: the peer answers it without acknowledging it. Only
+        // the unanswered probes count, the others are not retransmissions.
+        bool probe = !connection.snd_wnd;
+
+        if(probe ? ++connection.probes > max_retransmissions : ++connection.retransmissions > max_retransmissions){
+            logging::logf(logging::log_level::ERROR, "tcp: Too many retransmissions, drop the connection\n");
+
+            while(!connection.rtx_queue.empty()){
+                connection.rtx_queue.pop();
+            }
+
+            connection.rto_deadline = 0;
+            connection.connected    = false;
+
+            connection.window_queue.wake_all();
+            connection.receive_queue.wake_all();
+            notify_pollers(connection);
+
+            return;
+        }
+
+        if(probe){
+            logging::logf(logging::log_level::TRACE, "tcp: Zero window probe (seq:%u)\n", size_t(connection.snd_una));
+        } else {
+            logging::logf(logging::log_level::TRACE, "tcp: Retransmission timeout (seq:%u)\n", size_t(connection.snd_una));
+
+            // Restart from slow start
+            connection.ssthresh = std::max(flight_size(connection) / 2, uint32_t(2 * tcp_mss));
+            connection.cwnd     = tcp_mss;
+            connection.dup_acks = 0;
+        }
+
+        // Exponential backoff (for the probes too)
+        connection.rto = std::min(connection.rto * 2, max_rto_ms);
+
+        retransmit(connection);
+
+        connection.rto_deadline = now + connection.rto;
+    });
+}
+
+std::expected<void> network::tcp::layer::finalize_handshake(network::interface_descriptor& interface, network::socket& socket, network::packet_p& p) {
+    auto* tcp_header = reinterpret_cast<network::tcp::header*>(p->payload + p->tag(2));
+
     auto source_flags = switch_endian_16(tcp_header->flags);
 
     p->index -= *flag_data_offset(&source_flags) * 4;
@@ -467,6 +972,7 @@ std::expected<void> network::tcp::layer::finalize_packet(network::interface_desc
 
                 connection.fina_ack_number = switch_endian_32(tcp_header->ack_number);
                 connection.fina_seq_number = switch_endian_32(tcp_header->sequence_number);
+                connection.fina_window     = switch_endian_16(tcp_header->window_size);
 
                 received = true;
 
@@ -508,6 +1014,9 @@ std::expected<size_t> network::tcp::layer::connect(network::socket& sock, networ
     sock.connection_data = &connection;
     connection.socket = &sock;
 
+    // The SYN/ACK must find the connection
+    connections.bind_connection(connection);
+
     // Prepare the SYN packet
 
     auto p = kernel_prepare_packet(interface, connection, 0);
@@ -526,7 +1035,7 @@ std::expected<size_t> network::tcp::layer::connect(network::socket& sock, networ
 
     logging::logf(logging::log_level::TRACE, "tcp:connect: Send SYN\n");
 
-    auto status = finalize_packet(interface, sock, packet);
+    auto status = finalize_handshake(interface, sock, packet);
 
     if(!status){
         return std::make_unexpected<size_t, size_t>(status.error());
@@ -535,6 +1044,8 @@ std::expected<size_t> network::tcp::layer::connect(network::socket& sock, networ
     connection.seq_number = connection.fina_ack_number;
     connection.ack_number = connection.fina_seq_number + 1;
 
+    init_send_state(connection, connection.fina_window);
+
     // The SYN/ACK is ensured by finalize_packet
 
     logging::logf(logging::log_level::TRACE, "tcp:connect: Received SYN/ACK\n");
@@ -577,9 +1088,7 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket){
         return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
     }
 
-    // 1. Wait for SYN
-
-    connection.listening = true;
+    // 1. Wait for SYN (queued since server_start)
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: wait for connection\n");
 
@@ -612,14 +1121,17 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket){
 
             source_address = switch_endian_32(ip_header->source_ip);
 
+            // A retransmitted SYN can be queued after its connection was accepted
+            if (connections.get_connection_for_packet(source_address, source_port, target_port) != &connection) {
+                continue;
+            }
+
             break;
         }
     }
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: received SYN from %h\n", source_address);
 
-    connection.listening = false;
-
     // Set the future sequence and acknowledgement numbers
     connection.seq_number = ack;
     connection.ack_number = seq + 1;
@@ -645,6 +1157,8 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket){
     child_sock.connection_data = &child_connection;
     child_connection.socket = &child_sock;
 
+    connections.bind_connection(child_connection);
+
     // Child connection numbers
     child_connection.seq_number = connection.seq_number;
     child_connection.ack_number = connection.ack_number;
@@ -673,13 +1187,15 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket){
 
         logging::logf(logging::log_level::TRACE, "tcp:accept: Send SYN/ACK %h\n", size_t(flags));
 
-        auto status = finalize_packet(interface, child_sock, packet);
+        auto status = finalize_handshake(interface, child_sock, packet);
 
         if(!status){
             return std::make_unexpected<size_t, size_t>(status.error());
         }
     }
 
+    init_send_state(child_connection, child_connection.fina_window);
+
     // The ACK is enforced by finalize_packet
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: Done\n");
@@ -694,9 +1210,7 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
         return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
     }
 
-    // 1. Wait for SYN
-
-    connection.listening = true;
+    // 1. Wait for SYN (queued since server_start)
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: wait for connection\n");
 
@@ -741,6 +1255,11 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
 
             source_address = switch_endian_32(ip_header->source_ip);
 
+            // A retransmitted SYN can be queued after its connection was accepted
+            if (connections.get_connection_for_packet(source_address, source_port, target_port) != &connection) {
+                continue;
+            }
+
             break;
         }
 
@@ -749,8 +1268,6 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: received SYN from %h\n", source_address);
 
-    connection.listening = false;
-
     // Set the future sequence and acknowledgement numbers
     connection.seq_number = ack;
     connection.ack_number = seq + 1;
@@ -776,6 +1293,8 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
     child_sock.connection_data = &child_connection;
     child_connection.socket = &child_sock;
 
+    connections.bind_connection(child_connection);
+
     // Child connection numbers
     child_connection.seq_number = connection.seq_number;
     child_connection.ack_number = connection.ack_number;
@@ -804,13 +1323,15 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
 
         logging::logf(logging::log_level::TRACE, "tcp:accept: Send SYN/ACK %h\n", size_t(flags));
 
-        auto status = finalize_packet(interface, child_sock, packet);
+        auto status = finalize_handshake(interface, child_sock, packet);
 
         if(!status){
             return std::make_unexpected<size_t, size_t>(status.error());
         }
     }
 
+    init_send_state(child_connection, child_connection.fina_window);
+
     // The ACK is enforced by finalize_packet
 
     logging::logf(logging::log_level::TRACE, "tcp:accept: Done\n");
@@ -818,6 +1339,34 @@ std::expected<size_t> network::tcp::layer::accept(network::socket& socket, size_
     return {child_fd};
 }
 
+size_t network::tcp::layer::poll_events(network::socket& socket){
+    // Not connected yet
+    if(!socket.connection_data){
+        return 0;
+    }
+
+    auto& connection = socket.get_connection_data<tcp_connection>();
+
+    if(connection.server){
+        return connection.packets.empty() ? 0 : poll::POLL_IN;
+    }
+
+    size_t events = 0;
+
+    // The data received before the disconnection can still be read
+    if(!connection.rcv_buffer.empty()){
+        events |= poll::POLL_IN;
+    }
+
+    if(!connection.connected){
+        events |= poll::POLL_HUP;
+    } else if(connection.established && (connection.rtx_queue.empty() || flight_size(connection) < send_window(connection))){
+        events |= poll::POLL_OUT;
+    }
+
+    return events;
+}
+
 std::expected<void> network::tcp::layer::server_start(network::socket& sock, size_t server_port, network::ip::address server) {
     // Create the connection
 
@@ -831,10 +1380,15 @@ std::expected<void> network::tcp::layer::server_start(network::socket& sock, siz
     sock.connection_data = &connection;
     connection.socket = &sock;
 
+    connections.bind_connection(connection);
+
     // Mark the connection as connected
 
     connection.connected = true;
 
+    // The connection requests are queued even outside of accept
+    connection.listening = true;
+
     return {};
 }
 
@@ -847,6 +1401,27 @@ std::expected<void> network::tcp::layer::disconnect(network::socket& sock) {
         return std::make_expected();
     }
 
+    // Wait for all the data to be acknowledged before sending FIN
+
+    connection.send_lock.lock();
+
+    while(connection.connected && !connection.rtx_queue.empty()){
+        connection.window_queue.enqueue();
+        connection.send_lock.unlock();
+
+        scheduler::reschedule();
+
+        connection.send_lock.lock();
+    }
+
+    connection.established = false;
+
+    connection.send_lock.unlock();
+
+    if(!connection.connected){
+        return std::make_unexpected<void>(std::ERROR_SOCKET_TCP_ERROR);
+    }
+
     auto target_ip  = connection.server_address;
     auto& interface = network::select_interface(target_ip);
 
@@ -1059,11 +1634,31 @@ std::expected<network::packet_p> network::tcp::layer::kernel_prepare_packet(netw
 
         tcp_header->sequence_number = switch_endian_32(connection.seq_number);
         tcp_header->ack_number      = switch_endian_32(connection.ack_number);
+        tcp_header->window_size     = switch_endian_16(advertise_window(connection));
     }
 
     return p;
 }
 
+void network::tcp::layer::send_ack(network::interface_descriptor& interface, tcp_connection& connection){
+    auto p = kernel_prepare_packet(interface, connection, 0);
+
+    if (!p) {
+        logging::logf(logging::log_level::ERROR, "tcp: Impossible to prepare TCP packet for ACK\n");
+        return;
+    }
+
+    auto& packet = *p;
+
+    auto* tcp_header = reinterpret_cast<header*>(packet->payload + packet->tag(2));
+
+    auto flags = get_default_flags();
+    (flag_ack(&flags)) = 1;
+    tcp_header->flags = switch_endian_16(flags);
+
+    finalize_packet_direct(interface, packet);
+}
+
 // finalize without waiting for ACK
 std::expected<void> network::tcp::layer::finalize_packet_direct(network::interface_descriptor& interface, network::packet_p& p) {
     auto* tcp_header = reinterpret_cast<network::tcp::header*>(p->payload + p->tag(2));
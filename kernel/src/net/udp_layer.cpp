@@ -13,35 +13,85 @@
 #include "net/dhcp_layer.hpp"
 #include "net/checksum.hpp"
 #include "net/network.hpp"
+#include "net/packet_ring.hpp"
 
 #include "kernel_utils.hpp"
+#include "poll.hpp"
 
 namespace {
 
+uint32_t pseudo_header_sum(const network::ip::header* ip_header, size_t length){
+    // Accumulate the IP addresses
+    auto sum = network::checksum_add_bytes(&ip_header->source_ip, 8);
+
+    // Accumulate the IP Protocol
+    sum += ip_header->protocol;
+
+    // Accumulate the UDP length
+    sum += length;
+
+    return sum;
+}
+
+/*!
+ * \brief Set the length of a packet and compute its checksum.
+ *
+ * The length is the one of the packet allocated by the kernel. The header
+ * cannot be trusted, the headers of the ring packets are writable by the
+ * process.
+ */
 void compute_checksum(network::packet& packet){
     auto* ip_header = reinterpret_cast<network::ip::header*>(packet.payload + packet.tag(1));
     auto* udp_header = reinterpret_cast<network::udp::header*>(packet.payload + packet.tag(2));
 
+    size_t length = packet.payload_size - packet.tag(2);
+
+    udp_header->length   = switch_endian_16(length);
     udp_header->checksum = 0;
 
-    auto length = switch_endian_16(udp_header->length);
+    // Accumulate the Payload
+    auto sum = network::checksum_add_bytes(packet.payload + packet.tag(2), length);
 
-    uint32_t sum = 0;
+    sum += pseudo_header_sum(ip_header, length);
 
-    // Accumulate the Payload
-    sum += network::checksum_add_bytes(packet.payload + packet.tag(2), length);
+    // Complete the 1-complement sum
+    udp_header->checksum = switch_endian_16(network::checksum_finalize_nz(sum));
+}
 
-    // Accumulate the IP addresses
-    sum += network::checksum_add_bytes(&ip_header->source_ip, 8);
+/*!
+ * \brief Copy a user packet to kernel memory, computing its checksum while
+ * copying the UDP header and payload.
+ *
+ * The length is the one of the packet allocated by the kernel, not the one
+ * of the header, written by the process.
+ */
+network::packet_p copy_and_checksum(network::packet& packet){
+    auto* ip_header = reinterpret_cast<network::ip::header*>(packet.payload + packet.tag(1));
+    auto* udp_header = reinterpret_cast<network::udp::header*>(packet.payload + packet.tag(2));
 
-    // Accumulate the IP Protocol
-    sum += ip_header->protocol;
+    auto offset = packet.tag(2);
+    size_t length = packet.payload_size - offset;
 
-    // Accumulate the UDP length
-    sum += length;
+    udp_header->length   = switch_endian_16(length);
+    udp_header->checksum = 0;
 
-    // Complete the 1-complement sum
-    udp_header->checksum = switch_endian_16(network::checksum_finalize_nz(sum));
+    auto copy = network::make_packet(packet.payload_size);
+
+    std::copy_n(packet.payload, offset, copy->payload);
+
+    auto sum = network::checksum_copy(copy->payload + offset, packet.payload + offset, length);
+
+    sum += pseudo_header_sum(ip_header, length);
+
+    copy->index     = packet.index;
+    copy->tags      = packet.tags;
+    copy->interface = packet.interface;
+
+    auto* copy_header = reinterpret_cast<network::udp::header*>(copy->payload + offset);
+
+    copy_header->checksum = switch_endian_16(network::checksum_finalize_nz(sum));
+
+    return copy;
 }
 
 void prepare_packet(network::packet& packet, size_t source, size_t target, size_t payload_size){
@@ -58,6 +108,69 @@ void prepare_packet(network::packet& packet, size_t source, size_t target, size_
     packet.index += sizeof(network::udp::header);
 }
 
+size_t payload_length(const network::packet_p& packet){
+    auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
+
+    // The length of the header includes the header itself
+    return switch_endian_16(udp_header->length) - sizeof(network::udp::header);
+}
+
+/*!
+ * \brief Copy the payload of a received packet to a user buffer
+ * \param address If not null, the source address is written there
+ * \return The size of the payload or an error
+ */
+std::expected<size_t> read_payload(const network::packet_p& packet, char* buffer, size_t n, network::inet_address* address){
+    auto payload_len = payload_length(packet);
+
+    if(payload_len > n){
+        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
+    }
+
+    if(address){
+        auto* ip_header  = reinterpret_cast<network::ip::header*>(packet->payload + packet->tag(1));
+        auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
+
+        address->port    = switch_endian_16(udp_header->source_port);
+        address->address = switch_endian_32(ip_header->source_ip);
+    }
+
+    std::copy_n(packet->payload + packet->index, payload_len, buffer);
+
+    return payload_len;
+}
+
+/*!
+ * \brief Read the messages already received by the socket, without waiting
+ * \return The number of messages read or an error if the first one could not be read
+ */
+std::expected<size_t> read_datagrams(network::socket& socket, network::datagram* datagrams, size_t n){
+    size_t received = 0;
+
+    while(received < n && !socket.listen_packets.empty()){
+        auto& datagram = datagrams[received];
+        auto packet    = socket.listen_packets.top();
+
+        // A message that does not fit is left for the next receive
+        if(received && payload_length(packet) > datagram.size){
+            break;
+        }
+
+        socket.listen_packets.pop();
+
+        auto size = read_payload(packet, datagram.buffer, datagram.size, &datagram.address);
+
+        if(!size){
+            return std::make_unexpected<size_t>(size.error());
+        }
+
+        datagram.received = *size;
+        ++received;
+    }
+
+    return received;
+}
+
 } //end of anonymous namespace
 
 network::udp::layer::layer(network::ip::layer* parent) : parent(parent) {
@@ -90,7 +203,11 @@ void network::udp::layer::decode(network::interface_descriptor& interface, netwo
         dhcp_layer->decode(interface, packet);
     }
 
-    auto connection_ptr = connections.get_connection_for_packet(source_port, target_port);
+    auto* ip_header = reinterpret_cast<network::ip::header*>(packet->payload + packet->tag(1));
+
+    network::ip::address source_address = switch_endian_32(ip_header->source_ip);
+
+    auto connection_ptr = connections.get_connection_for_packet(source_address, source_port, target_port);
 
     if(connection_ptr){
         auto& connection = *connection_ptr;
@@ -103,6 +220,7 @@ void network::udp::layer::decode(network::interface_descriptor& interface, netwo
             if (socket.listen) {
                 socket.listen_packets.push(packet);
                 socket.listen_queue.notify_one();
+                poll::notify(socket);
             }
         }
     } else {
@@ -127,7 +245,7 @@ std::expected<network::packet_p> network::udp::layer::user_prepare_packet(char*
 
     auto ip = connection.server_address;
     auto ip_str = network::ip::ip_to_str(ip);
-    logging::logf(logging::log_level::ERROR, "udp: Craft destination=%s\n", ip_str.c_str());
+    logging::logf(logging::log_level::TRACE, "udp: Craft destination=%s\n", ip_str.c_str());
 
     // Ask the IP layer to craft a packet
     network::ip::packet_descriptor desc{sizeof(header) + descriptor->payload_size, connection.server_address, 0x11};
@@ -145,7 +263,7 @@ std::expected<network::packet_p> network::udp::layer::user_prepare_packet(char*
 
     auto ip = connection.server_address;
     auto ip_str = network::ip::ip_to_str(ip);
-    logging::logf(logging::log_level::ERROR, "udp: Craft destination=%s\n", ip_str.c_str());
+    logging::logf(logging::log_level::TRACE, "udp: Craft destination=%s\n", ip_str.c_str());
 
     // Ask the IP layer to craft a packet
     network::ip::packet_descriptor desc{sizeof(network::udp::header) + descriptor->payload_size, address->address, 0x11};
@@ -161,6 +279,14 @@ std::expected<network::packet_p> network::udp::layer::user_prepare_packet(char*
 std::expected<void> network::udp::layer::finalize_packet(network::interface_descriptor& interface, network::packet_p& p){
     p->index -= sizeof(header);
 
+    if(p->user){
+        // The packet has to be copied to kernel memory, compute the checksum
+        // during the copy rather than in a separate pass
+        auto copy = copy_and_checksum(*p);
+
+        return parent->finalize_packet(interface, copy);
+    }
+
     // Compute the checksum
     compute_checksum(*p);
 
@@ -185,6 +311,8 @@ std::expected<size_t> network::udp::layer::client_bind(network::socket& sock, si
     sock.connection_data = &connection;
     connection.socket = &sock;
 
+    connections.bind_connection(connection);
+
     // Mark the connection as connected
 
     connection.connected = true;
@@ -205,6 +333,8 @@ std::expected<void> network::udp::layer::server_bind(network::socket& sock, size
     sock.connection_data = &connection;
     connection.socket = &sock;
 
+    connections.bind_connection(connection);
+
     // Mark the connection as connected
 
     connection.connected = true;
@@ -297,16 +427,7 @@ std::expected<size_t> network::udp::layer::receive(char* buffer, network::socket
     auto packet = socket.listen_packets.top();
     socket.listen_packets.pop();
 
-    auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
-    auto payload_len = switch_endian_16(udp_header->length);
-
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
-    }
-
-    std::copy_n(packet->payload + packet->index, payload_len, buffer);
-
-    return payload_len;
+    return read_payload(packet, buffer, n, nullptr);
 }
 
 std::expected<size_t> network::udp::layer::receive(char* buffer, network::socket& socket, size_t n, size_t ms){
@@ -330,16 +451,7 @@ std::expected<size_t> network::udp::layer::receive(char* buffer, network::socket
     auto packet = socket.listen_packets.top();
     socket.listen_packets.pop();
 
-    auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
-    auto payload_len = switch_endian_16(udp_header->length);
-
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
-    }
-
-    std::copy_n(packet->payload + packet->index, payload_len, buffer);
-
-    return payload_len;
+    return read_payload(packet, buffer, n, nullptr);
 }
 
 std::expected<size_t> network::udp::layer::receive_from(char* buffer, network::socket& socket, size_t n, void* addr){
@@ -359,21 +471,7 @@ std::expected<size_t> network::udp::layer::receive_from(char* buffer, network::s
     auto packet = socket.listen_packets.top();
     socket.listen_packets.pop();
 
-    auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
-    auto payload_len = switch_endian_16(udp_header->length);
-
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
-    }
-
-    auto* ip_header = reinterpret_cast<network::ip::header*>(packet->payload + packet->tag(1));
-
-    address->port    = switch_endian_16(udp_header->source_port);
-    address->address = switch_endian_32(ip_header->source_ip);
-
-    std::copy_n(packet->payload + packet->index, payload_len, buffer);
-
-    return payload_len;
+    return read_payload(packet, buffer, n, address);
 }
 
 std::expected<size_t> network::udp::layer::receive_from(char* buffer, network::socket& socket, size_t n, size_t ms, void* addr){
@@ -399,21 +497,91 @@ std::expected<size_t> network::udp::layer::receive_from(char* buffer, network::s
     auto packet = socket.listen_packets.top();
     socket.listen_packets.pop();
 
-    auto* udp_header = reinterpret_cast<network::udp::header*>(packet->payload + packet->tag(2));
-    auto payload_len = switch_endian_16(udp_header->length);
+    return read_payload(packet, buffer, n, address);
+}
 
-    if(payload_len > n){
-        return std::make_unexpected<size_t>(std::ERROR_BUFFER_SMALL);
+std::expected<size_t> network::udp::layer::send_many(char* target_buffer, network::socket& socket, network::datagram* datagrams, size_t n, bool addressed){
+    for(size_t i = 0; i < n; ++i){
+        auto& datagram = datagrams[i];
+
+        // The packet is copied by finalize, the target buffer can be reused
+        auto status = addressed
+            ? send_to(target_buffer, socket, datagram.buffer, datagram.size, &datagram.address)
+            : send(target_buffer, socket, datagram.buffer, datagram.size);
+
+        if(!status){
+            if(i){
+                return i;
+            }
+
+            return std::make_unexpected<size_t>(status.error());
+        }
     }
 
-    auto* ip_header = reinterpret_cast<network::ip::header*>(packet->payload + packet->tag(1));
+    return n;
+}
 
-    address->port    = switch_endian_16(udp_header->source_port);
-    address->address = switch_endian_32(ip_header->source_ip);
+std::expected<void> network::udp::layer::ring_send(network::socket& socket, network::packet_ring& ring, size_t n){
+    auto& connection = socket.get_connection_data<udp_connection>();
 
-    std::copy_n(packet->payload + packet->index, payload_len, buffer);
+    // Make sure stream sockets are connected
+    if(!connection.connected){
+        return std::make_unexpected<void>(std::ERROR_SOCKET_NOT_CONNECTED);
+    }
 
-    return payload_len;
+    auto target_ip  = connection.server_address;
+    auto& interface = network::select_interface(target_ip);
+
+    // The slot is writable by the process, the headers are built in a kernel
+    // packet and only the payload is taken from the slot
+    network::udp::kernel_packet_descriptor desc{n, connection.local_port, connection.server_port, target_ip};
+    auto packet_e = kernel_prepare_packet(interface, desc);
+
+    if (packet_e) {
+        auto& packet = *packet_e;
+
+        network::take_ring_payload(ring, packet->payload + packet->index, n);
+
+        return finalize_packet(interface, packet);
+    }
+
+    return std::make_unexpected<void>(packet_e.error());
+}
+
+std::expected<size_t> network::udp::layer::receive_many(network::socket& socket, network::datagram* datagrams, size_t n){
+    auto& connection = socket.get_connection_data<udp_connection>();
+
+    // Make sure stream sockets are connected
+    if(!connection.connected){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
+    }
+
+    if(socket.listen_packets.empty()){
+        socket.listen_queue.wait();
+    }
+
+    return read_datagrams(socket, datagrams, n);
+}
+
+std::expected<size_t> network::udp::layer::receive_many(network::socket& socket, network::datagram* datagrams, size_t n, size_t ms){
+    auto& connection = socket.get_connection_data<udp_connection>();
+
+    // Make sure stream sockets are connected
+    if(!connection.connected){
+        return std::make_unexpected<size_t>(std::ERROR_SOCKET_NOT_CONNECTED);
+    }
+
+    if(socket.listen_packets.empty()){
+        if(!ms){
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_TIMEOUT);
+        }
+
+        if(!socket.listen_queue.wait_for(ms)){
+            return std::make_unexpected<size_t>(std::ERROR_SOCKET_TIMEOUT);
+        }
+    }
+
+    return read_datagrams(socket, datagrams, n);
 }
 
 void network::udp::layer::register_dns_layer(network::dns::layer* layer){
@@ -500,7 +500,7 @@ void clear_physical_page(size_t physical){
 }
 
 //TODO It is highly inefficient to remap CR3 each time
-bool paging::user_map(scheduler::process_t& process, size_t virt, size_t physical){
+bool paging::user_map(scheduler::process_t& process, size_t virt, size_t physical, uint8_t flags){
     physical_pointer cr3_ptr(process.physical_cr3, 1);
 
     if(!cr3_ptr){
@@ -573,7 +573,7 @@ bool paging::user_map(scheduler::process_t& process, size_t virt, size_t physica
     auto pt = pt_ptr.as<pt_t>();
 
     //Map to the physical address
-    pt[pte] = reinterpret_cast<page_entry>(physical | WRITE | USER | PRESENT);
+    pt[pte] = reinterpret_cast<page_entry>(physical | flags);
 
     return true;
 }
@@ -592,6 +592,91 @@ bool paging::user_map_pages(scheduler::process_t& process, size_t virt, size_t p
     return true;
 }
 
+void paging::user_unmap_pages(scheduler::process_t& process, size_t virt, size_t pages){
+    physical_pointer cr3_ptr(process.physical_cr3, 1);
+
+    if(!cr3_ptr){
+        return;
+    }
+
+    auto pml4t = cr3_ptr.as<pml4t_t>();
+
+    for(size_t page = 0; page < pages; ++page){
+        auto virt_addr = virt + page * PAGE_SIZE;
+
+        auto pml4e = pml4_entry(virt_addr);
+        auto pdpte = pdpt_entry(virt_addr);
+        auto pde = pd_entry(virt_addr);
+        auto pte = pt_entry(virt_addr);
+
+        //Nothing to do if one of the tables is not present
+
+        if(!(reinterpret_cast<uintptr_t>(pml4t[pml4e]) & PRESENT)){
+            continue;
+        }
+
+        physical_pointer pdpt_ptr(reinterpret_cast<uintptr_t>(pml4t[pml4e]) & ~0xFFF, 1);
+        auto pdpt = pdpt_ptr.as<pdpt_t>();
+
+        if(!(reinterpret_cast<uintptr_t>(pdpt[pdpte]) & PRESENT)){
+            continue;
+        }
+
+        physical_pointer pd_ptr(reinterpret_cast<uintptr_t>(pdpt[pdpte]) & ~0xFFF, 1);
+        auto pd = pd_ptr.as<pd_t>();
+
+        if(!(reinterpret_cast<uintptr_t>(pd[pde]) & PRESENT)){
+            continue;
+        }
+
+        physical_pointer pt_ptr(reinterpret_cast<uintptr_t>(pd[pde]) & ~0xFFF, 1);
+        auto pt = pt_ptr.as<pt_t>();
+
+        pt[pte] = 0x0;
+
+        flush_tlb(virt_addr);
+    }
+}
+
+bool paging::user_page_present(scheduler::process_t& process, size_t virt){
+    physical_pointer cr3_ptr(process.physical_cr3, 1);
+
+    if(!cr3_ptr){
+        return false;
+    }
+
+    auto pml4e = pml4_entry(virt);
+    auto pdpte = pdpt_entry(virt);
+    auto pde = pd_entry(virt);
+    auto pte = pt_entry(virt);
+
+    auto pml4t = cr3_ptr.as<pml4t_t>();
+    if(!(reinterpret_cast<uintptr_t>(pml4t[pml4e]) & PRESENT)){
+        return false;
+    }
+
+    physical_pointer pdpt_ptr(reinterpret_cast<uintptr_t>(pml4t[pml4e]) & ~0xFFF, 1);
+    auto pdpt = pdpt_ptr.as<pdpt_t>();
+
+    if(!(reinterpret_cast<uintptr_t>(pdpt[pdpte]) & PRESENT)){
+        return false;
+    }
+
+    physical_pointer pd_ptr(reinterpret_cast<uintptr_t>(pdpt[pdpte]) & ~0xFFF, 1);
+    auto pd = pd_ptr.as<pd_t>();
+
+    if(!(reinterpret_cast<uintptr_t>(pd[pde]) & PRESENT)){
+        return false;
+    }
+
+    physical_pointer pt_ptr(reinterpret_cast<uintptr_t>(pd[pde]) & ~0xFFF, 1);
+    auto pt = pt_ptr.as<pt_t>();
+
+    auto entry = reinterpret_cast<uintptr_t>(pt[pte]);
+
+    return (entry & PRESENT) && (entry & USER);
+}
+
 size_t paging::get_physical_pml4t(){
     return physical_pml4t_start;
 }
@@ -0,0 +1,297 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "poll.hpp"
+#include "scheduler.hpp"
+#include "timer.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "net/network.hpp"
+
+#include "tlib/errors.hpp"
+
+namespace {
+
+constexpr const size_t NO_SEQUENCE = size_t(-1); ///< Forces the next report of an edge-triggered entry
+
+bool target_exists(poll::poll_target target, size_t fd){
+    switch(target){
+        case poll::poll_target::SOCKET:
+            return scheduler::has_socket(fd);
+
+        case poll::poll_target::FILE:
+            return scheduler::has_handle(fd);
+
+        default:
+            return false;
+    }
+}
+
+poll::poll_entry* find_entry(poll::poll_set& set, poll::poll_target target, size_t fd){
+    for(auto& entry : set.entries){
+        if(entry.target == target && entry.fd == fd){
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void remove_poller(network::socket& socket, poll::poll_set& set){
+    for(size_t i = 0; i < socket.pollers.size(); ++i){
+        if(socket.pollers[i] == &set){
+            socket.pollers.erase(i);
+            break;
+        }
+    }
+}
+
+/*!
+ * \brief Fill the events with the ready entries of the set.
+ *
+ * This must be called with interrupts disabled, in the context of the owner
+ * of the set.
+ *
+ * \return the number of ready entries
+ */
+size_t collect(poll::poll_set& set, poll::poll_event* events, size_t max){
+    size_t ready = 0;
+
+    auto n = set.entries.size();
+
+    // Start after the last reported entry to not starve the others
+    for(size_t i = 0; i < n && ready < max; ++i){
+        auto index = (set.next + i) % n;
+        auto& entry = set.entries[index];
+
+        size_t state;
+        size_t sequence;
+
+        if(entry.target == poll::poll_target::SOCKET){
+            if(!scheduler::has_socket(entry.fd)){
+                continue;
+            }
+
+            auto& socket = scheduler::get_socket(entry.fd);
+
+            state    = network::poll_events(socket);
+            sequence = socket.poll_sequence;
+        } else {
+            if(!scheduler::has_handle(entry.fd)){
+                continue;
+            }
+
+            // Files never block
+            state    = poll::POLL_IN | poll::POLL_OUT;
+            sequence = 0;
+        }
+
+        state &= entry.events | poll::POLL_HUP;
+
+        if(!state){
+            continue;
+        }
+
+        if(entry.events & poll::POLL_EDGE){
+            if(sequence == entry.last_sequence){
+                continue;
+            }
+
+            entry.last_sequence = sequence;
+        }
+
+        events[ready++] = {entry.target, entry.fd, state};
+
+        set.next = index + 1;
+    }
+
+    return ready;
+}
+
+std::expected<size_t> wait_ready(size_t set_fd, poll::poll_event* events, size_t max, bool timeout, size_t ms){
+    if(!scheduler::has_poll_set(set_fd)){
+        return std::make_unexpected<size_t>(std::ERROR_INVALID_FILE_DESCRIPTOR);
+    }
+
+    if(!events || !max){
+        return std::make_unexpected<size_t>(std::ERROR_INVALID_COUNT);
+    }
+
+    auto& set = scheduler::get_poll_set(set_fd);
+
+    auto deadline = timer::milliseconds() + ms;
+
+    while(true){
+        {
+            direct_int_lock lock;
+
+            if(!set.is_valid()){
+                return std::make_unexpected<size_t>(std::ERROR_INVALID_FILE_DESCRIPTOR);
+            }
+
+            // The check and the enqueue are atomic with respect to notify
+            auto ready = collect(set, events, max);
+
+            if(ready){
+                return ready;
+            }
+
+            if(!timeout){
+                set.queue.enqueue();
+            } else {
+                auto now = timer::milliseconds();
+
+                if(now >= deadline){
+                    return 0;
+                }
+
+                set.queue.enqueue_timeout(deadline - now);
+            }
+        }
+
+        scheduler::reschedule();
+    }
+}
+
+} //end of anonymous namespace
+
+std::expected<size_t> poll::create(){
+    return scheduler::register_new_poll_set();
+}
+
+std::expected<void> poll::close(size_t set_fd){
+    if(!scheduler::has_poll_set(set_fd)){
+        return std::make_unexpected<void>(std::ERROR_INVALID_FILE_DESCRIPTOR);
+    }
+
+    auto& set = scheduler::get_poll_set(set_fd);
+
+    direct_int_lock lock;
+
+    for(auto& entry : set.entries){
+        if(entry.target == poll_target::SOCKET && scheduler::has_socket(entry.fd)){
+            remove_poller(scheduler::get_socket(entry.fd), set);
+        }
+    }
+
+    set.entries.clear();
+
+    scheduler::release_poll_set(set_fd);
+
+    // The waiters will see the set is not valid anymore
+    set.queue.wake_all();
+
+    return std::make_expected();
+}
+
+std::expected<void> poll::control(size_t set_fd, poll_operation operation, poll_target target, size_t fd, size_t events){
+    if(!scheduler::has_poll_set(set_fd)){
+        return std::make_unexpected<void>(std::ERROR_INVALID_FILE_DESCRIPTOR);
+    }
+
+    if(!target_exists(target, fd)){
+        return std::make_unexpected<void>(target == poll_target::SOCKET ? std::ERROR_SOCKET_INVALID_FD : std::ERROR_INVALID_FILE_DESCRIPTOR);
+    }
+
+    auto& set = scheduler::get_poll_set(set_fd);
+
+    direct_int_lock lock;
+
+    auto* entry = find_entry(set, target, fd);
+
+    switch(operation){
+        case poll_operation::ADD:
+            if(entry){
+                return std::make_unexpected<void>(std::ERROR_EXISTS);
+            }
+
+            set.entries.push_back({target, fd, events, NO_SEQUENCE});
+
+            if(target == poll_target::SOCKET){
+                scheduler::get_socket(fd).pollers.push_back(&set);
+            }
+
+            break;
+
+        case poll_operation::MODIFY:
+            if(!entry){
+                return std::make_unexpected<void>(std::ERROR_NOT_EXISTS);
+            }
+
+            entry->events        = events;
+            entry->last_sequence = NO_SEQUENCE;
+
+            break;
+
+        case poll_operation::REMOVE:
+            if(!entry){
+                return std::make_unexpected<void>(std::ERROR_NOT_EXISTS);
+            }
+
+            set.entries.erase(entry);
+
+            if(target == poll_target::SOCKET){
+                remove_poller(scheduler::get_socket(fd), set);
+            }
+
+            break;
+
+        default:
+            return std::make_unexpected<void>(std::ERROR_INVALID_REQUEST);
+    }
+
+    // Let the waiters consider the new events
+    set.queue.wake_all();
+
+    return std::make_expected();
+}
+
+std::expected<size_t> poll::wait(size_t set_fd, poll_event* events, size_t max){
+    return wait_ready(set_fd, events, max, false, 0);
+}
+
+std::expected<size_t> poll::wait(size_t set_fd, poll_event* events, size_t max, size_t ms){
+    return wait_ready(set_fd, events, max, true, ms);
+}
+
+void poll::notify(network::socket& socket){
+    direct_int_lock lock;
+
+    ++socket.poll_sequence;
+
+    for(auto* set : socket.pollers){
+        set->queue.wake_all();
+    }
+}
+
+void poll::detach(network::socket& socket){
+    direct_int_lock lock;
+
+    for(auto* set : socket.pollers){
+        for(size_t i = 0; i < set->entries.size(); ++i){
+            auto& entry = set->entries[i];
+
+            if(entry.target == poll_target::SOCKET && entry.fd == socket.id){
+                set->entries.erase(i);
+                break;
+            }
+        }
+    }
+
+    socket.pollers.clear();
+}
+
+void poll::release(std::deque<network::socket>& sockets, std::deque<poll_set>& poll_sets){
+    direct_int_lock lock;
+
+    for(auto& socket : sockets){
+        socket.pollers.clear();
+    }
+
+    poll_sets.clear();
+}
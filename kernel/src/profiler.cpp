@@ -0,0 +1,210 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+#include <algorithms.hpp>
+
+#include "profiler.hpp"
+#include "scheduler.hpp"
+#include "timer.hpp"
+#include "paging.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
+
+volatile bool profiler::enabled = false;
+
+namespace {
+
+constexpr const size_t max_samples   = 4096; ///< The number of samples of the buffer
+constexpr const size_t max_processes = 64;   ///< The number of processes names kept
+constexpr const uint64_t no_pid      = uint64_t(-1); ///< No process sampled yet
+
+profiler::sample_record* samples    = nullptr; ///< The samples
+profiler::process_record* processes = nullptr; ///< The names of the sampled processes
+
+size_t recorded       = 0; ///< The number of samples in the buffer
+size_t lost           = 0; ///< The number of samples dropped since the start
+size_t known          = 0; ///< The number of processes records
+size_t period         = 1; ///< The number of ticks between two samples
+size_t remaining      = 1; ///< The number of ticks before the next sample
+uint64_t last_pid     = no_pid; ///< The last sampled process
+
+void remember_process(uint64_t pid){
+    if(pid == last_pid){
+        return;
+    }
+
+    last_pid = pid;
+
+    for(size_t i = 0; i < known; ++i){
+        if(processes[i].pid == pid){
+            return;
+        }
+    }
+
+    if(known == max_processes){
+        return;
+    }
+
+    auto& record = processes[known++];
+
+    auto& name = scheduler::get_process(pid).name;
+    auto length = std::min(name.size(), sizeof(record.name) - 1);
+
+    record.pid = pid;
+    std::copy_n(name.c_str(), length, record.name);
+    record.name[length] = '\0';
+}
+
+std::string sysfs_enable(void*){
+    return profiler::enabled ? "1" : "0";
+}
+
+size_t sysfs_store_enable(void*, const std::string& value){
+    bool enable = std::atoui(value);
+
+    direct_int_lock lock;
+
+    // A new profile starts with an empty buffer
+    if(!profiler::enabled && enable){
+        recorded  = 0;
+        lost      = 0;
+        known     = 0;
+        last_pid  = no_pid;
+        remaining = period;
+    }
+
+    profiler::enabled = enable;
+
+    return 0;
+}
+
+std::string sysfs_period(void*){
+    return std::to_string(period);
+}
+
+size_t sysfs_store_period(void*, const std::string& value){
+    auto ticks = std::atoui(value);
+
+    if(ticks){
+        direct_int_lock lock;
+
+        period    = ticks;
+        remaining = ticks;
+    }
+
+    return 0;
+}
+
+std::string sysfs_frequency(){
+    return std::to_string(timer::timer_frequency() / period);
+}
+
+std::string sysfs_samples(){
+    return std::to_string(recorded);
+}
+
+std::string sysfs_lost(){
+    return std::to_string(lost);
+}
+
+std::string sysfs_raw(){
+    auto* buffer = new char[sizeof(profiler::dump_header) + max_processes * sizeof(profiler::process_record) + max_samples * sizeof(profiler::sample_record)];
+
+    auto& header = *reinterpret_cast<profiler::dump_header*>(buffer);
+
+    size_t size;
+
+    {
+        direct_int_lock lock;
+
+        std::copy_n("THORPRF1", 8, header.magic);
+        header.version     = 1;
+        header.sample_size = sizeof(profiler::sample_record);
+        header.samples     = recorded;
+        header.processes   = known;
+        header.lost        = lost;
+        header.frequency   = timer::timer_frequency() / period;
+
+        auto* process_records = reinterpret_cast<profiler::process_record*>(buffer + sizeof(profiler::dump_header));
+        auto* sample_records  = reinterpret_cast<profiler::sample_record*>(process_records + known);
+
+        std::copy_n(processes, known, process_records);
+        std::copy_n(samples, recorded, sample_records);
+
+        size = sizeof(profiler::dump_header) + known * sizeof(profiler::process_record) + recorded * sizeof(profiler::sample_record);
+    }
+
+    std::string value(buffer, buffer + size);
+
+    delete[] buffer;
+
+    return value;
+}
+
+} //end of anonymous namespace
+
+void profiler::init(){
+    samples   = new profiler::sample_record[max_samples];
+    processes = new profiler::process_record[max_processes];
+
+    sysfs::set_writable_value_data(sysfs::get_sys_path(), path("/profiler/enable"), &sysfs_enable, &sysfs_store_enable, nullptr);
+    sysfs::set_writable_value_data(sysfs::get_sys_path(), path("/profiler/period"), &sysfs_period, &sysfs_store_period, nullptr);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/profiler/frequency"), &sysfs_frequency);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/profiler/samples"), &sysfs_samples);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/profiler/lost"), &sysfs_lost);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/profiler/raw"), &sysfs_raw);
+}
+
+void profiler::sample(const interrupt::syscall_regs* regs){
+    // Called from the timer IRQ handler, with interrupts disabled
+
+    if(--remaining){
+        return;
+    }
+
+    remaining = period;
+
+    if(recorded == max_samples){
+        ++lost;
+        return;
+    }
+
+    auto pid = scheduler::get_pid();
+
+    auto& s = samples[recorded++];
+
+    s.rip   = regs->rip;
+    s.pid   = pid;
+    s.flags = (regs->cs & 3) ? SAMPLE_USER : 0;
+    s.depth = 0;
+
+#ifdef THOR_STACK
+    // The callers can only be found with the frame pointers, only the kernel
+    // stacks are walked since they are mapped in the kernel page tables
+    if(!(s.flags & SAMPLE_USER)){
+        auto rbp = regs->rbp;
+
+        while(s.depth < max_frames && rbp && !(rbp & 7) && paging::page_present(rbp) && paging::page_present(rbp + 8)){
+            s.frames[s.depth++] = *reinterpret_cast<uint64_t*>(rbp + 8);
+
+            auto next = *reinterpret_cast<uint64_t*>(rbp);
+
+            // The stack grows down, the callers frames are above
+            if(next <= rbp){
+                break;
+            }
+
+            rbp = next;
+        }
+    }
+#endif
+
+    remember_process(pid);
+}
@@ -18,6 +18,7 @@
 
 #include "scheduler.hpp"
 #include "paging.hpp"
+#include "shared_page.hpp"
 #include "assert.hpp"
 #include "gdt.hpp"
 #include "stdio.hpp"
@@ -30,9 +31,14 @@
 #include "logging.hpp"
 #include "timer.hpp"
 #include "kernel.hpp"
+#include "fpu.hpp"
+#include "trace.hpp"
+#include "futex.hpp"
 
 #include "fs/procfs.hpp"
 
+#include "net/packet_ring.hpp"
+
 //Provided by task_switch.s
 extern "C" {
 extern void task_switch(size_t current, size_t next);
@@ -84,6 +90,30 @@ void idle_task(){
     }
 }
 
+// A terminated thread can be joined as long as its creator is alive
+bool joinable(const scheduler::process_t& thread){
+    if(thread.system || thread.tgid == thread.pid){
+        return false;
+    }
+
+    auto& creator = pcb[thread.ppid];
+
+    if(creator.process.pid != thread.ppid || creator.process.tgid != thread.tgid){
+        return false;
+    }
+
+    return creator.state != scheduler::process_state::EMPTY && creator.state != scheduler::process_state::KILLED && creator.state != scheduler::process_state::ZOMBIE;
+}
+
+// Must be called with interrupts disabled
+void release_slot(scheduler::process_control_t& process){
+    process.process.pid = 0;
+    process.process.ppid = 0;
+    process.process.tgid = 0;
+
+    process.state = scheduler::process_state::EMPTY;
+}
+
 void gc_task(){
     while(true){
         //Wait until there is something to do
@@ -106,9 +136,9 @@ void gc_task(){
                     }
                 }
 
-                // 1. Release physical memory of PML4T (if not system task)
+                // 1. Release physical memory of PML4T (if not system task nor a secondary thread)
 
-                if(!desc.system){
+                if(!desc.system && desc.tgid == desc.pid){
                     physical_allocator::free(desc.physical_cr3, 1);
                 }
 
@@ -148,7 +178,11 @@ void gc_task(){
                     paging::unmap_pages(desc.virtual_kernel_stack, scheduler::kernel_stack_size / paging::PAGE_SIZE);
                 }
 
-                // 5. Remove process from run queue
+                // 5. Release the extended processor state
+
+                fpu::release(prev_pid);
+
+                // 6. Remove process from run queue
 
                 {
                     // Move only write to the list with a lock
@@ -162,10 +196,8 @@ void gc_task(){
                     }
                 }
 
-                // 6. Clean process
+                // 7. Clean process (the ids are cleared with the slot)
 
-                desc.pid = 0;
-                desc.ppid = 0;
                 desc.system = false;
                 desc.physical_cr3 = 0;
                 desc.physical_user_stack = 0;
@@ -175,12 +207,35 @@ void gc_task(){
                 desc.context = nullptr;
                 desc.brk_start = desc.brk_end = 0;
 
-                // 7. Clean file handles
+                // 8. Clean file handles
                 //TODO If not empty, probably something should be done
                 process.handles.clear();
 
-                // 8. Release the PCB slot
-                process.state = scheduler::process_state::EMPTY;
+                // 9. Release the packet rings, a send in progress may still use them
+                for(auto& socket : process.sockets){
+                    network::close_ring(socket, false);
+                }
+
+                // 10. Clean the poll sets, no socket must refer to them anymore
+                poll::release(process.sockets, process.poll_sets);
+
+                // 11. Release the PCB slot, a thread keeps it until it is
+                // joined so that its pid cannot be reused before
+
+                {
+                    direct_int_lock slot_lock;
+
+                    if(joinable(desc)){
+                        process.state = scheduler::process_state::ZOMBIE;
+
+                        // The creator may wait for the zombie in join_thread
+                        if(pcb[desc.ppid].state == scheduler::process_state::WAITING){
+                            scheduler::unblock_process(desc.ppid);
+                        }
+                    } else {
+                        release_slot(process);
+                    }
+                }
 
                 logging::logf(logging::log_level::DEBUG, "scheduler: Process %u cleaned\n", prev_pid);
             }
@@ -264,6 +319,7 @@ scheduler::process_t& new_process(){
     process.process.system = false;
     process.process.pid = pid;
     process.process.ppid = current_pid;
+    process.process.tgid = pid;
     process.process.priority = scheduler::DEFAULT_PRIORITY;
     process.state = scheduler::process_state::NEW;
     process.process.tty = pcb[current_pid].process.tty;
@@ -273,13 +329,28 @@ scheduler::process_t& new_process(){
 
     process.process.wait.pid = pid;
     process.process.wait.next = nullptr;
+    process.process.wait.prev = nullptr;
+    process.process.wait.queue = nullptr;
+    process.process.wait.timed_out = false;
 
     // By default, a process is working in root
     process.working_directory = path("/");
 
+    process.stats = scheduler::process_stats();
+
     return process.process;
 }
 
+/*!
+ * \brief Returns the main thread of the group of the current process.
+ *
+ * The handles, the sockets, the working directory and the heap are shared by
+ * all the threads and only stored in the main thread.
+ */
+scheduler::process_control_t& current_group(){
+    return pcb[pcb[current_pid].process.tgid];
+}
+
 void queue_process(scheduler::pid_t pid){
     thor_assert(pid < scheduler::MAX_PROCESS, "pid out of bounds");
 
@@ -378,6 +449,17 @@ void switch_to_process_with_lock(size_t new_pid){
         return;
     }
 
+    trace::point(trace::event::SWITCH, old_pid, new_pid);
+
+    // A process that is still runnable has been preempted or has yielded
+    auto old_state = pcb[old_pid].state;
+
+    if(old_state == scheduler::process_state::READY || old_state == scheduler::process_state::RUNNING){
+        ++pcb[old_pid].stats.involuntary_switches;
+    } else {
+        ++pcb[old_pid].stats.voluntary_switches;
+    }
+
     current_pid = new_pid;
 
     auto& process = pcb[new_pid];
@@ -386,6 +468,8 @@ void switch_to_process_with_lock(size_t new_pid){
     gdt::tss().rsp0_low = process.process.kernel_rsp & 0xFFFFFFFF;
     gdt::tss().rsp0_high = process.process.kernel_rsp >> 32;
 
+    fpu::switched(new_pid);
+
     task_switch(old_pid, current_pid);
 }
 
@@ -500,6 +584,23 @@ void clear_physical_memory(size_t memory, size_t pages){
     std::fill_n(it, (pages * paging::PAGE_SIZE) / sizeof(uint64_t), 0);
 }
 
+bool allocate_kernel_stack(scheduler::process_t& process){
+    auto virtual_kernel_stack = virtual_allocator::allocate(scheduler::kernel_stack_size / paging::PAGE_SIZE);
+    auto physical_kernel_stack = physical_allocator::allocate(scheduler::kernel_stack_size / paging::PAGE_SIZE);
+
+    if(!paging::map_pages(virtual_kernel_stack, physical_kernel_stack, scheduler::kernel_stack_size / paging::PAGE_SIZE)){
+        return false;
+    }
+
+    process.physical_kernel_stack = physical_kernel_stack;
+    process.virtual_kernel_stack = virtual_kernel_stack;
+    process.kernel_rsp = virtual_kernel_stack + (scheduler::kernel_stack_size - 8);
+
+    clear_physical_memory(process.physical_kernel_stack, scheduler::kernel_stack_size / paging::PAGE_SIZE);
+
+    return true;
+}
+
 bool create_paging(char* buffer, scheduler::process_t& process){
     //1. Prepare PML4T
 
@@ -514,6 +615,11 @@ bool create_paging(char* buffer, scheduler::process_t& process){
     //Map the kernel pages inside the user memory space
     paging::map_kernel_inside_user(process);
 
+    //Map the shared page (read-only)
+    if(!shared_page::map(process)){
+        logging::logf(logging::log_level::ERROR, "scheduler: Unable to map the shared page in process %u\n", process.pid);
+    }
+
     //2. Create all the other necessary structures
 
     //2.1 Allocate user stack
@@ -567,20 +673,12 @@ bool create_paging(char* buffer, scheduler::process_t& process){
     }
 
     //2.3 Allocate kernel stack
-    auto virtual_kernel_stack = virtual_allocator::allocate(scheduler::kernel_stack_size / paging::PAGE_SIZE);
-    auto physical_kernel_stack = physical_allocator::allocate(scheduler::kernel_stack_size / paging::PAGE_SIZE);
-
-    if(!paging::map_pages(virtual_kernel_stack, physical_kernel_stack, scheduler::kernel_stack_size / paging::PAGE_SIZE)){
+    if(!allocate_kernel_stack(process)){
         return false;
     }
 
-    process.physical_kernel_stack = physical_kernel_stack;
-    process.virtual_kernel_stack = virtual_kernel_stack;
-    process.kernel_rsp = virtual_kernel_stack + (scheduler::user_stack_size - 8);
-
-    //3. Clear stacks
+    //3. Clear user stack
     clear_physical_memory(process.physical_user_stack, scheduler::user_stack_size / paging::PAGE_SIZE);
-    clear_physical_memory(process.physical_kernel_stack, scheduler::kernel_stack_size / paging::PAGE_SIZE);
 
     return true;
 }
@@ -666,6 +764,36 @@ void init_context(scheduler::process_t& process, const char* buffer, const std::
     process.context = reinterpret_cast<interrupt::syscall_regs*>(scheduler::user_rsp - sizeof(interrupt::syscall_regs) - args_size);
 }
 
+// The user part of the address space, up to the end of the canonical lower half
+bool user_address(scheduler::process_t& process, size_t address){
+    return address >= scheduler::program_base && address < (size_t(1) << 47) && paging::user_page_present(process, address);
+}
+
+void init_thread_context(scheduler::process_t& process, size_t entry, size_t stack, size_t first, size_t second){
+    // The thread starts as if its entry point had been called
+    auto stack_top = stack & ~(STACK_ALIGNMENT - 1);
+    auto thread_rsp = stack_top - sizeof(size_t);
+
+    // The context is stored on the kernel stack of the thread, the user memory
+    // can be modified by the other threads of the process
+    auto rsp = process.virtual_kernel_stack + scheduler::kernel_stack_size - STACK_ALIGNMENT - sizeof(interrupt::syscall_regs);
+    auto regs = reinterpret_cast<interrupt::syscall_regs*>(rsp);
+
+    std::fill_n(reinterpret_cast<char*>(regs), sizeof(interrupt::syscall_regs), 0);
+
+    regs->rsp = thread_rsp;
+    regs->rbp = 0;
+    regs->rip = entry;
+    regs->cs = gdt::USER_CODE_SELECTOR + 3;
+    regs->ds = gdt::USER_DATA_SELECTOR + 3;
+    regs->rflags = 0x200;
+
+    regs->rdi = first;
+    regs->rsi = second;
+
+    process.context = regs;
+}
+
 } //end of anonymous namespace
 
 //Provided for task_switch.s
@@ -755,12 +883,14 @@ std::expected<scheduler::pid_t> scheduler::exec(const std::string& file, const s
 
     init_context(process, buffer, file, params);
 
-    pcb[process.pid].working_directory = pcb[current_pid].working_directory;
+    auto& group = current_group();
+
+    pcb[process.pid].working_directory = group.working_directory;
 
     // Inherit standard file descriptors from the parent
-    pcb[process.pid].handles.emplace_back(pcb[current_pid].handles[0]);
-    pcb[process.pid].handles.emplace_back(pcb[current_pid].handles[1]);
-    pcb[process.pid].handles.emplace_back(pcb[current_pid].handles[2]);
+    pcb[process.pid].handles.emplace_back(group.handles[0]);
+    pcb[process.pid].handles.emplace_back(group.handles[1]);
+    pcb[process.pid].handles.emplace_back(group.handles[2]);
 
     logging::logf(logging::log_level::DEBUG, "scheduler: Exec process pid=%u, ppid=%u\n", process.pid, process.ppid);
 
@@ -769,8 +899,52 @@ std::expected<scheduler::pid_t> scheduler::exec(const std::string& file, const s
     return process.pid;
 }
 
+std::expected<scheduler::pid_t> scheduler::create_thread(size_t entry, size_t stack, size_t first, size_t second){
+    auto& group = current_group().process;
+
+    // System processes have no user address space to share
+    if(group.system){
+        return std::make_unexpected<pid_t>(std::ERROR_PERMISSION_DENIED);
+    }
+
+    // The thread starts in user mode, its code and the first push on its
+    // stack must be in the user memory of the group
+    if(!user_address(group, entry) || stack < program_base + STACK_ALIGNMENT || !user_address(group, (stack & ~(STACK_ALIGNMENT - 1)) - sizeof(size_t))){
+        return std::make_unexpected<pid_t>(std::ERROR_INVALID_REQUEST);
+    }
+
+    auto& process = new_process();
+
+    process.tgid = group.pid;
+    process.priority = pcb[current_pid].process.priority;
+    process.name = group.name;
+
+    // Share the address space of the group
+    process.physical_cr3 = group.physical_cr3;
+    process.paging_size = 0;
+
+    // The user stack is provided by the process
+    process.physical_user_stack = 0;
+
+    if(!allocate_kernel_stack(process)){
+        logging::log(logging::log_level::DEBUG, "scheduler:create_thread: Impossible to allocate kernel stack\n");
+
+        pcb[process.pid].state = process_state::EMPTY;
+
+        return std::make_unexpected<pid_t>(std::ERROR_FAILED_EXECUTION);
+    }
+
+    init_thread_context(process, entry, stack, first, second);
+
+    logging::logf(logging::log_level::DEBUG, "scheduler: Create thread pid=%u, tgid=%u\n", process.pid, process.tgid);
+
+    queue_process(process.pid);
+
+    return process.pid;
+}
+
 void scheduler::sbrk(size_t inc){
-    auto& process = pcb[current_pid].process;
+    auto& process = current_group().process;
 
     size_t size = (inc + paging::PAGE_SIZE - 1) & ~(paging::PAGE_SIZE - 1);
     size_t pages = size / paging::PAGE_SIZE;
@@ -832,6 +1006,44 @@ void scheduler::await_termination(pid_t pid){
     }
 }
 
+std::expected<void> scheduler::join_thread(pid_t tid){
+    if(tid >= MAX_PROCESS){
+        return std::make_unexpected<void>(std::ERROR_NOT_EXISTS);
+    }
+
+    while(true){
+        {
+            direct_int_lock lock;
+
+            auto& thread = pcb[tid];
+
+            // A thread keeps its slot until it is joined
+            if(thread.state == process_state::EMPTY){
+                return std::make_unexpected<void>(std::ERROR_NOT_EXISTS);
+            }
+
+            // Only the creator of a thread of the same group can join it
+            if(thread.process.tgid == thread.process.pid || thread.process.tgid != pcb[current_pid].process.tgid || thread.process.ppid != current_pid){
+                return std::make_unexpected<void>(std::ERROR_PERMISSION_DENIED);
+            }
+
+            // The resources of the thread are already released
+            if(thread.state == process_state::ZOMBIE){
+                release_slot(thread);
+
+                return std::make_expected();
+            }
+
+            logging::logf(logging::log_level::DEBUG, "scheduler: Process %u joins %u\n", current_pid, tid);
+
+            pcb[current_pid].state = process_state::WAITING;
+        }
+
+        // Reschedule is out of the critical section
+        reschedule();
+    }
+}
+
 void scheduler::kill_current_process(){
     logging::logf(logging::log_level::DEBUG, "scheduler: Kill %u\n", current_pid);
 
@@ -841,6 +1053,30 @@ void scheduler::kill_current_process(){
         // The process is now considered killed
         pcb[current_pid].state = scheduler::process_state::KILLED;
 
+        // The threads cannot survive the main thread
+        if(pcb[current_pid].process.tgid == current_pid){
+            for(auto& process : pcb){
+                if(process.state != process_state::EMPTY && process.state != process_state::KILLED && process.state != process_state::ZOMBIE && process.process.tgid == current_pid){
+                    // A blocked thread must not stay in its wait queue
+                    if(process.process.wait.queue){
+                        process.process.wait.queue->remove(process.process.wait);
+                    }
+
+                    process.state = process_state::KILLED;
+                }
+            }
+
+            // No thread of the group can wait on a futex anymore
+            futex::release_group(current_pid);
+        }
+
+        // The zombies of the process (of its group for the main thread) cannot be joined anymore
+        for(auto& process : pcb){
+            if(process.state == process_state::ZOMBIE && (process.process.ppid == current_pid || process.process.tgid == current_pid)){
+                release_slot(process);
+            }
+        }
+
         //Notify parent if waiting
         auto ppid = pcb[current_pid].process.ppid;
         for(auto& process : pcb){
@@ -861,11 +1097,17 @@ void scheduler::kill_current_process(){
     thor_unreachable("A killed process has been run!");
 }
 
-void scheduler::tick(){
+void scheduler::tick(bool user){
     if(!started){
         return;
     }
 
+    if(user){
+        ++pcb[current_pid].stats.user_ticks;
+    } else {
+        ++pcb[current_pid].stats.kernel_ticks;
+    }
+
     // Update sleep timeouts
     for(auto& process : pcb){
         if(process.state == process_state::SLEEPING || process.state == process_state::BLOCKED_TIMEOUT){
@@ -873,6 +1115,12 @@ void scheduler::tick(){
 
             if(process.sleep_timeout == 0){
                 verbose_logf(logging::log_level::TRACE, "scheduler: Process %u finished sleeping, is ready\n", process.process.pid);
+
+                // The process does not wait anymore in its queue
+                if(process.state == process_state::BLOCKED_TIMEOUT && process.process.wait.queue){
+                    process.process.wait.queue->expire(process.process.wait);
+                }
+
                 process.state = process_state::READY;
             }
         }
@@ -948,6 +1196,10 @@ scheduler::pid_t scheduler::get_pid(){
     return current_pid;
 }
 
+scheduler::pid_t scheduler::get_tgid(){
+    return pcb[current_pid].process.tgid;
+}
+
 scheduler::process_t& scheduler::get_process(pid_t pid){
     thor_assert(pid < scheduler::MAX_PROCESS, "pid out of bounds");
 
@@ -960,6 +1212,10 @@ scheduler::process_state scheduler::get_process_state(pid_t pid){
     return pcb[pid].state;
 }
 
+scheduler::process_stats& scheduler::get_stats(){
+    return pcb[current_pid].stats;
+}
+
 void scheduler::block_process_light(pid_t pid){
     thor_assert(pid < scheduler::MAX_PROCESS, "pid out of bounds");
 
@@ -1043,57 +1299,77 @@ void scheduler::sleep_ms(pid_t pid, size_t time){
 }
 
 size_t scheduler::register_new_handle(const path& p){
-    pcb[current_pid].handles.push_back(p);
+    current_group().handles.push_back(p);
 
-    return pcb[current_pid].handles.size();
+    return current_group().handles.size();
 }
 
 void scheduler::release_handle(size_t fd){
-    pcb[current_pid].handles[fd - 1].invalidate();
+    current_group().handles[fd - 1].invalidate();
 }
 
 bool scheduler::has_handle(size_t fd){
-    return fd > 0 && fd <= pcb[current_pid].handles.size() && pcb[current_pid].handles[fd - 1].is_valid();
+    return fd > 0 && fd <= current_group().handles.size() && current_group().handles[fd - 1].is_valid();
 }
 
 const path& scheduler::get_handle(size_t fd){
-    return pcb[current_pid].handles[fd - 1];
+    return current_group().handles[fd - 1];
 }
 
 size_t scheduler::register_new_socket(network::socket_domain domain, network::socket_type type, network::socket_protocol protocol){
-    auto id = pcb[current_pid].sockets.size() + 1;
+    auto id = current_group().sockets.size() + 1;
 
-    pcb[current_pid].sockets.emplace_back(id, domain, type, protocol, size_t(1), false);
+    current_group().sockets.emplace_back(id, domain, type, protocol, size_t(1), false);
 
     return id;
 }
 
 void scheduler::release_socket(size_t fd){
-    pcb[current_pid].sockets[fd - 1].invalidate();
+    current_group().sockets[fd - 1].invalidate();
 }
 
 bool scheduler::has_socket(size_t fd){
-    return fd > 0 && fd - 1 < pcb[current_pid].sockets.size() && pcb[current_pid].sockets[fd - 1].is_valid();
+    return fd > 0 && fd - 1 < current_group().sockets.size() && current_group().sockets[fd - 1].is_valid();
 }
 
 network::socket& scheduler::get_socket(size_t fd){
-    return pcb[current_pid].sockets[fd - 1];
+    return current_group().sockets[fd - 1];
 }
 
 std::deque<network::socket>& scheduler::get_sockets(){
-    return pcb[current_pid].sockets;
+    return current_group().sockets;
 }
 
 std::deque<network::socket>& scheduler::get_sockets(scheduler::pid_t pid){
     return pcb[pid].sockets;
 }
 
+size_t scheduler::register_new_poll_set(){
+    auto id = current_group().poll_sets.size() + 1;
+
+    current_group().poll_sets.emplace_back(id);
+
+    return id;
+}
+
+void scheduler::release_poll_set(size_t fd){
+    current_group().poll_sets[fd - 1].invalidate();
+}
+
+bool scheduler::has_poll_set(size_t fd){
+    return fd > 0 && fd - 1 < current_group().poll_sets.size() && current_group().poll_sets[fd - 1].is_valid();
+}
+
+poll::poll_set& scheduler::get_poll_set(size_t fd){
+    return current_group().poll_sets[fd - 1];
+}
+
 const path& scheduler::get_working_directory(){
-    return pcb[current_pid].working_directory;
+    return current_group().working_directory;
 }
 
 void scheduler::set_working_directory(const path& directory){
-    pcb[current_pid].working_directory = directory;
+    current_group().working_directory = directory;
 }
 
 scheduler::process_t& scheduler::create_kernel_task(const char* name, char* user_stack, char* kernel_stack, void (*fun)()){
@@ -1162,13 +1438,12 @@ void scheduler::frequency_updated(uint64_t old_frequency, uint64_t new_frequency
     // Cannot be interrupted during frequency update
     direct_int_lock lock;
 
-    rr_quantum = ROUND_ROBIN_QUANTUM * (double(new_frequency) / double(1000));
-
-    double ratio = old_frequency / double(new_frequency);
+    // The kernel does not use the FPU, the computations are done in integers
+    rr_quantum = (ROUND_ROBIN_QUANTUM * new_frequency) / 1000;
 
     for(auto& process : pcb){
         if(process.state == process_state::SLEEPING){
-            process.sleep_timeout *= ratio;
+            process.sleep_timeout = (process.sleep_timeout * old_frequency) / new_frequency;
         }
     }
 
@@ -0,0 +1,121 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "shared_page.hpp"
+#include "paging.hpp"
+#include "physical_allocator.hpp"
+#include "virtual_allocator.hpp"
+#include "timer.hpp"
+#include "vesa.hpp"
+#include "stdio.hpp"
+#include "arch.hpp"
+#include "logging.hpp"
+
+namespace {
+
+size_t physical_page = 0;                      ///< The physical address of the shared page
+volatile shared_page::shared_data* data = nullptr; ///< The kernel view of the shared page
+
+void fill_cpu(volatile shared_page::shared_data& data){
+    uint32_t a, b, c, d;
+
+    arch::cpuid(0, 0, a, b, c, d);
+
+    // The vendor string is in ebx, edx and ecx
+    uint32_t vendor[3] = {b, d, c};
+    auto* chars = reinterpret_cast<const char*>(vendor);
+
+    for(size_t i = 0; i < 12; ++i){
+        data.cpu_vendor[i] = chars[i];
+    }
+
+    data.cpu_vendor[12] = '\0';
+
+    arch::cpuid(1, 0, a, b, c, d);
+
+    data.cpu_signature = a;
+}
+
+void fill_display(volatile shared_page::shared_data& data){
+    auto& console = stdio::get_terminal(0).get_console();
+
+    data.columns = console.get_columns();
+    data.rows    = console.get_rows();
+
+    if(vesa::enabled()){
+        data.vesa_width               = vesa::get_width();
+        data.vesa_height              = vesa::get_height();
+        data.vesa_x_shift             = vesa::get_x_shift();
+        data.vesa_y_shift             = vesa::get_y_shift();
+        data.vesa_bytes_per_scan_line = vesa::get_bytes_per_scan_line();
+        data.vesa_red_shift           = vesa::get_red_shift();
+        data.vesa_green_shift         = vesa::get_green_shift();
+        data.vesa_blue_shift          = vesa::get_blue_shift();
+    }
+}
+
+} //end of anonymous namespace
+
+void shared_page::init(){
+    physical_page = physical_allocator::allocate(1);
+
+    if(!physical_page){
+        logging::logf(logging::log_level::ERROR, "shared_page: Unable to allocate the shared page\n");
+        return;
+    }
+
+    auto virtual_page = virtual_allocator::allocate(1);
+
+    if(!paging::map(virtual_page, physical_page)){
+        logging::logf(logging::log_level::ERROR, "shared_page: Unable to map the shared page\n");
+        physical_page = 0;
+        return;
+    }
+
+    auto* page = reinterpret_cast<volatile uint64_t*>(virtual_page);
+    for(size_t i = 0; i < paging::PAGE_SIZE / sizeof(uint64_t); ++i){
+        page[i] = 0;
+    }
+
+    auto* new_data = reinterpret_cast<volatile shared_data*>(virtual_page);
+
+    new_data->counter_frequency = timer::counter_frequency();
+    new_data->timer_frequency   = timer::timer_frequency();
+
+    fill_display(*new_data);
+    fill_cpu(*new_data);
+
+    // From now on, the ticks update the page
+    data = new_data;
+
+    update_time();
+
+    logging::logf(logging::log_level::DEBUG, "shared_page: physical:%h virtual:%h\n", physical_page, virtual_page);
+}
+
+bool shared_page::map(scheduler::process_t& process){
+    if(!physical_page){
+        return false;
+    }
+
+    return paging::user_map(process, shared_page_address, physical_page, paging::PRESENT | paging::USER);
+}
+
+void shared_page::update_time(){
+    if(!data){
+        return;
+    }
+
+    auto counter = timer::counter();
+    auto frequency = data->counter_frequency;
+
+    ++data->ticks;
+
+    data->counter      = counter;
+    data->milliseconds = counter / (frequency / 1000);
+    data->seconds      = counter / frequency;
+}
@@ -18,7 +18,6 @@ _syscall\number:
     //so they must reenabled again
     sti
 
-    push rax
     push \number
 
     jmp syscall_common_handler
@@ -40,12 +39,76 @@ syscall_common_handler:
 
     restore_kernel_segments
 
+    // The CPU aligned the stack before pushing its 5 quadwords, the 16
+    // pushed since then leave it misaligned for the call
     mov rdi, rsp
+    sub rsp, 8
     call _syscall_handler
+    add rsp, 8
 
     restore_context
 
     //Was pushed by the base handler code
-    add rsp, 16
+    add rsp, 8
 
     iretq // iret will clean the other automatically pushed stuff
+
+// Entry point of the SYSCALL instruction
+//
+// The CPU does not switch the stack, it only saves the return address in rcx
+// and the flags in r11, and interrupts are masked. The stub builds the same
+// frame as the system call gates (interrupt::syscall_regs: the registers, the
+// gate number and the interrupt frame) on the kernel stack of the process
+// (rsp0 of the TSS), with the same alignment, so that the same handlers can
+// be used. The user passes the third parameter in r10 since rcx is
+// overwritten by SYSCALL.
+
+.global _syscall_fast
+_syscall_fast:
+    mov [rip + syscall_user_rsp], rsp
+    mov rsp, [rip + tss_rsp0_address]
+    mov rsp, [rsp]
+    and rsp, -16
+
+    push 0x23                         // ss (USER_DATA_SELECTOR + 3)
+    push [rip + syscall_user_rsp]     // rsp
+    push r11                          // rflags
+    push 0x2B                         // cs (USER_CODE_SELECTOR + 3)
+    push rcx                          // rip
+    push 0                            // the first system call gate
+
+    save_context
+
+    // Give the third parameter to the handlers in rcx (rax and rbx are below)
+    mov [rsp + 16], r10
+
+    // SYSCALL loaded the user data selector in SS
+    mov eax, 0x10
+    mov ss, eax
+
+    restore_kernel_segments
+
+    sti
+
+    mov rdi, rsp
+    sub rsp, 8
+    call _syscall_handler
+    add rsp, 8
+
+    // The user stack must not be used before SYSRET
+    cli
+
+    restore_context
+
+    add rsp, 8 // The system call gate
+    pop rcx    // rip
+    add rsp, 8 // cs
+    pop r11    // rflags
+    pop rsp    // The user stack
+
+    sysretq
+
+.data
+
+syscall_user_rsp:
+    .quad 0
@@ -10,18 +10,25 @@
 #include "system_calls.hpp"
 #include "print.hpp"
 #include "scheduler.hpp"
+#include "futex.hpp"
+#include "poll.hpp"
 #include "timer.hpp"
 #include "drivers/keyboard.hpp"
 #include "stdio.hpp"
 #include "acpi.hpp"
 #include "drivers/rtc.hpp"
 #include "kernel_utils.hpp"
+#include "trace.hpp"
+#include "latency_histogram.hpp"
+#include "arch.hpp"
 #include "vesa.hpp"
 #include "drivers/mouse.hpp"
 #include "vfs/vfs.hpp"
 #include "ioctl.hpp"
 #include "net/network.hpp"
 #include "net/alpha.hpp"
+#include "conc/int_lock.hpp"
+#include "fs/sysfs.hpp"
 
 //TODO Split this file
 
@@ -33,6 +40,45 @@ using system_call = void(*)(interrupt::syscall_regs*);
 
 std::array<system_call, 0x1000> system_calls;
 
+constexpr const uint8_t no_slot = 0xFF; ///< The system call is not accounted
+
+std::array<uint8_t, 0x1000> system_call_slots; ///< The accounting slot of each system call
+std::array<uint16_t, scheduler::accounted_system_calls> slot_numbers; ///< The system call of each accounting slot
+size_t used_slots = 0; ///< The number of accounting slots in use
+
+std::array<latency::histogram, scheduler::accounted_system_calls> latencies; ///< The latency of each system call (by slot)
+
+std::string sysfs_latencies(void*){
+    std::string value = "# number count mean max log2(cycles):count...\n";
+
+    for(size_t slot = 0; slot < used_slots; ++slot){
+        latency::histogram h;
+
+        {
+            direct_int_lock lock;
+            h = latencies[slot];
+        }
+
+        if(h.count){
+            value += sprintf("%h ", size_t(slot_numbers[slot]));
+            value += latency::to_string(h);
+            value += '\n';
+        }
+    }
+
+    return value;
+}
+
+size_t sysfs_clear_latencies(void*, const std::string&){
+    direct_int_lock lock;
+
+    for(auto& h : latencies){
+        latency::clear(h);
+    }
+
+    return 0;
+}
+
 int64_t expected_to_i64(const std::expected<void>& status){
     if(status){
         return 0;
@@ -96,14 +142,53 @@ void sc_await_termination(interrupt::syscall_regs* regs){
     scheduler::await_termination(pid);
 }
 
+void sc_thread_create(interrupt::syscall_regs* regs){
+    auto entry  = regs->rbx;
+    auto stack  = regs->rcx;
+    auto first  = regs->rdx;
+    auto second = regs->rsi;
+
+    auto status = scheduler::create_thread(entry, stack, first, second);
+    regs->rax = expected_to_i64(status);
+}
+
+void sc_thread_join(interrupt::syscall_regs* regs){
+    auto tid = regs->rbx;
+
+    auto status = scheduler::join_thread(tid);
+    regs->rax = expected_to_i64(status);
+}
+
+void sc_thread_exit(interrupt::syscall_regs* /*regs*/) __attribute((noreturn));
+void sc_thread_exit(interrupt::syscall_regs* /*regs*/){
+    scheduler::kill_current_process();
+}
+
+void sc_futex_wait(interrupt::syscall_regs* regs){
+    auto address = regs->rbx;
+    auto value   = regs->rcx;
+    auto ms      = regs->rdx;
+
+    auto status = futex::wait(address, value, ms);
+    regs->rax = expected_to_i64(status);
+}
+
+void sc_futex_wake(interrupt::syscall_regs* regs){
+    auto address = regs->rbx;
+    auto n       = regs->rcx;
+
+    auto status = futex::wake(address, n);
+    regs->rax = expected_to_i64(status);
+}
+
 void sc_brk_start(interrupt::syscall_regs* regs){
-    auto& process = scheduler::get_process(scheduler::get_pid());
+    auto& process = scheduler::get_process(scheduler::get_tgid());
 
     regs->rax = process.brk_start;
 }
 
 void sc_brk_end(interrupt::syscall_regs* regs){
-    auto& process = scheduler::get_process(scheduler::get_pid());
+    auto& process = scheduler::get_process(scheduler::get_tgid());
 
     regs->rax = process.brk_end;
 }
@@ -111,7 +196,7 @@ void sc_brk_end(interrupt::syscall_regs* regs){
 void sc_sbrk(interrupt::syscall_regs* regs){
     scheduler::sbrk(regs->rbx);
 
-    auto& process = scheduler::get_process(scheduler::get_pid());
+    auto& process = scheduler::get_process(scheduler::get_tgid());
     regs->rax = process.brk_end;
 }
 
@@ -356,6 +441,10 @@ void sc_ioctl(interrupt::syscall_regs* regs){
     regs->rax = expected_to_i64(status);
 }
 
+void sc_null(interrupt::syscall_regs* regs){
+    regs->rax = 0;
+}
+
 void sc_alpha(interrupt::syscall_regs*){
     network::alpha();
 }
@@ -420,6 +509,67 @@ void sc_send_to(interrupt::syscall_regs* regs){
     regs->rax = expected_to_i64(network::send_to(socket_fd, buffer, n, target_buffer, address));
 }
 
+void sc_send_many(interrupt::syscall_regs* regs){
+    auto socket_fd     = regs->rbx;
+    auto datagrams     = reinterpret_cast<network::datagram*>(regs->rcx);
+    auto n             = regs->rdx;
+    auto target_buffer = reinterpret_cast<char*>(regs->rsi);
+    auto addressed     = bool(regs->rdi);
+
+    regs->rax = expected_to_i64(network::send_many(socket_fd, datagrams, n, target_buffer, addressed));
+}
+
+void sc_receive_many(interrupt::syscall_regs* regs){
+    auto socket_fd = regs->rbx;
+    auto datagrams = reinterpret_cast<network::datagram*>(regs->rcx);
+    auto n         = regs->rdx;
+
+    regs->rax = expected_to_i64(network::receive_many(socket_fd, datagrams, n));
+}
+
+void sc_receive_many_timeout(interrupt::syscall_regs* regs){
+    auto socket_fd = regs->rbx;
+    auto datagrams = reinterpret_cast<network::datagram*>(regs->rcx);
+    auto n         = regs->rdx;
+    auto ms        = regs->rsi;
+
+    regs->rax = expected_to_i64(network::receive_many(socket_fd, datagrams, n, ms));
+}
+
+void sc_open_ring(interrupt::syscall_regs* regs){
+    auto socket_fd = regs->rbx;
+
+    regs->rax = expected_to_i64(network::open_ring(socket_fd));
+}
+
+void sc_ring_send(interrupt::syscall_regs* regs){
+    auto socket_fd = regs->rbx;
+
+    regs->rax = expected_to_i64(network::ring_send(socket_fd));
+}
+
+void sc_ring_wait(interrupt::syscall_regs* regs){
+    auto socket_fd = regs->rbx;
+
+    regs->rax = expected_to_i64(network::ring_wait(socket_fd));
+}
+
+void sc_resolve(interrupt::syscall_regs* regs){
+    auto name       = reinterpret_cast<const char*>(regs->rbx);
+    auto length     = regs->rcx;
+    auto server     = network::ip::address(regs->rdx);
+    auto timeout_ms = regs->rsi;
+    auto tries      = regs->rdi;
+
+    auto address = network::resolve(name, length, server, timeout_ms, tries);
+
+    if(address){
+        regs->rax = address->raw_address;
+    } else {
+        regs->rax = -address.error();
+    }
+}
+
 void sc_receive(interrupt::syscall_regs* regs){
     auto socket_fd = regs->rbx;
     auto buffer    = reinterpret_cast<char*>(regs->rcx);
@@ -538,6 +688,43 @@ void sc_accept_timeout(interrupt::syscall_regs* regs) {
     regs->rax   = expected_to_i64(status);
 }
 
+void sc_poll_create(interrupt::syscall_regs* regs){
+    regs->rax = expected_to_i64(poll::create());
+}
+
+void sc_poll_close(interrupt::syscall_regs* regs){
+    auto set_fd = regs->rbx;
+
+    regs->rax = expected_to_i64(poll::close(set_fd));
+}
+
+void sc_poll_control(interrupt::syscall_regs* regs){
+    auto set_fd    = regs->rbx;
+    auto operation = static_cast<poll::poll_operation>(regs->rcx);
+    auto target    = static_cast<poll::poll_target>(regs->rdx);
+    auto fd        = regs->rsi;
+    auto events    = regs->rdi;
+
+    regs->rax = expected_to_i64(poll::control(set_fd, operation, target, fd, events));
+}
+
+void sc_poll_wait(interrupt::syscall_regs* regs){
+    auto set_fd = regs->rbx;
+    auto events = reinterpret_cast<poll::poll_event*>(regs->rcx);
+    auto max    = regs->rdx;
+
+    regs->rax = expected_to_i64(poll::wait(set_fd, events, max));
+}
+
+void sc_poll_wait_ms(interrupt::syscall_regs* regs){
+    auto set_fd = regs->rbx;
+    auto events = reinterpret_cast<poll::poll_event*>(regs->rcx);
+    auto max    = regs->rdx;
+    auto ms     = regs->rsi;
+
+    regs->rax = expected_to_i64(poll::wait(set_fd, events, max, ms));
+}
+
 void sc_dns_server(interrupt::syscall_regs* regs){
     regs->rax = network::dns_server().raw_address;
 }
@@ -580,8 +767,27 @@ void sc_kill(interrupt::syscall_regs* /*regs*/){
 void system_call_entry(interrupt::syscall_regs* regs){
     auto code = regs->rax;
 
-    if(likely(system_calls[code])){
+    if(likely(code < system_calls.size() && system_calls[code])){
+        auto slot = system_call_slots[code];
+
+        if(likely(slot != no_slot)){
+            ++scheduler::get_stats().system_calls[slot];
+        }
+
+        trace::point(trace::event::SYSCALL_ENTRY, code);
+
+        auto start = arch::rdtsc();
         system_calls[code](regs);
+        auto cycles = arch::rdtsc() - start;
+
+        trace::point(trace::event::SYSCALL_EXIT, code, regs->rax);
+
+        if(likely(slot != no_slot)){
+            // Another process may be in the same system call
+            direct_int_lock lock;
+            latency::record(latencies[slot], cycles);
+        }
+
         return;
     }
 
@@ -600,6 +806,7 @@ void install_system_calls(){
 
     std::fill(system_calls.begin(), system_calls.end(), nullptr);
 
+    system_calls[0x0] = sc_null;
     system_calls[0x2] = sc_log_string;
     system_calls[0x4] = sc_sleep_ms;
     system_calls[0x5] = sc_exec;
@@ -607,6 +814,11 @@ void install_system_calls(){
     system_calls[0x7] = sc_brk_start;
     system_calls[0x8] = sc_brk_end;
     system_calls[0x9] = sc_sbrk;
+    system_calls[0xA] = sc_thread_create;
+    system_calls[0xB] = sc_thread_join;
+    system_calls[0xC] = sc_thread_exit;
+    system_calls[0xD] = sc_futex_wait;
+    system_calls[0xE] = sc_futex_wake;
     system_calls[0x20] = sc_set_canonical;
     system_calls[0x21] = sc_set_mouse;
     system_calls[0x22] = sc_clear_screen;
@@ -671,5 +883,44 @@ void install_system_calls(){
     system_calls[0xB15] = sc_dns_server;
     system_calls[0xB16] = sc_accept;
     system_calls[0xB17] = sc_accept_timeout;
+    system_calls[0xB18] = sc_send_many;
+    system_calls[0xB19] = sc_receive_many;
+    system_calls[0xB1A] = sc_receive_many_timeout;
+    system_calls[0xB20] = sc_poll_create;
+    system_calls[0xB21] = sc_poll_close;
+    system_calls[0xB22] = sc_poll_control;
+    system_calls[0xB23] = sc_poll_wait;
+    system_calls[0xB24] = sc_poll_wait_ms;
+    system_calls[0xB28] = sc_open_ring;
+    system_calls[0xB29] = sc_ring_send;
+    system_calls[0xB2A] = sc_ring_wait;
+    system_calls[0xB2B] = sc_resolve;
     system_calls[0x66] = sc_alpha;
+
+    // Give an accounting slot to each system call, in order
+
+    std::fill(system_call_slots.begin(), system_call_slots.end(), no_slot);
+
+    for(size_t code = 0; code < system_calls.size(); ++code){
+        if(system_calls[code]){
+            if(used_slots == slot_numbers.size()){
+                logging::logf(logging::log_level::ERROR, "Too many system calls to account %h\n", code);
+                continue;
+            }
+
+            system_call_slots[code]  = used_slots;
+            slot_numbers[used_slots] = code;
+            ++used_slots;
+        }
+    }
+
+    sysfs::set_writable_value_data(sysfs::get_sys_path(), path("/kernel/stats/system_calls"), &sysfs_latencies, &sysfs_clear_latencies, nullptr);
+}
+
+size_t system_call_slots_used(){
+    return used_slots;
+}
+
+size_t system_call_number(size_t slot){
+    return slot_numbers[slot];
 }
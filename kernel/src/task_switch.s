@@ -27,7 +27,7 @@ init_task_switch:
     pop rdi
     mov rsp, [rax]
 
-    restore_context_light
+    restore_context
 
     //Was pushed by the base handler code
     add rsp, 8
@@ -186,11 +186,22 @@ void AcpiOsSleep(UINT64 ms){
 void AcpiOsStall(UINT32 us){
     verbose_logf(logging::log_level::TRACE, "thor:acpica:osl: Stall\n");
 
-    uint64_t c = timer::counter();
-    uint64_t wait = us * (timer::counter_frequency() / double(1000000));
+    // The kernel cannot use floating point, multiply first for precision
+    // unless it would overflow
+    uint64_t frequency = timer::counter_frequency();
+    uint64_t wait;
+
+    if(us && frequency > uint64_t(-1) / us){
+        wait = us * (frequency / 1000000);
+    } else {
+        wait = us * frequency / 1000000;
+    }
+
     wait = !wait ? 1 : wait;
 
-    while(timer::counter() != c + wait){
+    uint64_t c = timer::counter();
+
+    while(timer::counter() - c < wait){
         asm volatile("nop");
         asm volatile("nop");
         asm volatile("nop");
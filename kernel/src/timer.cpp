@@ -9,6 +9,8 @@
 #include "scheduler.hpp"
 #include "logging.hpp"
 #include "kernel.hpp"   //suspend_boot
+#include "shared_page.hpp"
+#include "profiler.hpp"
 
 #include "drivers/pit.hpp"
 #include "drivers/hpet.hpp"
@@ -56,9 +58,15 @@ void timer::install(){
     sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/uptime"), &sysfs_uptime);
 }
 
-void timer::tick(){
-    // Simply let the scheduler know about the tick
-    scheduler::tick();
+void timer::tick(const interrupt::syscall_regs* regs){
+    // Let the processes see the new time
+    shared_page::update_time();
+
+    // Sample the interrupted code
+    profiler::tick(regs);
+
+    // Let the scheduler know about the tick
+    scheduler::tick(regs->cs & 3);
 }
 
 uint64_t timer::seconds(){
@@ -0,0 +1,127 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+#include <algorithms.hpp>
+
+#include "trace.hpp"
+#include "arch.hpp"
+#include "scheduler.hpp"
+#include "timer.hpp"
+
+#include "conc/int_lock.hpp"
+
+#include "fs/sysfs.hpp"
+
+#include "tlib/errors.hpp"
+
+volatile uint64_t trace::enabled_mask = 0;
+
+namespace {
+
+constexpr const size_t ring_size = 8192; ///< The number of events of the ring
+
+trace::record* ring = nullptr; ///< The events
+uint64_t head       = 0;       ///< The number of events recorded since the tracing was started
+
+uint64_t base_tsc = 0; ///< The TSC at initialization
+uint64_t base_ms  = 0; ///< The time at initialization, in ms
+
+std::string sysfs_enable(void*){
+    return std::to_string(trace::enabled_mask);
+}
+
+size_t sysfs_store_enable(void*, const std::string& value){
+    auto mask = std::atoui(value);
+
+    direct_int_lock lock;
+
+    // A new trace starts with an empty ring
+    if(!trace::enabled_mask && mask){
+        head = 0;
+    }
+
+    trace::enabled_mask = mask;
+
+    return 0;
+}
+
+std::string sysfs_records(){
+    return std::to_string(std::min(head, uint64_t(ring_size)));
+}
+
+std::string sysfs_lost(){
+    return std::to_string(head > ring_size ? head - ring_size : 0);
+}
+
+std::string sysfs_raw(){
+    auto* buffer = new char[sizeof(trace::dump_header) + ring_size * sizeof(trace::record)];
+
+    auto& header = *reinterpret_cast<trace::dump_header*>(buffer);
+    auto* events = reinterpret_cast<trace::record*>(buffer + sizeof(trace::dump_header));
+
+    {
+        direct_int_lock lock;
+
+        auto records = std::min(head, uint64_t(ring_size));
+        auto first   = head - records;
+
+        std::copy_n("THORTRC1", 8, header.magic);
+        header.version     = 1;
+        header.record_size = sizeof(trace::record);
+        header.records     = records;
+        header.lost        = first;
+        header.base_tsc    = base_tsc;
+        header.base_ms     = base_ms;
+        header.now_tsc     = arch::rdtsc();
+        header.now_ms      = timer::milliseconds();
+
+        // Oldest events first
+        for(size_t i = 0; i < records; ++i){
+            events[i] = ring[(first + i) % ring_size];
+        }
+    }
+
+    std::string value(buffer, buffer + sizeof(trace::dump_header) + header.records * sizeof(trace::record));
+
+    delete[] buffer;
+
+    return value;
+}
+
+} //end of anonymous namespace
+
+void trace::init(){
+    ring = new trace::record[ring_size];
+
+    base_tsc = arch::rdtsc();
+    base_ms  = timer::milliseconds();
+
+    sysfs::set_constant_value(sysfs::get_sys_path(), path("/trace/categories"), "1:sched 2:syscall 4:irq 8:block 16:net 32:fault");
+    sysfs::set_writable_value_data(sysfs::get_sys_path(), path("/trace/enable"), &sysfs_enable, &sysfs_store_enable, nullptr);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/trace/records"), &sysfs_records);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/trace/lost"), &sysfs_lost);
+    sysfs::set_dynamic_value(sysfs::get_sys_path(), path("/trace/raw"), &sysfs_raw);
+}
+
+void trace::record_event(event e, uint64_t a, uint64_t b){
+    if(!ring){
+        return;
+    }
+
+    // Events are also recorded from the IRQ handlers
+    direct_int_lock lock;
+
+    auto& r = ring[head++ % ring_size];
+
+    r.tsc  = arch::rdtsc();
+    r.type = uint16_t(e);
+    r.cpu  = 0;
+    r.pid  = scheduler::get_pid();
+    r.a    = a;
+    r.b    = b;
+}
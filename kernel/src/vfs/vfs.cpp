@@ -393,6 +393,8 @@ std::expected<size_t> vfs::read(fd_t fd, char* buffer, size_t count, size_t offs
     if (result) {
         return std::make_unexpected<size_t>(result);
     } else {
+        scheduler::get_stats().read_bytes += read;
+
         return read;
     }
 }
@@ -417,6 +419,8 @@ std::expected<size_t> vfs::read(fd_t fd, char* buffer, size_t count, size_t offs
     if (result) {
         return std::make_unexpected<size_t>(result);
     } else {
+        scheduler::get_stats().read_bytes += read;
+
         return read;
     }
 }
@@ -455,6 +459,8 @@ std::expected<size_t> vfs::write(fd_t fd, const char* buffer, size_t count, size
     if (result) {
         return std::make_unexpected<size_t>(result);
     } else {
+        scheduler::get_stats().written_bytes += written;
+
         return written;
     }
 }
@@ -0,0 +1,230 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+
+#include "net/checksum.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+constexpr const size_t max_length = 2048;
+
+// The byte-per-byte implementation, as reference
+uint32_t reference_add_bytes(const void* values, size_t length){
+    auto raw_values = static_cast<const uint8_t*>(values);
+
+    uint32_t sum = 0;
+
+    for(size_t i = 0; i < length; ++i){
+        if(i & 1){
+            sum += static_cast<uint32_t>(raw_values[i]);
+        } else {
+            sum += static_cast<uint32_t>(raw_values[i]) << 8;
+        }
+    }
+
+    return sum;
+}
+
+void fill_random(uint8_t* buffer, size_t length){
+    for(size_t i = 0; i < length; ++i){
+        buffer[i] = rand() & 0xFF;
+    }
+}
+
+void test_lengths(){
+    uint8_t buffer[max_length + 8];
+
+    fill_random(buffer, sizeof(buffer));
+
+    for(size_t offset = 0; offset < 8; ++offset){
+        for(size_t length = 0; length <= 100; ++length){
+            auto expected = network::checksum_finalize(reference_add_bytes(buffer + offset, length));
+            auto value    = network::checksum_finalize(network::checksum_add_bytes(buffer + offset, length));
+
+            CHECK_EQUALS_DIRECT(value, expected);
+        }
+
+        auto expected = network::checksum_finalize(reference_add_bytes(buffer + offset, max_length));
+        auto value    = network::checksum_finalize(network::checksum_add_bytes(buffer + offset, max_length));
+
+        CHECK_EQUALS_DIRECT(value, expected);
+    }
+}
+
+void test_carries(){
+    // The worst case for the carries
+    uint8_t buffer[max_length];
+    memset(buffer, 0xFF, sizeof(buffer));
+
+    for(size_t length = max_length - 9; length <= max_length; ++length){
+        auto expected = network::checksum_finalize(reference_add_bytes(buffer, length));
+        auto value    = network::checksum_finalize(network::checksum_add_bytes(buffer, length));
+
+        CHECK_EQUALS_DIRECT(value, expected);
+    }
+}
+
+void test_known_value(){
+    // The example of RFC 1071
+    uint8_t buffer[] = {0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7};
+
+    CHECK_EQUALS_DIRECT(network::checksum_finalize(network::checksum_add_bytes(buffer, sizeof(buffer))), uint16_t(~0xddf2));
+}
+
+void test_copy(){
+    uint8_t source[max_length];
+    char destination[max_length];
+
+    fill_random(source, sizeof(source));
+
+    size_t lengths[] = {0, 1, 7, 8, 9, 20, 63, 1480, 1481};
+
+    for(size_t length : lengths){
+        memset(destination, 0, sizeof(destination));
+
+        auto sum = network::checksum_copy(destination, reinterpret_cast<const char*>(source), length);
+
+        CHECK_DIRECT(memcmp(destination, source, length) == 0);
+        CHECK_DIRECT(destination[length] == 0);
+        CHECK_EQUALS_DIRECT(network::checksum_finalize(sum), network::checksum_finalize(reference_add_bytes(source, length)));
+    }
+}
+
+void test_update(){
+    uint8_t buffer[40];
+
+    fill_random(buffer, sizeof(buffer));
+
+    // Use the field at offset 10 as checksum
+    buffer[10] = buffer[11] = 0;
+
+    uint16_t checksum = network::checksum_finalize(network::checksum_add_bytes(buffer, sizeof(buffer)));
+
+    for(size_t i = 0; i < 100; ++i){
+        uint16_t old_value;
+        uint16_t new_value = rand();
+        memcpy(&old_value, buffer + 4, 2);
+        memcpy(buffer + 4, &new_value, 2);
+
+        uint32_t old_value_32;
+        uint32_t new_value_32 = rand();
+        memcpy(&old_value_32, buffer + 24, 4);
+        memcpy(buffer + 24, &new_value_32, 4);
+
+        // The checksum is stored in network order, the fields as they are
+        uint16_t stored = __builtin_bswap16(checksum);
+        stored = network::checksum_update(stored, old_value, new_value);
+        stored = network::checksum_update_32(stored, old_value_32, new_value_32);
+
+        checksum = __builtin_bswap16(stored);
+
+        auto expected = network::checksum_finalize(network::checksum_add_bytes(buffer, sizeof(buffer)));
+
+        // 0x0000 and 0xFFFF are the same value in ones-complement
+        CHECK_DIRECT(checksum == expected || (checksum == 0xFFFF && expected == 0) || (checksum == 0 && expected == 0xFFFF));
+    }
+}
+
+void test_rfc1624(){
+    // The example of RFC 1624 (section 4), a 16-bit field goes from 0x5555
+    // to 0x3285 and the checksum must be 0x0000, not 0xFFFF (RFC 1141)
+    CHECK_EQUALS_DIRECT(network::checksum_update(0xDD2F, 0x5555, 0x3285), 0x0000);
+
+    // The same change in either half of a 32-bit field
+    CHECK_EQUALS_DIRECT(network::checksum_update_32(0xDD2F, 0x55550000, 0x32850000), 0x0000);
+    CHECK_EQUALS_DIRECT(network::checksum_update_32(0xDD2F, 0x00005555, 0x00003285), 0x0000);
+
+    // Reverting the change gives back the original checksum
+    CHECK_EQUALS_DIRECT(network::checksum_update(0x0000, 0x3285, 0x5555), 0xDD2F);
+
+    // Replacing a field by the same value does not change the checksum
+    CHECK_EQUALS_DIRECT(network::checksum_update(0x1234, 0xABCD, 0xABCD), 0x1234);
+    CHECK_EQUALS_DIRECT(network::checksum_update_32(0x1234, 0xABCDEF01, 0xABCDEF01), 0x1234);
+}
+
+#ifdef THOR_BENCHMARK
+
+double elapsed_ms(const timespec& start, const timespec& end){
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+void bench(){
+    constexpr const size_t length     = 1500;
+    constexpr const size_t iterations = 20000;
+
+    uint8_t buffer[length];
+    char destination[length];
+
+    fill_random(buffer, length);
+
+    volatile uint32_t sink = 0;
+
+    timespec start;
+    timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t i = 0; i < iterations; ++i){
+        sink = sink + reference_add_bytes(buffer, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto reference_ms = elapsed_ms(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t i = 0; i < iterations; ++i){
+        sink = sink + network::checksum_add_bytes(buffer, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto word_ms = elapsed_ms(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t i = 0; i < iterations; ++i){
+        memcpy(destination, buffer, length);
+        sink = sink + network::checksum_add_bytes(destination, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto separate_ms = elapsed_ms(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t i = 0; i < iterations; ++i){
+        sink = sink + network::checksum_copy(destination, reinterpret_cast<const char*>(buffer), length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto copy_ms = elapsed_ms(start, end);
+
+    printf("checksum: %lu x %lu bytes\n", iterations, length);
+    printf("checksum:   byte per byte:      %.2fms\n", reference_ms);
+    printf("checksum:   word-wide:          %.2fms\n", word_ms);
+    printf("checksum:   copy then checksum: %.2fms\n", separate_ms);
+    printf("checksum:   copy and checksum:  %.2fms\n", copy_ms);
+}
+
+#endif
+
+} //end of anonymous namespace
+
+void checksum_tests(){
+    test_lengths();
+    test_carries();
+    test_known_value();
+    test_copy();
+    test_update();
+    test_rfc1624();
+
+#ifdef THOR_BENCHMARK
+    bench();
+#endif
+}
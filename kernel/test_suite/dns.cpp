@@ -0,0 +1,145 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <cstring>
+
+#include "net/dns_message.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+constexpr const char* example = "www.Example.com";
+
+/*!
+ * \brief Append a record with a pointer to the question name
+ */
+size_t add_record(char* message, size_t offset, uint16_t type, uint32_t ttl, const uint8_t* data, size_t length){
+    auto* bytes = reinterpret_cast<uint8_t*>(message + offset);
+
+    network::dns::write_16(bytes, 0xC00C);
+    network::dns::write_16(bytes + 2, type);
+    network::dns::write_16(bytes + 4, network::dns::class_in);
+    network::dns::write_16(bytes + 6, ttl >> 16);
+    network::dns::write_16(bytes + 8, ttl & 0xFFFF);
+    network::dns::write_16(bytes + 10, length);
+
+    memcpy(bytes + 12, data, length);
+
+    return offset + 12 + length;
+}
+
+/*!
+ * \brief Transform the query into a response with the given counts
+ */
+void make_response(char* message, uint8_t rcode, uint16_t answers, uint16_t authority){
+    auto* bytes = reinterpret_cast<uint8_t*>(message);
+
+    network::dns::write_16(bytes + 2, 0x8180 | rcode);
+    network::dns::write_16(bytes + 6, answers);
+    network::dns::write_16(bytes + 8, authority);
+}
+
+void test_query(){
+    char message[512];
+
+    auto length = network::dns::encode_query(message, sizeof(message), 0x1234, example, strlen(example));
+
+    CHECK_EQUALS_DIRECT(length, 12 + 17 + 4);
+    CHECK_DIRECT(memcmp(message + 12, "\3www\7Example\3com\0", 17) == 0);
+    CHECK_EQUALS_DIRECT(network::dns::read_16(reinterpret_cast<uint8_t*>(message)), 0x1234);
+
+    // Invalid names
+    CHECK_EQUALS_DIRECT(network::dns::encode_query(message, sizeof(message), 1, "", 0), 0);
+    CHECK_EQUALS_DIRECT(network::dns::encode_query(message, sizeof(message), 1, "a..b", 4), 0);
+    CHECK_EQUALS_DIRECT(network::dns::encode_query(message, sizeof(message), 1, ".a", 2), 0);
+
+    // Too small buffer
+    CHECK_EQUALS_DIRECT(network::dns::encode_query(message, 20, 1, example, strlen(example)), 0);
+}
+
+void test_answer(){
+    char message[512];
+
+    auto offset = network::dns::encode_query(message, sizeof(message), 7, example, strlen(example));
+
+    // A CNAME to a compressed name and then the address
+    uint8_t cname[] = {3, 'w', 'e', 'b', 0xC0, 16};
+    uint8_t address[] = {93, 184, 216, 34};
+
+    offset = add_record(message, offset, network::dns::type_cname, 300, cname, sizeof(cname));
+    offset = add_record(message, offset, network::dns::type_a, 3600, address, sizeof(address));
+
+    make_response(message, 0, 2, 0);
+
+    network::dns::response_info info;
+
+    CHECK_DIRECT(network::dns::decode_response(message, offset, "WWW.example.com", 15, info));
+    CHECK_EQUALS_DIRECT(info.identification, 7);
+    CHECK_EQUALS_DIRECT(info.rcode, 0);
+    CHECK_DIRECT(info.address_found);
+    CHECK_EQUALS_DIRECT(info.address, 0x5DB8D822);
+    CHECK_EQUALS_DIRECT(info.ttl, 300);
+
+    // The response must be for the question
+    CHECK_DIRECT(!network::dns::decode_response(message, offset, "www.example.org", 15, info));
+
+    // Truncated responses are invalid
+    CHECK_DIRECT(!network::dns::decode_response(message, offset - 1, example, strlen(example), info));
+}
+
+void test_negative(){
+    char message[512];
+
+    auto offset = network::dns::encode_query(message, sizeof(message), 9, example, strlen(example));
+
+    // SOA with root names, the minimum is the last field
+    uint8_t soa[22] = {0, 0};
+    soa[21] = 60;
+
+    offset = add_record(message, offset, network::dns::type_soa, 900, soa, sizeof(soa));
+
+    make_response(message, network::dns::rcode_nxdomain, 0, 1);
+
+    network::dns::response_info info;
+
+    CHECK_DIRECT(network::dns::decode_response(message, offset, example, strlen(example), info));
+    CHECK_EQUALS_DIRECT(info.rcode, network::dns::rcode_nxdomain);
+    CHECK_DIRECT(!info.address_found);
+    CHECK_DIRECT(info.soa_found);
+    CHECK_EQUALS_DIRECT(info.negative_ttl, 60);
+}
+
+void test_pointer_loop(){
+    char message[512];
+
+    auto offset = network::dns::encode_query(message, sizeof(message), 3, example, strlen(example));
+
+    // A name pointing to itself
+    uint8_t address[] = {1, 2, 3, 4};
+    auto record = offset;
+
+    offset = add_record(message, offset, network::dns::type_a, 60, address, sizeof(address));
+
+    message[record]     = char(0xC0);
+    message[record + 1] = char(record);
+
+    make_response(message, 0, 1, 0);
+
+    network::dns::response_info info;
+
+    CHECK_DIRECT(!network::dns::decode_response(message, offset, example, strlen(example), info));
+}
+
+} //end of anonymous namespace
+
+void dns_tests(){
+    test_query();
+    test_answer();
+    test_negative();
+    test_pointer_loop();
+}
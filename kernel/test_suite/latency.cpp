@@ -0,0 +1,54 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "latency_histogram.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+void test_buckets(){
+    CHECK_EQUALS_DIRECT(latency::bucket(0), 0);
+    CHECK_EQUALS_DIRECT(latency::bucket(1), 0);
+    CHECK_EQUALS_DIRECT(latency::bucket(2), 1);
+    CHECK_EQUALS_DIRECT(latency::bucket(3), 1);
+    CHECK_EQUALS_DIRECT(latency::bucket(4), 2);
+    CHECK_EQUALS_DIRECT(latency::bucket(1023), 9);
+    CHECK_EQUALS_DIRECT(latency::bucket(1024), 10);
+
+    // The last bucket holds all the long latencies
+    CHECK_EQUALS_DIRECT(latency::bucket(uint64_t(1) << 39), latency::buckets - 1);
+    CHECK_EQUALS_DIRECT(latency::bucket(uint64_t(1) << 63), latency::buckets - 1);
+}
+
+void test_record(){
+    latency::histogram h;
+    latency::clear(h);
+
+    latency::record(h, 100);
+    latency::record(h, 120);
+    latency::record(h, 5000);
+
+    CHECK_EQUALS_DIRECT(h.count, 3);
+    CHECK_EQUALS_DIRECT(h.total, 5220);
+    CHECK_EQUALS_DIRECT(h.max, 5000);
+    CHECK_EQUALS_DIRECT(h.counts[6], 2);
+    CHECK_EQUALS_DIRECT(h.counts[12], 1);
+
+    latency::clear(h);
+
+    CHECK_EQUALS_DIRECT(h.count, 0);
+    CHECK_EQUALS_DIRECT(h.max, 0);
+    CHECK_EQUALS_DIRECT(h.counts[6], 0);
+}
+
+} //end of anonymous namespace
+
+void latency_tests(){
+    test_buckets();
+    test_record();
+}
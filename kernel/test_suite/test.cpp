@@ -11,9 +11,15 @@
 #include "test.hpp"
 
 void path_tests();
+void checksum_tests();
+void dns_tests();
+void latency_tests();
 
 int main(){
     path_tests();
+    checksum_tests();
+    dns_tests();
+    latency_tests();
 
     printf("All tests finished\n");
 
@@ -0,0 +1,133 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+// Self-check of the CPU time accounting: a busy loop that never enters the
+// kernel must be charged to the user ticks of the process
+
+#include <string.hpp>
+
+#include <tlib/file.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/print.hpp>
+#include <tlib/directory_entry.hpp>
+
+namespace {
+
+static constexpr const size_t BUFFER_SIZE    = 4096;
+static constexpr const size_t DEFAULT_TICKS  = 200;
+static constexpr const uint64_t STATE_RUNNING = 3;
+
+std::string read_file(const std::string& path){
+    std::string value;
+
+    auto fd = tlib::open(path.c_str());
+
+    if(fd){
+        char buffer[64];
+
+        auto result = tlib::read(*fd, buffer, 63);
+
+        if(result){
+            buffer[*result] = '\0';
+            value = buffer;
+        }
+
+        tlib::close(*fd);
+    }
+
+    return value;
+}
+
+// There is no system call for the pid, the process is the running one with
+// the name of the executable
+std::string find_self(const char* name){
+    char entries_buffer[BUFFER_SIZE];
+
+    auto fd = tlib::open("/proc/");
+
+    if(!fd){
+        tlib::printf("cputime: error: %s\n", std::error_message(fd.error()));
+        return {};
+    }
+
+    auto entries_result = tlib::entries(*fd, entries_buffer, BUFFER_SIZE);
+
+    tlib::close(*fd);
+
+    if(!entries_result){
+        tlib::printf("cputime: error: %s\n", std::error_message(entries_result.error()));
+        return {};
+    }
+
+    size_t position = 0;
+
+    while(true){
+        auto entry = reinterpret_cast<tlib::directory_entry*>(entries_buffer + position);
+
+        std::string base_path = std::string("/proc/") + &entry->name;
+
+        if(read_file(base_path + "/name") == name && parse(read_file(base_path + "/state")) == STATE_RUNNING){
+            return base_path;
+        }
+
+        if(!entry->offset_next){
+            break;
+        }
+
+        position += entry->offset_next;
+    }
+
+    return {};
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    size_t ticks = DEFAULT_TICKS;
+
+    if(argc > 1){
+        ticks = std::atoui(argv[1]);
+
+        if(!ticks){
+            tlib::printf("cputime: error: invalid number of ticks\n");
+            return 1;
+        }
+    }
+
+    auto base_path = find_self(argv[0]);
+
+    if(base_path.empty()){
+        tlib::printf("cputime: error: the process is not in /proc\n");
+        return 1;
+    }
+
+    auto user_before   = parse(read_file(base_path + "/user_ticks"));
+    auto kernel_before = parse(read_file(base_path + "/kernel_ticks"));
+
+    // Spin without entering the kernel, the ticks come from the shared page
+    auto& shared = tlib::shared();
+    auto end     = shared.ticks + ticks;
+
+    while(shared.ticks < end){}
+
+    auto user   = parse(read_file(base_path + "/user_ticks")) - user_before;
+    auto kernel = parse(read_file(base_path + "/kernel_ticks")) - kernel_before;
+
+    tlib::printf("cputime: %u ticks of busy loop: %u user ticks, %u kernel ticks\n", ticks, user, kernel);
+
+    // Other processes may run during the loop, but the process only enters
+    // the kernel to read its own statistics
+    if(!user || user < 9 * (user + kernel) / 10){
+        tlib::printf("cputime: FAILED: the busy loop is not charged to the user ticks\n");
+        return 1;
+    }
+
+    tlib::printf("cputime: OK\n");
+
+    return 0;
+}
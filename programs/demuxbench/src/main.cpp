@@ -0,0 +1,210 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_CONNECTIONS = 128;  ///< The default number of open connections
+constexpr const size_t DEFAULT_ROUND_TRIPS = 1000; ///< The default number of round trips
+constexpr const size_t MESSAGE_SIZE        = 32;   ///< The size of each message
+constexpr const size_t PORT                = 7779;
+
+size_t connections = DEFAULT_CONNECTIONS;
+size_t round_trips = DEFAULT_ROUND_TRIPS;
+
+tlib::semaphore server_ready;
+tlib::semaphore server_accepted;
+bool server_error = false;
+
+bool receive_message(tlib::socket& sock, char* buffer){
+    size_t received = 0;
+
+    while (received < MESSAGE_SIZE) {
+        auto size = sock.receive(buffer + received, MESSAGE_SIZE - received);
+
+        if (!sock) {
+            tlib::printf("demuxbench: receive error: %s\n", std::error_message(sock.error()));
+            return false;
+        }
+
+        received += size;
+    }
+
+    return true;
+}
+
+void server_thread(void*){
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+    sock.server_start(tlib::ip::make_address(127, 0, 0, 1), PORT);
+
+    if (!sock) {
+        tlib::printf("demuxbench: server error: %s\n", std::error_message(sock.error()));
+        server_error = true;
+        server_ready.post();
+        return;
+    }
+
+    server_ready.post();
+
+    auto* children = new tlib::socket[connections];
+
+    for (size_t i = 0; i < connections; ++i) {
+        children[i] = sock.accept();
+
+        if (!sock || !children[i]) {
+            tlib::printf("demuxbench: accept error: %s\n", std::error_message(sock.error()));
+            server_error = true;
+            server_accepted.post();
+            delete[] children;
+            return;
+        }
+    }
+
+    server_accepted.post();
+
+    // Echo the messages on the last connection
+
+    auto& child = children[connections - 1];
+
+    child.listen(true);
+
+    char buffer[MESSAGE_SIZE];
+
+    for (size_t i = 0; i < round_trips; ++i) {
+        if (!receive_message(child, buffer)) {
+            server_error = true;
+            break;
+        }
+
+        child.send(buffer, MESSAGE_SIZE);
+
+        if (!child) {
+            tlib::printf("demuxbench: send error: %s\n", std::error_message(child.error()));
+            server_error = true;
+            break;
+        }
+    }
+
+    child.listen(false);
+
+    delete[] children;
+}
+
+int run(tlib::socket* clients){
+    for (size_t i = 0; i < connections; ++i) {
+        clients[i] = tlib::socket(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+        clients[i].connect(tlib::ip::make_address(127, 0, 0, 1), PORT);
+
+        if (!clients[i]) {
+            tlib::printf("demuxbench: connect error (%u): %s\n", i, std::error_message(clients[i].error()));
+            return 1;
+        }
+    }
+
+    server_accepted.wait();
+
+    if (server_error) {
+        return 1;
+    }
+
+    // The last connection is the most expensive to find with a linear lookup
+
+    auto& sock = clients[connections - 1];
+
+    sock.listen(true);
+
+    char buffer[MESSAGE_SIZE] = {};
+
+    auto start = tlib::ms_time();
+
+    for (size_t i = 0; i < round_trips; ++i) {
+        sock.send(buffer, MESSAGE_SIZE);
+
+        if (!sock) {
+            tlib::printf("demuxbench: send error: %s\n", std::error_message(sock.error()));
+            return 1;
+        }
+
+        if (!receive_message(sock, buffer)) {
+            return 1;
+        }
+    }
+
+    auto duration = tlib::ms_time() - start;
+
+    sock.listen(false);
+
+    if (duration) {
+        tlib::printf("demuxbench: %u round trips in %ums (%u us per round trip)\n", round_trips, duration, duration * 1000 / round_trips);
+    } else {
+        tlib::printf("demuxbench: %u round trips in <1ms\n", round_trips);
+    }
+
+    return 0;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if (argc > 3) {
+        tlib::print_line("usage: demuxbench [connections [round_trips]]");
+        return 1;
+    }
+
+    if (argc > 1) {
+        connections = std::atoui(argv[1]);
+    }
+
+    if (argc > 2) {
+        round_trips = std::atoui(argv[2]);
+    }
+
+    if (!connections || !round_trips) {
+        tlib::print_line("demuxbench: the number of connections and round trips must be positive");
+        return 1;
+    }
+
+    tlib::printf("demuxbench: %u round trips of %u bytes with %u open loopback connections\n", round_trips, MESSAGE_SIZE, connections);
+
+    auto t = tlib::create_thread(&server_thread, nullptr);
+
+    if (!t) {
+        tlib::printf("demuxbench: error: %s\n", std::error_message(t.error()));
+        return 1;
+    }
+
+    server_ready.wait();
+
+    if (server_error) {
+        tlib::join(*t);
+        return 1;
+    }
+
+    auto* clients = new tlib::socket[connections];
+
+    // On error, the server thread may still be waiting for connections,
+    // it is terminated with the process
+    if (run(clients)) {
+        return 1;
+    }
+
+    tlib::join(*t);
+
+    delete[] clients;
+
+    return server_error ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/dns.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+
+/*
+ * Check the DNS cache of the kernel against a stand-in DNS server, running
+ * on loopback in a thread of this program.
+ */
+
+namespace {
+
+constexpr const size_t THREADS        = 4;    ///< The number of concurrent resolutions of the same name
+constexpr const size_t RESPONSE_DELAY = 100;  ///< The time the server waits before answering, in ms
+constexpr const size_t SERVER_TIMEOUT = 5000; ///< The time after which the server stops
+
+const tlib::ip::address localhost = tlib::ip::make_address(127, 0, 0, 1);
+
+tlib::semaphore server_ready;
+tlib::semaphore start_threads;
+volatile bool server_error = false;
+volatile bool stop         = false;
+volatile size_t queries    = 0;
+
+size_t failures = 0;
+
+void write_16(char* buffer, uint16_t value){
+    buffer[0] = value >> 8;
+    buffer[1] = value & 0xFF;
+}
+
+void write_32(char* buffer, uint32_t value){
+    write_16(buffer, value >> 16);
+    write_16(buffer + 2, value & 0xFFFF);
+}
+
+/*!
+ * \brief Transform the query in buffer into its response.
+ *
+ * The names starting with "nx" do not exist, the names starting with "short"
+ * have a TTL of one second. The address of a name is 10.0.0.<query number>.
+ *
+ * \return The size of the response
+ */
+size_t answer(char* buffer, size_t size){
+    // Find the end of the question
+    size_t end = 12;
+
+    while (end < size && buffer[end]) {
+        end += static_cast<uint8_t>(buffer[end]) + 1;
+    }
+
+    end += 1 + 4;
+
+    if (end > size) {
+        return 0;
+    }
+
+    bool nx        = buffer[12] >= 2 && buffer[13] == 'n' && buffer[14] == 'x';
+    bool short_ttl = buffer[12] >= 5 && buffer[13] == 's' && buffer[14] == 'h' && buffer[15] == 'o' && buffer[16] == 'r' && buffer[17] == 't';
+
+    write_16(buffer + 2, nx ? 0x8183 : 0x8180);
+    write_16(buffer + 6, nx ? 0 : 1);
+    write_16(buffer + 8, nx ? 1 : 0);
+    write_16(buffer + 10, 0);
+
+    auto* record = buffer + end;
+
+    // The name is a pointer to the question
+    write_16(record, 0xC00C);
+
+    if (nx) {
+        // SOA with empty names and a minimum of 60 seconds
+        write_16(record + 2, 6);
+        write_16(record + 4, 1);
+        write_32(record + 6, 3600);
+        write_16(record + 10, 22);
+
+        record[12] = 0;
+        record[13] = 0;
+
+        for (size_t i = 0; i < 5; ++i) {
+            write_32(record + 14 + i * 4, i == 4 ? 60 : 1);
+        }
+
+        return end + 12 + 22;
+    }
+
+    write_16(record + 2, 1);
+    write_16(record + 4, 1);
+    write_32(record + 6, short_ttl ? 1 : 60);
+    write_16(record + 10, 4);
+
+    record[12] = 10;
+    record[13] = 0;
+    record[14] = 0;
+    record[15] = queries;
+
+    return end + 12 + 4;
+}
+
+void server_thread(void*){
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::DGRAM, tlib::socket_protocol::UDP);
+
+    sock.server_bind(localhost, 53);
+    sock.listen(true);
+
+    if (!sock) {
+        tlib::printf("dnscache: server error: %s\n", std::error_message(sock.error()));
+        server_error = true;
+        server_ready.post();
+        return;
+    }
+
+    server_ready.post();
+
+    char buffer[512];
+
+    while (!stop) {
+        tlib::inet_address address;
+
+        auto size = sock.receive_from(buffer, sizeof(buffer), SERVER_TIMEOUT, &address);
+
+        if (!sock) {
+            if (sock.error() != std::ERROR_SOCKET_TIMEOUT) {
+                tlib::printf("dnscache: receive error: %s\n", std::error_message(sock.error()));
+            }
+
+            break;
+        }
+
+        ++queries;
+
+        // Let the concurrent resolutions pile up on the pending query
+        tlib::sleep_ms(RESPONSE_DELAY);
+
+        auto response = answer(buffer, size);
+
+        if (response) {
+            sock.send_to(buffer, response, &address);
+        }
+    }
+
+    sock.listen(false);
+}
+
+void check(bool condition, const char* message){
+    if (!condition) {
+        tlib::printf("dnscache: FAIL: %s\n", message);
+        ++failures;
+    } else {
+        tlib::printf("dnscache: ok: %s\n", message);
+    }
+}
+
+std::expected<tlib::ip::address> resolve(const char* name){
+    return tlib::dns::resolve_from(name, localhost, 1000, 2);
+}
+
+std::expected<tlib::ip::address> shared_results[THREADS];
+
+void resolver_thread(void* data){
+    auto i = reinterpret_cast<size_t>(data);
+
+    start_threads.wait();
+
+    shared_results[i] = resolve("shared.test");
+}
+
+} // end of anonymous namespace
+
+int main(){
+    auto server = tlib::create_thread(&server_thread, nullptr);
+
+    if (!server) {
+        tlib::printf("dnscache: error: %s\n", std::error_message(server.error()));
+        return 1;
+    }
+
+    server_ready.wait();
+
+    if (server_error) {
+        tlib::join(*server);
+        return 1;
+    }
+
+    // Miss then hit (the names are not case-sensitive)
+
+    auto first = resolve("host.test");
+    check(first && queries == 1, "the first resolution queries the server");
+
+    auto second = resolve("HOST.test.");
+    check(second && queries == 1, "the second resolution is answered by the cache");
+    check(first && second && first->raw_address == second->raw_address, "both resolutions return the same address");
+
+    // Negative answers are cached too
+
+    auto nx = resolve("nx.test");
+    check(!nx && nx.error() == std::ERROR_NOT_EXISTS && queries == 2, "an unknown name is not found");
+
+    nx = resolve("nx.test");
+    check(!nx && nx.error() == std::ERROR_NOT_EXISTS && queries == 2, "the negative answer is cached");
+
+    // Concurrent resolutions share a single query
+
+    tlib::thread threads[THREADS];
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        auto t = tlib::create_thread(&resolver_thread, reinterpret_cast<void*>(i));
+
+        if (!t) {
+            tlib::printf("dnscache: error: %s\n", std::error_message(t.error()));
+            return 1;
+        }
+
+        threads[i] = *t;
+    }
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        start_threads.post();
+    }
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        tlib::join(threads[i]);
+    }
+
+    bool all_resolved = true;
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        all_resolved = all_resolved && shared_results[i] && shared_results[i]->raw_address == shared_results[0]->raw_address;
+    }
+
+    check(all_resolved && queries == 3, "concurrent resolutions share one query");
+
+    // The answers expire with their TTL
+
+    resolve("short.test");
+    check(queries == 4, "a new name queries the server");
+
+    tlib::sleep_ms(1100);
+
+    resolve("short.test");
+    check(queries == 5, "an expired answer queries the server again");
+
+    stop = true;
+
+    // Wake up the server
+    resolve("stop.test");
+
+    tlib::join(*server);
+
+    if (failures) {
+        tlib::printf("dnscache: %u checks failed\n", failures);
+        return 1;
+    }
+
+    tlib::print_line("dnscache: all checks passed");
+
+    return 0;
+}
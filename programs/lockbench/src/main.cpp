@@ -0,0 +1,161 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+#include <vector.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+#include <tlib/errors.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_THREADS = 4;
+constexpr const size_t ITERATIONS      = 1000000;
+constexpr const size_t ROUNDS          = 10000;
+
+tlib::mutex lock;
+size_t counter = 0;
+size_t per_thread = 0;
+
+tlib::semaphore ping;
+tlib::semaphore pong;
+
+void display_result(const char* name, size_t operations, uint64_t duration){
+    if(duration){
+        tlib::printf("%s: %u operations in %ums (%u ops/ms)\n", name, operations, duration, operations / duration);
+    } else {
+        tlib::printf("%s: %u operations in <1ms\n", name, operations);
+    }
+}
+
+void increment(void*){
+    for(size_t i = 0; i < per_thread; ++i){
+        lock.lock();
+        ++counter;
+        lock.unlock();
+    }
+}
+
+void pong_thread(void*){
+    for(size_t i = 0; i < ROUNDS; ++i){
+        ping.wait();
+        pong.post();
+    }
+}
+
+void uncontended(){
+    auto start = tlib::ms_time();
+
+    for(size_t i = 0; i < ITERATIONS; ++i){
+        lock.lock();
+        ++counter;
+        lock.unlock();
+    }
+
+    auto end = tlib::ms_time();
+
+    display_result("uncontended mutex", ITERATIONS, end - start);
+}
+
+bool contended(size_t threads){
+    counter = 0;
+    per_thread = ITERATIONS / threads;
+
+    std::vector<tlib::thread> workers;
+
+    auto start = tlib::ms_time();
+
+    for(size_t i = 0; i < threads; ++i){
+        auto t = tlib::create_thread(&increment, nullptr);
+
+        if(!t){
+            tlib::printf("lockbench: error: %s\n", std::error_message(t.error()));
+            return false;
+        }
+
+        workers.push_back(*t);
+    }
+
+    for(auto& t : workers){
+        tlib::join(t);
+    }
+
+    auto end = tlib::ms_time();
+
+    if(counter != per_thread * threads){
+        tlib::printf("lockbench: error: lost updates (%u instead of %u)\n", counter, per_thread * threads);
+        return false;
+    }
+
+    tlib::printf("%u threads: ", threads);
+    display_result("contended mutex", per_thread * threads, end - start);
+
+    return true;
+}
+
+bool ping_pong(){
+    auto t = tlib::create_thread(&pong_thread, nullptr);
+
+    if(!t){
+        tlib::printf("lockbench: error: %s\n", std::error_message(t.error()));
+        return false;
+    }
+
+    auto start = tlib::ms_time();
+
+    for(size_t i = 0; i < ROUNDS; ++i){
+        ping.post();
+        pong.wait();
+    }
+
+    auto end = tlib::ms_time();
+
+    tlib::join(*t);
+
+    display_result("semaphore ping-pong", ROUNDS, end - start);
+
+    return true;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    size_t threads = DEFAULT_THREADS;
+
+    if(argc > 2){
+        tlib::print_line("usage: lockbench [threads]");
+        return 1;
+    }
+
+    if(argc == 2){
+        threads = std::atoui(argv[1]);
+
+        if(!threads){
+            tlib::print_line("lockbench: the number of threads must be positive");
+            return 1;
+        }
+    }
+
+    tlib::printf("Start lock benchmark...\n");
+
+    uncontended();
+
+    for(size_t i = 1; i <= threads; i *= 2){
+        if(!contended(i)){
+            return 1;
+        }
+    }
+
+    if(!ping_pong()){
+        return 1;
+    }
+
+    return 0;
+}
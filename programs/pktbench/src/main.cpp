@@ -0,0 +1,223 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_PACKETS = 100000; ///< The default number of packets
+constexpr const size_t DEFAULT_BATCH   = 32;     ///< The default number of datagrams per batch
+constexpr const size_t MAX_BATCH       = 64;     ///< The maximum number of datagrams per batch
+constexpr const size_t PACKET_SIZE     = 64;     ///< The size of each datagram
+constexpr const size_t PORT            = 7778;
+constexpr const size_t TIMEOUT         = 1000;   ///< The time after which the remaining packets are considered lost
+
+size_t packets = DEFAULT_PACKETS;
+size_t batch   = DEFAULT_BATCH;
+
+tlib::semaphore receiver_ready;
+bool receiver_error   = false;
+size_t received       = 0;
+uint64_t receive_time = 0;
+
+char buffers[MAX_BATCH][PACKET_SIZE];
+tlib::datagram datagrams[MAX_BATCH];
+
+void display_result(const char* name, size_t n, uint64_t duration){
+    if(duration){
+        tlib::printf("%s: %u packets in %ums (%u pps)\n", name, n, duration, n * 1000 / duration);
+    } else {
+        tlib::printf("%s: %u packets in <1ms\n", name, n);
+    }
+}
+
+void prepare_datagrams(tlib::datagram* datagrams, size_t n){
+    for (size_t i = 0; i < n; ++i) {
+        datagrams[i].buffer   = buffers[i];
+        datagrams[i].size     = PACKET_SIZE;
+        datagrams[i].received = 0;
+    }
+}
+
+/*!
+ * \brief Receive the packets, one per system call if n is 1, n at most per
+ * system call otherwise.
+ */
+void receiver_thread(void* data){
+    auto n = reinterpret_cast<size_t>(data);
+
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::DGRAM, tlib::socket_protocol::UDP);
+
+    sock.server_bind(tlib::ip::make_address(127, 0, 0, 1), PORT);
+    sock.listen(true);
+
+    if (!sock) {
+        tlib::printf("pktbench: receiver error: %s\n", std::error_message(sock.error()));
+        receiver_error = true;
+        receiver_ready.post();
+        return;
+    }
+
+    receiver_ready.post();
+
+    tlib::datagram received_datagrams[MAX_BATCH];
+
+    uint64_t start = 0;
+    uint64_t end   = 0;
+
+    while (received < packets) {
+        size_t count;
+
+        if (n == 1) {
+            sock.receive(buffers[0], PACKET_SIZE, TIMEOUT);
+            count = 1;
+        } else {
+            prepare_datagrams(received_datagrams, n);
+            count = sock.receive_many(received_datagrams, n, TIMEOUT);
+        }
+
+        if (!sock) {
+            if (sock.error() != std::ERROR_SOCKET_TIMEOUT) {
+                tlib::printf("pktbench: receive error: %s\n", std::error_message(sock.error()));
+                receiver_error = true;
+            }
+
+            break;
+        }
+
+        end = tlib::ms_time();
+
+        if (!start) {
+            start = end;
+        }
+
+        received += count;
+    }
+
+    receive_time = end - start;
+
+    sock.listen(false);
+}
+
+/*!
+ * \brief Send the packets over loopback, n per system call, and display the
+ * throughput of both sides
+ */
+bool run(size_t n){
+    received       = 0;
+    receive_time   = 0;
+    receiver_error = false;
+
+    auto t = tlib::create_thread(&receiver_thread, reinterpret_cast<void*>(n));
+
+    if (!t) {
+        tlib::printf("pktbench: error: %s\n", std::error_message(t.error()));
+        return false;
+    }
+
+    receiver_ready.wait();
+
+    if (receiver_error) {
+        tlib::join(*t);
+        return false;
+    }
+
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::DGRAM, tlib::socket_protocol::UDP);
+
+    sock.client_bind(tlib::ip::make_address(127, 0, 0, 1), PORT);
+
+    if (!sock) {
+        tlib::printf("pktbench: bind error: %s\n", std::error_message(sock.error()));
+        return false;
+    }
+
+    char buffer[PACKET_SIZE] = {};
+
+    prepare_datagrams(datagrams, n);
+
+    auto start = tlib::ms_time();
+
+    for (size_t i = 0; i < packets; i += n) {
+        if (n == 1) {
+            sock.send(buffer, PACKET_SIZE);
+        } else {
+            sock.send_many(datagrams, std::min(n, packets - i));
+        }
+
+        if (!sock) {
+            tlib::printf("pktbench: send error: %s\n", std::error_message(sock.error()));
+            return false;
+        }
+    }
+
+    auto end = tlib::ms_time();
+
+    tlib::join(*t);
+
+    if (receiver_error) {
+        return false;
+    }
+
+    display_result("  send", packets, end - start);
+    display_result("  receive", received, receive_time);
+
+    if (received < packets) {
+        tlib::printf("  %u packets lost\n", packets - received);
+    }
+
+    return true;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if (argc > 3) {
+        tlib::print_line("usage: pktbench [packets] [batch]");
+        return 1;
+    }
+
+    if (argc >= 2) {
+        packets = std::atoui(argv[1]);
+
+        if (!packets) {
+            tlib::print_line("pktbench: the number of packets must be positive");
+            return 1;
+        }
+    }
+
+    if (argc == 3) {
+        batch = std::atoui(argv[2]);
+
+        if (batch < 2 || batch > MAX_BATCH) {
+            tlib::printf("pktbench: the batch size must be between 2 and %u\n", MAX_BATCH);
+            return 1;
+        }
+    }
+
+    tlib::printf("pktbench: send %u packets of %u bytes over loopback\n", packets, PACKET_SIZE);
+
+    tlib::print_line("1 datagram per system call");
+
+    if (!run(1)) {
+        return 1;
+    }
+
+    tlib::printf("%u datagrams per system call\n", batch);
+
+    if (!run(batch)) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/poll.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_PORT = 7;  ///< The standard echo port
+constexpr const size_t MAX_CLIENTS  = 32; ///< The maximum number of simultaneous clients
+constexpr const size_t MAX_EVENTS   = 16; ///< The maximum number of events per wait
+constexpr const size_t BUFFER_SIZE  = 1024;
+
+tlib::socket server;
+tlib::socket clients[MAX_CLIENTS];
+
+size_t set;
+bool edge = false;
+
+tlib::socket* find_client(size_t fd){
+    for (auto& client : clients) {
+        if (client.open() && client.get_fd() == fd) {
+            return &client;
+        }
+    }
+
+    return nullptr;
+}
+
+void close_client(tlib::socket& client){
+    tlib::poll_remove(set, tlib::poll_target::SOCKET, client.get_fd());
+
+    tlib::printf("pollecho: client %u disconnected\n", client.get_fd());
+
+    // The destructor disconnects and closes the socket
+    client = tlib::socket();
+}
+
+void accept_client(){
+    auto child = server.accept();
+
+    if (!server || !child) {
+        tlib::printf("pollecho: accept error: %s\n", std::error_message(server.error()));
+        server.clear();
+        return;
+    }
+
+    for (auto& client : clients) {
+        if (!client.open()) {
+            client = std::move(child);
+
+            client.listen(true);
+
+            auto events = tlib::POLL_IN | (edge ? tlib::POLL_EDGE : 0);
+            auto status = tlib::poll_add(set, tlib::poll_target::SOCKET, client.get_fd(), events);
+
+            if (!status) {
+                tlib::printf("pollecho: poll error: %s\n", std::error_message(status.error()));
+                client = tlib::socket();
+                return;
+            }
+
+            tlib::printf("pollecho: client %u connected\n", client.get_fd());
+
+            return;
+        }
+    }
+
+    tlib::print_line("pollecho: too many clients");
+}
+
+void echo(tlib::socket& client){
+    char buffer[BUFFER_SIZE];
+
+    // In edge-triggered mode, everything must be read now
+    while (true) {
+        auto size = client.receive(buffer, BUFFER_SIZE, 0);
+
+        if (!client) {
+            if (client.error() == std::ERROR_SOCKET_TIMEOUT) {
+                client.clear();
+                return;
+            }
+
+            close_client(client);
+            return;
+        }
+
+        client.send(buffer, size);
+
+        if (!client) {
+            close_client(client);
+            return;
+        }
+
+        if (!edge) {
+            return;
+        }
+    }
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    size_t port = DEFAULT_PORT;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "-e") {
+            edge = true;
+        } else {
+            port = std::atoui(arg);
+        }
+    }
+
+    server = tlib::socket(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+    server.server_start(tlib::ip::make_address(0, 0, 0, 0), port);
+
+    if (!server) {
+        tlib::printf("pollecho: server error: %s\n", std::error_message(server.error()));
+        return 1;
+    }
+
+    auto set_status = tlib::poll_create();
+
+    if (!set_status) {
+        tlib::printf("pollecho: poll error: %s\n", std::error_message(set_status.error()));
+        return 1;
+    }
+
+    set = *set_status;
+
+    auto status = tlib::poll_add(set, tlib::poll_target::SOCKET, server.get_fd(), tlib::POLL_IN);
+
+    if (!status) {
+        tlib::printf("pollecho: poll error: %s\n", std::error_message(status.error()));
+        return 1;
+    }
+
+    tlib::printf("pollecho: listening on port %u (%s-triggered)\n", port, edge ? "edge" : "level");
+
+    tlib::poll_event events[MAX_EVENTS];
+
+    while (true) {
+        auto ready = tlib::poll_wait(set, events, MAX_EVENTS);
+
+        if (!ready) {
+            tlib::printf("pollecho: poll error: %s\n", std::error_message(ready.error()));
+            break;
+        }
+
+        for (size_t i = 0; i < *ready; ++i) {
+            auto& event = events[i];
+
+            if (event.fd == server.get_fd()) {
+                accept_client();
+            } else if (auto* client = find_client(event.fd)) {
+                if (event.events & tlib::POLL_IN) {
+                    echo(*client);
+                }
+
+                // The client may already be closed by echo
+                if ((event.events & tlib::POLL_HUP) && client->open()) {
+                    close_client(*client);
+                }
+            }
+        }
+    }
+
+    tlib::poll_close(set);
+
+    return 1;
+}
@@ -0,0 +1,171 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/file.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/print.hpp>
+#include <tlib/flags.hpp>
+
+namespace {
+
+void usage(){
+    tlib::print_line("usage: profile start [period] | stop | status | dump file");
+    tlib::print_line("  period: number of timer ticks between two samples (default: 1)");
+}
+
+bool write_value(const char* file, const std::string& value){
+    auto fd = tlib::open(file);
+
+    if(!fd){
+        tlib::printf("profile: error: %s\n", std::error_message(fd.error()));
+        return false;
+    }
+
+    auto result = tlib::write(*fd, value.c_str(), value.size());
+
+    tlib::close(*fd);
+
+    if(!result){
+        tlib::printf("profile: error: %s\n", std::error_message(result.error()));
+        return false;
+    }
+
+    return true;
+}
+
+std::string read_value(const char* file){
+    std::string value;
+
+    auto fd = tlib::open(file);
+
+    if(fd){
+        char buffer[64];
+
+        auto result = tlib::read(*fd, buffer, 64);
+
+        if(result){
+            for(size_t i = 0; i < *result; ++i){
+                value += buffer[i];
+            }
+        }
+
+        tlib::close(*fd);
+    }
+
+    return value;
+}
+
+int dump(const char* file){
+    // The samples must not move while they are read
+    if(!write_value("/sys/profiler/enable", "0")){
+        return 1;
+    }
+
+    auto fd = tlib::open("/sys/profiler/raw");
+
+    if(!fd){
+        tlib::printf("profile: error: %s\n", std::error_message(fd.error()));
+        return 1;
+    }
+
+    auto info = tlib::stat(*fd);
+
+    if(!info){
+        tlib::printf("profile: error: %s\n", std::error_message(info.error()));
+        tlib::close(*fd);
+        return 1;
+    }
+
+    auto size   = info->size;
+    auto buffer = new char[size];
+
+    auto read_result = tlib::read(*fd, buffer, size);
+
+    tlib::close(*fd);
+
+    if(!read_result){
+        tlib::printf("profile: error: %s\n", std::error_message(read_result.error()));
+        delete[] buffer;
+        return 1;
+    }
+
+    auto out = tlib::open(file, std::OPEN_CREATE);
+
+    if(!out){
+        tlib::printf("profile: error: %s\n", std::error_message(out.error()));
+        delete[] buffer;
+        return 1;
+    }
+
+    int code = 0;
+
+    auto truncate_result = tlib::truncate(*out, *read_result);
+
+    if(truncate_result){
+        auto write_result = tlib::write(*out, buffer, *read_result, 0);
+
+        if(write_result){
+            tlib::printf("profile: %u bytes written to %s\n", *read_result, file);
+        } else {
+            tlib::printf("profile: error: %s\n", std::error_message(write_result.error()));
+            code = 1;
+        }
+    } else {
+        tlib::printf("profile: error: %s\n", std::error_message(truncate_result.error()));
+        code = 1;
+    }
+
+    tlib::close(*out);
+
+    delete[] buffer;
+
+    return code;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        usage();
+        return 1;
+    }
+
+    std::string command(argv[1]);
+
+    if(command == "start"){
+        if(argc > 2){
+            auto period = std::atoui(argv[2]);
+
+            if(!period){
+                usage();
+                return 1;
+            }
+
+            if(!write_value("/sys/profiler/period", std::to_string(period))){
+                return 1;
+            }
+        }
+
+        return write_value("/sys/profiler/enable", "1") ? 0 : 1;
+    } else if(command == "stop"){
+        return write_value("/sys/profiler/enable", "0") ? 0 : 1;
+    } else if(command == "status"){
+        tlib::printf("enabled: %s\n", read_value("/sys/profiler/enable").c_str());
+        tlib::printf("frequency: %sHz\n", read_value("/sys/profiler/frequency").c_str());
+        tlib::printf("samples: %s\n", read_value("/sys/profiler/samples").c_str());
+        tlib::printf("lost: %s\n", read_value("/sys/profiler/lost").c_str());
+        return 0;
+    } else if(command == "dump" && argc == 3){
+        return dump(argv[2]);
+    }
+
+    usage();
+    return 1;
+}
@@ -69,6 +69,8 @@ const char* state_str(uint64_t state){
             return "WAITING";
         case 7:
             return "KILLED";
+        case 9:
+            return "ZOMBIE";
         default:
             return "UNKNOWN";
     }
@@ -0,0 +1,290 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_SIZE = 1024 * 1024; ///< The default number of bytes to transfer
+constexpr const size_t CHUNK        = 1024;        ///< The size of each send
+constexpr const size_t BATCH        = 16;          ///< The number of ring slots sent per system call
+constexpr const size_t PORT         = 7779;
+constexpr const size_t TIMEOUT      = 1000;        ///< The time after which the remaining datagrams are considered lost
+
+size_t total = DEFAULT_SIZE;
+bool stream  = false;
+
+tlib::semaphore receiver_ready;
+bool receiver_error   = false;
+size_t received       = 0;
+uint64_t receive_time = 0;
+
+void display_result(const char* name, size_t bytes, uint64_t duration){
+    if(duration){
+        tlib::printf("%s: %u bytes in %ums (%u KB/s)\n", name, bytes, duration, (bytes / 1024) * 1000 / duration);
+    } else {
+        tlib::printf("%s: %u bytes in <1ms\n", name, bytes);
+    }
+}
+
+void fill(char* buffer, size_t n){
+    for (size_t i = 0; i < n; ++i) {
+        buffer[i] = 'a' + i % 26;
+    }
+}
+
+/*!
+ * \brief Receive the data until everything is received (or lost for datagrams)
+ */
+void receive_all(tlib::socket& sock){
+    char buffer[2048];
+
+    uint64_t start = 0;
+    uint64_t end   = 0;
+
+    while (received < total) {
+        auto size = stream ? sock.receive(buffer, sizeof(buffer)) : sock.receive(buffer, sizeof(buffer), TIMEOUT);
+
+        if (!sock) {
+            if (sock.error() != std::ERROR_SOCKET_TIMEOUT) {
+                tlib::printf("ringbench: receive error: %s\n", std::error_message(sock.error()));
+                receiver_error = true;
+            }
+
+            break;
+        }
+
+        end = tlib::ms_time();
+
+        if (!start) {
+            start = end;
+        }
+
+        received += size;
+    }
+
+    receive_time = end - start;
+}
+
+void receiver_thread(void*){
+    if (stream) {
+        tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+        sock.server_start(tlib::ip::make_address(127, 0, 0, 1), PORT);
+
+        if (!sock) {
+            tlib::printf("ringbench: server error: %s\n", std::error_message(sock.error()));
+            receiver_error = true;
+            receiver_ready.post();
+            return;
+        }
+
+        receiver_ready.post();
+
+        auto child = sock.accept();
+
+        if (!sock || !child) {
+            tlib::printf("ringbench: accept error: %s\n", std::error_message(sock.error()));
+            receiver_error = true;
+            return;
+        }
+
+        child.listen(true);
+        receive_all(child);
+        child.listen(false);
+    } else {
+        tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::DGRAM, tlib::socket_protocol::UDP);
+
+        sock.server_bind(tlib::ip::make_address(127, 0, 0, 1), PORT);
+        sock.listen(true);
+
+        if (!sock) {
+            tlib::printf("ringbench: receiver error: %s\n", std::error_message(sock.error()));
+            receiver_error = true;
+            receiver_ready.post();
+            return;
+        }
+
+        receiver_ready.post();
+
+        receive_all(sock);
+
+        sock.listen(false);
+    }
+}
+
+/*!
+ * \brief Send the data with one copy per send
+ */
+bool send_copy(tlib::socket& sock){
+    char buffer[CHUNK];
+
+    fill(buffer, CHUNK);
+
+    for (size_t sent = 0; sent < total; sent += CHUNK) {
+        sock.send(buffer, std::min(CHUNK, total - sent));
+
+        if (!sock) {
+            tlib::printf("ringbench: send error: %s\n", std::error_message(sock.error()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Send the data written in place in the packet ring
+ */
+bool send_ring(tlib::socket& sock){
+    if (!sock.open_ring()) {
+        tlib::printf("ringbench: ring error: %s\n", std::error_message(sock.error()));
+        return false;
+    }
+
+    size_t pending = 0;
+
+    for (size_t sent = 0; sent < total; sent += CHUNK) {
+        auto* buffer = sock.ring_buffer();
+
+        if (!buffer) {
+            tlib::printf("ringbench: ring error: %s\n", std::error_message(sock.error()));
+            return false;
+        }
+
+        auto n = std::min(CHUNK, total - sent);
+
+        fill(buffer, n);
+        sock.ring_commit(n);
+
+        if (++pending == BATCH || sent + n >= total) {
+            sock.ring_send();
+            pending = 0;
+
+            if (!sock) {
+                tlib::printf("ringbench: send error: %s\n", std::error_message(sock.error()));
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool run(bool ring){
+    received       = 0;
+    receive_time   = 0;
+    receiver_error = false;
+
+    auto t = tlib::create_thread(&receiver_thread, nullptr);
+
+    if (!t) {
+        tlib::printf("ringbench: error: %s\n", std::error_message(t.error()));
+        return false;
+    }
+
+    receiver_ready.wait();
+
+    if (receiver_error) {
+        tlib::join(*t);
+        return false;
+    }
+
+    tlib::socket sock(tlib::socket_domain::AF_INET,
+                      stream ? tlib::socket_type::STREAM : tlib::socket_type::DGRAM,
+                      stream ? tlib::socket_protocol::TCP : tlib::socket_protocol::UDP);
+
+    if (stream) {
+        sock.connect(tlib::ip::make_address(127, 0, 0, 1), PORT);
+    } else {
+        sock.client_bind(tlib::ip::make_address(127, 0, 0, 1), PORT);
+    }
+
+    if (!sock) {
+        tlib::printf("ringbench: connect error: %s\n", std::error_message(sock.error()));
+        return false;
+    }
+
+    auto start = tlib::ms_time();
+
+    if (!(ring ? send_ring(sock) : send_copy(sock))) {
+        return false;
+    }
+
+    auto end = tlib::ms_time();
+
+    tlib::join(*t);
+
+    if (stream) {
+        sock.disconnect();
+    }
+
+    if (receiver_error) {
+        return false;
+    }
+
+    display_result("  send", total, end - start);
+    display_result("  receive", received, receive_time);
+
+    if (received < total) {
+        tlib::printf("  %u bytes lost\n", total - received);
+    }
+
+    return true;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if (argc > 3) {
+        tlib::print_line("usage: ringbench [udp|tcp] [KB]");
+        return 1;
+    }
+
+    if (argc >= 2) {
+        std::string protocol(argv[1]);
+
+        if (protocol == "tcp") {
+            stream = true;
+        } else if (protocol != "udp") {
+            tlib::print_line("usage: ringbench [udp|tcp] [KB]");
+            return 1;
+        }
+    }
+
+    if (argc == 3) {
+        total = std::atoui(argv[2]) * 1024;
+
+        if (!total) {
+            tlib::print_line("ringbench: the size must be positive");
+            return 1;
+        }
+    }
+
+    tlib::printf("ringbench: transfer %u bytes over loopback with %s\n", total, stream ? "TCP" : "UDP");
+
+    tlib::print_line("copy (send)");
+
+    if (!run(false)) {
+        return 1;
+    }
+
+    tlib::print_line("packet ring");
+
+    if (!run(true)) {
+        return 1;
+    }
+
+    return 0;
+}
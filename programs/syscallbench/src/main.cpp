@@ -0,0 +1,61 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_ITERATIONS = 1000000;
+
+void display_result(const char* name, size_t calls, uint64_t duration){
+    if(duration){
+        tlib::printf("%s: %u calls in %ums (%u ns/call)\n", name, calls, duration, duration * 1000000 / calls);
+    } else {
+        tlib::printf("%s: %u calls in <1ms\n", name, calls);
+    }
+}
+
+template<typename Call>
+void bench(const char* name, size_t iterations, Call call){
+    auto start = tlib::ms_time();
+
+    for(size_t i = 0; i < iterations; ++i){
+        call();
+    }
+
+    auto end = tlib::ms_time();
+
+    display_result(name, iterations, end - start);
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if(argc > 2){
+        tlib::print_line("usage: syscallbench [iterations]");
+        return 1;
+    }
+
+    size_t iterations = DEFAULT_ITERATIONS;
+
+    if(argc == 2){
+        iterations = std::atoui(argv[1]);
+
+        if(!iterations){
+            tlib::print_line("syscallbench: the number of iterations must be positive");
+            return 1;
+        }
+    }
+
+    bench("int 50", iterations, tlib::null_call_interrupt);
+    bench("syscall", iterations, tlib::null_call);
+
+    return 0;
+}
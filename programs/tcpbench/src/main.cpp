@@ -0,0 +1,230 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/print.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/net.hpp>
+#include <tlib/thread.hpp>
+#include <tlib/sync.hpp>
+
+namespace {
+
+constexpr const size_t DEFAULT_SIZE  = 1024 * 1024; ///< The default number of bytes to transfer
+constexpr const size_t CHUNK         = 1024;        ///< The size of each send
+constexpr const size_t LOOPBACK_PORT = 7777;
+
+size_t total = DEFAULT_SIZE;
+
+tlib::semaphore server_ready;
+bool server_error     = false;
+size_t received       = 0;
+uint64_t receive_time = 0;
+
+void display_result(const char* name, size_t bytes, uint64_t duration){
+    if(duration){
+        tlib::printf("%s: %u bytes in %ums (%u KB/s)\n", name, bytes, duration, (bytes / 1024) * 1000 / duration);
+    } else {
+        tlib::printf("%s: %u bytes in <1ms\n", name, bytes);
+    }
+}
+
+void server_thread(void*){
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+    sock.server_start(tlib::ip::make_address(127, 0, 0, 1), LOOPBACK_PORT);
+
+    if (!sock) {
+        tlib::printf("tcpbench: server error: %s\n", std::error_message(sock.error()));
+        server_error = true;
+        server_ready.post();
+        return;
+    }
+
+    server_ready.post();
+
+    auto child = sock.accept();
+
+    if (!sock || !child) {
+        tlib::printf("tcpbench: accept error: %s\n", std::error_message(sock.error()));
+        server_error = true;
+        return;
+    }
+
+    child.listen(true);
+
+    char buffer[2048];
+
+    uint64_t start = 0;
+
+    while (received < total) {
+        auto size = child.receive(buffer, sizeof(buffer));
+
+        if (!child) {
+            tlib::printf("tcpbench: receive error: %s\n", std::error_message(child.error()));
+            server_error = true;
+            break;
+        }
+
+        if (!start) {
+            start = tlib::ms_time();
+        }
+
+        received += size;
+    }
+
+    receive_time = tlib::ms_time() - start;
+
+    child.listen(false);
+}
+
+bool send_all(tlib::socket& sock){
+    char buffer[CHUNK];
+
+    for (size_t i = 0; i < CHUNK; ++i) {
+        buffer[i] = 'a' + i % 26;
+    }
+
+    size_t sent = 0;
+
+    while (sent < total) {
+        auto n = std::min(CHUNK, total - sent);
+
+        sock.send(buffer, n);
+
+        if (!sock) {
+            tlib::printf("tcpbench: send error: %s\n", std::error_message(sock.error()));
+            return false;
+        }
+
+        sent += n;
+    }
+
+    return true;
+}
+
+int loopback(){
+    tlib::printf("tcpbench: transfer %u bytes over loopback\n", total);
+
+    auto t = tlib::create_thread(&server_thread, nullptr);
+
+    if (!t) {
+        tlib::printf("tcpbench: error: %s\n", std::error_message(t.error()));
+        return 1;
+    }
+
+    server_ready.wait();
+
+    if (server_error) {
+        tlib::join(*t);
+        return 1;
+    }
+
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+    auto start = tlib::ms_time();
+
+    sock.connect(tlib::ip::make_address(127, 0, 0, 1), LOOPBACK_PORT);
+
+    if (!sock) {
+        tlib::printf("tcpbench: connect error: %s\n", std::error_message(sock.error()));
+        return 1;
+    }
+
+    if (!send_all(sock)) {
+        return 1;
+    }
+
+    auto sent_time = tlib::ms_time() - start;
+
+    tlib::join(*t);
+
+    sock.disconnect();
+
+    if (server_error) {
+        return 1;
+    }
+
+    display_result("send", total, sent_time);
+    display_result("receive", received, receive_time);
+
+    return 0;
+}
+
+int remote(const tlib::ip::address& server, size_t port){
+    tlib::printf("tcpbench: transfer %u bytes to port %u\n", total, port);
+
+    tlib::socket sock(tlib::socket_domain::AF_INET, tlib::socket_type::STREAM, tlib::socket_protocol::TCP);
+
+    sock.connect(server, port);
+
+    if (!sock) {
+        tlib::printf("tcpbench: connect error: %s\n", std::error_message(sock.error()));
+        return 1;
+    }
+
+    auto start = tlib::ms_time();
+
+    if (!send_all(sock)) {
+        return 1;
+    }
+
+    // The disconnection waits for all the data to be acknowledged
+    sock.disconnect();
+
+    auto end = tlib::ms_time();
+
+    if (!sock) {
+        tlib::printf("tcpbench: disconnect error: %s\n", std::error_message(sock.error()));
+        return 1;
+    }
+
+    display_result("send", total, end - start);
+
+    return 0;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if (argc == 2 || argc == 4) {
+        total = std::atoui(argv[argc - 1]) * 1024;
+
+        if (!total) {
+            tlib::print_line("tcpbench: the size must be positive");
+            return 1;
+        }
+    }
+
+    if (argc == 1 || argc == 2) {
+        return loopback();
+    }
+
+    if (argc == 3 || argc == 4) {
+        std::string server(argv[1]);
+
+        auto port = std::atoui(argv[2]);
+
+        auto ip_parts = std::split(server, '.');
+
+        if (ip_parts.size() != 4) {
+            tlib::print_line("Invalid address IP for the server");
+            return 1;
+        }
+
+        auto server_ip = tlib::ip::make_address(std::atoui(ip_parts[0]), std::atoui(ip_parts[1]), std::atoui(ip_parts[2]), std::atoui(ip_parts[3]));
+
+        return remote(server_ip, port);
+    }
+
+    tlib::print_line("usage: tcpbench [KB]");
+    tlib::print_line("       tcpbench server port [KB]");
+
+    return 1;
+}
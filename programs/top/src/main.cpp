@@ -0,0 +1,280 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <vector.hpp>
+#include <string.hpp>
+
+#include <tlib/file.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/print.hpp>
+#include <tlib/directory_entry.hpp>
+
+namespace {
+
+static constexpr const size_t BUFFER_SIZE   = 4096;
+static constexpr const size_t DEFAULT_DELAY = 1000;
+
+struct process_sample {
+    uint64_t pid;
+    std::string name;
+    uint64_t state;
+    uint64_t user_ticks;
+    uint64_t kernel_ticks;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t read_bytes;
+    uint64_t written_bytes;
+    uint64_t packets_sent;
+    uint64_t packets_received;
+};
+
+struct process_delta {
+    const process_sample* sample;
+    uint64_t ticks;
+    uint64_t switches;
+    uint64_t read_bytes;
+    uint64_t written_bytes;
+    uint64_t packets;
+};
+
+std::string read_file(const std::string& path){
+    std::string value;
+
+    auto fd = tlib::open(path.c_str());
+
+    if(fd){
+        char buffer[64];
+
+        auto result = tlib::read(*fd, buffer, 63);
+
+        if(result){
+            buffer[*result] = '\0';
+            value = buffer;
+        }
+
+        tlib::close(*fd);
+    }
+
+    return value;
+}
+
+const char* state_str(uint64_t state){
+    switch(state){
+        case 1:
+            return "NEW";
+        case 2:
+            return "READY";
+        case 3:
+            return "RUNNING";
+        case 4:
+        case 8:
+            return "BLOCKED";
+        case 5:
+            return "SLEEPING";
+        case 6:
+            return "WAITING";
+        case 7:
+            return "KILLED";
+        case 9:
+            return "ZOMBIE";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+std::vector<process_sample> sample_processes(char* entries_buffer){
+    std::vector<process_sample> samples;
+
+    auto fd = tlib::open("/proc/");
+
+    if(!fd){
+        tlib::printf("top: error: %s\n", std::error_message(fd.error()));
+        return samples;
+    }
+
+    auto entries_result = tlib::entries(*fd, entries_buffer, BUFFER_SIZE);
+
+    tlib::close(*fd);
+
+    if(!entries_result){
+        tlib::printf("top: error: %s\n", std::error_message(entries_result.error()));
+        return samples;
+    }
+
+    size_t position = 0;
+
+    while(true){
+        auto entry = reinterpret_cast<tlib::directory_entry*>(entries_buffer + position);
+
+        std::string base_path = std::string("/proc/") + &entry->name;
+
+        process_sample sample;
+        sample.pid                  = parse(read_file(base_path + "/pid"));
+        sample.name                 = read_file(base_path + "/name");
+        sample.state                = parse(read_file(base_path + "/state"));
+        sample.user_ticks           = parse(read_file(base_path + "/user_ticks"));
+        sample.kernel_ticks         = parse(read_file(base_path + "/kernel_ticks"));
+        sample.voluntary_switches   = parse(read_file(base_path + "/voluntary_switches"));
+        sample.involuntary_switches = parse(read_file(base_path + "/involuntary_switches"));
+        sample.read_bytes           = parse(read_file(base_path + "/read_bytes"));
+        sample.written_bytes        = parse(read_file(base_path + "/written_bytes"));
+        sample.packets_sent         = parse(read_file(base_path + "/packets_sent"));
+        sample.packets_received     = parse(read_file(base_path + "/packets_received"));
+
+        samples.push_back(sample);
+
+        if(!entry->offset_next){
+            break;
+        }
+
+        position += entry->offset_next;
+    }
+
+    return samples;
+}
+
+const process_sample* find(const std::vector<process_sample>& samples, const process_sample& sample){
+    for(auto& previous : samples){
+        // A pid can be reused by a new process
+        if(previous.pid == sample.pid && previous.name == sample.name){
+            return &previous;
+        }
+    }
+
+    return nullptr;
+}
+
+void display(const std::vector<process_sample>& previous, const std::vector<process_sample>& current, uint64_t elapsed_ms, size_t rows){
+    std::vector<process_delta> deltas;
+
+    uint64_t total_ticks = 0;
+
+    for(auto& sample : current){
+        process_delta delta;
+        delta.sample        = &sample;
+        delta.ticks         = sample.user_ticks + sample.kernel_ticks;
+        delta.switches      = sample.voluntary_switches + sample.involuntary_switches;
+        delta.read_bytes    = sample.read_bytes;
+        delta.written_bytes = sample.written_bytes;
+        delta.packets       = sample.packets_sent + sample.packets_received;
+
+        if(auto* before = find(previous, sample)){
+            delta.ticks         -= before->user_ticks + before->kernel_ticks;
+            delta.switches      -= before->voluntary_switches + before->involuntary_switches;
+            delta.read_bytes    -= before->read_bytes;
+            delta.written_bytes -= before->written_bytes;
+            delta.packets       -= before->packets_sent + before->packets_received;
+        }
+
+        total_ticks += delta.ticks;
+
+        // Insertion by decreasing CPU usage
+        size_t i = deltas.size();
+        deltas.push_back(delta);
+
+        while(i > 0 && deltas[i - 1].ticks < deltas[i].ticks){
+            std::swap(deltas[i - 1], deltas[i]);
+            --i;
+        }
+    }
+
+    if(!total_ticks){
+        total_ticks = 1;
+    }
+
+    if(!elapsed_ms){
+        elapsed_ms = 1;
+    }
+
+    tlib::clear();
+
+    tlib::printf("top - %u processes, refreshed every %ums (q to quit)\n\n", current.size(), elapsed_ms);
+    tlib::print_line("PID  CPU%  State    Switch/s  Read/s    Write/s   Packet/s  Name");
+
+    size_t lines = 0;
+
+    for(auto& delta : deltas){
+        // Keep the header and the prompt on the screen
+        if(rows > 4 && lines == rows - 4){
+            break;
+        }
+
+        auto& sample = *delta.sample;
+
+        tlib::printf("%5u%6u%9s%10u%10m%10m%10u%s\n",
+            sample.pid,
+            100 * delta.ticks / total_ticks,
+            state_str(sample.state),
+            1000 * delta.switches / elapsed_ms,
+            1000 * delta.read_bytes / elapsed_ms,
+            1000 * delta.written_bytes / elapsed_ms,
+            1000 * delta.packets / elapsed_ms,
+            sample.name.c_str());
+
+        ++lines;
+    }
+}
+
+// Wait for the given time, return false if the user wants to quit
+bool wait(size_t delay){
+    auto end = tlib::ms_time() + delay;
+
+    while(true){
+        auto now = tlib::ms_time();
+
+        if(now >= end){
+            return true;
+        }
+
+        auto code = tlib::read_input_raw(end - now);
+
+        if(code == std::keycode::PRESSED_Q || code == std::keycode::PRESSED_ESC){
+            return false;
+        }
+    }
+}
+
+} // end of anonymous space
+
+int main(int argc, char* argv[]){
+    size_t delay = DEFAULT_DELAY;
+
+    if(argc > 1){
+        delay = std::atoui(argv[1]);
+
+        if(!delay){
+            tlib::print_line("usage: top [delay_ms]");
+            return 1;
+        }
+    }
+
+    auto entries_buffer = new char[BUFFER_SIZE];
+
+    tlib::set_canonical(false);
+
+    auto rows = tlib::get_rows();
+
+    auto previous = sample_processes(entries_buffer);
+    auto before   = tlib::ms_time();
+
+    while(wait(delay)){
+        auto current = sample_processes(entries_buffer);
+        auto now     = tlib::ms_time();
+
+        display(previous, current, now - before, rows);
+
+        previous = std::move(current);
+        before   = now;
+    }
+
+    tlib::set_canonical(true);
+
+    delete[] entries_buffer;
+
+    return 0;
+}
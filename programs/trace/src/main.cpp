@@ -0,0 +1,166 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <string.hpp>
+
+#include <tlib/file.hpp>
+#include <tlib/system.hpp>
+#include <tlib/errors.hpp>
+#include <tlib/print.hpp>
+#include <tlib/flags.hpp>
+
+namespace {
+
+constexpr const size_t ALL_EVENTS = 63; ///< All the categories of tracepoints
+
+void usage(){
+    tlib::print_line("usage: trace start [mask] | stop | status | dump file");
+    tlib::print_line("  mask: 1:sched 2:syscall 4:irq 8:block 16:net 32:fault (default: all)");
+}
+
+bool write_value(const char* file, const std::string& value){
+    auto fd = tlib::open(file);
+
+    if(!fd){
+        tlib::printf("trace: error: %s\n", std::error_message(fd.error()));
+        return false;
+    }
+
+    auto result = tlib::write(*fd, value.c_str(), value.size());
+
+    tlib::close(*fd);
+
+    if(!result){
+        tlib::printf("trace: error: %s\n", std::error_message(result.error()));
+        return false;
+    }
+
+    return true;
+}
+
+std::string read_value(const char* file){
+    std::string value;
+
+    auto fd = tlib::open(file);
+
+    if(fd){
+        char buffer[64];
+
+        auto result = tlib::read(*fd, buffer, 64);
+
+        if(result){
+            for(size_t i = 0; i < *result; ++i){
+                value += buffer[i];
+            }
+        }
+
+        tlib::close(*fd);
+    }
+
+    return value;
+}
+
+int dump(const char* file){
+    // The ring must not move while it is read
+    if(!write_value("/sys/trace/enable", "0")){
+        return 1;
+    }
+
+    auto fd = tlib::open("/sys/trace/raw");
+
+    if(!fd){
+        tlib::printf("trace: error: %s\n", std::error_message(fd.error()));
+        return 1;
+    }
+
+    auto info = tlib::stat(*fd);
+
+    if(!info){
+        tlib::printf("trace: error: %s\n", std::error_message(info.error()));
+        tlib::close(*fd);
+        return 1;
+    }
+
+    auto size   = info->size;
+    auto buffer = new char[size];
+
+    auto read_result = tlib::read(*fd, buffer, size);
+
+    tlib::close(*fd);
+
+    if(!read_result){
+        tlib::printf("trace: error: %s\n", std::error_message(read_result.error()));
+        delete[] buffer;
+        return 1;
+    }
+
+    auto out = tlib::open(file, std::OPEN_CREATE);
+
+    if(!out){
+        tlib::printf("trace: error: %s\n", std::error_message(out.error()));
+        delete[] buffer;
+        return 1;
+    }
+
+    int code = 0;
+
+    auto truncate_result = tlib::truncate(*out, *read_result);
+
+    if(truncate_result){
+        auto write_result = tlib::write(*out, buffer, *read_result, 0);
+
+        if(write_result){
+            tlib::printf("trace: %u bytes written to %s\n", *read_result, file);
+        } else {
+            tlib::printf("trace: error: %s\n", std::error_message(write_result.error()));
+            code = 1;
+        }
+    } else {
+        tlib::printf("trace: error: %s\n", std::error_message(truncate_result.error()));
+        code = 1;
+    }
+
+    tlib::close(*out);
+
+    delete[] buffer;
+
+    return code;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        usage();
+        return 1;
+    }
+
+    std::string command(argv[1]);
+
+    if(command == "start"){
+        auto mask = argc > 2 ? std::atoui(argv[2]) : ALL_EVENTS;
+
+        if(!mask){
+            usage();
+            return 1;
+        }
+
+        return write_value("/sys/trace/enable", std::to_string(mask)) ? 0 : 1;
+    } else if(command == "stop"){
+        return write_value("/sys/trace/enable", "0") ? 0 : 1;
+    } else if(command == "status"){
+        tlib::printf("enabled: %s\n", read_value("/sys/trace/enable").c_str());
+        tlib::printf("records: %s\n", read_value("/sys/trace/records").c_str());
+        tlib::printf("lost: %s\n", read_value("/sys/trace/lost").c_str());
+        return 0;
+    } else if(command == "dump" && argc == 3){
+        return dump(argv[2]);
+    }
+
+    usage();
+    return 1;
+}
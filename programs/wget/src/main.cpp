@@ -73,19 +73,32 @@ int wget_http(const std::string& url){
 
         sock.send(message.c_str(), message.size());
 
-        char message_buffer[2049];
-        auto size = sock.receive(message_buffer, 2048, 2000);
-        if (!sock) {
-            if (sock.error() == std::ERROR_SOCKET_TIMEOUT) {
-                tlib::printf("Timeout\n");
+        // Read the stream until the server stops sending
+
+        char message_buffer[4097];
+        size_t total = 0;
+
+        while (true) {
+            auto size = sock.receive(message_buffer, 4096, 2000);
+            if (!sock) {
+                if (sock.error() == std::ERROR_SOCKET_TIMEOUT && !total) {
+                    tlib::printf("Timeout\n");
+                    return 1;
+                }
+
+                if (sock.error() == std::ERROR_SOCKET_TIMEOUT || sock.error() == std::ERROR_SOCKET_NOT_CONNECTED) {
+                    sock.clear();
+                    break;
+                }
+
+                tlib::printf("nc: receive error: %s\n", std::error_message(sock.error()));
                 return 1;
             }
 
-            tlib::printf("nc: receive error: %s\n", std::error_message(sock.error()));
-            return 1;
-        } else {
             message_buffer[size] = '\0';
             tlib::print(message_buffer);
+
+            total += size;
         }
 
         sock.listen(false);
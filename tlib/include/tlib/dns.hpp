@@ -22,7 +22,20 @@ namespace dns {
 std::string decode_domain(char* payload, size_t& offset);
 std::expected<void> send_request(tlib::socket& sock, const std::string& domain, uint16_t rr_type = 0x1, uint16_t rr_class = 0x1);
 
+/*!
+ * \brief Resolve the address of a domain through the DNS cache of the kernel
+ * \param domain The domain to resolve
+ * \param timeout The time to wait for each query, on a cache miss
+ * \param retries The number of queries to send before giving up
+ */
 std::expected<tlib::ip::address> resolve(const std::string& domain, size_t timeout = 1000, size_t retries = 1);
+
+/*!
+ * \brief Resolve the address of a domain through the DNS cache of the kernel,
+ * querying the given server on a cache miss
+ */
+std::expected<tlib::ip::address> resolve_from(const std::string& domain, tlib::ip::address server, size_t timeout = 1000, size_t retries = 1);
+
 std::expected<std::string> resolve_str(const std::string& domain, size_t timeout = 1000, size_t retries = 1);
 
 tlib::ip::address gateway_address();
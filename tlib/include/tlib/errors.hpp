@@ -45,6 +45,9 @@ constexpr const size_t ERROR_SOCKET_INVALID_TYPE_PROTOCOL     = 30;
 constexpr const size_t ERROR_SOCKET_NOT_CONNECTED             = 31;
 constexpr const size_t ERROR_SOCKET_INVALID_CONNECTION        = 32;
 constexpr const size_t ERROR_SOCKET_TCP_ERROR        = 33;
+constexpr const size_t ERROR_WOULD_BLOCK                      = 34;
+constexpr const size_t ERROR_TIMEOUT                          = 35;
+constexpr const size_t ERROR_BUSY                             = 36;
 
 inline const char* error_message(size_t error){
     switch(error){
@@ -114,6 +117,12 @@ inline const char* error_message(size_t error){
             return "Issue with the internal connection";
         case ERROR_SOCKET_TCP_ERROR:
             return "TCP packet was not acknowledged";
+        case ERROR_WOULD_BLOCK:
+            return "The operation would block";
+        case ERROR_TIMEOUT:
+            return "Timeout";
+        case ERROR_BUSY:
+            return "The resource is busy";
         default:
             return "Unknonwn error";
     }
@@ -131,6 +131,66 @@ std::expected<size_t> receive_from(size_t socket_fd, char* buffer, size_t n, voi
  */
 std::expected<size_t> receive_from(size_t socket_fd, char* buffer, size_t n, size_t ms, void* address);
 
+/*!
+ * \brief Send several datagrams to the connected server, with a single system call
+ * \param socket_fd The socket file descriptor
+ * \param datagrams The datagrams to send
+ * \param n The number of datagrams
+ * \return the number of sent datagrams, or an error if none was sent
+ */
+std::expected<size_t> send_many(size_t socket_fd, datagram* datagrams, size_t n);
+
+/*!
+ * \brief Send several datagrams, each to its address, with a single system call
+ * \param socket_fd The socket file descriptor
+ * \param datagrams The datagrams to send
+ * \param n The number of datagrams
+ * \return the number of sent datagrams, or an error if none was sent
+ */
+std::expected<size_t> send_many_to(size_t socket_fd, datagram* datagrams, size_t n);
+
+/*!
+ * \brief Receive several datagrams with a single system call, waiting
+ * indefinitely for the first one
+ * \param socket_fd The socket file descriptor
+ * \param datagrams The datagrams to fill
+ * \param n The maximum number of datagrams
+ * \return the number of received datagrams, or an error
+ */
+std::expected<size_t> receive_many(size_t socket_fd, datagram* datagrams, size_t n);
+
+/*!
+ * \brief Receive several datagrams with a single system call, waiting at
+ * most ms milliseconds for the first one
+ * \param socket_fd The socket file descriptor
+ * \param datagrams The datagrams to fill
+ * \param n The maximum number of datagrams
+ * \param ms The maximum time to wait
+ * \return the number of received datagrams, or an error
+ */
+std::expected<size_t> receive_many(size_t socket_fd, datagram* datagrams, size_t n, size_t ms);
+
+/*!
+ * \brief Create the packet ring of the socket and map it in the process
+ * \param socket_fd The socket file descriptor
+ * \return the header of the ring, or an error
+ */
+std::expected<packet_ring_header*> open_ring(size_t socket_fd);
+
+/*!
+ * \brief Send the slots of the packet ring that were filled since the last call
+ * \param socket_fd The socket file descriptor
+ * \return the number of sent slots, or an error if none was sent
+ */
+std::expected<size_t> ring_send(size_t socket_fd);
+
+/*!
+ * \brief Wait until the packet ring of the socket has a free slot
+ * \param socket_fd The socket file descriptor
+ * \return nothing, or an error
+ */
+std::expected<void> ring_wait(size_t socket_fd);
+
 /*!
  * \brief Listen for messages on the socket
  * \param socket_fd The socket file descriptor
@@ -274,6 +334,11 @@ struct socket {
      */
     bool bound() const;
 
+    /*!
+     * \brief Returns the file descriptor of the socket
+     */
+    size_t get_fd() const;
+
     /*!
      * \brief Indicates if everything is in order
      * \return true if everything is good, false otherwise
@@ -413,6 +478,57 @@ struct socket {
      */
     size_t receive_from(char* buffer, size_t n, size_t ms, void* address);
 
+    /*!
+     * \brief Send several datagrams to the connected server
+     * \return The number of sent datagrams
+     */
+    size_t send_many(datagram* datagrams, size_t n);
+
+    /*!
+     * \brief Send several datagrams, each to its address
+     * \return The number of sent datagrams
+     */
+    size_t send_many_to(datagram* datagrams, size_t n);
+
+    /*!
+     * \brief Receive several datagrams, waiting indefinitely for the first one
+     * \return The number of received datagrams
+     */
+    size_t receive_many(datagram* datagrams, size_t n);
+
+    /*!
+     * \brief Receive several datagrams, waiting at most ms milliseconds for the first one
+     * \return The number of received datagrams
+     */
+    size_t receive_many(datagram* datagrams, size_t n, size_t ms);
+
+    /*!
+     * \brief Map a packet ring for the socket, to send many packets with one system call
+     * \return true if the ring is ready, false otherwise
+     */
+    bool open_ring();
+
+    /*!
+     * \brief Returns the buffer of the next slot of the packet ring, waiting
+     * for the kernel to release a slot if the ring is full.
+     *
+     * At most packet_ring_max_payload bytes can be written in the buffer.
+     *
+     * \return the buffer of the next slot, nullptr if there is an error
+     */
+    char* ring_buffer();
+
+    /*!
+     * \brief Mark the next slot of the packet ring as filled with n bytes
+     */
+    void ring_commit(size_t n);
+
+    /*!
+     * \brief Send all the filled slots of the packet ring
+     * \return The number of sent slots
+     */
+    size_t ring_send();
+
     /*!
      * \brief Wait for a packet, indefinitely.
      * \return the received packet
@@ -436,6 +552,7 @@ private:
     size_t error_code;        ///< The error code
     bool _connected;          ///< Connection flag
     bool _bound;              ///< Bind flag
+    packet_ring_header* ring; ///< The packet ring (optional)
 };
 
 /*!
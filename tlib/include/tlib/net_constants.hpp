@@ -75,6 +75,16 @@ struct inet_address {
     size_t port;
 };
 
+/*!
+ * \brief A datagram of a batched send or receive
+ */
+struct datagram {
+    char* buffer;         ///< The payload
+    size_t size;          ///< The size of the payload (the capacity of the buffer when receiving)
+    size_t received;      ///< The size of the received payload
+    inet_address address; ///< The target address (when sending to) or the source address (when receiving)
+};
+
 namespace ethernet {
 
 struct address {
@@ -214,6 +224,27 @@ struct packet_descriptor {
 
 } // end of tcp namespace
 
+constexpr const size_t packet_ring_slots       = 32;   ///< The number of slots of a packet ring
+constexpr const size_t packet_ring_slot_size   = 2048; ///< The size of a slot of a packet ring
+constexpr const size_t packet_ring_headroom    = 128;  ///< The offset of the payload inside a slot
+constexpr const size_t packet_ring_max_payload = packet_ring_slot_size - packet_ring_headroom; ///< The maximum payload of a slot
+constexpr const size_t packet_ring_slots_offset = 4096; ///< The offset of the first slot (after the header)
+constexpr const size_t packet_ring_size = packet_ring_slots_offset + packet_ring_slots * packet_ring_slot_size; ///< The size of a packet ring
+
+/*!
+ * \brief The header of a packet ring, shared between a process and the kernel.
+ *
+ * The process writes the payload of the slot head % packet_ring_slots at
+ * packet_ring_headroom, sets its size and increments head. The kernel copies
+ * the payload of a slot when it is sent and increments tail right away, the
+ * slot can then be reused by the process.
+ */
+struct packet_ring_header {
+    volatile uint64_t head;                     ///< The number of slots filled by the process
+    volatile uint64_t tail;                     ///< The number of slots consumed by the kernel
+    volatile uint32_t sizes[packet_ring_slots]; ///< The size of the payload of each slot
+};
+
 enum class socket_domain : size_t {
     AF_INET
 };
@@ -0,0 +1,88 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+/*!
+ * \file
+ * \brief Readiness multiplexing of sockets and files
+ *
+ * A poll set contains sockets and files. A wait on the set returns once at
+ * least one of them is ready. By default, the readiness is level-triggered:
+ * a descriptor is reported as long as it is ready. With POLL_EDGE, it is only
+ * reported again once new data arrived.
+ */
+
+#ifndef TLIB_POLL_H
+#define TLIB_POLL_H
+
+#include <expected.hpp>
+
+#include "tlib/poll_constants.hpp"
+#include "tlib/config.hpp"
+
+ASSERT_ONLY_THOR_PROGRAM
+
+namespace tlib {
+
+/*!
+ * \brief Create a new poll set
+ * \return The file descriptor of the poll set, or an error
+ */
+std::expected<size_t> poll_create();
+
+/*!
+ * \brief Close the given poll set
+ */
+std::expected<void> poll_close(size_t set_fd);
+
+/*!
+ * \brief Add a descriptor to the poll set
+ * \param set_fd The poll set file descriptor
+ * \param target The kind of descriptor
+ * \param fd The descriptor
+ * \param events The events of interest (POLL_IN, POLL_OUT and POLL_EDGE)
+ */
+std::expected<void> poll_add(size_t set_fd, poll_target target, size_t fd, size_t events);
+
+/*!
+ * \brief Change the events of interest of a descriptor of the poll set
+ * \param set_fd The poll set file descriptor
+ * \param target The kind of descriptor
+ * \param fd The descriptor
+ * \param events The events of interest (POLL_IN, POLL_OUT and POLL_EDGE)
+ */
+std::expected<void> poll_modify(size_t set_fd, poll_target target, size_t fd, size_t events);
+
+/*!
+ * \brief Remove a descriptor from the poll set
+ * \param set_fd The poll set file descriptor
+ * \param target The kind of descriptor
+ * \param fd The descriptor
+ */
+std::expected<void> poll_remove(size_t set_fd, poll_target target, size_t fd);
+
+/*!
+ * \brief Wait, indefinitely, until at least one descriptor is ready
+ * \param set_fd The poll set file descriptor
+ * \param events The array of ready descriptors to fill
+ * \param max The capacity of the array
+ * \return The number of ready descriptors, or an error
+ */
+std::expected<size_t> poll_wait(size_t set_fd, poll_event* events, size_t max);
+
+/*!
+ * \brief Wait, at most ms milliseconds, until at least one descriptor is ready
+ * \param set_fd The poll set file descriptor
+ * \param events The array of ready descriptors to fill
+ * \param max The capacity of the array
+ * \param ms The timeout (0 returns immediately)
+ * \return The number of ready descriptors (0 on timeout), or an error
+ */
+std::expected<size_t> poll_wait(size_t set_fd, poll_event* events, size_t max, size_t ms);
+
+} // end of namespace tlib
+
+#endif
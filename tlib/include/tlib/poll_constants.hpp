@@ -0,0 +1,50 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef TLIB_POLL_CONSTANTS_H
+#define TLIB_POLL_CONSTANTS_H
+
+#include <types.hpp>
+
+#include "tlib/config.hpp"
+
+THOR_NAMESPACE(tlib, poll) {
+
+constexpr const size_t POLL_IN   = 1 << 0; ///< Data can be read (or a connection accepted)
+constexpr const size_t POLL_OUT  = 1 << 1; ///< Data can be written
+constexpr const size_t POLL_HUP  = 1 << 2; ///< The connection was closed (always reported)
+constexpr const size_t POLL_EDGE = 1 << 8; ///< Only report new readiness (edge-triggered)
+
+/*!
+ * \brief The kind of a descriptor in a poll set
+ */
+enum class poll_target : size_t {
+    SOCKET = 0, ///< A socket
+    FILE   = 1  ///< A file handle
+};
+
+/*!
+ * \brief The operations on a poll set
+ */
+enum class poll_operation : size_t {
+    ADD    = 0, ///< Add a descriptor to the set
+    MODIFY = 1, ///< Change the events of a descriptor of the set
+    REMOVE = 2  ///< Remove a descriptor from the set
+};
+
+/*!
+ * \brief A ready descriptor, as returned by a wait on a poll set
+ */
+struct poll_event {
+    poll_target target; ///< The kind of descriptor
+    size_t fd;          ///< The descriptor
+    size_t events;      ///< The ready events
+};
+
+} // end of namespace poll
+
+#endif
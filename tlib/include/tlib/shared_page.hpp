@@ -0,0 +1,51 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef TLIB_SHARED_PAGE_H
+#define TLIB_SHARED_PAGE_H
+
+#include <types.hpp>
+
+#include "tlib/config.hpp"
+
+THOR_NAMESPACE(tlib, shared_page) {
+
+constexpr const size_t shared_page_address = 0x8000100000; ///< The virtual address of the shared page in every process
+
+/*!
+ * \brief The data the kernel shares, read-only, with all the processes.
+ *
+ * The time values are updated by the kernel at each timer tick, the other
+ * values do not change after boot.
+ */
+struct shared_data {
+    uint64_t ticks;             ///< The number of timer ticks since boot
+    uint64_t counter;           ///< The value of the timer counter at the last tick
+    uint64_t milliseconds;      ///< The uptime in milliseconds
+    uint64_t seconds;           ///< The uptime in seconds
+    uint64_t counter_frequency; ///< The frequency of the timer counter, in Hz
+    uint64_t timer_frequency;   ///< The frequency of the timer ticks, in Hz
+
+    uint64_t columns; ///< The number of columns of the terminals
+    uint64_t rows;    ///< The number of rows of the terminals
+
+    uint64_t vesa_width;               ///< The width of the VESA screen
+    uint64_t vesa_height;              ///< The height of the VESA screen
+    uint64_t vesa_x_shift;             ///< The x shift of the VESA screen
+    uint64_t vesa_y_shift;             ///< The y shift of the VESA screen
+    uint64_t vesa_bytes_per_scan_line; ///< The number of bytes per scan line of the VESA screen
+    uint64_t vesa_red_shift;           ///< The shift of the red component
+    uint64_t vesa_green_shift;         ///< The shift of the green component
+    uint64_t vesa_blue_shift;          ///< The shift of the blue component
+
+    char cpu_vendor[16];    ///< The vendor string of the processor
+    uint32_t cpu_signature; ///< The family, model and stepping of the processor (CPUID 1)
+};
+
+} // end of namespace shared_page
+
+#endif
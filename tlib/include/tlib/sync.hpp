@@ -0,0 +1,143 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+/*!
+ * \file
+ * \brief Synchronization primitives for the threads of a program
+ *
+ * All the primitives are built on futexes. When there is no contention, they
+ * only use atomic instructions and never enter the kernel.
+ */
+
+#ifndef TLIB_SYNC_H
+#define TLIB_SYNC_H
+
+#include <types.hpp>
+#include <expected.hpp>
+
+#include "tlib/config.hpp"
+
+ASSERT_ONLY_THOR_PROGRAM
+
+namespace tlib {
+
+/*!
+ * \brief Block the current thread if the word at the given address still
+ * contains the given value, until it is woken up.
+ * \param address The address of the word
+ * \param value The expected value of the word
+ * \param ms The timeout in milliseconds (0 means no timeout)
+ * \return nothing or an error (ERROR_WOULD_BLOCK if the value changed, ERROR_TIMEOUT if the timeout passed,
+ * ERROR_BUSY if there is no free wait queue)
+ */
+std::expected<void> futex_wait(volatile uint32_t* address, uint32_t value, size_t ms = 0);
+
+/*!
+ * \brief Wake up threads waiting on the given address
+ * \param address The address of the word
+ * \param n The maximum number of threads to wake up
+ * \return The number of threads woken up or an error
+ */
+std::expected<size_t> futex_wake(volatile uint32_t* address, size_t n);
+
+/*!
+ * \brief A mutual exclusion lock
+ */
+struct mutex {
+    /*!
+     * \brief Acquire the lock
+     */
+    void lock();
+
+    /*!
+     * \brief Try to acquire the lock, without waiting
+     * \return true if the lock was acquired, false otherwise
+     */
+    bool try_lock();
+
+    /*!
+     * \brief Release the lock
+     */
+    void unlock();
+
+private:
+    void lock_contended();
+
+    volatile uint32_t state = 0; ///< 0: unlocked, 1: locked, 2: locked with waiters
+
+    friend struct condition_variable;
+};
+
+/*!
+ * \brief A condition variable, to be used with a tlib::mutex
+ */
+struct condition_variable {
+    /*!
+     * \brief Release the mutex and wait until notified. The mutex is
+     * acquired again before returning.
+     *
+     * As with any condition variable, spurious wake ups are possible.
+     */
+    void wait(mutex& m);
+
+    /*!
+     * \brief Release the mutex and wait until notified or until the timeout
+     * is passed. The mutex is acquired again before returning.
+     *
+     * \return true if the thread was notified, false if the timeout is passed
+     */
+    bool wait_for(mutex& m, size_t ms);
+
+    /*!
+     * \brief Wake up one waiting thread
+     */
+    void notify_one();
+
+    /*!
+     * \brief Wake up all the waiting threads
+     */
+    void notify_all();
+
+private:
+    volatile uint32_t sequence = 0; ///< Incremented on each notification
+    volatile uint32_t waiters  = 0; ///< The number of waiting threads
+};
+
+/*!
+ * \brief A counting semaphore
+ */
+struct semaphore {
+    /*!
+     * \brief Construct a new semaphore
+     * \param v The initial value of the semaphore
+     */
+    explicit semaphore(uint32_t v = 0) : value(v) {}
+
+    /*!
+     * \brief Decrease the value of the semaphore, waiting for it to be positive
+     */
+    void wait();
+
+    /*!
+     * \brief Try to decrease the value of the semaphore, without waiting
+     * \return true if the value was decreased, false otherwise
+     */
+    bool try_wait();
+
+    /*!
+     * \brief Increase the value of the semaphore
+     */
+    void post();
+
+private:
+    volatile uint32_t value;       ///< The value of the semaphore
+    volatile uint32_t waiters = 0; ///< The number of waiting threads
+};
+
+} // end of namespace tlib
+
+#endif
@@ -0,0 +1,32 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef TLIB_SYSCALL_H
+#define TLIB_SYSCALL_H
+
+#include "tlib/config.hpp"
+
+ASSERT_ONLY_THOR_PROGRAM
+
+/*
+ * The system calls are entered with the SYSCALL instruction. The number is
+ * in rax and the parameters in rbx, rcx, rdx, rsi and rdi, exactly as with
+ * the int 50 gate. Since SYSCALL overwrites rcx (return address) and r11
+ * (flags), the third parameter is passed to the kernel in r10 and the three
+ * registers are preserved around the instruction. This way, the inline
+ * assembly of the callers does not change.
+ */
+
+#define TLIB_SYSCALL "push rcx; push r10; push r11; mov r10, rcx; syscall; pop r11; pop r10; pop rcx; "
+
+/*
+ * The legacy interrupt gate, only kept to measure the difference.
+ */
+
+#define TLIB_SYSCALL_INTERRUPT "int 50; "
+
+#endif
@@ -15,6 +15,7 @@
 
 #include "tlib/datetime.hpp"
 #include "tlib/config.hpp"
+#include "tlib/shared_page.hpp"
 
 ASSERT_ONLY_THOR_PROGRAM
 
@@ -34,11 +35,29 @@ datetime local_date();
 void reboot(unsigned int delay = 0);
 void shutdown(unsigned int delay = 0);
 
+/*!
+ * \brief Returns the page the kernel shares (read-only) with all the processes
+ */
+inline const volatile shared_data& shared(){
+    return *reinterpret_cast<const volatile shared_data*>(shared_page_address);
+}
+
 uint64_t s_time();
 uint64_t ms_time();
 
 void alpha();
 
+/*!
+ * \brief Enter the kernel and return without doing anything
+ */
+void null_call();
+
+/*!
+ * \brief Enter the kernel through the legacy interrupt gate and return
+ * without doing anything
+ */
+void null_call_interrupt();
+
 } // end of tlib namespace
 
 #endif
@@ -0,0 +1,69 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+/*!
+ * \file
+ * \brief Threads support for the Thor OS
+ *
+ * The threads of a process share its address space, its file handles and its
+ * sockets. Each thread is scheduled independently by the kernel.
+ */
+
+#ifndef TLIB_THREAD_H
+#define TLIB_THREAD_H
+
+#include <types.hpp>
+#include <expected.hpp>
+
+#include "tlib/config.hpp"
+
+ASSERT_ONLY_THOR_PROGRAM
+
+namespace tlib {
+
+constexpr const size_t DEFAULT_THREAD_STACK = 16 * 1024; ///< The default size of a thread stack
+
+using thread_fun = void (*)(void*);
+
+/*!
+ * \brief A thread of the current process
+ */
+struct thread {
+    size_t tid;  ///< The thread id
+    char* stack; ///< The stack of the thread
+};
+
+/*!
+ * \brief Create a new thread executing the given function
+ * \param fun The function to execute
+ * \param data The data to pass to the function
+ * \param stack_size The size of the stack of the thread
+ * \return The thread or an error
+ */
+std::expected<thread> create_thread(thread_fun fun, void* data, size_t stack_size = DEFAULT_THREAD_STACK);
+
+/*!
+ * \brief Wait for the given thread to terminate and release its stack.
+ *
+ * A thread can only be joined by the thread that created it.
+ *
+ * \param t The thread to wait for
+ * \return Nothing or an error if the thread cannot be joined by the current thread
+ */
+std::expected<void> join(thread& t);
+
+/*!
+ * \brief Terminate the current thread.
+ *
+ * When the function of a thread returns, the thread is automatically
+ * terminated.
+ */
+void exit_thread() __attribute__((noreturn));
+
+} // end of namespace tlib
+
+#endif
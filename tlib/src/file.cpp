@@ -6,10 +6,11 @@
 //=======================================================================
 
 #include "tlib/file.hpp"
+#include "tlib/syscall.hpp"
 
 std::expected<size_t> tlib::open(const char* file, size_t flags){
     int64_t fd;
-    asm volatile("mov rax, 0x300; mov rbx, %[path]; mov rcx, %[flags]; int 50; mov %[fd], rax"
+    asm volatile("mov rax, 0x300; mov rbx, %[path]; mov rcx, %[flags]; " TLIB_SYSCALL "mov %[fd], rax"
         : [fd] "=m" (fd)
         : [path] "g" (reinterpret_cast<size_t>(file)), [flags] "g" (flags)
         : "rax", "rbx", "rcx");
@@ -23,7 +24,7 @@ std::expected<size_t> tlib::open(const char* file, size_t flags){
 
 int64_t tlib::mkdir(const char* file){
     int64_t result;
-    asm volatile("mov rax, 0x306; mov rbx, %[path]; int 50; mov %[result], rax"
+    asm volatile("mov rax, 0x306; mov rbx, %[path]; " TLIB_SYSCALL "mov %[result], rax"
         : [result] "=m" (result)
         : [path] "g" (reinterpret_cast<size_t>(file))
         : "rax", "rbx");
@@ -32,7 +33,7 @@ int64_t tlib::mkdir(const char* file){
 
 int64_t tlib::rm(const char* file){
     int64_t result;
-    asm volatile("mov rax, 0x307; mov rbx, %[path]; int 50; mov %[result], rax"
+    asm volatile("mov rax, 0x307; mov rbx, %[path]; " TLIB_SYSCALL "mov %[result], rax"
         : [result] "=m" (result)
         : [path] "g" (reinterpret_cast<size_t>(file))
         : "rax", "rbx");
@@ -40,7 +41,7 @@ int64_t tlib::rm(const char* file){
 }
 
 void tlib::close(size_t fd){
-    asm volatile("mov rax, 0x302; mov rbx, %[fd]; int 50;"
+    asm volatile("mov rax, 0x302; mov rbx, %[fd]; " TLIB_SYSCALL
         : /* No outputs */
         : [fd] "g" (fd)
         : "rax", "rbx");
@@ -50,7 +51,7 @@ std::expected<tlib::stat_info> tlib::stat(size_t fd){
     tlib::stat_info info;
 
     int64_t code;
-    asm volatile("mov rax, 0x301; mov rbx, %[fd]; mov rcx, %[buffer]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x301; mov rbx, %[fd]; mov rcx, %[buffer]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [buffer] "g" (reinterpret_cast<size_t>(&info))
         : "rax", "rbx", "rcx");
@@ -66,7 +67,7 @@ std::expected<tlib::statfs_info> tlib::statfs(const char* file){
     tlib::statfs_info info;
 
     int64_t code;
-    asm volatile("mov rax, 0x310; mov rbx, %[path]; mov rcx, %[buffer]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x310; mov rbx, %[path]; mov rcx, %[buffer]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [path] "g" (reinterpret_cast<size_t>(file)), [buffer] "g" (reinterpret_cast<size_t>(&info))
         : "rax", "rbx", "rcx");
@@ -80,7 +81,7 @@ std::expected<tlib::statfs_info> tlib::statfs(const char* file){
 
 std::expected<size_t> tlib::read(size_t fd, char* buffer, size_t max, size_t offset){
     int64_t code;
-    asm volatile("mov rax, 0x303; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x303; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [buffer] "g" (reinterpret_cast<size_t>(buffer)), [max] "g" (max), [offset] "g" (offset)
         : "rax", "rbx", "rcx", "rdx", "rsi");
@@ -93,7 +94,7 @@ std::expected<size_t> tlib::read(size_t fd, char* buffer, size_t max, size_t off
 }
 std::expected<size_t> tlib::read(size_t fd, char* buffer, size_t max, size_t offset, size_t ms){
     int64_t code;
-    asm volatile("mov rax, 0x315; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; mov rdi, %[ms]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x315; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; mov rdi, %[ms]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [buffer] "g" (reinterpret_cast<size_t>(buffer)), [max] "g" (max), [offset] "g" (offset), [ms] "g" (ms)
         : "rax", "rbx", "rcx", "rdx", "rsi", "rdi");
@@ -107,7 +108,7 @@ std::expected<size_t> tlib::read(size_t fd, char* buffer, size_t max, size_t off
 
 std::expected<size_t> tlib::write(size_t fd, const char* buffer, size_t max, size_t offset){
     int64_t code;
-    asm volatile("mov rax, 0x311; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x311; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; mov rsi, %[offset]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [buffer] "g" (reinterpret_cast<size_t>(buffer)), [max] "g" (max), [offset] "g" (offset)
         : "rax", "rbx", "rcx", "rdx", "rsi");
@@ -121,7 +122,7 @@ std::expected<size_t> tlib::write(size_t fd, const char* buffer, size_t max, siz
 
 std::expected<size_t> tlib::clear(size_t fd, size_t max, size_t offset){
     int64_t code;
-    asm volatile("mov rax, 0x313; mov rbx, %[fd]; mov rcx, %[max]; mov rdx, %[offset]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x313; mov rbx, %[fd]; mov rcx, %[max]; mov rdx, %[offset]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [max] "g" (max), [offset] "g" (offset)
         : "rax", "rbx", "rcx", "rdx");
@@ -135,7 +136,7 @@ std::expected<size_t> tlib::clear(size_t fd, size_t max, size_t offset){
 
 std::expected<size_t> tlib::truncate(size_t fd, size_t size){
     int64_t code;
-    asm volatile("mov rax, 0x312; mov rbx, %[fd]; mov rcx, %[size]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x312; mov rbx, %[fd]; mov rcx, %[size]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [size] "g" (size)
         : "rax", "rbx", "rcx");
@@ -149,7 +150,7 @@ std::expected<size_t> tlib::truncate(size_t fd, size_t size){
 
 std::expected<size_t> tlib::entries(size_t fd, char* buffer, size_t max){
     int64_t code;
-    asm volatile("mov rax, 0x308; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x308; mov rbx, %[fd]; mov rcx, %[buffer]; mov rdx, %[max]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [fd] "g" (fd), [buffer] "g" (reinterpret_cast<size_t>(buffer)), [max] "g" (max)
         : "rax", "rbx", "rcx", "rdx");
@@ -163,7 +164,7 @@ std::expected<size_t> tlib::entries(size_t fd, char* buffer, size_t max){
 
 std::expected<size_t> tlib::mounts(char* buffer, size_t max){
     int64_t code;
-    asm volatile("mov rax, 0x309; mov rbx, %[buffer]; mov rcx, %[max]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x309; mov rbx, %[buffer]; mov rcx, %[max]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [buffer] "g" (reinterpret_cast<size_t>(buffer)), [max] "g" (max)
         : "rax", "rbx", "rcx");
@@ -177,7 +178,7 @@ std::expected<size_t> tlib::mounts(char* buffer, size_t max){
 
 std::expected<void> tlib::mount(size_t type, size_t dev_fd, size_t mp_fd){
     int64_t code;
-    asm volatile("mov rax, 0x314; mov rbx, %[type]; mov rcx, %[mp]; mov rdx, %[dev]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0x314; mov rbx, %[type]; mov rcx, %[mp]; mov rdx, %[dev]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [type] "g" (type), [dev] "g" (dev_fd), [mp] "g" (mp_fd)
         : "rax", "rbx", "rcx", "rdx");
@@ -193,7 +194,7 @@ std::string tlib::current_working_directory(){
     char buffer[128];
     buffer[0] = '\0';
 
-    asm volatile("mov rax, 0x304; mov rbx, %[buffer]; int 50;"
+    asm volatile("mov rax, 0x304; mov rbx, %[buffer]; " TLIB_SYSCALL
         : /* No outputs */
         : [buffer] "g" (reinterpret_cast<size_t>(buffer))
         : "rax", "rbx");
@@ -202,7 +203,7 @@ std::string tlib::current_working_directory(){
 }
 
 void tlib::set_current_working_directory(const std::string& directory){
-    asm volatile("mov rax, 0x305; mov rbx, %[buffer]; int 50;"
+    asm volatile("mov rax, 0x305; mov rbx, %[buffer]; " TLIB_SYSCALL
         : /* No outputs */
         : [buffer] "g" (reinterpret_cast<size_t>(directory.c_str()))
         : "rax", "rbx");
@@ -6,12 +6,14 @@
 //=======================================================================
 
 #include "tlib/graphics.hpp"
+#include "tlib/syscall.hpp"
+#include "tlib/system.hpp"
 
 namespace {
 
 uint64_t syscall_get(uint64_t call){
     size_t value;
-    asm volatile("mov rax, %[call]; int 50; mov %[value], rax"
+    asm volatile("mov rax, %[call]; " TLIB_SYSCALL "mov %[value], rax"
         : [value] "=m" (value)
         : [call] "r" (call)
         : "rax");
@@ -21,39 +23,39 @@ uint64_t syscall_get(uint64_t call){
 } // end of anonymous namespace
 
 uint64_t tlib::graphics::get_width(){
-    return syscall_get(0xC00);
+    return shared().vesa_width;
 }
 
 uint64_t tlib::graphics::get_height(){
-    return syscall_get(0xC01);
+    return shared().vesa_height;
 }
 
 uint64_t tlib::graphics::get_x_shift(){
-    return syscall_get(0xC02);
+    return shared().vesa_x_shift;
 }
 
 uint64_t tlib::graphics::get_y_shift(){
-    return syscall_get(0xC03);
+    return shared().vesa_y_shift;
 }
 
 uint64_t tlib::graphics::get_bytes_per_scan_line(){
-    return syscall_get(0xC04);
+    return shared().vesa_bytes_per_scan_line;
 }
 
 uint64_t tlib::graphics::get_red_shift(){
-    return syscall_get(0xC05);
+    return shared().vesa_red_shift;
 }
 
 uint64_t tlib::graphics::get_green_shift(){
-    return syscall_get(0xC06);
+    return shared().vesa_green_shift;
 }
 
 uint64_t tlib::graphics::get_blue_shift(){
-    return syscall_get(0xC07);
+    return shared().vesa_blue_shift;
 }
 
 void tlib::graphics::redraw(char* buffer){
-    asm volatile("mov rax, 0xC08; mov rbx, %[buffer]; int 50;"
+    asm volatile("mov rax, 0xC08; mov rbx, %[buffer]; " TLIB_SYSCALL
         :
         : [buffer] "g" (buffer)
         : "rax", "rbx");
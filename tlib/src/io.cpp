@@ -6,10 +6,11 @@
 //=======================================================================
 
 #include "tlib/io.hpp"
+#include "tlib/syscall.hpp"
 
 int64_t tlib::ioctl(size_t device, tlib::ioctl_request request, void* data){
     int64_t code;
-    asm volatile("mov rax, 0xA00; mov rbx, %[device]; mov rcx, %[request]; mov rdx, %[data]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xA00; mov rbx, %[device]; mov rcx, %[request]; mov rdx, %[data]; " TLIB_SYSCALL "mov %[code], rax"
         : [code] "=m" (code)
         : [device] "g" (device), [request] "g" (static_cast<size_t>(request)), [data] "g" (reinterpret_cast<size_t>(data))
         : "rax", "rbx", "rcx", "rdx");
@@ -6,6 +6,10 @@
 //=======================================================================
 
 #include "tlib/malloc.hpp"
+#include "tlib/syscall.hpp"
+#include "tlib/sync.hpp"
+
+#include <lock_guard.hpp>
 
 #define likely(x)    __builtin_expect (!!(x), 1)
 #define unlikely(x)  __builtin_expect (!!(x), 0)
@@ -48,6 +52,8 @@ static_assert(aligned(MIN_SPLIT), "The size of minimum split must guarantee alig
 fake_head head;
 malloc_header_chunk* malloc_head = 0;
 
+tlib::mutex heap_lock; ///< Protects the heap against concurrent threads
+
 //Insert new_block after current in the free list and update
 //all the necessary links
 void insert_after(malloc_header_chunk* current, malloc_header_chunk* new_block){
@@ -124,6 +130,8 @@ void init_head(){
 } //end of anonymous namespace
 
 void* tlib::malloc(size_t bytes){
+    std::lock_guard<tlib::mutex> guard(heap_lock);
+
     if(unlikely(!init)){
         init_head();
     }
@@ -195,6 +203,8 @@ void tlib::free(void* block){
     auto free_header = reinterpret_cast<malloc_header_chunk*>(
         reinterpret_cast<uintptr_t>(block) - sizeof(malloc_header_chunk));
 
+    std::lock_guard<tlib::mutex> guard(heap_lock);
+
     //Less memory is used
     _used -= free_header->size + META_SIZE;
 
@@ -204,7 +214,7 @@ void tlib::free(void* block){
 
 size_t tlib::brk_start(){
     size_t value;
-    asm volatile("mov rax, 7; int 50; mov %[brk_start], rax"
+    asm volatile("mov rax, 7; " TLIB_SYSCALL "mov %[brk_start], rax"
         : [brk_start] "=m" (value)
         : //No inputs
         : "rax");
@@ -213,7 +223,7 @@ size_t tlib::brk_start(){
 
 size_t tlib::brk_end(){
     size_t value;
-    asm volatile("mov rax, 8; int 50; mov %[brk_end], rax"
+    asm volatile("mov rax, 8; " TLIB_SYSCALL "mov %[brk_end], rax"
         : [brk_end] "=m" (value)
         : //No inputs
         : "rax");
@@ -222,7 +232,7 @@ size_t tlib::brk_end(){
 
 size_t tlib::sbrk(size_t inc){
     size_t value;
-    asm volatile("mov rax, 9; mov rbx, %[brk_inc]; int 50; mov %[brk_end], rax"
+    asm volatile("mov rax, 9; mov rbx, %[brk_inc]; " TLIB_SYSCALL "mov %[brk_end], rax"
         : [brk_end] "=m" (value)
         : [brk_inc] "g" (inc)
         : "rax", "rbx");
@@ -6,6 +6,7 @@
 //=======================================================================
 
 #include "tlib/net.hpp"
+#include "tlib/syscall.hpp"
 #include "tlib/malloc.hpp"
 
 tlib::packet::packet()
@@ -38,7 +39,7 @@ tlib::packet::~packet() {
 
 std::expected<size_t> tlib::socket_open(socket_domain domain, socket_type type, socket_protocol protocol) {
     int64_t fd;
-    asm volatile("mov rax, 0xB00; mov rbx, %[domain]; mov rcx, %[type]; mov rdx, %[protocol]; int 50; mov %[fd], rax"
+    asm volatile("mov rax, 0xB00; mov rbx, %[domain]; mov rcx, %[type]; mov rdx, %[protocol]; " TLIB_SYSCALL "mov %[fd], rax"
                  : [fd] "=m"(fd)
                  : [domain] "g"(static_cast<size_t>(domain)), [type] "g"(static_cast<size_t>(type)), [protocol] "g"(static_cast<size_t>(protocol))
                  : "rax", "rbx", "rcx", "rdx");
@@ -51,7 +52,7 @@ std::expected<size_t> tlib::socket_open(socket_domain domain, socket_type type,
 }
 
 void tlib::socket_close(size_t fd) {
-    asm volatile("mov rax, 0xB01; mov rbx, %[fd]; int 50;"
+    asm volatile("mov rax, 0xB01; mov rbx, %[fd]; " TLIB_SYSCALL
                  : /* No outputs */
                  : [fd] "g"(fd)
                  : "rax", "rbx");
@@ -62,7 +63,7 @@ std::expected<tlib::packet> tlib::prepare_packet(size_t socket_fd, void* desc) {
 
     int64_t fd;
     uint64_t index;
-    asm volatile("mov rax, 0xB02; mov rbx, %[socket]; mov rcx, %[desc]; mov rdx, %[buffer]; int 50; mov %[fd], rax; mov %[index], rbx;"
+    asm volatile("mov rax, 0xB02; mov rbx, %[socket]; mov rcx, %[desc]; mov rdx, %[buffer]; " TLIB_SYSCALL "mov %[fd], rax; mov %[index], rbx;"
                  : [fd] "=m"(fd), [index] "=m"(index)
                  : [socket] "g"(socket_fd), [desc] "g"(reinterpret_cast<size_t>(desc)), [buffer] "g"(reinterpret_cast<size_t>(buffer))
                  : "rax", "rbx", "rcx", "rdx");
@@ -83,7 +84,7 @@ std::expected<void> tlib::finalize_packet(size_t socket_fd, const tlib::packet&
     auto packet_fd = p.fd;
 
     int64_t code;
-    asm volatile("mov rax, 0xB03; mov rbx, %[socket]; mov rcx, %[packet]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB03; mov rbx, %[socket]; mov rcx, %[packet]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [packet] "g"(packet_fd)
                  : "rax", "rbx", "rcx");
@@ -99,7 +100,7 @@ std::expected<void> tlib::send(size_t socket_fd, const char* buffer, size_t n) {
     auto* target_buffer = new char[2048];
 
     int64_t code;
-    asm volatile("mov rax, 0xB0B; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[target_buffer]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB0B; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[target_buffer]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n), [target_buffer] "g"(reinterpret_cast<size_t>(target_buffer))
                  : "rax", "rbx", "rcx", "rdx", "rsi");
@@ -117,7 +118,7 @@ std::expected<void> tlib::send_to(size_t socket_fd, const char* buffer, size_t n
     auto* target_buffer = new char[2048];
 
     int64_t code;
-    asm volatile("mov rax, 0xB13; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[target_buffer]; mov rdi, %[address]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB13; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[target_buffer]; mov rdi, %[address]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n), [target_buffer] "g"(reinterpret_cast<size_t>(target_buffer)), [address] "g"(reinterpret_cast<size_t>(address))
                  : "rax", "rbx", "rcx", "rdx", "rsi", "rdi");
@@ -133,7 +134,7 @@ std::expected<void> tlib::send_to(size_t socket_fd, const char* buffer, size_t n
 
 std::expected<size_t> tlib::receive(size_t socket_fd, char* buffer, size_t n) {
     int64_t code;
-    asm volatile("mov rax, 0xB10; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB10; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n)
                  : "rax", "rbx", "rcx", "rdx");
@@ -147,7 +148,7 @@ std::expected<size_t> tlib::receive(size_t socket_fd, char* buffer, size_t n) {
 
 std::expected<size_t> tlib::receive(size_t socket_fd, char* buffer, size_t n, size_t ms) {
     int64_t code;
-    asm volatile("mov rax, 0xB0C; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[ms]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB0C; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[ms]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n), [ms] "g" (ms)
                  : "rax", "rbx", "rcx", "rdx", "rsi");
@@ -161,7 +162,7 @@ std::expected<size_t> tlib::receive(size_t socket_fd, char* buffer, size_t n, si
 
 std::expected<size_t> tlib::receive_from(size_t socket_fd, char* buffer, size_t n, void* address) {
     int64_t code;
-    asm volatile("mov rax, 0xB11; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[address]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB11; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[address]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n), [address] "g" (reinterpret_cast<size_t>(address))
                  : "rax", "rbx", "rcx", "rdx", "rsi");
@@ -175,7 +176,7 @@ std::expected<size_t> tlib::receive_from(size_t socket_fd, char* buffer, size_t
 
 std::expected<size_t> tlib::receive_from(size_t socket_fd, char* buffer, size_t n, size_t ms, void* address) {
     int64_t code;
-    asm volatile("mov rax, 0xB12; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[ms]; mov rdi, %[address]; int 50; mov %[code], rax;"
+    asm volatile("mov rax, 0xB12; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[n]; mov rsi, %[ms]; mov rdi, %[address]; " TLIB_SYSCALL "mov %[code], rax;"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [n] "g" (n), [ms] "g" (ms), [address] "g" (reinterpret_cast<size_t>(address))
                  : "rax", "rbx", "rcx", "rdx", "rsi", "rdi");
@@ -187,9 +188,110 @@ std::expected<size_t> tlib::receive_from(size_t socket_fd, char* buffer, size_t
     }
 }
 
+namespace {
+
+std::expected<size_t> send_datagrams(size_t socket_fd, tlib::datagram* datagrams, size_t n, bool addressed) {
+    // A single buffer is enough for the whole batch
+    auto* target_buffer = new char[2048];
+
+    int64_t code;
+    asm volatile("mov rax, 0xB18; mov rbx, %[socket]; mov rcx, %[datagrams]; mov rdx, %[n]; mov rsi, %[target_buffer]; mov rdi, %[addressed]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd), [datagrams] "g"(reinterpret_cast<size_t>(datagrams)), [n] "g" (n), [target_buffer] "g"(reinterpret_cast<size_t>(target_buffer)), [addressed] "g"(size_t(addressed))
+                 : "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "memory");
+
+    delete[] target_buffer;
+
+    if (code < 0) {
+        return std::make_unexpected<size_t, size_t>(-code);
+    } else {
+        return code;
+    }
+}
+
+} // end of anonymous namespace
+
+std::expected<size_t> tlib::send_many(size_t socket_fd, datagram* datagrams, size_t n) {
+    return send_datagrams(socket_fd, datagrams, n, false);
+}
+
+std::expected<size_t> tlib::send_many_to(size_t socket_fd, datagram* datagrams, size_t n) {
+    return send_datagrams(socket_fd, datagrams, n, true);
+}
+
+std::expected<size_t> tlib::receive_many(size_t socket_fd, datagram* datagrams, size_t n) {
+    int64_t code;
+    asm volatile("mov rax, 0xB19; mov rbx, %[socket]; mov rcx, %[datagrams]; mov rdx, %[n]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd), [datagrams] "g"(reinterpret_cast<size_t>(datagrams)), [n] "g" (n)
+                 : "rax", "rbx", "rcx", "rdx", "memory");
+
+    if (code < 0) {
+        return std::make_unexpected<size_t, size_t>(-code);
+    } else {
+        return code;
+    }
+}
+
+std::expected<size_t> tlib::receive_many(size_t socket_fd, datagram* datagrams, size_t n, size_t ms) {
+    int64_t code;
+    asm volatile("mov rax, 0xB1A; mov rbx, %[socket]; mov rcx, %[datagrams]; mov rdx, %[n]; mov rsi, %[ms]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd), [datagrams] "g"(reinterpret_cast<size_t>(datagrams)), [n] "g" (n), [ms] "g" (ms)
+                 : "rax", "rbx", "rcx", "rdx", "rsi", "memory");
+
+    if (code < 0) {
+        return std::make_unexpected<size_t, size_t>(-code);
+    } else {
+        return code;
+    }
+}
+
+std::expected<tlib::packet_ring_header*> tlib::open_ring(size_t socket_fd) {
+    int64_t code;
+    asm volatile("mov rax, 0xB28; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd)
+                 : "rax", "rbx");
+
+    if (code < 0) {
+        return std::make_unexpected<packet_ring_header*, size_t>(-code);
+    } else {
+        return reinterpret_cast<packet_ring_header*>(code);
+    }
+}
+
+std::expected<size_t> tlib::ring_send(size_t socket_fd) {
+    int64_t code;
+    asm volatile("mov rax, 0xB29; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd)
+                 : "rax", "rbx", "memory");
+
+    if (code < 0) {
+        return std::make_unexpected<size_t, size_t>(-code);
+    } else {
+        return code;
+    }
+}
+
+std::expected<void> tlib::ring_wait(size_t socket_fd) {
+    int64_t code;
+    asm volatile("mov rax, 0xB2A; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax;"
+                 : [code] "=m"(code)
+                 : [socket] "g"(socket_fd)
+                 : "rax", "rbx", "memory");
+
+    if (code < 0) {
+        return std::make_expected_from_error<void, size_t>(-code);
+    } else {
+        return std::make_expected();
+    }
+}
+
 std::expected<void> tlib::listen(size_t socket_fd, bool l) {
     int64_t code;
-    asm volatile("mov rax, 0xB04; mov rbx, %[socket]; mov rcx, %[listen]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB04; mov rbx, %[socket]; mov rcx, %[listen]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [listen] "g"(size_t(l))
                  : "rax", "rbx", "rcx");
@@ -203,7 +305,7 @@ std::expected<void> tlib::listen(size_t socket_fd, bool l) {
 
 std::expected<size_t> tlib::client_bind(size_t socket_fd, tlib::ip::address server) {
     int64_t code;
-    asm volatile("mov rax, 0xB07; mov rbx, %[socket]; mov rcx, %[ip]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB07; mov rbx, %[socket]; mov rcx, %[ip]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g" (size_t(server.raw_address))
                  : "rax", "rbx", "rcx");
@@ -217,7 +319,7 @@ std::expected<size_t> tlib::client_bind(size_t socket_fd, tlib::ip::address serv
 
 std::expected<size_t> tlib::client_bind(size_t socket_fd, tlib::ip::address server, size_t port) {
     int64_t code;
-    asm volatile("mov rax, 0xB0D; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB0D; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g" (size_t(server.raw_address)), [port] "g" (port)
                  : "rax", "rbx", "rcx");
@@ -231,7 +333,7 @@ std::expected<size_t> tlib::client_bind(size_t socket_fd, tlib::ip::address serv
 
 std::expected<void> tlib::server_bind(size_t socket_fd, tlib::ip::address server) {
     int64_t code;
-    asm volatile("mov rax, 0xB0E; mov rbx, %[socket]; mov rcx, %[ip]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB0E; mov rbx, %[socket]; mov rcx, %[ip]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g" (size_t(server.raw_address))
                  : "rax", "rbx", "rcx");
@@ -245,7 +347,7 @@ std::expected<void> tlib::server_bind(size_t socket_fd, tlib::ip::address server
 
 std::expected<void> tlib::server_bind(size_t socket_fd, tlib::ip::address server, size_t port) {
     int64_t code;
-    asm volatile("mov rax, 0xB0F; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB0F; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g" (size_t(server.raw_address)), [port] "g" (port)
                  : "rax", "rbx", "rcx");
@@ -259,7 +361,7 @@ std::expected<void> tlib::server_bind(size_t socket_fd, tlib::ip::address server
 
 std::expected<void> tlib::client_unbind(size_t socket_fd) {
     int64_t code;
-    asm volatile("mov rax, 0xB0A; mov rbx, %[socket]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB0A; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd)
                  : "rax", "rbx");
@@ -273,7 +375,7 @@ std::expected<void> tlib::client_unbind(size_t socket_fd) {
 
 std::expected<size_t> tlib::connect(size_t socket_fd, tlib::ip::address server, size_t port) {
     int64_t code;
-    asm volatile("mov rax, 0xB08; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB08; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g"(size_t(server.raw_address)), [port] "g"(port)
                  : "rax", "rbx", "rcx", "rdx");
@@ -287,7 +389,7 @@ std::expected<size_t> tlib::connect(size_t socket_fd, tlib::ip::address server,
 
 std::expected<void> tlib::server_start(size_t socket_fd, tlib::ip::address server, size_t port) {
     int64_t code;
-    asm volatile("mov rax, 0xB14; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB14; mov rbx, %[socket]; mov rcx, %[ip]; mov rdx, %[port]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ip] "g"(size_t(server.raw_address)), [port] "g"(port)
                  : "rax", "rbx", "rcx", "rdx");
@@ -301,7 +403,7 @@ std::expected<void> tlib::server_start(size_t socket_fd, tlib::ip::address serve
 
 std::expected<size_t> tlib::accept(size_t socket_fd) {
     int64_t code;
-    asm volatile("mov rax, 0xB16; mov rbx, %[socket]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB16; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd)
                  : "rax", "rbx");
@@ -315,7 +417,7 @@ std::expected<size_t> tlib::accept(size_t socket_fd) {
 
 std::expected<size_t> tlib::accept(size_t socket_fd, size_t ms) {
     int64_t code;
-    asm volatile("mov rax, 0xB17; mov rbx, %[socket]; mov rcx, %[ms]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB17; mov rbx, %[socket]; mov rcx, %[ms]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd), [ms] "g"(ms)
                  : "rax", "rbx", "rcx");
@@ -329,7 +431,7 @@ std::expected<size_t> tlib::accept(size_t socket_fd, size_t ms) {
 
 std::expected<void> tlib::disconnect(size_t socket_fd) {
     int64_t code;
-    asm volatile("mov rax, 0xB09; mov rbx, %[socket]; int 50; mov %[code], rax"
+    asm volatile("mov rax, 0xB09; mov rbx, %[socket]; " TLIB_SYSCALL "mov %[code], rax"
                  : [code] "=m"(code)
                  : [socket] "g"(socket_fd)
                  : "rax", "rbx");
@@ -346,7 +448,7 @@ std::expected<tlib::packet> tlib::wait_for_packet(size_t socket_fd) {
 
     int64_t code;
     uint64_t payload;
-    asm volatile("mov rax, 0xB05; mov rbx, %[socket]; mov rcx, %[buffer]; int 50; mov %[code], rax; mov %[payload], rbx;"
+    asm volatile("mov rax, 0xB05; mov rbx, %[socket]; mov rcx, %[buffer]; " TLIB_SYSCALL "mov %[code], rax; mov %[payload], rbx;"
                  : [payload] "=m"(payload), [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer))
                  : "rax", "rbx", "rcx");
@@ -367,7 +469,7 @@ std::expected<tlib::packet> tlib::wait_for_packet(size_t socket_fd, size_t ms) {
 
     int64_t code;
     uint64_t payload;
-    asm volatile("mov rax, 0xB06; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[ms]; int 50; mov %[code], rax; mov %[payload], rbx;"
+    asm volatile("mov rax, 0xB06; mov rbx, %[socket]; mov rcx, %[buffer]; mov rdx, %[ms]; " TLIB_SYSCALL "mov %[code], rax; mov %[payload], rbx;"
                  : [payload] "=m"(payload), [code] "=m"(code)
                  : [socket] "g"(socket_fd), [buffer] "g"(reinterpret_cast<size_t>(buffer)), [ms] "g"(ms)
                  : "rax", "rbx", "rcx");
@@ -383,12 +485,12 @@ std::expected<tlib::packet> tlib::wait_for_packet(size_t socket_fd, size_t ms) {
     }
 }
 
-tlib::socket::socket() : fd(0), error_code(0) {
+tlib::socket::socket() : fd(0), error_code(0), ring(nullptr) {
     // Nothing else to init
 }
 
 tlib::socket::socket(socket_domain domain, socket_type type, socket_protocol protocol)
-        : domain(domain), type(type), protocol(protocol), fd(0), error_code(0) {
+        : domain(domain), type(type), protocol(protocol), fd(0), error_code(0), ring(nullptr) {
     auto open_status = tlib::socket_open(domain, type, protocol);
 
     if (open_status.valid()) {
@@ -399,12 +501,13 @@ tlib::socket::socket(socket_domain domain, socket_type type, socket_protocol pro
 }
 
 tlib::socket::socket(tlib::socket&& rhs)
-        : domain(rhs.domain), type(rhs.type), protocol(rhs.protocol), fd(rhs.fd), error_code(rhs.error_code), _connected(rhs._connected), _bound(rhs._bound) {
+        : domain(rhs.domain), type(rhs.type), protocol(rhs.protocol), fd(rhs.fd), error_code(rhs.error_code), _connected(rhs._connected), _bound(rhs._bound), ring(rhs.ring) {
     // This needs to be done so that the rhs will not do anything on
     // destroy
     rhs.fd = 0;
     rhs._connected = false;
     rhs._bound = false;
+    rhs.ring = nullptr;
 }
 
 tlib::socket& tlib::socket::operator=(tlib::socket&& rhs){
@@ -416,12 +519,14 @@ tlib::socket& tlib::socket::operator=(tlib::socket&& rhs){
         this->error_code = rhs.error_code;
         this->_connected = rhs._connected;
         this->_bound     = rhs._bound;
+        this->ring       = rhs.ring;
 
         // This needs to be done so that the rhs will not do anything on
         // destroy
         rhs.fd = 0;
         rhs._connected = false;
         rhs._bound = false;
+        rhs.ring = nullptr;
     }
 
     return *this;
@@ -457,6 +562,10 @@ bool tlib::socket::bound() const {
     return _bound;
 }
 
+size_t tlib::socket::get_fd() const {
+    return fd;
+}
+
 tlib::socket::operator bool() {
     return good();
 }
@@ -833,6 +942,130 @@ size_t tlib::socket::receive_from(char* buffer, size_t n, size_t ms, void* addre
     }
 }
 
+size_t tlib::socket::send_many(datagram* datagrams, size_t n) {
+    if (!good() || !open() || type != socket_type::DGRAM || !bound()) {
+        return 0;
+    }
+
+    auto p = tlib::send_many(fd, datagrams, n);
+    if (!p) {
+        error_code = p.error();
+        return 0;
+    } else {
+        return *p;
+    }
+}
+
+size_t tlib::socket::send_many_to(datagram* datagrams, size_t n) {
+    if (!good() || !open() || type != socket_type::DGRAM || !bound()) {
+        return 0;
+    }
+
+    auto p = tlib::send_many_to(fd, datagrams, n);
+    if (!p) {
+        error_code = p.error();
+        return 0;
+    } else {
+        return *p;
+    }
+}
+
+size_t tlib::socket::receive_many(datagram* datagrams, size_t n) {
+    if (!good() || !open() || type != socket_type::DGRAM || !bound()) {
+        return 0;
+    }
+
+    auto p = tlib::receive_many(fd, datagrams, n);
+    if (!p) {
+        error_code = p.error();
+        return 0;
+    } else {
+        return *p;
+    }
+}
+
+size_t tlib::socket::receive_many(datagram* datagrams, size_t n, size_t ms) {
+    if (!good() || !open() || type != socket_type::DGRAM || !bound()) {
+        return 0;
+    }
+
+    auto p = tlib::receive_many(fd, datagrams, n, ms);
+    if (!p) {
+        error_code = p.error();
+        return 0;
+    } else {
+        return *p;
+    }
+}
+
+bool tlib::socket::open_ring() {
+    if (!good() || !open()) {
+        return false;
+    }
+
+    if (ring) {
+        return true;
+    }
+
+    auto status = tlib::open_ring(fd);
+    if (!status) {
+        error_code = status.error();
+        return false;
+    }
+
+    ring = *status;
+
+    return true;
+}
+
+char* tlib::socket::ring_buffer() {
+    if (!good() || !ring) {
+        return nullptr;
+    }
+
+    // The ring is full, the filled slots must be sent before waiting for one
+    while (ring->head == ring->tail + packet_ring_slots) {
+        auto sent = tlib::ring_send(fd);
+        if (!sent) {
+            error_code = sent.error();
+            return nullptr;
+        }
+
+        auto status = tlib::ring_wait(fd);
+        if (!status) {
+            error_code = status.error();
+            return nullptr;
+        }
+    }
+
+    auto* slots = reinterpret_cast<char*>(ring) + packet_ring_slots_offset;
+
+    return slots + (ring->head % packet_ring_slots) * packet_ring_slot_size + packet_ring_headroom;
+}
+
+void tlib::socket::ring_commit(size_t n) {
+    if (!good() || !ring) {
+        return;
+    }
+
+    ring->sizes[ring->head % packet_ring_slots] = n;
+    ring->head = ring->head + 1;
+}
+
+size_t tlib::socket::ring_send() {
+    if (!good() || !ring) {
+        return 0;
+    }
+
+    auto p = tlib::ring_send(fd);
+    if (!p) {
+        error_code = p.error();
+        return 0;
+    } else {
+        return *p;
+    }
+}
+
 tlib::packet tlib::socket::wait_for_packet(size_t ms) {
     if (!good() || !open()) {
         return tlib::packet();
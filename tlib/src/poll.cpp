@@ -0,0 +1,95 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "tlib/poll.hpp"
+#include "tlib/syscall.hpp"
+
+namespace {
+
+std::expected<void> poll_control(size_t set_fd, tlib::poll_operation operation, tlib::poll_target target, size_t fd, size_t events){
+    int64_t code;
+    asm volatile("mov rax, 0xB22; mov rbx, %[set]; mov rcx, %[operation]; mov rdx, %[target]; mov rsi, %[fd]; mov rdi, %[events]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [set] "g" (set_fd), [operation] "g" (static_cast<size_t>(operation)), [target] "g" (static_cast<size_t>(target)), [fd] "g" (fd), [events] "g" (events)
+        : "rax", "rbx", "rcx", "rdx", "rsi", "rdi");
+
+    if(code < 0){
+        return std::make_expected_from_error<void, size_t>(-code);
+    } else {
+        return std::make_expected();
+    }
+}
+
+} // end of anonymous namespace
+
+std::expected<size_t> tlib::poll_create(){
+    int64_t code;
+    asm volatile("mov rax, 0xB20; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        :
+        : "rax");
+
+    if(code < 0){
+        return std::make_expected_from_error<size_t, size_t>(-code);
+    } else {
+        return std::make_expected<size_t>(code);
+    }
+}
+
+std::expected<void> tlib::poll_close(size_t set_fd){
+    int64_t code;
+    asm volatile("mov rax, 0xB21; mov rbx, %[set]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [set] "g" (set_fd)
+        : "rax", "rbx");
+
+    if(code < 0){
+        return std::make_expected_from_error<void, size_t>(-code);
+    } else {
+        return std::make_expected();
+    }
+}
+
+std::expected<void> tlib::poll_add(size_t set_fd, poll_target target, size_t fd, size_t events){
+    return poll_control(set_fd, poll_operation::ADD, target, fd, events);
+}
+
+std::expected<void> tlib::poll_modify(size_t set_fd, poll_target target, size_t fd, size_t events){
+    return poll_control(set_fd, poll_operation::MODIFY, target, fd, events);
+}
+
+std::expected<void> tlib::poll_remove(size_t set_fd, poll_target target, size_t fd){
+    return poll_control(set_fd, poll_operation::REMOVE, target, fd, 0);
+}
+
+std::expected<size_t> tlib::poll_wait(size_t set_fd, poll_event* events, size_t max){
+    int64_t code;
+    asm volatile("mov rax, 0xB23; mov rbx, %[set]; mov rcx, %[events]; mov rdx, %[max]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [set] "g" (set_fd), [events] "g" (reinterpret_cast<size_t>(events)), [max] "g" (max)
+        : "rax", "rbx", "rcx", "rdx", "memory");
+
+    if(code < 0){
+        return std::make_expected_from_error<size_t, size_t>(-code);
+    } else {
+        return std::make_expected<size_t>(code);
+    }
+}
+
+std::expected<size_t> tlib::poll_wait(size_t set_fd, poll_event* events, size_t max, size_t ms){
+    int64_t code;
+    asm volatile("mov rax, 0xB24; mov rbx, %[set]; mov rcx, %[events]; mov rdx, %[max]; mov rsi, %[ms]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [set] "g" (set_fd), [events] "g" (reinterpret_cast<size_t>(events)), [max] "g" (max), [ms] "g" (ms)
+        : "rax", "rbx", "rcx", "rdx", "rsi", "memory");
+
+    if(code < 0){
+        return std::make_expected_from_error<size_t, size_t>(-code);
+    } else {
+        return std::make_expected<size_t>(code);
+    }
+}
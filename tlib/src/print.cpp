@@ -8,6 +8,8 @@
 #include <stdarg.h>
 
 #include "tlib/print.hpp"
+#include "tlib/syscall.hpp"
+#include "tlib/system.hpp"
 #include "tlib/file.hpp"
 
 namespace {
@@ -37,7 +39,7 @@ void tlib::print(const std::string& s){
 }
 
 void log(const char* s){
-    asm volatile("mov rax, 2; mov rbx, %[s]; int 50"
+    asm volatile("mov rax, 2; mov rbx, %[s]; " TLIB_SYSCALL
         : //No outputs
         : [s] "g" (reinterpret_cast<size_t>(s))
         : "rax", "rbx");
@@ -77,7 +79,7 @@ void tlib::print(int64_t v){
 
 void tlib::set_canonical(bool can){
     size_t value = can;
-    asm volatile("mov rax, 0x20; mov rbx, %[value]; int 50;"
+    asm volatile("mov rax, 0x20; mov rbx, %[value]; " TLIB_SYSCALL
         :
         : [value] "g" (value)
         : "rax", "rbx");
@@ -85,7 +87,7 @@ void tlib::set_canonical(bool can){
 
 void tlib::set_mouse(bool m){
     size_t value = m;
-    asm volatile("mov rax, 0x21; mov rbx, %[value]; int 50;"
+    asm volatile("mov rax, 0x21; mov rbx, %[value]; " TLIB_SYSCALL
         :
         : [value] "g" (value)
         : "rax", "rbx");
@@ -138,28 +140,18 @@ std::keycode tlib::read_input_raw(size_t ms){
 }
 
 void  tlib::clear(){
-    asm volatile("mov rax, 0x22; int 50;"
+    asm volatile("mov rax, 0x22; " TLIB_SYSCALL
         : //No outputs
         : //No inputs
         : "rax");
 }
 
 size_t tlib::get_columns(){
-    size_t value;
-    asm volatile("mov rax, 0x23; int 50; mov %[columns], rax"
-        : [columns] "=m" (value)
-        : //No inputs
-        : "rax");
-    return value;
+    return shared().columns;
 }
 
 size_t tlib::get_rows(){
-    size_t value;
-    asm volatile("mov rax, 0x24; int 50; mov %[rows], rax"
-        : [rows] "=m" (value)
-        : //No inputs
-        : "rax");
-    return value;
+    return shared().rows;
 }
 
 void tlib::print_line(){
@@ -0,0 +1,171 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "tlib/sync.hpp"
+#include "tlib/syscall.hpp"
+#include "tlib/errors.hpp"
+
+#define likely(x)    __builtin_expect (!!(x), 1)
+
+namespace {
+
+constexpr const size_t WAKE_ALL = size_t(-1);
+
+uint32_t compare_exchange(volatile uint32_t* address, uint32_t expected, uint32_t desired){
+    __atomic_compare_exchange_n(address, &expected, desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    return expected;
+}
+
+} // end of anonymous namespace
+
+std::expected<void> tlib::futex_wait(volatile uint32_t* address, uint32_t value, size_t ms){
+    int64_t code;
+    asm volatile("mov rax, 0xD; mov rbx, %[address]; mov rcx, %[value]; mov rdx, %[ms]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [address] "g" (reinterpret_cast<size_t>(address)), [value] "g" (size_t(value)), [ms] "g" (ms)
+        : "rax", "rbx", "rcx", "rdx", "memory");
+
+    if(code < 0){
+        return std::make_expected_from_error<void, size_t>(-code);
+    } else {
+        return std::make_expected();
+    }
+}
+
+std::expected<size_t> tlib::futex_wake(volatile uint32_t* address, size_t n){
+    int64_t code;
+    asm volatile("mov rax, 0xE; mov rbx, %[address]; mov rcx, %[n]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [address] "g" (reinterpret_cast<size_t>(address)), [n] "g" (n)
+        : "rax", "rbx", "rcx", "memory");
+
+    if(code < 0){
+        return std::make_expected_from_error<size_t, size_t>(-code);
+    } else {
+        return std::make_expected<size_t>(code);
+    }
+}
+
+void tlib::mutex::lock(){
+    // Fast path: a single atomic instruction
+    if(likely(compare_exchange(&state, 0, 1) == 0)){
+        return;
+    }
+
+    lock_contended();
+}
+
+void tlib::mutex::lock_contended(){
+    // Mark the mutex as contended, so that unlock wakes a waiter
+    while(__atomic_exchange_n(&state, 2, __ATOMIC_ACQUIRE) != 0){
+        futex_wait(&state, 2);
+    }
+}
+
+bool tlib::mutex::try_lock(){
+    return compare_exchange(&state, 0, 1) == 0;
+}
+
+void tlib::mutex::unlock(){
+    // Fast path: nobody is waiting
+    if(likely(__atomic_fetch_sub(&state, 1, __ATOMIC_RELEASE) == 1)){
+        return;
+    }
+
+    __atomic_store_n(&state, 0, __ATOMIC_RELEASE);
+    futex_wake(&state, 1);
+}
+
+void tlib::condition_variable::wait(mutex& m){
+    auto seq = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+
+    __atomic_fetch_add(&waiters, 1, __ATOMIC_SEQ_CST);
+
+    m.unlock();
+    futex_wait(&sequence, seq);
+
+    __atomic_fetch_sub(&waiters, 1, __ATOMIC_SEQ_CST);
+
+    // Other threads may be waiting for the mutex
+    m.lock_contended();
+}
+
+bool tlib::condition_variable::wait_for(mutex& m, size_t ms){
+    if(!ms){
+        return false;
+    }
+
+    auto seq = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+
+    __atomic_fetch_add(&waiters, 1, __ATOMIC_SEQ_CST);
+
+    m.unlock();
+    auto status = futex_wait(&sequence, seq, ms);
+
+    __atomic_fetch_sub(&waiters, 1, __ATOMIC_SEQ_CST);
+
+    m.lock_contended();
+
+    return status || status.error() != std::ERROR_TIMEOUT;
+}
+
+void tlib::condition_variable::notify_one(){
+    __atomic_fetch_add(&sequence, 1, __ATOMIC_RELEASE);
+
+    if(__atomic_load_n(&waiters, __ATOMIC_SEQ_CST)){
+        futex_wake(&sequence, 1);
+    }
+}
+
+void tlib::condition_variable::notify_all(){
+    __atomic_fetch_add(&sequence, 1, __ATOMIC_RELEASE);
+
+    if(__atomic_load_n(&waiters, __ATOMIC_SEQ_CST)){
+        futex_wake(&sequence, WAKE_ALL);
+    }
+}
+
+void tlib::semaphore::wait(){
+    while(true){
+        auto v = __atomic_load_n(&value, __ATOMIC_RELAXED);
+
+        if(v > 0){
+            // Fast path: a single atomic instruction
+            if(compare_exchange(&value, v, v - 1) == v){
+                return;
+            }
+        } else {
+            __atomic_fetch_add(&waiters, 1, __ATOMIC_SEQ_CST);
+            futex_wait(&value, 0);
+            __atomic_fetch_sub(&waiters, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+bool tlib::semaphore::try_wait(){
+    auto v = __atomic_load_n(&value, __ATOMIC_RELAXED);
+
+    while(v > 0){
+        auto old = compare_exchange(&value, v, v - 1);
+
+        if(old == v){
+            return true;
+        }
+
+        v = old;
+    }
+
+    return false;
+}
+
+void tlib::semaphore::post(){
+    __atomic_fetch_add(&value, 1, __ATOMIC_RELEASE);
+
+    if(__atomic_load_n(&waiters, __ATOMIC_SEQ_CST)){
+        futex_wake(&value, 1);
+    }
+}
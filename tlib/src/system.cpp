@@ -6,22 +6,10 @@
 //=======================================================================
 
 #include "tlib/system.hpp"
-
-namespace {
-
-uint64_t syscall_get(uint64_t call){
-    size_t value;
-    asm volatile("mov rax, %[call]; int 50; mov %[value], rax"
-        : [value] "=m" (value)
-        : [call] "r" (call)
-        : "rax");
-    return value;
-}
-
-} // end of anonymous namespace
+#include "tlib/syscall.hpp"
 
 void tlib::exit(size_t return_code) {
-    asm volatile("mov rax, 0x666; mov rbx, %[ret]; int 50"
+    asm volatile("mov rax, 0x666; mov rbx, %[ret]; " TLIB_SYSCALL
         : //No outputs
         : [ret] "g" (return_code)
         : "rax", "rbx");
@@ -40,7 +28,7 @@ std::expected<size_t> tlib::exec(const char* executable, const std::vector<std::
     }
 
     int64_t pid;
-    asm volatile("mov rax, 5; mov rbx, %[path]; mov rcx, %[argc]; mov rdx, %[argv]; int 50; mov %[pid], rax"
+    asm volatile("mov rax, 5; mov rbx, %[path]; mov rcx, %[argc]; mov rdx, %[argv]; " TLIB_SYSCALL "mov %[pid], rax"
         : [pid] "=m" (pid)
         : [path] "g" (reinterpret_cast<size_t>(executable)), [argc] "g" (params.size()), [argv] "g" (reinterpret_cast<size_t>(args))
         : "rax", "rbx", "rcx", "rdx");
@@ -57,14 +45,14 @@ std::expected<size_t> tlib::exec(const char* executable, const std::vector<std::
 }
 
 void tlib::await_termination(size_t pid) {
-    asm volatile("mov rax, 6; mov rbx, %[pid]; int 50;"
+    asm volatile("mov rax, 6; mov rbx, %[pid]; " TLIB_SYSCALL
         : //No outputs
         : [pid] "g" (pid)
         : "rax", "rbx");
 }
 
 void tlib::sleep_ms(size_t ms){
-    asm volatile("mov rax, 4; mov rbx, %[ms]; int 50"
+    asm volatile("mov rax, 4; mov rbx, %[ms]; " TLIB_SYSCALL
         : //No outputs
         : [ms] "g" (ms)
         : "rax", "rbx");
@@ -73,7 +61,7 @@ void tlib::sleep_ms(size_t ms){
 tlib::datetime tlib::local_date(){
     tlib::datetime date_s;
 
-    asm volatile("mov rax, 0x400; mov rbx, %[buffer]; int 50; "
+    asm volatile("mov rax, 0x400; mov rbx, %[buffer]; " TLIB_SYSCALL 
         : /* No outputs */
         : [buffer] "g" (reinterpret_cast<size_t>(&date_s))
         : "rax", "rbx");
@@ -82,11 +70,11 @@ tlib::datetime tlib::local_date(){
 }
 
 uint64_t tlib::s_time(){
-    return syscall_get(0x401);
+    return shared().seconds;
 }
 
 uint64_t tlib::ms_time(){
-    return syscall_get(0x402);
+    return shared().milliseconds;
 }
 
 std::expected<size_t> tlib::exec_and_wait(const char* executable, const std::vector<std::string>& params){
@@ -104,7 +92,7 @@ void tlib::reboot(unsigned int delay) {
         tlib::sleep_ms(1000 * delay);
     }
 
-    asm volatile("mov rax, 0x50; int 50"
+    asm volatile("mov rax, 0x50; " TLIB_SYSCALL
         : //No outputs
         : //No inputs
         : "rax");
@@ -117,7 +105,7 @@ void tlib::shutdown(unsigned int delay) {
         tlib::sleep_ms(1000 * delay);
     }
 
-    asm volatile("mov rax, 0x51; int 50"
+    asm volatile("mov rax, 0x51; " TLIB_SYSCALL
         : //No outputs
         : //No inputs
         : "rax");
@@ -126,7 +114,21 @@ void tlib::shutdown(unsigned int delay) {
 }
 
 void tlib::alpha(){
-    asm volatile("mov rax, 0x66; int 50"
+    asm volatile("mov rax, 0x66; " TLIB_SYSCALL
+        : //No outputs
+        : //No inputs
+        : "rax");
+}
+
+void tlib::null_call(){
+    asm volatile("mov rax, 0; " TLIB_SYSCALL
+        : //No outputs
+        : //No inputs
+        : "rax");
+}
+
+void tlib::null_call_interrupt(){
+    asm volatile("mov rax, 0; " TLIB_SYSCALL_INTERRUPT
         : //No outputs
         : //No inputs
         : "rax");
@@ -0,0 +1,71 @@
+//=======================================================================
+// Copyright Baptiste Wicht 2013-2018.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://www.opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "tlib/thread.hpp"
+#include "tlib/syscall.hpp"
+#include "tlib/malloc.hpp"
+
+namespace {
+
+void thread_start(tlib::thread_fun fun, void* data) __attribute__((noreturn));
+void thread_start(tlib::thread_fun fun, void* data){
+    fun(data);
+
+    tlib::exit_thread();
+}
+
+} // end of anonymous namespace
+
+std::expected<tlib::thread> tlib::create_thread(thread_fun fun, void* data, size_t stack_size){
+    auto stack = new char[stack_size];
+
+    int64_t tid;
+    asm volatile("mov rax, 0xA; mov rbx, %[entry]; mov rcx, %[stack]; mov rdx, %[fun]; mov rsi, %[data]; " TLIB_SYSCALL "mov %[tid], rax"
+        : [tid] "=m" (tid)
+        : [entry] "g" (reinterpret_cast<size_t>(&thread_start)), [stack] "g" (reinterpret_cast<size_t>(stack + stack_size)),
+          [fun] "g" (reinterpret_cast<size_t>(fun)), [data] "g" (reinterpret_cast<size_t>(data))
+        : "rax", "rbx", "rcx", "rdx", "rsi");
+
+    if(tid < 0){
+        delete[] stack;
+
+        return std::make_unexpected<thread, size_t>(-tid);
+    }
+
+    thread t;
+    t.tid = tid;
+    t.stack = stack;
+
+    return std::make_expected<thread>(t);
+}
+
+std::expected<void> tlib::join(thread& t){
+    int64_t code;
+    asm volatile("mov rax, 0xB; mov rbx, %[tid]; " TLIB_SYSCALL "mov %[code], rax"
+        : [code] "=m" (code)
+        : [tid] "g" (t.tid)
+        : "rax", "rbx");
+
+    // The stack can only be released once the thread is terminated
+    if(code < 0){
+        return std::make_expected_from_error<void, size_t>(-code);
+    }
+
+    delete[] t.stack;
+    t.stack = nullptr;
+
+    return std::make_expected();
+}
+
+void tlib::exit_thread(){
+    asm volatile("mov rax, 0xC; " TLIB_SYSCALL
+        : //No outputs
+        : //No inputs
+        : "rax");
+
+    __builtin_unreachable();
+}
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+#=======================================================================
+# Copyright Baptiste Wicht 2013-2018.
+# Distributed under the terms of the MIT License.
+# (See accompanying file LICENSE or copy at
+#  http://www.opensource.org/licenses/MIT)
+#=======================================================================
+
+# Symbolize a dump of /sys/profiler/raw (made with the profile program).
+#
+# The kernel samples are resolved with the symbols of kernel/debug/kernel.bin.o
+# and the user samples with the symbols of programs/<name>/debug/<name>, the
+# name being the one of the sampled process.
+#
+# usage: profile.py [--folded out.folded] [--top N] [--nm NM] dump.prf
+#
+# The flat profile is printed on the standard output. The folded stacks (one
+# "process;outer;...;inner count" line per stack) can be given to
+# flamegraph.pl or speedscope.
+
+import argparse
+import bisect
+import collections
+import os
+import struct
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HEADER  = struct.Struct("<8sIIQQQQ")
+PROCESS = struct.Struct("<I28s")
+SAMPLE  = struct.Struct("<QIHH7Q")
+
+SAMPLE_USER = 1
+
+class Symbols:
+    def __init__(self, nm, path):
+        self.addresses = []
+        self.names = []
+
+        if not os.path.exists(path):
+            sys.stderr.write("profile: no symbols for %s\n" % path)
+            return
+
+        output = subprocess.run([nm, "-C", "-n", "--defined-only", path], stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+
+        for line in output.splitlines():
+            parts = line.split(" ", 2)
+
+            if len(parts) == 3 and parts[1] in "tTwW":
+                self.addresses.append(int(parts[0], 16))
+                self.names.append(parts[2])
+
+    def resolve(self, address):
+        i = bisect.bisect_right(self.addresses, address) - 1
+
+        if i < 0:
+            return "0x%X" % address
+
+        return self.names[i]
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        sys.exit("profile: truncated dump")
+
+    magic, version, sample_size, samples, processes, lost, frequency = HEADER.unpack_from(data, 0)
+
+    if magic != b"THORPRF1" or version != 1 or sample_size != SAMPLE.size:
+        sys.exit("profile: not a thor profiler dump (or unsupported version)")
+
+    offset = HEADER.size
+    names = {}
+
+    for _ in range(processes):
+        pid, name = PROCESS.unpack_from(data, offset)
+        names[pid] = name.split(b"\0", 1)[0].decode("ascii", "replace")
+        offset += PROCESS.size
+
+    samples = min(samples, (len(data) - offset) // SAMPLE.size)
+    records = [SAMPLE.unpack_from(data, offset + i * SAMPLE.size) for i in range(samples)]
+
+    return records, names, lost, frequency
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize a thor profiler dump")
+    parser.add_argument("dump")
+    parser.add_argument("--folded", help="write the folded stacks to this file")
+    parser.add_argument("--top", type=int, default=30, help="number of functions of the flat profile")
+    parser.add_argument("--nm", default="nm", help="the nm binary (x86_64-elf-nm for instance)")
+    args = parser.parse_args()
+
+    records, names, lost, frequency = load(args.dump)
+
+    if not records:
+        sys.exit("profile: no samples")
+
+    kernel = Symbols(args.nm, os.path.join(ROOT, "kernel/debug/kernel.bin.o"))
+    programs = {}
+
+    def program(pid):
+        name = os.path.basename(names.get(pid, ""))
+
+        if name not in programs:
+            programs[name] = Symbols(args.nm, os.path.join(ROOT, "programs", name, "debug", name))
+
+        return programs[name]
+
+    flat = collections.Counter()
+    folded = collections.Counter()
+
+    for rip, pid, flags, depth, *frames in records:
+        user = flags & SAMPLE_USER
+        symbols = program(pid) if user else kernel
+
+        function = symbols.resolve(rip)
+        process = names.get(pid, "pid %d" % pid)
+
+        flat[(function, "user" if user else "kernel")] += 1
+
+        stack = [symbols.resolve(frame) for frame in reversed(frames[:depth])]
+        folded[";".join([process] + stack + [function])] += 1
+
+    total = len(records)
+
+    print("%d samples at %dHz (%d lost)" % (total, frequency, lost))
+    print()
+    print("%8s %7s  %-6s  %s" % ("samples", "%", "mode", "function"))
+
+    for (function, mode), count in flat.most_common(args.top):
+        print("%8d %6.2f%%  %-6s  %s" % (count, 100.0 * count / total, mode, function))
+
+    if args.folded:
+        with open(args.folded, "w") as f:
+            for stack, count in sorted(folded.items()):
+                f.write("%s %d\n" % (stack, count))
+
+if __name__ == "__main__":
+    main()
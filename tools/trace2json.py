@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+#=======================================================================
+# Copyright Baptiste Wicht 2013-2018.
+# Distributed under the terms of the MIT License.
+# (See accompanying file LICENSE or copy at
+#  http://www.opensource.org/licenses/MIT)
+#=======================================================================
+
+# Convert a dump of /sys/trace/raw (made with the trace program) into the
+# Chrome trace event format, loadable in chrome://tracing or Perfetto.
+#
+# usage: trace2json.py dump.trc [out.json]
+
+import json
+import struct
+import sys
+
+HEADER = struct.Struct("<8sIIQQQQQQ")
+RECORD = struct.Struct("<QHHIQQ")
+
+SWITCH        = 0x0001
+SYSCALL_ENTRY = 0x0101
+SYSCALL_EXIT  = 0x0102
+IRQ_ENTRY     = 0x0201
+IRQ_EXIT      = 0x0202
+BLOCK_READ    = 0x0301
+BLOCK_WRITE   = 0x0302
+BLOCK_DONE    = 0x0303
+PACKET_RX     = 0x0401
+PACKET_TX     = 0x0402
+PAGE_FAULT    = 0x0501
+
+KERNEL_PID = 0  # The process used for the kernel-wide tracks (the idle process)
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        sys.exit("trace2json: truncated dump")
+
+    magic, version, record_size, records, lost, base_tsc, base_ms, now_tsc, now_ms = HEADER.unpack_from(data, 0)
+
+    if magic != b"THORTRC1" or version != 1 or record_size != RECORD.size:
+        sys.exit("trace2json: not a thor trace dump (or unsupported version)")
+
+    records = min(records, (len(data) - HEADER.size) // RECORD.size)
+    events = [RECORD.unpack_from(data, HEADER.size + i * RECORD.size) for i in range(records)]
+
+    # The TSC frequency is derived from the two time references of the dump
+    if now_ms > base_ms and now_tsc > base_tsc:
+        tsc_per_us = (now_tsc - base_tsc) / ((now_ms - base_ms) * 1000.0)
+    else:
+        tsc_per_us = 1000.0
+
+    return events, lost, base_tsc, tsc_per_us
+
+def convert(events, lost, base_tsc, tsc_per_us):
+    out = []
+
+    def ts(tsc):
+        return (tsc - base_tsc) / tsc_per_us
+
+    def add(ph, name, tsc, pid, tid, **kwargs):
+        event = {"ph": ph, "name": name, "ts": ts(tsc), "pid": pid, "tid": tid}
+        event.update(kwargs)
+        out.append(event)
+
+    out.append({"ph": "M", "name": "process_name", "pid": KERNEL_PID, "tid": 0, "args": {"name": "kernel"}})
+    out.append({"ph": "M", "name": "thread_name", "pid": KERNEL_PID, "tid": 0, "args": {"name": "cpu0"}})
+    out.append({"ph": "M", "name": "thread_name", "pid": KERNEL_PID, "tid": 1, "args": {"name": "irq"}})
+    out.append({"ph": "M", "name": "thread_name", "pid": KERNEL_PID, "tid": 2, "args": {"name": "block"}})
+
+    running = None  # (pid, tsc) of the process currently on the CPU
+    block = None    # The pending block request
+    syscalls = {}   # The pending system call of each process
+
+    for tsc, kind, cpu, pid, a, b in events:
+        if kind == SWITCH:
+            if running:
+                add("X", "pid %d" % running[0], running[1], KERNEL_PID, 0, dur=ts(tsc) - ts(running[1]))
+            running = (b, tsc)
+        elif kind == SYSCALL_ENTRY:
+            syscalls[pid] = a
+            add("B", "syscall 0x%X" % a, tsc, pid, pid)
+        elif kind == SYSCALL_EXIT:
+            # The entry may have been overwritten in the ring
+            if syscalls.pop(pid, None) is not None:
+                add("E", "syscall 0x%X" % a, tsc, pid, pid, args={"result": b})
+        elif kind == IRQ_ENTRY:
+            add("B", "irq %d" % a, tsc, KERNEL_PID, 1)
+        elif kind == IRQ_EXIT:
+            add("E", "irq %d" % a, tsc, KERNEL_PID, 1)
+        elif kind in (BLOCK_READ, BLOCK_WRITE):
+            block = "read" if kind == BLOCK_READ else "write"
+            add("B", block, tsc, KERNEL_PID, 2, args={"sector": a, "count": b, "pid": pid})
+        elif kind == BLOCK_DONE:
+            if block:
+                add("E", block, tsc, KERNEL_PID, 2, args={"result": a})
+                block = None
+        elif kind in (PACKET_RX, PACKET_TX):
+            name = "rx" if kind == PACKET_RX else "tx"
+            add("i", name, tsc, KERNEL_PID, 0, s="t", args={"interface": a, "size": b})
+        elif kind == PAGE_FAULT:
+            add("i", "page fault", tsc, pid, pid, s="t", args={"address": "0x%X" % a, "rip": "0x%X" % b})
+
+    if running and events:
+        add("X", "pid %d" % running[0], running[1], KERNEL_PID, 0, dur=ts(events[-1][0]) - ts(running[1]))
+
+    return {"traceEvents": out, "displayTimeUnit": "ns", "otherData": {"lost": lost}}
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit("usage: trace2json.py dump.trc [out.json]")
+
+    events, lost, base_tsc, tsc_per_us = load(sys.argv[1])
+
+    if lost:
+        sys.stderr.write("trace2json: %d records were overwritten in the ring\n" % lost)
+
+    result = convert(events, lost, base_tsc, tsc_per_us)
+
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as f:
+            json.dump(result, f)
+    else:
+        json.dump(result, sys.stdout)
+
+if __name__ == "__main__":
+    main()
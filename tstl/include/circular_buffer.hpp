@@ -49,6 +49,20 @@ public:
         return end == start;
     }
 
+    /*!
+     * \brief Returns the number of elements in the buffer
+     */
+    size_t size() const {
+        return (end + Size - start) % Size;
+    }
+
+    /*!
+     * \brief Returns the number of elements that can still be pushed
+     */
+    size_t free_size() const {
+        return S - size();
+    }
+
     /*!
      * \brief Push the given value to the buffer
      * \param value The value
@@ -64,6 +78,51 @@ public:
         }
     }
 
+    /*!
+     * \brief Push as many of the given values as possible to the buffer
+     * \param values The values
+     * \param n The number of values
+     * \return The number of values pushed
+     */
+    size_t push(const T* values, size_t n){
+        if(n > free_size()){
+            n = free_size();
+        }
+
+        write_at(0, values, n);
+        commit(n);
+
+        return n;
+    }
+
+    /*!
+     * \brief Write values after the end of the buffer, without pushing them.
+     *
+     * The values are only visible once they are committed. This allows
+     * to fill the free space out of order. The caller must make sure that
+     * offset + n is not greater than free_size().
+     *
+     * \param offset The position of the first value, after the end of the buffer
+     * \param values The values
+     * \param n The number of values
+     */
+    void write_at(size_t offset, const T* values, size_t n){
+        auto index = (end + offset) % Size;
+
+        for(size_t i = 0; i < n; ++i){
+            buffer[index] = values[i];
+            index = index + 1 == Size ? 0 : index + 1;
+        }
+    }
+
+    /*!
+     * \brief Push the n values previously written after the end of the buffer
+     * \param n The number of values
+     */
+    void commit(size_t n){
+        end = (end + n) % Size;
+    }
+
     /*!
      * \brief Construct a new element in place at it would have been pushed
      * \param values The values to forward to the constructor
@@ -96,6 +155,29 @@ public:
         return value;
     }
 
+    /*!
+     * \brief Removes up to n values from the top of the buffer
+     * \param values The destination of the values
+     * \param n The maximum number of values
+     * \return The number of values removed
+     */
+    size_t pop(T* values, size_t n){
+        if(n > size()){
+            n = size();
+        }
+
+        auto index = start;
+
+        for(size_t i = 0; i < n; ++i){
+            values[i] = buffer[index];
+            index = index + 1 == Size ? 0 : index + 1;
+        }
+
+        start = index;
+
+        return n;
+    }
+
     /*!
      * \brief Removes the last element that was pushed
      *
@@ -58,9 +58,58 @@ void contains_test(){
     check(buffer.contains(13));
 }
 
+void bulk_test(){
+    circular_buffer<char, 8> buffer;
+
+    check(buffer.size() == 0);
+    check(buffer.free_size() == 8);
+
+    check(buffer.push("abcdef", 6) == 6);
+    check(buffer.size() == 6);
+
+    char values[8];
+
+    check(buffer.pop(values, 4) == 4);
+    check(values[0] == 'a');
+    check(values[3] == 'd');
+    check(buffer.size() == 2);
+
+    // Wrap around
+    check(buffer.push("ghijklmn", 8) == 6);
+    check(buffer.full());
+
+    check(buffer.pop(values, 8) == 8);
+    check(values[0] == 'e');
+    check(values[7] == 'l');
+    check(buffer.empty());
+}
+
+void out_of_order_test(){
+    circular_buffer<char, 8> buffer;
+
+    buffer.push("ab", 2);
+
+    buffer.write_at(2, "ef", 2);
+    check(buffer.size() == 2);
+
+    buffer.write_at(0, "cd", 2);
+    buffer.commit(4);
+    check(buffer.size() == 6);
+
+    char values[8];
+
+    check(buffer.pop(values, 8) == 6);
+    check(values[0] == 'a');
+    check(values[2] == 'c');
+    check(values[4] == 'e');
+    check(values[5] == 'f');
+}
+
 } //end of anonymous namespace
 
 void circular_buffer_tests(){
     base_test();
     contains_test();
+    bulk_test();
+    out_of_order_test();
 }